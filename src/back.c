@@ -24,7 +24,7 @@
 *	You should have received a copy of the GNU General Public License
 *	along with SWarp. If not, see <http://www.gnu.org/licenses/>.
 *
-*	Last modified:		21/03/2025
+*	Last modified:		19/10/2026
 *
 *%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
 
@@ -40,6 +40,7 @@
 #include	<stdio.h>
 #include	<stdlib.h>
 #include	<string.h>
+#include	<unistd.h>
 
 #include	"define.h"
 #include	"globals.h"
@@ -47,24 +48,52 @@
 #include	"back.h"
 #include	"coadd.h"
 #include	"field.h"
+#include	"meta.h"
 #include	"misc.h"
 #include	"prefs.h"
+#ifdef USE_THREADS
+#include	"threads.h"
+#endif
 #include	"weight.h"
 
+static int	backcache_key(fieldstruct *field, fieldstruct *wfield,
+			int wscale_flag, char *key),
+		load_backcache(fieldstruct *field, fieldstruct *wfield,
+			char *key, char *cachename);
+static void	back_meshes(backstruct *backmesh, backstruct *wbackmesh,
+			PIXTYPE *buf, PIXTYPE *wbuf, size_t bufsize,
+			int n, int w, int bw, PIXTYPE wthresh, int histoflag),
+		back_readbody(tabstruct *tab, PIXTYPE *pix, PIXTYPE *buf,
+			size_t npix),
+		backinterp_line(fieldstruct *field, float *map, float *dmap,
+			int y, PIXTYPE *line),
+		save_backcache(fieldstruct *field, fieldstruct *wfield,
+			char *key, char *cachename);
+static backinterpstruct	*init_backinterp(fieldstruct *field);
+#ifdef USE_THREADS
+static void	*pthread_back_meshes(void *arg);
+#endif
+
 /******************************** make_back **********************************/
 /*
 Background maps are established from the images themselves; thus we need to
-make at least one first pass through the data.
+make at least one first pass through the data, unless the maps are found in
+the background cache. If the raw pixels have already been loaded in memory
+(see preload_data()), they are used instead of the input files. With
+BACK_SAMPLING > 1, statistics are computed from a regular subsample of lines
+in every mesh, which is much faster and accurate enough for sky-dominated
+frames.
 */
 void	make_back(fieldstruct *field, fieldstruct *wfield, int wscale_flag)
 
   {
    backstruct	*backmesh,*wbackmesh, *bm,*wbm;
    tabstruct	*tab, *wtab;
-   PIXTYPE	*buf,*wbuf, *buft,*wbuft;
-   size_t	bufsize, bufsize2, size, meshsize;
+   char		key[BACKCACHE_KEYSIZE], cachename[MAXCHAR];
+   PIXTYPE	*buf,*wbuf, *buft,*wbuft, *pix,*wpix;
+   size_t	bufsize, bufsize2, size, meshsize, ramsize;
    off_t	fcurpos,wfcurpos, wfcurpos2,fcurpos2, bufshift, jumpsize;
-   int		i,j,k,m,n, step, nlines,
+   int		i,j,k,m,n, step, nlines, sampling,
 		w,bw, bh, nx,ny,nb,
 		lflag, nr;
    float	*ratio,*ratiop, *weight, *sigma, sratio;
@@ -76,16 +105,35 @@ void	make_back(fieldstruct *field, fieldstruct *wfield, int wscale_flag)
   if (wfield && (wfield->flags&BACKRMS_FIELD))
     wfield= NULL;
   tab = field->tab;
+  pix = field->pix;
   if (wfield)
+    {
     wtab = wfield->tab;
+    wpix = wfield->pix;
+    }
   else
+    {
     wtab = NULL;	/* to avoid gcc -Wall warnings */
+    wpix = NULL;
+    }
   w = field->width;
   bw = field->backw;
   bh = field->backh;
   nx = field->nbackx;
   ny = field->nbacky;
   nb = field->nback;
+  sampling = prefs.back_sampling>bh? bh : prefs.back_sampling;
+
+/* Look for the background maps in the cache */
+  *cachename = '\0';
+  if (prefs.nbackcache_name && *prefs.backcache_name[0]
+	&& backcache_key(field, wfield, wscale_flag, key) == RETURN_OK)
+    {
+    meta_cachename(prefs.backcache_name[0], key, BACKCACHE_EXT, cachename);
+    NFPRINTF(OUTPUT, "Loading cached background maps ...");
+    if (load_backcache(field, wfield, key, cachename) == RETURN_OK)
+      goto back_end;
+    }
 
   NFPRINTF(OUTPUT, "Setting up background maps ...");
 
@@ -118,10 +166,12 @@ void	make_back(fieldstruct *field, fieldstruct *wfield, int wscale_flag)
   bufsize = (size_t)w*bh;
   meshsize = bufsize;
   nlines = 0;
-  if (bufsize > (size_t)BACK_BUFSIZE)
+  if (bufsize > (size_t)BACK_BUFSIZE || sampling>1)
     {
     nlines = BACK_BUFSIZE/w;
     step = (field->backh-1)/nlines+1;
+    if (step<sampling)
+      step = sampling;
     bufsize = (size_t)(nlines = field->backh/step)*w;
     bufshift = (step/2)*(size_t)w;
     jumpsize = (step-1)*(size_t)w;
@@ -154,6 +204,9 @@ void	make_back(fieldstruct *field, fieldstruct *wfield, int wscale_flag)
     wbackmesh = NULL;
     wbuf = NULL;
     }
+/* Pixel buffers are part of the MEM_MAX budget */
+  ramsize = bufsize*sizeof(PIXTYPE)*(wfield? 2:1);
+  reserve_ram(ramsize, 0, 1);
 
 /* Loop over the data packets */
   for (j=0; j<ny; j++)
@@ -167,15 +220,15 @@ void	make_back(fieldstruct *field, fieldstruct *wfield, int wscale_flag)
 /*---- The image is small enough so that we can make exhaustive stats */
       if (j == ny-1 && field->npix%bufsize)
         bufsize = field->npix%bufsize;
-      read_body(tab, buf, bufsize);
+      back_readbody(tab, pix, buf, bufsize);
       if (wfield)
         {
-        read_body(wtab, wbuf, bufsize);
+        back_readbody(wtab, wpix, wbuf, bufsize);
         weight_to_var(wbuf, bufsize);
         }
 /*---- Build the histograms */
-      backstat(backmesh, wbackmesh, buf, wbuf, bufsize,nx, w, bw,
-	wfield?wfield->var_thresh:0.0);
+      back_meshes(backmesh, wbackmesh, buf, wbuf, bufsize, nx, w, bw,
+	wfield?wfield->var_thresh:0.0, 0);
       bm = backmesh;
       for (m=nx; m--; bm++)
         if (bm->mean <= -BIG)
@@ -191,8 +244,8 @@ void	make_back(fieldstruct *field, fieldstruct *wfield, int wscale_flag)
           else
             QCALLOC(wbm->histo, int, wbm->nlevels);
         }
-      backhisto(backmesh, wbackmesh, buf, wbuf, bufsize,nx, w, bw,
-	wfield?wfield->var_thresh:0.0);
+      back_meshes(backmesh, wbackmesh, buf, wbuf, bufsize, nx, w, bw,
+	wfield?wfield->var_thresh:0.0, 1);
       }
     else
       {
@@ -215,6 +268,8 @@ void	make_back(fieldstruct *field, fieldstruct *wfield, int wscale_flag)
         meshsize = n*(size_t)w;
         nlines = BACK_BUFSIZE/w;
         step = (n-1)/nlines+1;
+        if (step<sampling)
+          step = sampling>n? n : sampling;
         bufsize = (nlines = n/step)*(size_t)w;
         bufshift = (step/2)*(size_t)w;
         jumpsize = (step-1)*(size_t)w;
@@ -225,6 +280,9 @@ void	make_back(fieldstruct *field, fieldstruct *wfield, int wscale_flag)
           free(wbuf);
           QMALLOC(wbuf, PIXTYPE, bufsize);	/* pixel buffer */
           }
+        release_ram(ramsize, 0);
+        ramsize = bufsize*sizeof(PIXTYPE)*(wfield? 2:1);
+        reserve_ram(ramsize, 0, 1);
         }
 
 /*---- Read and skip, read and skip, etc... */
@@ -235,7 +293,7 @@ void	make_back(fieldstruct *field, fieldstruct *wfield, int wscale_flag)
       buft = buf;
       for (i=nlines; i--; buft += w)
         {
-        read_body(tab, buft, w);
+        back_readbody(tab, pix, buft, w);
         if ((i)) {
           QFSEEK(tab->cat->file, jumpsize*tab->bytepix, SEEK_CUR,
 		field->filename);
@@ -256,7 +314,7 @@ void	make_back(fieldstruct *field, fieldstruct *wfield, int wscale_flag)
         wbuft = wbuf;
         for (i=nlines; i--; wbuft += w)
           {
-          read_body(wtab, wbuft, w);
+          back_readbody(wtab, wpix, wbuft, w);
           weight_to_var(wbuft, w);
           if ((i))
             {
@@ -268,8 +326,8 @@ void	make_back(fieldstruct *field, fieldstruct *wfield, int wscale_flag)
             }
           }
         }
-      backstat(backmesh, wbackmesh, buf, wbuf, bufsize, nx, w, bw,
-	wfield?wfield->var_thresh:0.0);
+      back_meshes(backmesh, wbackmesh, buf, wbuf, bufsize, nx, w, bw,
+	wfield?wfield->var_thresh:0.0, 0);
       QFSEEK(tab->cat->file, fcurpos2, SEEK_SET, field->filename);
 #ifdef HAVE_CFITSIO
       tab->cfitsio_currentElement = currentElement2;
@@ -293,20 +351,40 @@ void	make_back(fieldstruct *field, fieldstruct *wfield, int wscale_flag)
           else
             QCALLOC(wbm->histo, int, wbm->nlevels);
         }
-/*---- Build (progressively this time) the histograms */
-      for(size=meshsize, bufsize2=bufsize; size>0; size -= bufsize2)
+      if (sampling>1)
         {
-        if (bufsize2>size)
-          bufsize2 = size;
-        read_body(tab, buf, bufsize2);
+/*------ Build the histograms from the same sample of lines, and skip */
+        back_meshes(backmesh, wbackmesh, buf, wbuf, bufsize, nx, w, bw,
+		wfield?wfield->var_thresh:0.0, 1);
+        QFSEEK(tab->cat->file, (OFF_T2)meshsize*tab->bytepix, SEEK_CUR,
+		field->filename);
+#ifdef HAVE_CFITSIO
+        tab->cfitsio_currentElement += meshsize;
+#endif // HAVE_CFITSIO
         if (wfield)
           {
-          read_body(wtab, wbuf, bufsize2);
-          weight_to_var(wbuf, bufsize2);
+          QFSEEK(wtab->cat->file, (OFF_T2)meshsize*wtab->bytepix, SEEK_CUR,
+		wfield->filename);
+#ifdef HAVE_CFITSIO
+          wtab->cfitsio_currentElement += meshsize;
+#endif // HAVE_CFITSIO
           }
-        backhisto(backmesh, wbackmesh, buf, wbuf, bufsize2, nx, w, bw,
-		wfield?wfield->var_thresh:0.0);
         }
+      else
+/*------ Build (progressively this time) the histograms */
+        for(size=meshsize, bufsize2=bufsize; size>0; size -= bufsize2)
+          {
+          if (bufsize2>size)
+            bufsize2 = size;
+          back_readbody(tab, pix, buf, bufsize2);
+          if (wfield)
+            {
+            back_readbody(wtab, wpix, wbuf, bufsize2);
+            weight_to_var(wbuf, bufsize2);
+            }
+          back_meshes(backmesh, wbackmesh, buf, wbuf, bufsize2, nx, w, bw,
+		wfield?wfield->var_thresh:0.0, 1);
+          }
       }
 
 /*-- Compute background statistics from the histograms */
@@ -337,6 +415,7 @@ void	make_back(fieldstruct *field, fieldstruct *wfield, int wscale_flag)
     free(wbackmesh);
     free(wbuf);
     }
+  release_ram(ramsize, 0);
 
 /* Go back to the original position */
   QFSEEK(field->tab->cat->file, fcurpos, SEEK_SET, field->filename);
@@ -395,6 +474,11 @@ void	make_back(fieldstruct *field, fieldstruct *wfield, int wscale_flag)
   NFPRINTF(OUTPUT, "Computing backgound-noise d-map ...");
   free(field->dsigma);
   field->dsigma = make_backspline(field, field->sigma);
+
+  if (*cachename)
+    save_backcache(field, wfield, key, cachename);
+
+back_end:
 /* If asked for, force the backmean parameter to the supplied value */
   if (field->back_type == BACK_ABSOLUTE)
     field->backmean = field->backdefault;
@@ -406,19 +490,362 @@ void	make_back(fieldstruct *field, fieldstruct *wfield, int wscale_flag)
   }
 
 
+/****** back_meshes ********************************************************
+PROTO	void back_meshes(backstruct *backmesh, backstruct *wbackmesh,
+		PIXTYPE *buf, PIXTYPE *wbuf, size_t bufsize,
+		int n, int w, int bw, PIXTYPE wthresh, int histoflag)
+PURPOSE	Compute statistics or histograms in a row of meshes, in parallel if
+	possible.
+INPUT	Pointer to the first image mesh,
+	pointer to the first weight mesh (or NULL),
+	pointer to the image pixel buffer,
+	pointer to the weight pixel buffer (or NULL),
+	number of pixels in the buffer,
+	number of meshes,
+	buffer width,
+	mesh width,
+	weight threshold,
+	flag set to build histograms (backhisto()) instead of computing
+	statistics (backstat()).
+OUTPUT	-.
+NOTES	The row is split in ranges of meshes that are handed over to the
+	worker pool.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+static void	back_meshes(backstruct *backmesh, backstruct *wbackmesh,
+			PIXTYPE *buf, PIXTYPE *wbuf, size_t bufsize,
+			int n, int w, int bw, PIXTYPE wthresh, int histoflag)
+  {
+#ifdef USE_THREADS
+   threads_job_t	*job;
+   backmeshesstruct	*meshes;
+   int			c,m,m2, nchunk;
+#endif
+   int			lastbw;
+
+  lastbw = w - (n-1)*bw;
+#ifdef USE_THREADS
+  if (threads_pool && threads_pool->nthreads>1 && n>1)
+    {
+    nchunk = n<threads_pool->nthreads? n : threads_pool->nthreads;
+    QMALLOC(meshes, backmeshesstruct, nchunk);
+    job = threads_job_init(threads_pool);
+    for (c=0; c<nchunk; c++)
+      {
+      m = (int)((size_t)n*c/nchunk);
+      m2 = (int)((size_t)n*(c+1)/nchunk);
+      meshes[c].backmesh = backmesh + m;
+      meshes[c].wbackmesh = wbackmesh? wbackmesh + m : NULL;
+      meshes[c].buf = buf + (size_t)m*bw;
+      meshes[c].wbuf = wbuf? wbuf + (size_t)m*bw : NULL;
+      meshes[c].bufsize = bufsize;
+      meshes[c].n = m2 - m;
+      meshes[c].w = w;
+      meshes[c].bw = bw;
+      meshes[c].lastbw = m2==n? lastbw : bw;
+      meshes[c].wthresh = wthresh;
+      meshes[c].histoflag = histoflag;
+      threads_job_add(job, &pthread_back_meshes, &meshes[c]);
+      }
+    threads_job_end(job);
+    free(meshes);
+    return;
+    }
+#endif
+
+  if (histoflag)
+    backhisto(backmesh, wbackmesh, buf, wbuf, bufsize, n, w, bw, lastbw,
+	wthresh);
+  else
+    backstat(backmesh, wbackmesh, buf, wbuf, bufsize, n, w, bw, lastbw,
+	wthresh);
+
+  return;
+  }
+
+
+#ifdef USE_THREADS
+/****** pthread_back_meshes *************************************************
+PROTO	void *pthread_back_meshes(void *arg)
+PURPOSE	Pool task computing statistics or histograms in a range of meshes.
+INPUT	Pointer to the mesh range structure.
+OUTPUT	NULL void pointer.
+NOTES	-.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+static void	*pthread_back_meshes(void *arg)
+  {
+   backmeshesstruct	*meshes;
+
+  meshes = (backmeshesstruct *)arg;
+  if (meshes->histoflag)
+    backhisto(meshes->backmesh, meshes->wbackmesh, meshes->buf, meshes->wbuf,
+	meshes->bufsize, meshes->n, meshes->w, meshes->bw, meshes->lastbw,
+	meshes->wthresh);
+  else
+    backstat(meshes->backmesh, meshes->wbackmesh, meshes->buf, meshes->wbuf,
+	meshes->bufsize, meshes->n, meshes->w, meshes->bw, meshes->lastbw,
+	meshes->wthresh);
+
+  return (void *)NULL;
+  }
+#endif
+
+
+/****** back_readbody ******************************************************
+PROTO	void back_readbody(tabstruct *tab, PIXTYPE *pix, PIXTYPE *buf,
+			size_t npix)
+PURPOSE	Read pixels for background estimation, either from the file or from
+	memory.
+INPUT	Tab structure,
+	pointer to the raw pixels already in memory (or NULL),
+	pointer to the output buffer,
+	number of pixels to read.
+OUTPUT	-.
+NOTES	In both cases the file position is used and advanced, so that the
+	caller may skip data with fseek() independently of the source.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+static void	back_readbody(tabstruct *tab, PIXTYPE *pix, PIXTYPE *buf,
+			size_t npix)
+  {
+   OFF_T2	pos;
+
+  if (!pix)
+    {
+    read_body(tab, buf, npix);
+    return;
+    }
+
+  QFTELL(tab->cat->file, pos, tab->cat->filename);
+  memcpy(buf, pix + (pos - tab->bodypos)/tab->bytepix, npix*sizeof(PIXTYPE));
+  QFSEEK(tab->cat->file, (OFF_T2)npix*tab->bytepix, SEEK_CUR,
+	tab->cat->filename);
+
+  return;
+  }
+
+
+/****** backcache_key ******************************************************
+PROTO	int backcache_key(fieldstruct *field, fieldstruct *wfield,
+			int wscale_flag, char *key)
+PURPOSE	Build the string that identifies the background maps of a field in the
+	background cache.
+INPUT	Pointer to the field,
+	pointer to the weight field (or NULL),
+	weight rescaling flag,
+	pointer to the output key string (BACKCACHE_KEYSIZE bytes).
+OUTPUT	RETURN_OK if a key could be built, RETURN_ERROR otherwise.
+NOTES	The key combines the identity (path, size, modification time, inode
+	and DATASUM if present) of the image and weight files, the data
+	scaling, and all parameters that affect background maps.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+static int	backcache_key(fieldstruct *field, fieldstruct *wfield,
+			int wscale_flag, char *key)
+  {
+   char		id[2*MAXCHAR], datasum[82];
+   int		n;
+
+  if (meta_fileid(field->filename, id) != RETURN_OK)
+    return RETURN_ERROR;
+  if (fitsread(field->tab->headbuf, "DATASUM ", datasum, H_STRING, T_STRING)
+	!= RETURN_OK)
+    *datasum = '\0';
+  n = sprintf(key,"%s [%d] %s %d %.17g %.17g %d %d %d %d %d %d %.17g %d %d",
+	id, field->frameno, datasum,
+	field->tab->bitpix, field->tab->bscale, field->tab->bzero,
+	field->width, field->height, field->backw, field->backh,
+	field->nbackfx, field->nbackfy, prefs.back_fthresh, prefs.back_sampling,
+	wscale_flag);
+  if (wfield)
+    {
+    if (meta_fileid(wfield->filename, id) != RETURN_OK)
+      return RETURN_ERROR;
+    if (fitsread(wfield->tab->headbuf, "DATASUM ", datasum, H_STRING,
+	T_STRING) != RETURN_OK)
+      *datasum = '\0';
+    sprintf(key+n, " %s [%d] %s %d %.17g %.17g %d %.9g",
+	id, wfield->frameno, datasum,
+	wfield->tab->bitpix, wfield->tab->bscale, wfield->tab->bzero,
+	wfield->flags&(RMS_FIELD|VAR_FIELD|WEIGHT_FIELD),
+	wfield->weight_thresh);
+    }
+
+  return RETURN_OK;
+  }
+
+
+/****** load_backcache ******************************************************
+PROTO	int load_backcache(fieldstruct *field, fieldstruct *wfield,
+			char *key, char *cachename)
+PURPOSE	Load background maps from the background cache.
+INPUT	Pointer to the field,
+	pointer to the weight field (or NULL),
+	cache key,
+	cache filename.
+OUTPUT	RETURN_OK if the maps were found and are valid, RETURN_ERROR otherwise.
+NOTES	Fields are left untouched if the maps are not found.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+static int	load_backcache(fieldstruct *field, fieldstruct *wfield,
+			char *key, char *cachename)
+  {
+   backcacheheadstruct	head;
+   FILE			*file;
+   float		*map[6];
+   unsigned int		sum;
+   int			i, nb, nmap;
+
+  if (!(file = fopen(cachename, "rb")))
+    return RETURN_ERROR;
+  nb = field->nback;
+  if (fread(&head, sizeof(head), 1, file) != 1
+	|| strncmp(head.magic, BACKCACHE_MAGIC, 8)
+	|| strncmp(head.key, key, BACKCACHE_KEYSIZE)
+	|| head.nback != nb || head.wflag != (wfield!=NULL))
+    {
+    fclose(file);
+    return RETURN_ERROR;
+    }
+
+/* Image background and RMS maps + derivatives, weight-map back and RMS */
+  nmap = wfield? 6 : 4;
+  for (i=0; i<nmap; i++)
+    QMALLOC(map[i], float, nb);
+  sum = META_CHECKSUMINIT;
+  for (i=0; i<nmap; i++)
+    {
+    if (fread(map[i], nb*sizeof(float), 1, file) != 1)
+      break;
+    sum = meta_checksum(sum, map[i], nb*sizeof(float));
+    }
+  fclose(file);
+  if (i<nmap || sum != head.checksum)
+    {
+    for (i=0; i<nmap; i++)
+      free(map[i]);
+    return RETURN_ERROR;
+    }
+
+  free(field->back);
+  field->back = map[0];
+  free(field->sigma);
+  field->sigma = map[1];
+  free(field->dback);
+  field->dback = map[2];
+  free(field->dsigma);
+  field->dsigma = map[3];
+  free(field->backline);
+  QMALLOC(field->backline, PIXTYPE, field->width);
+  field->backmean = head.backmean;
+  field->backsig = head.backsig;
+  if (wfield)
+    {
+    free(wfield->back);
+    wfield->back = map[4];
+    free(wfield->sigma);
+    wfield->sigma = map[5];
+    wfield->sigfac = head.sigfac;
+    wfield->var_thresh = (PIXTYPE)head.var_thresh;
+    }
+
+  return RETURN_OK;
+  }
+
+
+/****** save_backcache ******************************************************
+PROTO	void save_backcache(fieldstruct *field, fieldstruct *wfield,
+			char *key, char *cachename)
+PURPOSE	Save background maps to the background cache.
+INPUT	Pointer to the field,
+	pointer to the weight field (or NULL),
+	cache key,
+	cache filename.
+OUTPUT	-.
+NOTES	The cache file is written under a temporary name and renamed.
+	Failures are silently ignored.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+static void	save_backcache(fieldstruct *field, fieldstruct *wfield,
+			char *key, char *cachename)
+  {
+   backcacheheadstruct	head;
+   FILE			*file;
+   float		*map[6];
+   char			tmpname[MAXCHAR];
+   size_t		n;
+   int			i, nb, nmap, fd, status;
+
+  nb = field->nback;
+  map[0] = field->back;
+  map[1] = field->sigma;
+  map[2] = field->dback;
+  map[3] = field->dsigma;
+  nmap = 4;
+  if (wfield)
+    {
+    map[4] = wfield->back;
+    map[5] = wfield->sigma;
+    nmap = 6;
+    }
+
+  memset(&head, 0, sizeof(head));
+  memcpy(head.magic, BACKCACHE_MAGIC, 8);
+  n = strlen(key);
+  memcpy(head.key, key, n<BACKCACHE_KEYSIZE? n : BACKCACHE_KEYSIZE-1);
+  head.nback = nb;
+  head.wflag = (wfield!=NULL);
+  head.backmean = field->backmean;
+  head.backsig = field->backsig;
+  if (wfield)
+    {
+    head.sigfac = wfield->sigfac;
+    head.var_thresh = (double)wfield->var_thresh;
+    }
+  head.checksum = META_CHECKSUMINIT;
+  for (i=0; i<nmap; i++)
+    head.checksum = meta_checksum(head.checksum, map[i], nb*sizeof(float));
+
+  sprintf(tmpname, "%.*sXXXXXX", MAXCHAR-8, cachename);
+  if ((fd = mkstemp(tmpname)) == -1)
+    return;
+  if (!(file = fdopen(fd, "wb")))
+    {
+    close(fd);
+    remove(tmpname);
+    return;
+    }
+  status = fwrite(&head, sizeof(head), 1, file) != 1;
+  for (i=0; i<nmap && !status; i++)
+    status = fwrite(map[i], nb*sizeof(float), 1, file) != 1;
+  if (fclose(file) || status || rename(tmpname, cachename))
+    remove(tmpname);
+
+  return;
+  }
+
+
 /******************************** backstat **********************************/
 /*
-Compute robust statistical estimators in a row of meshes.
+Compute robust statistical estimators in a row of meshes (the last one being
+lastbw pixels wide).
 */
 void	backstat(backstruct *backmesh, backstruct *wbackmesh,
 		PIXTYPE *buf, PIXTYPE *wbuf, size_t bufsize,
-			int n, int w, int bw, PIXTYPE wthresh)
+			int n, int w, int bw, int lastbw, PIXTYPE wthresh)
 
   {
    backstruct	*bm, *wbm;
    double	pix,wpix, sig, mean,wmean, sigma,wsigma, step;
    PIXTYPE	*buft,*wbuft, lcut,wlcut, hcut,whcut;
-   int		m,h,x,y, npix,wnpix, offset, lastbite;
+   int		m,h,x,y, npix,wnpix, offset;
 
   h = bufsize/w;
   bm = backmesh;
@@ -428,9 +855,9 @@ void	backstat(backstruct *backmesh, backstruct *wbackmesh,
   wmean = wsigma = wlcut = whcut = 0.0;	/* to avoid gcc -Wall warnings */
   for (m = n; m--; bm++,buf+=bw)
     {
-    if (!m && (lastbite=w%bw))
+    if (!m)
       {
-      bw = lastbite;
+      bw = lastbw;
       offset = w-bw;
       }
     mean = sigma = 0.0;
@@ -561,18 +988,19 @@ void	backstat(backstruct *backmesh, backstruct *wbackmesh,
 
 /******************************** backhisto *********************************/
 /*
-Compute robust statistical estimators in a row of meshes.
+Compute robust statistical estimators in a row of meshes (the last one being
+lastbw pixels wide).
 */
 void	backhisto(backstruct *backmesh, backstruct *wbackmesh,
 		PIXTYPE *buf, PIXTYPE *wbuf, size_t bufsize,
-			int n, int w, int bw, PIXTYPE wthresh)
+			int n, int w, int bw, int lastbw, PIXTYPE wthresh)
   {
    backstruct	*bm,*wbm;
    PIXTYPE	*buft,*wbuft,
 		pix;
    float	qscale,wqscale, cste,wcste, wpix;
    int		*histo,*whisto;
-   int		h,m,x,y, nlevels,wnlevels, lastbite, offset, bin;
+   int		h,m,x,y, nlevels,wnlevels, offset, bin;
 
   h = bufsize/w;
   bm = backmesh;
@@ -580,9 +1008,9 @@ void	backhisto(backstruct *backmesh, backstruct *wbackmesh,
   offset = w - bw;
   for (m=0; m++<n; bm++ , buf+=bw)
     {
-    if (m==n && (lastbite=w%bw))
+    if (m==n)
       {
-      bw = lastbite;
+      bw = lastbw;
       offset = w-bw;
       }
 /*-- Skip bad meshes */
@@ -896,28 +1324,80 @@ background map vertices).
 void	backline(fieldstruct *field, int y, PIXTYPE *line)
 
   {
-   int		i,j,x,yl, nbx,nbxm1,nby, nx,width, ystep, changepoint;
-   float	dx,dx0,dy,dy3, cdx,cdy,cdy3, temp, xstep,
-		*node,*nodep,*dnode, *blo,*bhi,*dblo,*dbhi, *u;
+   int		i;
    PIXTYPE	bval;
 
-  width = field->width;
-
   if (field->back_type==BACK_ABSOLUTE)
     {
 /*-- In absolute background mode, just subtract a cste */
     bval = (PIXTYPE)field->backmean;
-    for (i=width; i--;)
+    for (i=field->width; i--;)
       *(line++) = bval;
     return;
     }
 
+  backinterp_line(field, field->back, field->dback, y, line);
+
+  return;
+  }
+
+
+/******************************* backrmsline ********************************
+PROTO   void backrmsline(fieldstruct *field, int y, PIXTYPE *line)
+PURPOSE Bicubic-spline interpolation of the background noise along the current
+        scanline (y).
+INPUT   Measurement or detection field pointer,
+        Current line position. 
+        Where to put the data. 
+OUTPUT  -.
+NOTES   -.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+void	backrmsline(fieldstruct *field, int y, PIXTYPE *line)
+
+  {
+  backinterp_line(field, field->sigma, field->dsigma, y, line);
+
+  return;
+  }
+
+
+/****** backinterp_line *****************************************************
+PROTO	void backinterp_line(fieldstruct *field, float *map, float *dmap, int y,
+			PIXTYPE *line)
+PURPOSE	Bicubic-spline interpolation of a background map along scanline y.
+INPUT	Field pointer,
+	background map,
+	map of 2nd derivatives along y,
+	current line position,
+	where to put the data.
+OUTPUT	-.
+NOTES	Everything that does not depend on map values (pivots of the spline
+	solve along x, pixel offsets to the nodes) is computed once per field
+	by init_backinterp(), and the line is filled one node interval at a
+	time to allow vectorization. Results are identical to those of the
+	original pixel-by-pixel code.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+static void	backinterp_line(fieldstruct *field, float *map, float *dmap,
+			int y, PIXTYPE *line)
+
+  {
+   backinterpstruct	*bi;
+   int			j,x,yl, nbx,nby, ystep, jmax;
+   float		dy,dy3, cdy,cdy3, blo,bhi,dblo,dbhi,
+			*node,*dnode, *mlo,*mhi,*dmlo,*dmhi, *u,*piv,
+			*dx,*cdx,*dx2,*cdx2;
+
+  if (!(bi=field->backinterp))
+    bi = init_backinterp(field);
   nbx = field->nbackx;
-  nbxm1 = nbx - 1;
   nby = field->nbacky;
   if (nby > 1)
     {
-    dy = (float)y/field->backh - 0.5;	
+    dy = (float)y/field->backh - 0.5;
     dy -= (yl = (int)dy);
     if (yl<0)
       {
@@ -934,175 +1414,102 @@ void	backline(fieldstruct *field, int y, PIXTYPE *line)
     dy3 = (dy*dy*dy-dy);
     cdy3 = (cdy*cdy*cdy-cdy);
     ystep = nbx*yl;
-    blo = field->back + ystep;
-    bhi = blo + nbx;
-    dblo = field->dback + ystep;
-    dbhi = dblo + nbx;
-    QMALLOC(node, float, nbx);	/* Interpolated background */
-    nodep = node;
-    for (x=nbx; x--;)
-      *(nodep++) = cdy**(blo++) + dy**(bhi++) + cdy3**(dblo++) + dy3**(dbhi++);
-
-/*-- Computation of 2nd derivatives along x */
-    QMALLOC(dnode, float, nbx);	/* 2nd derivative along x */
+    mlo = map + ystep;
+    mhi = mlo + nbx;
+    dmlo = dmap + ystep;
+    dmhi = dmlo + nbx;
+    node = bi->node;
+    for (x=0; x<nbx; x++)
+      node[x] = cdy*mlo[x] + dy*mhi[x] + cdy3*dmlo[x] + dy3*dmhi[x];
+
+/*-- Computation of 2nd derivatives along x ("natural" boundary conditions) */
+    dnode = bi->dnode;
     if (nbx>1)
       {
-      QMALLOC(u, float, nbxm1);	/* temporary array */
-      *dnode = *u = 0.0;	/* "natural" lower boundary condition */
-      nodep = node+1;
-      for (x=nbxm1; --x; nodep++)
-        {
-        temp = -1/(*(dnode++)+4);
-        *dnode = temp;
-        temp *= *(u++) - 6*(*(nodep+1)+*(nodep-1)-2**nodep);
-        *u = temp;
-        }
-      *(++dnode) = 0.0;	/* "natural" upper boundary condition */
-      for (x=nbx-2; x--;)
-        {
-        temp = *(dnode--);
-        *dnode = (*dnode*temp+*(u--))/6.0;
-        }
-      free(u);
-      dnode--;
+      u = bi->u;
+      piv = bi->piv;
+      dnode[0] = u[0] = 0.0;
+      for (x=1; x<nbx-1; x++)
+        u[x] = piv[x]*(u[x-1] - 6*(node[x+1]+node[x-1]-2*node[x]));
+      dnode[nbx-1] = 0.0;
+      for (x=nbx-2; x>0; x--)
+        dnode[x] = (piv[x]*dnode[x+1]+u[x])/6.0;
       }
     }
   else
     {
 /*-- No interpolation and no new 2nd derivatives needed along y */
-    node = field->back;
-    dnode = field->dback;
+    node = map;
+    dnode = dmap;
     }
 
-/*-- Interpolation along x */
+/* Interpolation along x */
   if (nbx>1)
     {
-    nx = field->backw;
-    xstep = 1.0/nx;
-    changepoint = nx/2;
-    dx  = (xstep - 1)/2;	/* dx of the first pixel in the row */
-    dx0 = ((nx+1)%2)*xstep/2;	/* dx of the 1st pixel right to a bkgnd node */
-    blo = node;
-    bhi = node + 1;
-    dblo = dnode;
-    dbhi = dnode + 1;
-    for (x=i=0,j=width; j--; i++, dx += xstep)
+    dx = bi->dx;
+    cdx = bi->cdx;
+    dx2 = bi->dx2;
+    cdx2 = bi->cdx2;
+    for (x=0; x<nbx-1; x++)
       {
-      if (i==changepoint && x>0 && x<nbxm1)
-        {
-        blo++;
-        bhi++;
-        dblo++;
-        dbhi++;
-        dx = dx0;
-        }
-      cdx = 1 - dx;
-      *(line++) = (PIXTYPE)(cdx*(*blo+(cdx*cdx-1)**dblo)
-			+ dx*(*bhi+(dx*dx-1)**dbhi));
-      if (i==nx)
-        {
-        x++;
-        i = 0;
-        }
+      blo = node[x];
+      bhi = node[x+1];
+      dblo = dnode[x];
+      dbhi = dnode[x+1];
+      jmax = bi->xstart[x+1];
+      for (j=bi->xstart[x]; j<jmax; j++)
+        line[j] = (PIXTYPE)(cdx[j]*(blo+cdx2[j]*dblo)
+			+ dx[j]*(bhi+dx2[j]*dbhi));
       }
     }
   else
-    for (j=width; j--;)
+    for (j=field->width; j--;)
       *(line++) = (PIXTYPE)*node;
 
-  if (nby>1)
-    {
-    free(node);
-    free(dnode);
-    }
-
   return;
   }
 
 
-/******************************* backrmsline ********************************
-PROTO   void backrmsline(fieldstruct *field, int y, PIXTYPE *line)
-PURPOSE Bicubic-spline interpolation of the background noise along the current
-        scanline (y).
-INPUT   Measurement or detection field pointer,
-        Current line position. 
-        Where to put the data. 
-OUTPUT  -.
-NOTES   Most of the code is a copy of subbackline(), for optimization reasons.
-AUTHOR  E. Bertin (IAP & Leiden & ESO)
-VERSION 02/02/98
+/****** init_backinterp *****************************************************
+PROTO	backinterpstruct *init_backinterp(fieldstruct *field)
+PURPOSE	Precompute the map-independent data used for interpolating background
+	lines.
+INPUT	Field pointer.
+OUTPUT	Pointer to the new background interpolation structure.
+NOTES	The structure is attached to the field and freed by end_back().
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
  ***/
-void	backrmsline(fieldstruct *field, int y, PIXTYPE *line)
+static backinterpstruct	*init_backinterp(fieldstruct *field)
 
   {
-   int		i,j,x,yl, nbx,nbxm1,nby, nx,width, ystep, changepoint;
-   float	dx,dx0,dy,dy3, cdx,cdy,cdy3, temp, xstep,
-		*node,*nodep,*dnode, *blo,*bhi,*dblo,*dbhi, *u;
+   backinterpstruct	*bi;
+   int			i,j,k,x, nbx,nbxm1, nx, width, changepoint;
+   float		dx,dx0,cdx, xstep, temp;
 
   nbx = field->nbackx;
   nbxm1 = nbx - 1;
-  nby = field->nbacky;
-  if (nby > 1)
-    {
-    dy = (float)y/field->backh - 0.5;
-    dy -= (yl = (int)dy);
-    if (yl<0)
-      {
-      yl = 0;
-      dy -= 1.0;
-      }
-    else if (yl>=nby-1)
-      {
-      yl = nby<2 ? 0 : nby-2;
-      dy += 1.0;
-      }
-/*-- Interpolation along y for each node */
-    cdy = 1 - dy;
-    dy3 = (dy*dy*dy-dy);
-    cdy3 = (cdy*cdy*cdy-cdy);
-    ystep = nbx*yl;
-    blo = field->sigma + ystep;
-    bhi = blo + nbx;
-    dblo = field->dsigma + ystep;
-    dbhi = dblo + nbx;
-    QMALLOC(node, float, nbx);	/* Interpolated background */
-    nodep = node;
-    for (x=nbx; x--;)
-      *(nodep++) = cdy**(blo++) + dy**(bhi++) + cdy3**(dblo++) + dy3**(dbhi++);
-
-/*-- Computation of 2nd derivatives along x */
-    QMALLOC(dnode, float, nbx);	/* 2nd derivative along x */
-    if (nbx>1)
-      {
-      QMALLOC(u, float, nbxm1);	/* temporary array */
-      *dnode = *u = 0.0;	/* "natural" lower boundary condition */
-      nodep = node+1;
-      for (x=nbxm1; --x; nodep++)
-        {
-        temp = -1/(*(dnode++)+4);
-        *dnode = temp;
-        temp *= *(u++) - 6*(*(nodep+1)+*(nodep-1)-2**nodep);
-        *u = temp;
-        }
-      *(++dnode) = 0.0;	/* "natural" upper boundary condition */
-      for (x=nbx-2; x--;)
-        {
-        temp = *(dnode--);
-        *dnode = (*dnode*temp+*(u--))/6.0;
-        }
-      free(u);
-      dnode--;
-      }
-    }
-  else
+  width = field->width;
+  QCALLOC(bi, backinterpstruct, 1);
+  QMALLOC(bi->node, float, nbx);
+  QMALLOC(bi->dnode, float, nbx);
+  QMALLOC(bi->u, float, nbx);
+  QMALLOC(bi->piv, float, nbx);
+  QCALLOC(bi->xstart, int, nbx+1);
+  QMALLOC(bi->dx, float, width);
+  QMALLOC(bi->cdx, float, width);
+  QMALLOC(bi->dx2, float, width);
+  QMALLOC(bi->cdx2, float, width);
+
+/* Pivots of the tridiagonal system for 2nd derivatives along x */
+  bi->piv[0] = 0.0;
+  for (x=1; x<nbxm1; x++)
     {
-/*-- No interpolation and no new 2nd derivatives needed along y */
-    node = field->sigma;
-    dnode = field->dsigma;
+    temp = -1/(bi->piv[x-1]+4);
+    bi->piv[x] = temp;
     }
 
-/*-- Interpolation along x */
-  width = field->width;
+/* Pixel offsets to the nodes, and first pixel of each node interval */
   if (nbx>1)
     {
     nx = field->backw;
@@ -1110,41 +1517,31 @@ void	backrmsline(fieldstruct *field, int y, PIXTYPE *line)
     changepoint = nx/2;
     dx  = (xstep - 1)/2;	/* dx of the first pixel in the row */
     dx0 = ((nx+1)%2)*xstep/2;	/* dx of the 1st pixel right to a bkgnd node */
-    blo = node;
-    bhi = node + 1;
-    dblo = dnode;
-    dbhi = dnode + 1;
-    for (x=i=0,j=width; j--; i++, dx += xstep)
+    for (x=i=j=k=0; j<width; j++, i++, dx += xstep)
       {
       if (i==changepoint && x>0 && x<nbxm1)
         {
-        blo++;
-        bhi++;
-        dblo++;
-        dbhi++;
+        bi->xstart[++k] = j;
         dx = dx0;
         }
       cdx = 1 - dx;
-      *(line++) = (PIXTYPE)(cdx*(*blo+(cdx*cdx-1)**dblo)
-			+ dx*(*bhi+(dx*dx-1)**dbhi));
+      bi->dx[j] = dx;
+      bi->cdx[j] = cdx;
+      bi->dx2[j] = dx*dx-1;
+      bi->cdx2[j] = cdx*cdx-1;
       if (i==nx)
         {
         x++;
         i = 0;
         }
       }
+    while (++k<nbx)
+      bi->xstart[k] = width;
     }
-  else
-    for (j=width; j--;)
-      *(line++) = (PIXTYPE)*node;
 
-  if (nby>1)
-    {
-    free(node);
-    free(dnode);
-    }
+  field->backinterp = bi;
 
-  return;
+  return bi;
   }
 
 
@@ -1155,11 +1552,27 @@ Terminate background procedures (mainly freeing memory).
 void	end_back(fieldstruct *field)
 
   {
+   backinterpstruct	*bi;
+
   free(field->back);
   free(field->dback);
   free(field->sigma);
   free(field->dsigma);
   free(field->backline);
+  if ((bi=field->backinterp))
+    {
+    free(bi->node);
+    free(bi->dnode);
+    free(bi->u);
+    free(bi->piv);
+    free(bi->xstart);
+    free(bi->dx);
+    free(bi->cdx);
+    free(bi->dx2);
+    free(bi->cdx2);
+    free(bi);
+    field->backinterp = NULL;
+    }
 
   return;
   }
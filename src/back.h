@@ -22,7 +22,7 @@
 *	You should have received a copy of the GNU General Public License
 *	along with SWarp. If not, see <http://www.gnu.org/licenses/>.
 *
-*	Last modified:		26/10/2010
+*	Last modified:		19/10/2026
 *
 *%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
 
@@ -43,6 +43,10 @@ One must have:		BACK_BUFSIZE >= MAXPICSIZE
 			QUANTIF_AMIN > 0
 */
 
+#define	BACKCACHE_MAGIC		"SWBACK01"	/* Background cache signature */
+#define	BACKCACHE_EXT		".back"		/* Background cache extension */
+#define	BACKCACHE_KEYSIZE	(6*MAXCHAR)	/* Max. background cache key size */
+
 /*------------------------------- structures --------------------------------*/
 /* Background info */
 typedef struct structback
@@ -55,13 +59,50 @@ typedef struct structback
   int		npix;			/* Number of pixels involved */
   }	backstruct;
 
+/* Precomputed data for interpolating background lines */
+typedef struct backinterp
+  {
+  float		*node, *dnode;		/* Current nodes and 2nd derivatives */
+  float		*u;			/* Work array for the spline solve */
+  float		*piv;			/* Pivots of the spline solve along x */
+  int		*xstart;		/* First pixel of each node interval */
+  float		*dx, *cdx;		/* Pixel offsets to the nodes */
+  float		*dx2, *cdx2;		/* Squared pixel offsets minus 1 */
+  }	backinterpstruct;
+
+/* Range of meshes processed by a thread */
+typedef struct backmeshes
+  {
+  backstruct	*backmesh, *wbackmesh;	/* First image and weight meshes */
+  PIXTYPE	*buf, *wbuf;		/* First image and weight pixels */
+  size_t	bufsize;		/* Number of pixels in the buffer */
+  int		n;			/* Number of meshes */
+  int		w;			/* Buffer width */
+  int		bw, lastbw;		/* Mesh width, last mesh width */
+  PIXTYPE	wthresh;		/* Weight threshold */
+  int		histoflag;		/* backhisto() instead of backstat()? */
+  }	backmeshesstruct;
+
+/* Background cache file header */
+typedef struct backcachehead
+  {
+  char		magic[8];		/* File signature */
+  char		key[BACKCACHE_KEYSIZE];	/* Inputs and background parameters */
+  int		nback;			/* Number of meshes */
+  int		wflag;			/* Weight-map maps included? */
+  double	backmean, backsig;	/* Background level and RMS */
+  double	sigfac;			/* Weight-map scaling factor */
+  double	var_thresh;		/* Weight-map variance threshold */
+  unsigned int	checksum;		/* Checksum of the maps */
+  }	backcacheheadstruct;
+
 
 /*------------------------------- functions ---------------------------------*/
 extern void	backhisto(backstruct *, backstruct *, PIXTYPE *, PIXTYPE *,
-			size_t, int, int, int, PIXTYPE),
+			size_t, int, int, int, int, PIXTYPE),
 		backline(fieldstruct *, int, PIXTYPE *),
 		backstat(backstruct *, backstruct *, PIXTYPE *, PIXTYPE *,
-			size_t, int, int, int, PIXTYPE),
+			size_t, int, int, int, int, PIXTYPE),
 		backrmsline(fieldstruct *, int, PIXTYPE *),
 		end_back(fieldstruct *),
 		filter_back(fieldstruct *),
@@ -0,0 +1,969 @@
+/*
+*				bench.c
+*
+* Benchmark program for SWarp processing steps.
+*
+*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+*
+*	This file part of:	SWarp
+*
+*	Copyright:		(C) 2026 CEA/AIM/UParisSaclay
+*
+*	License:		GNU General Public License
+*
+*	SWarp is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*	SWarp is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU General Public License for more details.
+*	You should have received a copy of the GNU General Public License
+*	along with SWarp. If not, see <http://www.gnu.org/licenses/>.
+*
+*	Last modified:		19/10/2026
+*
+*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+
+#ifdef HAVE_CONFIG_H
+#include	"config.h"
+#endif
+
+#ifdef HAVE_MATHIMF_H
+#include <mathimf.h>
+#else
+#include <math.h>
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "define.h"
+#include "globals.h"
+#include "fits/fitscat.h"
+#include "back.h"
+#include "coadd.h"
+#include "data.h"
+#include "field.h"
+#include "fitswcs.h"
+#include "interpolate.h"
+#include "key.h"
+#include "misc.h"
+#include "perf.h"
+#include "prefs.h"
+#include "projapprox.h"
+
+#define		BENCH_SYNTAX \
+"swarpbench [-s <size>][-p <bitpix>][-j <TAN|TPV>][-r <rotation>]\n" \
+"           [-a <pixel_scale>][-o <depth>][-w <0|1>][-b <back_size>]\n" \
+"           [-n <max_sampling>][-t <nthreads>][-d <tmp_dir>]\n"
+
+#define		BENCH_SKY	1000.0	/* Synthetic sky level (ADUs) */
+#define		BENCH_NOISE	10.0	/* Synthetic sky noise (ADUs) */
+#define		BENCH_STARDENS	5e-4	/* Synthetic stars per pixel */
+#define		BENCH_SEEING	1.5	/* Synthetic PSF sigma (pixels) */
+#define		BENCH_RA	150.0	/* Synthetic field centre (deg) */
+#define		BENCH_DEC	2.0	/* Synthetic field centre (deg) */
+#define		BENCH_DISTORT	0.01	/* TPV relative distortion at corners */
+#define		BENCH_DITHER	0.1	/* Max. dither (fraction of frame size) */
+#define		BENCH_PROJOFFSET 1.0	/* Output tangent point offset (deg) */
+#define		BENCH_NCOMBINE	12	/* Number of floating-point COMBINE_TYPEs */
+
+static char	*bench_framename[MAXINFIELD],
+		*bench_outname, *bench_outwname, *bench_tmpdir,
+		bench_nthreadstr[16], bench_backsizestr[16];
+static double	bench_rot, bench_scale;
+static int	bench_nframe, bench_tpvflag, bench_weightflag;
+
+static PIXTYPE	*bench_synthpix(int width, int height, unsigned int seed);
+static double	bench_gauss(unsigned int *seed),
+		bench_makeit(char **argkey, char **argval, int narg,
+			perfstatstruct *stat),
+		bench_sky(int x, int y, int w, int h),
+		bench_writefits(char *filename, PIXTYPE *pix, int width,
+			int height, int bitpix, double *crpix);
+static void	bench_back(char *filename, int width, int height,
+			int maxsampling),
+		bench_combine(void),
+		bench_endtoend(int size),
+		bench_interp(char *filename, int width, int height),
+		bench_io(char *filename, int width, int height),
+		bench_proj(char *filename, int width, int height),
+		bench_synth(char *filename, int width, int height, int bitpix,
+			double *crpix, unsigned int seed),
+		bench_synthweight(char *filename, int width, int height,
+			double *crpix, unsigned int seed);
+
+/********************************** main ************************************/
+int	main(int argc, char *argv[])
+  {
+   static char	*argkey[] = {"VERBOSE_TYPE", "WRITE_XML", "NTHREADS"},
+		*argval[] = {"QUIET", "N", bench_nthreadstr};
+   char		filename[MAXCHAR], *str;
+   double	crpix[2];
+   unsigned int	seed;
+   int		a,k, size, bitpix, backsize, maxsampling, nthreads;
+
+  size = 4096;
+  bitpix = BP_FLOAT;
+  backsize = 128;
+  maxsampling = 16;
+  nthreads = 1;
+  bench_nframe = 4;
+  bench_weightflag = 1;
+  bench_tpvflag = 0;
+  bench_rot = 0.0;
+  bench_scale = 0.2;
+  bench_tmpdir = getenv("TMPDIR");
+  if (!bench_tmpdir || !*bench_tmpdir)
+    bench_tmpdir = "/tmp";
+  for (a=1; a<argc; a++)
+    {
+    if (argv[a][0] != '-' || a == argc-1)
+      error(EXIT_SUCCESS, "SYNTAX: ", BENCH_SYNTAX);
+    switch((int)argv[a][1])
+      {
+      case 's':
+        size = atoi(argv[++a]);
+        break;
+      case 'p':
+        bitpix = atoi(argv[++a]);
+        break;
+      case 'j':
+        str = argv[++a];
+        if (!cistrcmp(str, "TPV", FIND_STRICT))
+          bench_tpvflag = 1;
+        else if (!cistrcmp(str, "TAN", FIND_STRICT))
+          bench_tpvflag = 0;
+        else
+          error(EXIT_FAILURE, "*Error*: unsupported projection: ", str);
+        break;
+      case 'r':
+        bench_rot = atof(argv[++a]);
+        break;
+      case 'a':
+        bench_scale = atof(argv[++a]);
+        break;
+      case 'o':
+        bench_nframe = atoi(argv[++a]);
+        break;
+      case 'w':
+        bench_weightflag = atoi(argv[++a]);
+        break;
+      case 'b':
+        backsize = atoi(argv[++a]);
+        break;
+      case 'n':
+        maxsampling = atoi(argv[++a]);
+        break;
+      case 't':
+        nthreads = atoi(argv[++a]);
+        break;
+      case 'd':
+        bench_tmpdir = argv[++a];
+        break;
+      default:
+        error(EXIT_SUCCESS, "SYNTAX: ", BENCH_SYNTAX);
+      }
+    }
+  if (size<16 || backsize<1 || maxsampling<1 || nthreads<0
+	|| bench_nframe<1 || bench_nframe>MAXINFIELD || bench_scale<=0.0
+	|| (bitpix!=BP_BYTE && bitpix!=BP_SHORT && bitpix!=BP_LONG
+		&& bitpix!=BP_FLOAT && bitpix!=BP_DOUBLE))
+    error(EXIT_FAILURE, "*Error*: invalid benchmark parameters", "");
+
+/* Synthetic input frames share the same tangent point, with integer dithers */
+  seed = 1;
+  for (k=0; k<bench_nframe; k++)
+    {
+    sprintf(filename, "%.*s/swarpbench_%ld_%d.fits", MAXCHAR-64, bench_tmpdir,
+		(long)getpid(), k);
+    QMALLOC(bench_framename[k], char, strlen(filename)+1);
+    strcpy(bench_framename[k], filename);
+    prefs.infield_name[k] = bench_framename[k];
+    crpix[0] = (size+1)/2.0;
+    crpix[1] = (size+1)/2.0;
+    if (k)
+      {
+      crpix[0] += (int)(BENCH_DITHER*size*(rand_r(&seed)/(RAND_MAX+1.0)-0.5));
+      crpix[1] += (int)(BENCH_DITHER*size*(rand_r(&seed)/(RAND_MAX+1.0)-0.5));
+      }
+    bench_synth(filename, size, size, bitpix, crpix, k+1);
+    if (bench_weightflag)
+      {
+      sprintf(filename, "%.*s/swarpbench_%ld_%d.weight.fits", MAXCHAR-64,
+		bench_tmpdir, (long)getpid(), k);
+      bench_synthweight(filename, size, size, crpix, k+1);
+      }
+    }
+  sprintf(filename, "%.*s/swarpbench_%ld_coadd.fits", MAXCHAR-64, bench_tmpdir,
+		(long)getpid());
+  QMALLOC(bench_outname, char, strlen(filename)+1);
+  strcpy(bench_outname, filename);
+  sprintf(filename, "%.*s/swarpbench_%ld_coadd.weight.fits", MAXCHAR-64,
+		bench_tmpdir, (long)getpid());
+  QMALLOC(bench_outwname, char, strlen(filename)+1);
+  strcpy(bench_outwname, filename);
+
+/* Use default configuration parameters */
+  sprintf(bench_nthreadstr, "%d", nthreads);
+  sprintf(bench_backsizestr, "%d", backsize);
+  prefs.ninfield = bench_nframe;
+  readprefs("/dev/null", argkey, argval, 3);
+  prefs.back_size[0] = backsize;
+  useprefs();
+
+  printf("%d synthetic %dx%d frame%s (BITPIX = %d, %s, %g\"/pixel, "
+	"rotation = %g deg, %s weights), %d thread%s\n\n",
+	bench_nframe, size, size, bench_nframe>1? "s" : "", bitpix,
+	bench_tpvflag? "TPV" : "TAN", bench_scale, bench_rot,
+	bench_weightflag? "with" : "without", prefs.nthreads,
+	prefs.nthreads>1? "s" : "");
+  sprintf(filename, "%.*s/swarpbench_%ld_io.fits", MAXCHAR-64, bench_tmpdir,
+		(long)getpid());
+  bench_io(filename, size, size);
+  printf("\nBACK_SIZE = %d (noise = %g ADU)\n", backsize, BENCH_NOISE);
+  bench_back(bench_framename[0], size, size, maxsampling);
+  printf("\n");
+  bench_interp(bench_framename[0], size, size);
+  printf("\n");
+  bench_proj(bench_framename[0], size, size);
+  printf("\n");
+  bench_combine();
+  printf("\n");
+  bench_endtoend(size);
+
+/* Remove all temporary files */
+  for (k=0; k<bench_nframe; k++)
+    {
+    remove(bench_framename[k]);
+    if (bench_weightflag)
+      {
+      sprintf(filename, "%.*s/swarpbench_%ld_%d.weight.fits", MAXCHAR-64,
+		bench_tmpdir, (long)getpid(), k);
+      remove(filename);
+      }
+    free(bench_framename[k]);
+    }
+  remove(bench_outname);
+  remove(bench_outwname);
+  free(bench_outname);
+  free(bench_outwname);
+
+  exit(EXIT_SUCCESS);
+  }
+
+
+/****** bench_io *************************************************************
+PROTO	void bench_io(char *filename, int width, int height)
+PURPOSE	Time the conversion of pixel data from and to every supported BITPIX
+	through write_body() and read_body().
+INPUT	Temporary filename,
+	image width,
+	image height.
+OUTPUT	-.
+NOTES	The file is read right after being written, hence it is likely to be
+	served from the page cache: rates mostly reflect conversion costs.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+static void	bench_io(char *filename, int width, int height)
+  {
+   static int	bitpix[] = {BP_BYTE, BP_SHORT, BP_LONG, BP_FLOAT, BP_DOUBLE};
+   catstruct	*cat;
+   tabstruct	*tab;
+   PIXTYPE	*pix, *buf;
+   double	dtw, dtr, npix;
+   size_t	n;
+   int		b;
+
+  n = (size_t)width*height;
+  npix = (double)n;
+  pix = bench_synthpix(width, height, 1);
+  QMALLOC(buf, PIXTYPE, n);
+  printf("BITPIX  write(s)   Mpix/s    MB/s   read(s)   Mpix/s    MB/s\n");
+  for (b=0; b<5; b++)
+    {
+    dtw = bench_writefits(filename, pix, width, height, bitpix[b], NULL);
+    if (!(cat = read_cat(filename)))
+      error(EXIT_FAILURE, "*Error*: cannot read ", filename);
+    tab = cat->tab;
+    QFSEEK(cat->file, tab->bodypos, SEEK_SET, filename);
+    dtr = counter_seconds();
+    read_body(tab, buf, n);
+    dtr = counter_seconds() - dtr;
+    free_cat(&cat, 1);
+    remove(filename);
+    printf("%6d %9.3f %8.1f %7.1f %9.3f %8.1f %7.1f\n",
+	bitpix[b],
+	dtw, npix/1e6/dtw, npix*abs(bitpix[b])/8/1e6/dtw,
+	dtr, npix/1e6/dtr, npix*abs(bitpix[b])/8/1e6/dtr);
+    }
+
+  free(buf);
+  free(pix);
+
+  return;
+  }
+
+
+/****** bench_back ***********************************************************
+PROTO	void bench_back(char *filename, int width, int height,
+			int maxsampling)
+PURPOSE	Time background map estimation at various line sampling steps, and
+	measure its accuracy with respect to the exhaustive estimate and to the
+	true sky.
+INPUT	Synthetic image filename,
+	image width,
+	image height,
+	maximum BACK_SAMPLING value.
+OUTPUT	-.
+NOTES	Errors are computed over all pixels from interpolated background lines,
+	and expressed in units of the pixel noise.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+static void	bench_back(char *filename, int width, int height,
+			int maxsampling)
+  {
+   catstruct	*cat;
+   fieldstruct	*field;
+   PIXTYPE	*exact, *line, *linet, *exactt;
+   double	dt, d, dmax, dsum, tmax, tsum;
+   int		s, x, y;
+
+  if (!(cat = read_cat(filename)))
+    error(EXIT_FAILURE, "*Error*: cannot read ", filename);
+  field = load_field(cat, 0, 0, NULL);
+  free_cat(&cat, 1);
+  if (open_cat(field->cat, READ_ONLY) != RETURN_OK)
+    error(EXIT_FAILURE, "*Error*: cannot open ", filename);
+
+  QMALLOC(exact, PIXTYPE, (size_t)width*height);
+  printf("BACK_SAMPLING     time   Mpix/s   max|exact|  rms|exact|"
+	"    max|sky|    rms|sky|\n");
+  for (s=1; s<=maxsampling; s*=2)
+    {
+    prefs.back_sampling = s;
+    dt = counter_seconds();
+    make_back(field, NULL, 0);
+    dt = counter_seconds() - dt;
+    line = field->backline;
+    dmax = dsum = tmax = tsum = 0.0;
+    for (y=0; y<height; y++)
+      {
+      backline(field, y, line);
+      exactt = exact + (size_t)y*width;
+      if (s==1)
+        memcpy(exactt, line, width*sizeof(PIXTYPE));
+      for (linet=line, x=0; x<width; x++)
+        {
+        d = fabs(*(exactt++) - *linet);
+        dsum += d*d;
+        if (d>dmax)
+          dmax = d;
+        d = fabs(bench_sky(x, y, width, height) - *(linet++));
+        tsum += d*d;
+        if (d>tmax)
+          tmax = d;
+        }
+      }
+    d = (double)width*height;
+    printf("%13d %8.3f %8.1f %11.4f %11.4f %11.4f %11.4f\n",
+	s, dt, d/1e6/dt,
+	dmax/BENCH_NOISE, sqrt(dsum/d)/BENCH_NOISE,
+	tmax/BENCH_NOISE, sqrt(tsum/d)/BENCH_NOISE);
+    }
+
+  free(exact);
+  end_field(field);
+
+  return;
+  }
+
+
+/****** bench_interp *******************************************************
+PROTO	void bench_interp(char *filename, int width, int height)
+PURPOSE	Time pixel interpolation for every floating-point RESAMPLING_TYPE.
+INPUT	Synthetic image filename,
+	image width,
+	image height.
+OUTPUT	-.
+NOTES	One interpolation is done for every input pixel, at a fixed sub-pixel
+	offset.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+static void	bench_interp(char *filename, int width, int height)
+  {
+   static char		*name[] = {"NEAREST", "BILINEAR", "LANCZOS2",
+				"LANCZOS3", "LANCZOS4"};
+   static interpenum	itype[] = {INTERP_NEARESTNEIGHBOUR, INTERP_BILINEAR,
+				INTERP_LANCZOS2, INTERP_LANCZOS3,
+				INTERP_LANCZOS4};
+   catstruct		*cat;
+   fieldstruct		*field;
+   ikernelstruct	*ikernel;
+   interpenum		interptype[2];
+   PIXTYPE		val, wval;
+   double		pos[2], dt, sum;
+   int			i, x, y;
+
+  if (!(cat = read_cat(filename)))
+    error(EXIT_FAILURE, "*Error*: cannot read ", filename);
+  field = load_field(cat, 0, 0, NULL);
+  free_cat(&cat, 1);
+  if (open_cat(field->cat, READ_ONLY) != RETURN_OK)
+    error(EXIT_FAILURE, "*Error*: cannot open ", filename);
+  preload_data(field, NULL);
+
+  printf("RESAMPLING_TYPE     time   Mpix/s\n");
+  sum = 0.0;
+  for (i=0; i<5; i++)
+    {
+    interptype[0] = interptype[1] = itype[i];
+    ikernel = init_ikernel(interptype, 2);
+    dt = counter_seconds();
+    for (y=1; y<=height; y++)
+      for (x=1; x<=width; x++)
+        {
+        pos[0] = x + 0.31;
+        pos[1] = y + 0.67;
+        interpolate_pix(field, NULL, NULL, ikernel, pos, &val, &wval);
+        sum += val;
+        }
+    dt = counter_seconds() - dt;
+    free_ikernel(ikernel);
+    printf("%-15s %8.3f %8.1f\n", name[i], dt, (double)width*height/1e6/dt);
+    }
+
+/* Keep the compiler from discarding interpolated values */
+  if (sum == 0.0)
+    warning("Null interpolated values in ", filename);
+
+  end_field(field);
+
+  return;
+  }
+
+
+/****** bench_proj ***********************************************************
+PROTO	void bench_proj(char *filename, int width, int height)
+PURPOSE	Time exact and approximated reprojections from a north-up ZEA output
+	frame to the synthetic image frame.
+INPUT	Synthetic image filename,
+	image width,
+	image height.
+OUTPUT	-.
+NOTES	The approximation error is measured against the exact reprojection
+	in an extra, untimed, pass. The tangent point of the output frame is
+	BENCH_PROJOFFSET degrees south of the image centre, so that the
+	reprojection is not linear even for undistorted frames.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+static void	bench_proj(char *filename, int width, int height)
+  {
+   static char		*ctype[] = {"RA---ZEA", "DEC--ZEA"};
+   catstruct		*cat;
+   fieldstruct		*field;
+   wcsstruct		*wcs;
+   projappstruct	*projapp;
+   double		crval[2], crpix[2], cdelt[2], startpos[2],
+			*rawpos, *wcspos, *rawout, *appout,
+			dt, dti, dta, d, dx, dy, dmax;
+   int			naxisn[2], x, y;
+
+  if (!(cat = read_cat(filename)))
+    error(EXIT_FAILURE, "*Error*: cannot read ", filename);
+  field = load_field(cat, 0, 0, NULL);
+  free_cat(&cat, 1);
+
+  crval[0] = field->wcs->crval[0];
+  crval[1] = field->wcs->crval[1] - BENCH_PROJOFFSET;
+  cdelt[0] = -bench_scale/3600.0;
+  cdelt[1] = bench_scale/3600.0;
+  crpix[0] = (width+1)/2.0;
+  crpix[1] = (height+1)/2.0 - BENCH_PROJOFFSET/cdelt[1];
+  naxisn[0] = width;
+  naxisn[1] = height;
+  wcs = create_wcs(ctype, crval, crpix, cdelt, naxisn, 2);
+  QMALLOC(rawpos, double, 2*width);
+  QMALLOC(wcspos, double, 2*width);
+  QMALLOC(rawout, double, 2*width);
+  QMALLOC(appout, double, 2*width);
+
+/* Exact reprojection, one line at a time */
+  dt = counter_seconds();
+  for (y=1; y<=height; y++)
+    {
+    for (x=0; x<width; x++)
+      {
+      rawpos[2*x] = x + 1.0;
+      rawpos[2*x+1] = (double)y;
+      }
+    raw_to_wcs_line(wcs, rawpos, wcspos, width);
+    wcs_to_raw_line(field->wcs, wcspos, rawout, width);
+    }
+  dt = counter_seconds() - dt;
+  printf("Reprojection        time   Mpix/s  max.error(pix)\n");
+  printf("exact           %8.3f %8.1f\n", dt, (double)width*height/1e6/dt);
+
+/* Approximated reprojection */
+  dti = counter_seconds();
+  projapp = projapp_init(field->wcs, wcs, prefs.proj_err[0], 0);
+  dti = counter_seconds() - dti;
+  if (projapp)
+    {
+    startpos[0] = 1.0;
+    dta = counter_seconds();
+    for (y=1; y<=height; y++)
+      {
+      startpos[1] = (double)y;
+      projapp_line(projapp, startpos, 1.0, width, appout, NULL);
+      }
+    dta = counter_seconds() - dta;
+/*-- Measure the approximation error */
+    dmax = 0.0;
+    for (y=1; y<=height; y++)
+      {
+      for (x=0; x<width; x++)
+        {
+        rawpos[2*x] = x + 1.0;
+        rawpos[2*x+1] = (double)y;
+        }
+      raw_to_wcs_line(wcs, rawpos, wcspos, width);
+      wcs_to_raw_line(field->wcs, wcspos, rawout, width);
+      startpos[1] = (double)y;
+      projapp_line(projapp, startpos, 1.0, width, appout, NULL);
+      for (x=0; x<2*width; x+=2)
+        {
+        dx = appout[x] - rawout[x];
+        dy = appout[x+1] - rawout[x+1];
+        if ((d = sqrt(dx*dx+dy*dy)) > dmax)
+          dmax = d;
+        }
+      }
+    printf("approx          %8.3f %8.1f %15.6f  (init: %.3f s)\n",
+	dta, (double)width*height/1e6/dta, dmax, dti);
+    projapp_end(projapp);
+    }
+  else
+    printf("approx          (not applicable)\n");
+
+  free(rawpos);
+  free(wcspos);
+  free(rawout);
+  free(appout);
+  end_wcs(wcs);
+  end_field(field);
+
+  return;
+  }
+
+
+/****** bench_combine ********************************************************
+PROTO	void bench_combine(void)
+PURPOSE	Time the co-addition of the synthetic frames for every floating-point
+	COMBINE_TYPE.
+INPUT	-.
+OUTPUT	-.
+NOTES	Frames are co-added without resampling (they share the same tangent
+	point and pixel grid); co-addition rates are given per output pixel and
+	per thread.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+static void	bench_combine(void)
+  {
+   static char		*name[BENCH_NCOMBINE] = {"MEDIAN", "AVERAGE", "MIN",
+				"MAX", "WEIGHTED", "CLIPPED", "CHI_OLD",
+				"CHI-MODE", "CHI-MEAN", "SUM",
+				"WEIGHTED_WEIGHT", "MEDIAN_WEIGHT"};
+   perfstatstruct	stat[PERF_NSTAGE], *line;
+   char			*argkey[] = {"VERBOSE_TYPE", "WRITE_XML", "NTHREADS",
+				"IMAGEOUT_NAME", "WEIGHTOUT_NAME",
+				"WEIGHT_TYPE", "RESAMPLE", "COMBINE_TYPE"},
+			*argval[8];
+   double		dt;
+   int			c;
+
+  argval[0] = "QUIET";
+  argval[1] = "N";
+  argval[2] = bench_nthreadstr;
+  argval[3] = bench_outname;
+  argval[4] = bench_outwname;
+  argval[5] = bench_weightflag? "MAP_WEIGHT" : "NONE";
+  argval[6] = "N";
+  printf("COMBINE_TYPE     total(s)  load(s) coadd(s)   Mpix/s\n");
+  for (c=0; c<BENCH_NCOMBINE; c++)
+    {
+    argval[7] = name[c];
+    dt = bench_makeit(argkey, argval, 8, stat);
+    line = &stat[PERF_COADDLINE];
+    printf("%-15s %9.3f %8.3f %8.3f %8.1f\n",
+	name[c], dt, stat[PERF_COADDLOAD].time, line->time,
+	line->time>0.0? line->npix/1e6/line->time : 0.0);
+    }
+
+  return;
+  }
+
+
+/****** bench_endtoend *******************************************************
+PROTO	void bench_endtoend(int size)
+PURPOSE	Time a complete resampling and co-addition run on the synthetic
+	frames, with a breakdown per processing stage.
+INPUT	Frame size.
+OUTPUT	-.
+NOTES	Stage rates are given per thread.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+static void	bench_endtoend(int size)
+  {
+   perfstatstruct	stat[PERF_NSTAGE], *st;
+   char			*argkey[] = {"VERBOSE_TYPE", "WRITE_XML", "NTHREADS",
+				"IMAGEOUT_NAME", "WEIGHTOUT_NAME", "RESAMPLE_DIR",
+				"WEIGHT_TYPE", "BACK_SIZE"},
+			*argval[8];
+   double		dt;
+   int			s;
+
+  argval[0] = "QUIET";
+  argval[1] = "N";
+  argval[2] = bench_nthreadstr;
+  argval[3] = bench_outname;
+  argval[4] = bench_outwname;
+  argval[5] = bench_tmpdir;
+  argval[6] = bench_weightflag? "MAP_WEIGHT" : "NONE";
+  argval[7] = bench_backsizestr;
+  dt = bench_makeit(argkey, argval, 8, stat);
+  printf("End-to-end       ncalls  time(s)     Mpix   Mpix/s     MB/s"
+	"  peakMB\n");
+  for (s=0; s<PERF_NSTAGE; s++)
+    {
+    st = &stat[s];
+    if (!st->ncall)
+      continue;
+    printf("%-15s %7ld %8.3f %8.1f %8.1f %8.1f %7.1f\n",
+	perf_stagename((perfenum)s), st->ncall, st->time, st->npix/1e6,
+	st->time>0.0? st->npix/1e6/st->time : 0.0,
+	st->time>0.0? st->nbytes/1e6/st->time : 0.0,
+	perf_mempeak((perfenum)s)/1e6);
+    }
+  for (s=0; s<PERF_NCOUNT; s++)
+    printf("%-15s %7ld\n", perf_countname((perfcountenum)s),
+	perf_counter((perfcountenum)s));
+  printf("Total %.3f s (%.1f input Mpix/s)\n",
+	dt, (double)bench_nframe*size*size/1e6/dt);
+
+  return;
+  }
+
+
+/****** bench_makeit *********************************************************
+PROTO	double bench_makeit(char **argkey, char **argval, int narg,
+			perfstatstruct *stat)
+PURPOSE	Run SWarp on the synthetic frames with a given configuration.
+INPUT	Array of configuration keywords,
+	array of configuration values,
+	number of configuration parameters,
+	array of PERF_NSTAGE statistics to be filled in.
+OUTPUT	Total wall-clock time (in s).
+NOTES	Statistics from all threads are summed.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+static double	bench_makeit(char **argkey, char **argval, int narg,
+			perfstatstruct *stat)
+  {
+   perfstatstruct	*tstat;
+   double		dt;
+   int			s, t;
+
+  prefs.ninfield = bench_nframe;
+  readprefs("/dev/null", argkey, argval, narg);
+  useprefs();
+
+  dt = counter_seconds();
+  makeit();
+  dt = counter_seconds() - dt;
+
+/* Credit measurements still pending and sum them over all threads */
+  perf_endinput(-1);
+  memset(stat, 0, PERF_NSTAGE*sizeof(perfstatstruct));
+  for (t=0; t<perf_nslot(); t++)
+    {
+    tstat = perf_threadstat(t);
+    for (s=0; s<PERF_NSTAGE; s++)
+      {
+      stat[s].time += tstat[s].time;
+      stat[s].npix += tstat[s].npix;
+      stat[s].nbytes += tstat[s].nbytes;
+      stat[s].ncall += tstat[s].ncall;
+      }
+    }
+  end_perf();
+
+  return dt;
+  }
+
+
+/****** bench_synth **********************************************************
+PROTO	void bench_synth(char *filename, int width, int height, int bitpix,
+			double *crpix, unsigned int seed)
+PURPOSE	Write a synthetic sky image to a FITS file.
+INPUT	Output filename,
+	image width,
+	image height,
+	FITS BITPIX,
+	WCS reference pixel coordinates (or NULL for no WCS),
+	random seed.
+OUTPUT	-.
+NOTES	See bench_synthpix().
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+static void	bench_synth(char *filename, int width, int height, int bitpix,
+			double *crpix, unsigned int seed)
+  {
+   PIXTYPE	*pix;
+
+  pix = bench_synthpix(width, height, seed);
+  bench_writefits(filename, pix, width, height, bitpix, crpix);
+  free(pix);
+
+  return;
+  }
+
+
+/****** bench_synthweight ****************************************************
+PROTO	void bench_synthweight(char *filename, int width, int height,
+			double *crpix, unsigned int seed)
+PURPOSE	Write a synthetic weight map to a FITS file.
+INPUT	Output filename,
+	image width,
+	image height,
+	WCS reference pixel coordinates (or NULL for no WCS),
+	random seed.
+OUTPUT	-.
+NOTES	The weight map has a smooth vignetting pattern, one bad column and a
+	sprinkling of bad pixels (all with zero weight).
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+static void	bench_synthweight(char *filename, int width, int height,
+			double *crpix, unsigned int seed)
+  {
+   PIXTYPE	*pix, *pixt;
+   double	dx, dy, r2;
+   int		i, n, x, y, xbad;
+
+  QMALLOC(pix, PIXTYPE, (size_t)width*height);
+  r2 = 0.25*((double)width*width + (double)height*height);
+  pixt = pix;
+  for (y=0; y<height; y++)
+    for (x=0; x<width; x++)
+      {
+      dx = x - 0.5*width;
+      dy = y - 0.5*height;
+      *(pixt++) = (PIXTYPE)(1.0/(1.0 + 0.5*(dx*dx+dy*dy)/r2));
+      }
+
+  xbad = rand_r(&seed)%width;
+  for (y=0; y<height; y++)
+    pix[(size_t)y*width+xbad] = 0.0;
+  n = (int)(1e-4*width*height);
+  for (i=0; i<n; i++)
+    pix[(size_t)(rand_r(&seed)%height)*width + rand_r(&seed)%width] = 0.0;
+
+  bench_writefits(filename, pix, width, height, BP_FLOAT, crpix);
+  free(pix);
+
+  return;
+  }
+
+
+/****** bench_synthpix *******************************************************
+PROTO	PIXTYPE *bench_synthpix(int width, int height, unsigned int seed)
+PURPOSE	Generate a synthetic sky image.
+INPUT	Image width,
+	image height,
+	random seed.
+OUTPUT	Pointer to the allocated image.
+NOTES	The image contains a smooth sky (see bench_sky()), Gaussian noise and
+	Gaussian stars with an exponential flux distribution.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+static PIXTYPE	*bench_synthpix(int width, int height, unsigned int seed)
+  {
+   PIXTYPE	*pix, *pixt;
+   double	flux, xc, yc, dx, dy, rmax2;
+   int		i, n, x, y, xmin, xmax, ymin, ymax;
+
+  QMALLOC(pix, PIXTYPE, (size_t)width*height);
+  pixt = pix;
+  for (y=0; y<height; y++)
+    for (x=0; x<width; x++)
+      *(pixt++) = (PIXTYPE)(bench_sky(x, y, width, height)
+			+ BENCH_NOISE*bench_gauss(&seed));
+
+  n = (int)(BENCH_STARDENS*width*height);
+  rmax2 = 25.0*BENCH_SEEING*BENCH_SEEING;
+  for (i=0; i<n; i++)
+    {
+    xc = width*(rand_r(&seed)/(RAND_MAX+1.0));
+    yc = height*(rand_r(&seed)/(RAND_MAX+1.0));
+    flux = -100.0*BENCH_NOISE*log(1.0 - rand_r(&seed)/(RAND_MAX+1.0))
+		/(2.0*PI*BENCH_SEEING*BENCH_SEEING);
+    xmin = (int)(xc-5.0*BENCH_SEEING);
+    xmax = (int)(xc+5.0*BENCH_SEEING);
+    ymin = (int)(yc-5.0*BENCH_SEEING);
+    ymax = (int)(yc+5.0*BENCH_SEEING);
+    for (y=ymin<0?0:ymin; y<=ymax && y<height; y++)
+      for (x=xmin<0?0:xmin; x<=xmax && x<width; x++)
+        {
+        dx = x - xc;
+        dy = y - yc;
+        if (dx*dx+dy*dy < rmax2)
+          pix[(size_t)y*width+x] += (PIXTYPE)(flux
+		*exp(-0.5*(dx*dx+dy*dy)/(BENCH_SEEING*BENCH_SEEING)));
+        }
+    }
+
+  return pix;
+  }
+
+
+/****** bench_writefits ******************************************************
+PROTO	double bench_writefits(char *filename, PIXTYPE *pix, int width,
+			int height, int bitpix, double *crpix)
+PURPOSE	Write an image to a FITS file, with an optional WCS header.
+INPUT	Output filename,
+	pointer to the image,
+	image width,
+	image height,
+	FITS BITPIX,
+	WCS reference pixel coordinates (or NULL for no WCS).
+OUTPUT	Time spent in write_body() (in s).
+NOTES	The WCS is centred on (BENCH_RA, BENCH_DEC) and uses the projection,
+	pixel scale and rotation set on the command line. TPV distortions are
+	cubic and radial, and reach BENCH_DISTORT in relative terms at the
+	frame corners.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+static double	bench_writefits(char *filename, PIXTYPE *pix, int width,
+			int height, int bitpix, double *crpix)
+  {
+   static char	*ctype[] = {"RA---TAN", "DEC--TAN"};
+   catstruct	*cat;
+   tabstruct	*tab;
+   wcsstruct	*wcs;
+   double	crval[2], bscale, scale, rmax, dist, dt;
+   int		d;
+
+  cat = new_cat(1);
+  init_cat(cat);
+  strcpy(cat->filename, filename);
+  tab = cat->tab;
+  tab->cat = cat;
+  tab->bitpix = bitpix;
+  tab->naxis = 2;
+  QMALLOC(tab->naxisn, int, 2);
+  tab->naxisn[0] = width;
+  tab->naxisn[1] = height;
+  update_head(tab);
+/* Keep sky values within the range of bytes */
+  if (bitpix == BP_BYTE)
+    {
+    bscale = 8.0;
+    addkeywordto_head(tab, "BSCALE  ", "True value = BZERO + BSCALE*value");
+    fitswrite(tab->headbuf, "BSCALE  ", &bscale, H_EXPO, T_DOUBLE);
+    }
+  if (crpix)
+    {
+    crval[0] = BENCH_RA;
+    crval[1] = BENCH_DEC;
+    wcs = create_wcs(ctype, crval, crpix, NULL, tab->naxisn, 2);
+    scale = bench_scale/3600.0;
+    wcs->cd[0] = -scale*cos(bench_rot*DEG);
+    wcs->cd[1] = scale*sin(bench_rot*DEG);
+    wcs->cd[2] = scale*sin(bench_rot*DEG);
+    wcs->cd[3] = scale*cos(bench_rot*DEG);
+    for (d=0; d<2; d++)
+      strcpy(wcs->cunit[d], "deg");
+    if (bench_tpvflag)
+      {
+      strcpy(wcs->ctype[0], "RA---TPV");
+      strcpy(wcs->ctype[1], "DEC--TPV");
+      rmax = 0.5*sqrt((double)width*width + (double)height*height)*scale;
+      dist = BENCH_DISTORT/(rmax*rmax);
+/*---- xi += dist*xi*r^2 and eta += dist*eta*r^2 */
+      for (d=0; d<2; d++)
+        {
+        wcs->projp[1+100*d] = 1.0;
+        wcs->projp[7+100*d] = wcs->projp[9+100*d] = dist;
+        }
+      }
+    write_wcs(tab, wcs);
+    end_wcs(wcs);
+    }
+  else
+    readbasic_head(tab);
+
+  if (open_cat(cat, WRITE_ONLY) != RETURN_OK)
+    error(EXIT_FAILURE, "*Error*: cannot open for writing ", filename);
+  QFWRITE(tab->headbuf, tab->headnblock*FBSIZE, cat->file, filename);
+  dt = counter_seconds();
+  write_body(tab, pix, (size_t)width*height);
+  dt = counter_seconds() - dt;
+  pad_tab(cat, tab->tabsize);
+  free_cat(&cat, 1);
+
+  return dt;
+  }
+
+
+/****** bench_sky ************************************************************
+PROTO	double bench_sky(int x, int y, int w, int h)
+PURPOSE	Return the true sky level of the synthetic image at a given position.
+INPUT	x position,
+	y position,
+	image width,
+	image height.
+OUTPUT	Sky level.
+NOTES	The sky has a gradient and a large scale ripple of a few noise rms.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+static double	bench_sky(int x, int y, int w, int h)
+  {
+  return BENCH_SKY + 5.0*BENCH_NOISE*x/w
+	+ 2.0*BENCH_NOISE*sin(2.0*PI*x/w)*cos(3.0*PI*y/h);
+  }
+
+
+/****** bench_gauss **********************************************************
+PROTO	double bench_gauss(unsigned int *seed)
+PURPOSE	Return a normally distributed random number.
+INPUT	Pointer to the random seed.
+OUTPUT	Random number.
+NOTES	Box-Muller method.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+static double	bench_gauss(unsigned int *seed)
+  {
+   double	u1, u2;
+
+  u1 = (rand_r(seed)+1.0)/(RAND_MAX+1.0);
+  u2 = rand_r(seed)/(RAND_MAX+1.0);
+
+  return sqrt(-2.0*log(u1))*cos(2.0*PI*u2);
+  }
+
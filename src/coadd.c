@@ -24,7 +24,7 @@
 *	You should have received a copy of the GNU General Public License
 *	along with SWarp. If not, see <http://www.gnu.org/licenses/>.
 *
-*	Last modified:		21/03/2025
+*	Last modified:		19/10/2026
 *
 *%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
 
@@ -38,6 +38,7 @@
 #include <math.h>
 #endif
 
+#include <fcntl.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -49,22 +50,24 @@
 #include "fits/fitscat.h"
 #include "fitswcs.h"
 #include "coadd.h"
+#include "compact.h"
 #include "data.h"
 #include "field.h"
+#include "footprint.h"
 #include "header.h"
 #include "interpolate.h"
+#include "node.h"
+#include "numa.h"
+#include "perf.h"
 #include "prefs.h"
+#include "state.h"
 #ifdef USE_THREADS
 #include "threads.h"
 #endif
 #include "weight.h"
+#include "writer.h"
 #include "wcs/wcs.h"
 
-#define	ARRAY_BIT(x,y)		(array[(y/(8*sizeof(unsigned int)))*nnode+x]&(1 \
-					<<(y%(8*sizeof(unsigned int)))))
-#define	SET_ARRAY_BIT(x,y)	(array[(y/(8*sizeof(unsigned int)))*ninput+x] \
-					|= (1<<(y%(8*sizeof(unsigned int)))))
-
 #ifdef	HAVE_LGAMMA
 #define	LOGGAMMA	lgamma
 #else
@@ -72,42 +75,53 @@
 static double		gammln(double xx);
 #endif
 
- coaddenum	coadd_type;
- double	*coadd_bias;
- FLAGTYPE	*multiibuf,*multiwibuf, *outibuf,*outwibuf; 
- PIXTYPE	*multibuf,*multiwbuf, *outbuf,*outwbuf,
-		coadd_wthresh, *coadd_pixstack, *coadd_pixfstack;
- unsigned int	*multinbuf,*multiobuf;
- int		coadd_nomax, coadd_width, iflag;
-  FILE		*cliplog;
- fieldstruct	**infields;
-
-#ifdef USE_THREADS
- pthread_t		*thread,
-			movthread;
- pthread_mutex_t	coaddmutex;
- threads_gate_t		*pthread_startgate, *pthread_stopgate,
-			*pthread_startgate2, *pthread_stopgate2;
- FLAGTYPE		*pthread_lineibuf, *pthread_multiibuf;
- PIXTYPE		*pthread_linebuf, *pthread_multibuf;
- unsigned int		*pthread_multinbuf, *pthread_multiobuf,
-			*pthread_baseline_y, *pthread_origin;
- int			pthread_bufline, pthread_nbuflines, pthread_npix,
-			pthread_step, pthread_endflag, pthread_wdataflag;
-#endif
-
 /*------------------------------ function -----------------------------------*/
- static int	coadd_iline(int l),
-		coadd_line(int l, int b, int *bufmin);
+ static int	coadd_frame(coaddstruct *coadd, fieldstruct **infield,
+			fieldstruct **inwfield, int ninput,
+			fieldstruct *outfield, fieldstruct *outwfield,
+			coaddenum coaddtype, PIXTYPE wthresh),
+		coadd_iline(coaddstruct *coadd, int l),
+		coadd_line(coaddstruct *coadd, int l, int b, int *bufmin);
+
+ static coaddindexstruct	*init_coaddindex(int *ybegbufline, int ninput);
 
  static double	*chi_bias(int n);
+ static int	coadd_evictinput(coaddindexstruct *index,
+			fieldstruct **infield, fieldstruct **inwfield,
+			unsigned int *cflag, int n),
+		coaddindex_cmp(const void *p1, const void *p2),
+		int_cmp(const void *p1, const void *p2);
+ static void	coadd_ireadline(fieldstruct *field,
+			footprintstruct *footprint, int y, FLAGTYPE *line),
+		coadd_prefetch(fieldstruct *field, int ybeg, int ybuf,
+			int nbuflines),
+		coadd_readline(fieldstruct *field,
+			footprintstruct *footprint, int y, PIXTYPE *line),
+		end_coaddindex(coaddindexstruct *index),
+		prefetch_coaddindex(coaddindexstruct *index,
+			fieldstruct **infield, fieldstruct **inwfield,
+			unsigned int *cflag, int ybuf, int nbuflines),
+		prune_coaddindex(coaddindexstruct *index, unsigned int *cflag),
+		update_coaddindex(coaddindexstruct *index, int ybufmax);
+ static void	coadd_mefpos(coaddmefstruct *mef, int rank,
+			fieldstruct *outfield, fieldstruct *outwfield,
+			int wonlyflag),
+		skytile_filename(char *filename, char *reffilename, int *tpos);
+ static int	skytile_coadd(skytilesstruct *tiles, skytilestruct *tile,
+			int slot),
+		skytile_concurrent(fieldstruct **infield,
+			fieldstruct **inwfield, int ninput);
+ static fieldstruct	*skytile_view(fieldstruct *field);
+ static void	skytile_endview(fieldstruct *view);
  static PIXTYPE	fast_median(PIXTYPE *arr, int n);
- static int	coadd_iload(fieldstruct *field, fieldstruct *wfield,
+ static int	coadd_iload(coaddstruct *coadd,
+			fieldstruct *field, fieldstruct *wfield,
 			FLAGTYPE *multibuf, FLAGTYPE *multiwibuf,
 			unsigned int *multinbuf,
 			int *rawpos, int *rawmin, int *rawmax,
 			int nlines, int outwidth, int multinmax),
-		coadd_load(fieldstruct *field, fieldstruct *wfield,
+		coadd_load(coaddstruct *coadd,
+			fieldstruct *field, fieldstruct *wfield,
 			PIXTYPE *multibuf, unsigned int *multiobuf,
 			PIXTYPE *multiwbuf,
 			unsigned int *multinbuf,
@@ -119,7 +133,11 @@ static void	max_clique_recur(unsigned int *array, int nnode, int *old,
 
 #ifdef USE_THREADS
  static void	*pthread_coadd_lines(void *arg),
-		*pthread_move_lines(void *arg);
+		*pthread_move_lines(void *arg),
+		*pthread_skytiles(void *arg);
+ static int	coadd_nextline(coaddstruct *coadd, int node);
+ static void	coadd_splitlines(coaddstruct *coadd, int nbuflines),
+		coadd_touchlines(coaddstruct *coadd, int t);
 #endif
 
 #ifdef HAVE_CFITSIO
@@ -282,25 +300,72 @@ INPUT	Input field ptr array,
 	Output weight field ptr,
 	Coaddition type.
 OUTPUT	RETURN_OK if no error, or RETURN_ERROR in case of non-fatal error(s).
-NOTES   -.
+NOTES   In weight-only mode (RESAMPLE_WEIGHTONLY), input images are not read
+	and only the output weight-map is written.
 AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
-VERSION	21/03/2025
+VERSION	19/10/2026
  ***/
 int coadd_fields(fieldstruct **infield, fieldstruct **inwfield, int ninput,
 			fieldstruct *outfield, fieldstruct *outwfield,
 			coaddenum coaddtype, PIXTYPE wthresh)
 
   {
+   coaddstruct	coadd;
+
+  memset(&coadd, 0, sizeof(coaddstruct));
+  coadd.bufsize = (size_t)prefs.coaddbuf_size*1024*1024;
+  coadd.nopenfiles_max = prefs.nopenfiles_max;
+  coadd.nthreads = prefs.nthreads;
+  coadd.perfslot = PERF_MAIN;
+
+  return coadd_frame(&coadd, infield, inwfield, ninput, outfield, outwfield,
+	coaddtype, wthresh);
+  }
+
+
+/******* coadd_frame **********************************************************
+PROTO	int coadd_frame(coaddstruct *coadd, fieldstruct **infield,
+			fieldstruct **inwfield, int ninput,
+			fieldstruct *outfield, fieldstruct *outwfield,
+			coaddenum coaddtype, PIXTYPE wthresh)
+PURPOSE	Coadd images within a given co-addition context.
+INPUT	Pointer to the co-addition context,
+	Input field ptr array,
+	Input weight field ptr array,
+	number of input fields,
+	Output field ptr,
+	Output weight field ptr,
+	Coaddition type.
+OUTPUT	RETURN_OK if no error, or RETURN_ERROR in case of non-fatal error(s).
+NOTES   The context must provide the buffer size, the maximum number of open
+	files and the number of co-addition threads. With 0 threads, lines are
+	co-added by the calling thread: this is how several frames can be
+	co-added concurrently by pool tasks. Concurrent co-additions
+	(coadd->concflag set) must not share input fields, are kept quiet,
+	and leave the accounting of statistics to the caller.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+static int	coadd_frame(coaddstruct *coadd, fieldstruct **infield,
+			fieldstruct **inwfield, int ninput,
+			fieldstruct *outfield, fieldstruct *outwfield,
+			coaddenum coaddtype, PIXTYPE wthresh)
+
+  {
 #ifdef USE_THREADS
-   static pthread_attr_t	pthread_attr;
-   int				*proc,
-				p;
+   pthread_attr_t		pthread_attr;
+   threads_job_t		*job;
+   coaddtaskstruct		*task;
+   int				p;
 #endif
    wcsstruct		*wcs;
+   coaddindexstruct	*index;
+   statestruct		*state;
+   writerstruct		*writer, *wwriter;
    FLAGTYPE		*emptyibuf,*outiline, *ipix,*wipix;
    PIXTYPE		*emptybuf,*outline, *pix,*wpix;
-   double		exptime, w,w1,w2, mw, satlev;
-   size_t		multiwidth;
+   double		exptime, w,w1,w2, mw, satlev, t0;
+   size_t		multiwidth, linesize, bufsize, ramleft;
    unsigned int		*cflag,*array,
 			d, n, n1,n2, flag;
    int			bufmin[NAXIS], bufmax[NAXIS], bufpos[NAXIS],
@@ -311,24 +376,47 @@ int coadd_fields(fieldstruct **infield, fieldstruct **inwfield, int ninput,
 			outwidth, width, height,min,max,
 			naxis, nlines, nlinesmax,
 			nbuflines,nbuflines2,nbuflinesmax, omax,omax2,
-			offbeg, offend, fieldno, nopenfiles, closeflag;
+			offbeg, offend, fieldno, nopenfiles, nneeded,
+			nclosed, reopenflag,
+			nodeflag, zmin, zmax, ystart, yend, a;
+
+  coadd->iflag = outfield->bitpix>0;
+/* Only weights are read and written in weight-only mode */
+  coadd->wonlyflag = (!coadd->iflag
+	&& prefs.resamp_wonly != RESAMPWEIGHT_NONE);
 
 #ifdef HAVE_CFITSIO
   // CFITSIO set up tile compressed output images (if specified by user)
-  setupTileCompressedFile(outfield, 0);
+  if (!coadd->wonlyflag)
+    setupTileCompressedFile(outfield, 0);
   setupTileCompressedFile(outwfield, 1);
 #endif // HAVE_CFITSIO
 
-  coadd_type = coaddtype;
-  coadd_wthresh = wthresh;
+  coadd->type = coaddtype;
+  coadd->wthresh = wthresh;
   naxis = outfield->tab->naxis;
-  iflag = outfield->bitpix>0;
 
 /* The output width is the useful length of the NAXIS1 axis */
   width = outfield->width;
 /* The output ``height'' is the product of all other axis lengths */
   height = outfield->height;
 
+/* With distributed co-additions, only a strip of the output is processed */
+  ystart = 0;
+  yend = height;
+  zmin = zmax = 0;
+  if ((nodeflag = NODE_ACTIVE && naxis>1))
+    {
+    node_strip(outfield, &zmin, &zmax);
+    ystart = (zmin-1)*(height/outfield->wcs->naxisn[naxis-1]);
+    yend = zmax*(height/outfield->wcs->naxisn[naxis-1]);
+    }
+
+/* Load the co-addition state (incremental co-additions only) */
+  state = prefs.state_type==STATE_NONE? NULL
+	: init_state(prefs.state_name, outfield, coaddtype,
+		prefs.state_type==STATE_REMOVE);
+
 /* Find global extrema of mapped image */
   for (d=0; d<naxis; d++)
     {
@@ -349,6 +437,21 @@ int coadd_fields(fieldstruct **infield, fieldstruct **inwfield, int ninput,
     rawmax[d] = outfield->wcs->naxisn[d];
     bufmin[d] = min>0 ? (min<rawmax[d] ? min : rawmax[d]) : 1;
     bufmax[d] = max>0 ? (max<rawmax[d] ? max : rawmax[d]) : 1;
+/*-- Previous inputs may cover the whole output frame */
+    if (state)
+      {
+      bufmin[d] = 1;
+      bufmax[d] = rawmax[d];
+      }
+/*-- Restrict the buffer to the strip processed by the current node */
+    if (nodeflag && d==naxis-1)
+      {
+      rawpos[d] = zmin;
+      if (bufmin[d] < zmin)
+        bufmin[d] = zmin;
+      if (bufmax[d] > zmax)
+        bufmax[d] = zmax;
+      }
     }
 
   QMALLOC(ybegbufline, int, ninput);
@@ -368,6 +471,8 @@ int coadd_fields(fieldstruct **infield, fieldstruct **inwfield, int ninput,
     ybegbufline[n] = nbuflines;
     yendbufline[n] = nbuflines2;
     }
+/* Index input footprints to find quickly those overlapping a buffer */
+  index = init_coaddindex(ybegbufline, ninput);
 
 /* Empty pixels at the beginning of each line */
   offbeg = bufmin[0]-1;
@@ -375,14 +480,14 @@ int coadd_fields(fieldstruct **infield, fieldstruct **inwfield, int ninput,
 /* Empty pixels at the end of each line */
   offend = outfield->wcs->naxisn[0] - bufmax[0];
 
-  coadd_width = outwidth = outfield->wcs->naxisn[0] - offend - offbeg;
+  coadd->width = outwidth = outfield->wcs->naxisn[0] - offend - offbeg;
 
 /* Build a graph of overlaps */
   QCALLOC(array, unsigned int,
 	ninput*(1+(ninput-1)/(8*sizeof(unsigned int))));
   for (n1=0; n1<ninput; n1++)
     {
-    SET_ARRAY_BIT(n1,n1);
+    SET_ARRAY_BIT(array,ninput,n1,n1);
     wcs = infield[n1]->wcs;
     for (d=0; d<naxis; d++)
       {
@@ -401,8 +506,8 @@ int coadd_fields(fieldstruct **infield, fieldstruct **inwfield, int ninput,
           }
       if (flag)
         {
-        SET_ARRAY_BIT(n1,n2);
-	SET_ARRAY_BIT(n2,n1);
+        SET_ARRAY_BIT(array,ninput,n1,n2);
+	SET_ARRAY_BIT(array,ninput,n2,n1);
         }
       }
     }
@@ -442,7 +547,7 @@ int coadd_fields(fieldstruct **infield, fieldstruct **inwfield, int ninput,
 
 /* Compute biases for CHI and centered CHI combine types */
   if (coaddtype == COADD_CHI_MODE || coaddtype == COADD_CHI_MEAN)
-    coadd_bias = chi_bias(omax2);
+    coadd->bias = chi_bias(omax2);
 
 /* Approximation to the final equivalent gain */
   outfield->fgain = 0.0;
@@ -464,7 +569,7 @@ int coadd_fields(fieldstruct **infield, fieldstruct **inwfield, int ninput,
     if (w2 > 0.0)
       outfield->fgain = w1*w1/w2/omax2;
     }
-  else
+  else if (omax2)
     outfield->fgain = mw/omax2;
 
   outfield->gain = outfield->fgain;	/* "true" gain = effective gain */
@@ -472,64 +577,94 @@ int coadd_fields(fieldstruct **infield, fieldstruct **inwfield, int ninput,
 /* Compute output saturation level (the minimum on all saturation) */
   satlev = BIG;
   for (n=0; n<ninput; n++)
-    {
-    infield[n]->fsaturation = (prefs.subback_flag[n]
-		&& infield[n]->fsaturation > infield[n]->fbackmean)?
-			(infield[n]->fsaturation - infield[n]->fbackmean)
-		: infield[n]->fsaturation;
     if (infield[n]->fsaturation < satlev)
       satlev = infield[n]->fsaturation;
-    }
   outfield->saturation = outfield->fsaturation = satlev;
 
+/* Output metadata must account for all the inputs in the state */
+  if (state)
+    {
+    update_state(state, infield, ninput, outfield);
+    omax2 = outfield->fieldno;
+    }
+
 /* Add relevant information to output FITS headers */
-  writefitsinfo_outfield(outfield, *infield);
-  writefitsinfo_outfield(outwfield, inwfield? *inwfield : *infield);
+#ifdef USE_THREADS
+  if (coadd->lock)
+    QPTHREAD_MUTEX_LOCK(coadd->lock);
+#endif
+  writefitsinfo_outfield(outfield, ninput? *infield : NULL);
+  writefitsinfo_outfield(outwfield, !ninput? NULL
+				: (inwfield? *inwfield : *infield));
+/* Only for WRITING the weights */
+  outwfield->sigfac = (double)1.0;	/* A possible scaling among others */
+  set_weightconv(outwfield);
+#ifdef USE_THREADS
+  if (coadd->lock)
+    QPTHREAD_MUTEX_UNLOCK(coadd->lock);
+#endif
 
-  *gstr = '\0';
-  QPRINTF(OUTPUT, "-------------- Co-adding frames            \n");
-  QPRINTF(OUTPUT, "Maximum overlap density: %d frame%s\n",
+  if (!coadd->concflag)
+    {
+    *gstr = '\0';
+    QPRINTF(OUTPUT, "-------------- Co-adding frames            \n");
+    QPRINTF(OUTPUT, "Maximum overlap density: %d frame%s\n",
 	omax2, omax2>1? "s" : "");
+    }
 
-  coadd_nomax = omax;
+  coadd->nomax = omax;
   multiwidth = (size_t)outwidth*omax;
-  nbuflinesmax = (int)(((size_t)prefs.coaddbuf_size*1024*1024)
-	/ ((2*multiwidth+3*outwidth+2*coadd_nomax)*sizeof(PIXTYPE)));
+  linesize = (2*multiwidth+3*outwidth+2*coadd->nomax)*sizeof(PIXTYPE);
+  if (state)
+    linesize += (size_t)outwidth*(2*sizeof(double)+sizeof(unsigned int));
+/* Co-addition buffers are part of the MEM_MAX budget */
+  bufsize = coadd->bufsize;
+  if (bufsize > (ramleft = get_ramleft(0)))
+    {
+    if (!coadd->concflag)
+      {
+      sprintf(gstr, "%d MB", (int)(ramleft/(1024*1024)));
+      warning("Co-addition buffer reduced to fit within MEM_MAX: ", gstr);
+      }
+    bufsize = ramleft;
+    }
+  nbuflinesmax = (int)(bufsize / linesize);
   if (nbuflinesmax < 1)
     nbuflinesmax = 1;
   else if (nbuflinesmax>height)
     nbuflinesmax = height;
 #ifdef USE_THREADS
-/* Number of active threads */
-  nproc = prefs.nthreads;
 /* Make sure that the number of multibuffer lines is a multiple of the */
 /* number of processes */
-  nbuflinesmax += (nproc - (nbuflinesmax%nproc))%nproc;
+  if (coadd->nthreads)
+    nbuflinesmax += (coadd->nthreads - (nbuflinesmax%coadd->nthreads))
+		%coadd->nthreads;
 #endif
 
 /* Allocate memory for the "multi-buffers" storing "packed" pixels from all */
 /* images for the current line(s), prior to co-addition */
-  if (iflag)
+  if (coadd->iflag)
     {
-    QMALLOC(multiibuf, FLAGTYPE, nbuflinesmax*multiwidth);
-    QMALLOC(multiwibuf, FLAGTYPE, nbuflinesmax*multiwidth);
+    QNUMA_MALLOC(coadd->multiibuf, FLAGTYPE, nbuflinesmax*multiwidth);
+    QNUMA_MALLOC(coadd->multiwibuf, FLAGTYPE, nbuflinesmax*multiwidth);
     }
   else
     {
-    QMALLOC(multibuf, PIXTYPE, nbuflinesmax*multiwidth);
-    QMALLOC(multiobuf, unsigned int, nbuflinesmax*multiwidth);
-    if (coadd_type==COADD_CLIPPED && prefs.clip_logflag)
+    QNUMA_MALLOC(coadd->multibuf, PIXTYPE, nbuflinesmax*multiwidth);
+    QNUMA_MALLOC(coadd->multiobuf, unsigned int, nbuflinesmax*multiwidth);
+    if (coadd->type==COADD_CLIPPED && prefs.clip_logflag && !coadd->cliplog)
       {
     /* Open clipping log for mode COADD_CLIPPED */
-      if(!(cliplog = fopen(prefs.clip_logname,"w")))
+      if(!(coadd->cliplog = fopen(prefs.clip_logname,"w")))
         error(EXIT_FAILURE, "*Error*: cannot open for writing ",
 		prefs.clip_logname);
+      coadd->clipownflag = 1;
       }
-    QMALLOC(multiwbuf, PIXTYPE, nbuflinesmax*multiwidth);
+    QNUMA_MALLOC(coadd->multiwbuf, PIXTYPE, nbuflinesmax*multiwidth);
     }
-  QMALLOC(multinbuf, unsigned int, nbuflinesmax*(size_t)outwidth);
+  QMALLOC(coadd->multinbuf, unsigned int, nbuflinesmax*(size_t)outwidth);
 /* Allocate memory for the output buffers that contain "empty data" */
-  if (iflag)
+  if (coadd->iflag)
     {
     QCALLOC(emptyibuf, FLAGTYPE, width);
     QCALLOC(outiline, FLAGTYPE, width);
@@ -541,75 +676,147 @@ int coadd_fields(fieldstruct **infield, fieldstruct **inwfield, int ninput,
     }
 /* Allocate memory for the output buffers that contain the final data in */
 /* internal format (PIXTYPE or FLAGTYPE) */
-  if (iflag)
+  if (coadd->iflag)
     {
-    QMALLOC(outibuf, FLAGTYPE, nbuflinesmax*(size_t)outwidth);
-    QMALLOC(outwibuf, FLAGTYPE, nbuflinesmax*(size_t)outwidth);
+    QMALLOC(coadd->outibuf, FLAGTYPE, nbuflinesmax*(size_t)outwidth);
+    QMALLOC(coadd->outwibuf, FLAGTYPE, nbuflinesmax*(size_t)outwidth);
     }
   else
     {
-    QMALLOC(outbuf, PIXTYPE, nbuflinesmax*(size_t)outwidth);
-    QMALLOC(outwbuf, PIXTYPE, nbuflinesmax*(size_t)outwidth);
-    QMALLOC(coadd_pixstack, PIXTYPE, nbuflinesmax*(size_t)coadd_nomax);
-    QMALLOC(coadd_pixfstack, PIXTYPE, nbuflinesmax*(size_t)coadd_nomax);
+    QMALLOC(coadd->outbuf, PIXTYPE, nbuflinesmax*(size_t)outwidth);
+    QMALLOC(coadd->outwbuf, PIXTYPE, nbuflinesmax*(size_t)outwidth);
+    QMALLOC(coadd->pixstack, PIXTYPE, nbuflinesmax*(size_t)coadd->nomax);
+    QMALLOC(coadd->pixfstack, PIXTYPE, nbuflinesmax*(size_t)coadd->nomax);
+    }
+  if (state)
+    {
+    QMALLOC(coadd->sumbuf, double, nbuflinesmax*(size_t)outwidth);
+    QMALLOC(coadd->sumwbuf, double, nbuflinesmax*(size_t)outwidth);
+    QMALLOC(coadd->nsumbuf, unsigned int, nbuflinesmax*(size_t)outwidth);
     }
   QCALLOC(cflag, unsigned int, ninput);
+  bufsize = (size_t)nbuflinesmax*linesize;
+  reserve_ram(bufsize, 0, 1);
 
 /* Open output file and save header */
-  if (open_cat(outfield->cat, WRITE_ONLY) != RETURN_OK)
-      error(EXIT_FAILURE, "*Error*: cannot open for writing ",
+/* Checksums are computed while writing (this may increase header sizes) */
+  if (prefs.checksum_flag)
+    {
+    if (!coadd->wonlyflag)
+      start_bodysum(outfield->tab,
+	(OFF_T2)ystart*width*outfield->tab->bytepix);
+    start_bodysum(outwfield->tab,
+	(OFF_T2)ystart*width*outwfield->tab->bytepix);
+    }
+  if (nodeflag)
+    {
+/*-- Output files are shared among nodes: the first node writes headers */
+    if (!coadd->wonlyflag)
+      {
+      node_openfile(outfield);
+      if (!prefs.node_index)
+        QFWRITE(outfield->tab->headbuf, outfield->tab->headnblock*FBSIZE,
+		outfield->cat->file, outfield->filename);
+      QFSEEK(outfield->cat->file, (OFF_T2)outfield->tab->headnblock*FBSIZE
+	+ (OFF_T2)ystart*width*outfield->tab->bytepix,
+	SEEK_SET, outfield->filename);
+      }
+    node_openfile(outwfield);
+    if (!prefs.node_index)
+      QFWRITE(outwfield->tab->headbuf, outwfield->tab->headnblock*FBSIZE,
+	outwfield->cat->file, outwfield->filename);
+    QFSEEK(outwfield->cat->file, (OFF_T2)outwfield->tab->headnblock*FBSIZE
+	+ (OFF_T2)ystart*width*outwfield->tab->bytepix,
+	SEEK_SET, outwfield->filename);
+    }
+  else
+    {
+/*-- Extensions of MEF outputs are written in place */
+    if (coadd->mef)
+      coadd_mefpos(coadd->mef, coadd->mefrank, outfield, outwfield,
+	coadd->wonlyflag);
+    if (!coadd->wonlyflag)
+      {
+      if (open_cat(outfield->cat, WRITE_ONLY) != RETURN_OK)
+        error(EXIT_FAILURE, "*Error*: cannot open for writing ",
 		outfield->filename);
-  QFWRITE(outfield->tab->headbuf, outfield->tab->headnblock*FBSIZE,
+      QFTELL(outfield->cat->file, outfield->tab->headpos, outfield->filename);
+      QFWRITE(outfield->tab->headbuf, outfield->tab->headnblock*FBSIZE,
 	outfield->cat->file, outfield->filename);
+      }
 
-/* Open output weight file and save header */
-  outwfield->sigfac = (double)1.0;	/* A possible scaling among others */
-  if (open_cat(outwfield->cat, WRITE_ONLY) != RETURN_OK)
-    error(EXIT_FAILURE, "*Error*: cannot open for writing ",
+/*-- Open output weight file and save header */
+    if (open_cat(outwfield->cat, WRITE_ONLY) != RETURN_OK)
+      error(EXIT_FAILURE, "*Error*: cannot open for writing ",
 		outwfield->filename);
-  QFWRITE(outwfield->tab->headbuf, outwfield->tab->headnblock*FBSIZE,
+    QFTELL(outwfield->cat->file, outwfield->tab->headpos, outwfield->filename);
+    QFWRITE(outwfield->tab->headbuf, outwfield->tab->headnblock*FBSIZE,
 	outwfield->cat->file, outwfield->filename);
+    }
 
-/* Only for WRITING the weights */
-  set_weightconv(outwfield);
-  
-  infields = infield; // global pointer so coadd_line can access it easily
+/* Output bodies are written asynchronously */
+  writer = coadd->wonlyflag? NULL : init_writer(outfield->tab, coadd->iflag);
+  wwriter = init_writer(outwfield->tab, coadd->iflag);
+
+  coadd->infield = infield; // so that coadd_line can access it easily
 
 /* Start all threads! */
 #ifdef USE_THREADS
 /* Set up multi-threading stuff */
-  QPTHREAD_MUTEX_INIT(&coaddmutex, NULL);
+  QPTHREAD_MUTEX_INIT(&coadd->mutex, NULL);
   QPTHREAD_ATTR_INIT(&pthread_attr);
   QPTHREAD_ATTR_SETDETACHSTATE(&pthread_attr, PTHREAD_CREATE_JOINABLE);
-  pthread_startgate = threads_gate_init(nproc+1, NULL);
-  pthread_stopgate = threads_gate_init(nproc+1, NULL);
-  pthread_startgate2 = threads_gate_init(2, NULL);
-  pthread_stopgate2 = threads_gate_init(2, NULL);
-  QMALLOC(proc, int, nproc);
-  QMALLOC(thread, pthread_t, nproc);
-  pthread_bufline = pthread_nbuflines = nbuflinesmax;
-  pthread_endflag = 0;
-/* Start the co-addition threads */
-  for (p=0; p<nproc; p++)
-    {
-    proc[p] = p;
-    QPTHREAD_CREATE(&thread[p], &pthread_attr, &pthread_coadd_lines, &bufmin);
+  coadd->startgate2 = threads_gate_init(2, NULL);
+  coadd->stopgate2 = threads_gate_init(2, NULL);
+  coadd->endflag = 0;
+  job = NULL;
+  task = NULL;
+/* Without co-addition threads, lines are co-added by the calling thread */
+  if (coadd->nthreads)
+    {
+    coadd->startgate = threads_gate_init(coadd->nthreads+1, NULL);
+    coadd->stopgate = threads_gate_init(coadd->nthreads+1, NULL);
+    QMALLOC(task, coaddtaskstruct, coadd->nthreads);
+    coadd->nnode = numa_nnode();
+    coadd->nbuflinesmax = nbuflinesmax;
+    coadd_splitlines(coadd, 0);
+    coadd->bufmin = bufmin;
+/*-- With several NUMA nodes, buffer lines are first touched by their users */
+    if (coadd->nnode>1)
+      coadd->numagate = threads_gate_init(coadd->nthreads+1, NULL);
+/*-- Start the co-addition tasks (one per pool worker) */
+    job = threads_job_init(threads_pool);
+    for (p=0; p<coadd->nthreads; p++)
+      {
+      task[p].coadd = coadd;
+      task[p].p = p;
+      threads_job_add(job, &pthread_coadd_lines, &task[p]);
+      }
+    if (coadd->nnode>1)
+      threads_gate_sync(coadd->numagate);
     }
 /* Start the data mover thread */
-  QPTHREAD_CREATE(&movthread, &pthread_attr, &pthread_move_lines, &p);
+  QPTHREAD_CREATE(&coadd->movthread, &pthread_attr, &pthread_move_lines,
+	coadd);
 #endif
 
   nopenfiles = 0;
 
 /* Loop over output ``lines'': this can be over more than 1 (Y) dimension */
   ybufmax = 0;
-  for (y=0; y<height; y+=nlines)
+  for (y=ystart; y<yend; y+=nlines)
     {
-    NPRINTF(OUTPUT, "\33[1M> Preparing line:%7d / %-7d\n\33[1A", y+1, height);
+/*-- Co-addition and writing statistics are not related to any input */
+    if (!coadd->concflag)
+      {
+      perf_endinput(-1);
+      NPRINTF(OUTPUT, "\33[1M> Preparing line:%7d / %-7d\n\33[1A",
+	y+1, height);
+      }
 /*-- Skip empty lines */
     for (d=naxis; --d;)
       rawpos2[d] = rawpos[d];
-    nlinesmax = height-y;
+    nlinesmax = yend-y;
     for (nbuflines=nlines=0; nbuflines<nbuflinesmax && nlines<nlinesmax;
 		nlines++)
       {
@@ -630,23 +837,43 @@ int coadd_fields(fieldstruct **infield, fieldstruct **inwfield, int ninput,
     ybufmax = ybuf+nbuflines;
     if (multiwidth)
 /*---- Initialize output data line */
-      memset(multinbuf, 0, (size_t)outwidth*nbuflines*sizeof(unsigned int));
+      memset(coadd->multinbuf, 0,
+	(size_t)outwidth*nbuflines*sizeof(unsigned int));
+/*-- Focus on images that begin before the current buffer ends */
+    update_coaddindex(index, ybufmax);
+/*-- Request all the data of the first buffer at once */
+    if (y==ystart)
+      prefetch_coaddindex(index, coadd->wonlyflag? NULL : infield, inwfield,
+	cflag, ybuf, nbuflines);
 /*-- Examine the batch of input images for the current output image section */
-    NPRINTF(OUTPUT, "\33[1M> Reading   line:%7d / %-7d\n\33[1A", y+1,height);
-    for (n=0; n<ninput; n++)
+    if (!coadd->concflag)
+      NPRINTF(OUTPUT, "\33[1M> Reading   line:%7d / %-7d (depth:%5d)\n\33[1A",
+	y+1,height, index->nactive);
+    for (a=0; a<index->nactive; a++)
       {
-/*---- Focus on images that begin before the current buffer ends */
-      if ((cflag[n] & COADDFLAG_FINISHED) || ybegbufline[n] >= ybufmax)
+      n = index->active[a];
+      if (cflag[n] & COADDFLAG_FINISHED)
         continue;
       wcs = infield[n]->wcs;
 /*---- Discard images entirely below the current lower limit */
       if (yendbufline[n] < ybuf)
         {
         cflag[n] |= COADDFLAG_FINISHED;
+/*------ Release the file handles of images we are done with */
+        if (infield[n]->cat->file)
+          {
+          close_cat(infield[n]->cat);
+          nopenfiles--;
+          }
+        if (inwfield[n] && inwfield[n]->cat->file)
+          {
+          close_cat(inwfield[n]->cat);
+          nopenfiles--;
+          }
         continue;
         }
 /*---- Open images if needed */
-      if (!(cflag[n] & COADDFLAG_OPEN))
+      if (!(reopenflag = cflag[n] & COADDFLAG_OPEN))
 	{
         cflag[n] |= COADDFLAG_OPEN;
         dy = ybegbufline[n] - ybuf;
@@ -660,112 +887,147 @@ int coadd_fields(fieldstruct **infield, fieldstruct **inwfield, int ninput,
         nbuflines2 = nbuflines;
       nbuflines2 -= dy;
 
+/*---- Make room in the pool of file handles if needed */
+      nneeded = ((coadd->wonlyflag || infield[n]->cat->file)? 0 : 1)
+		+ ((inwfield[n] && !inwfield[n]->cat->file)? 1 : 0);
+      while (coadd->nopenfiles_max && nneeded
+		&& nopenfiles + nneeded > coadd->nopenfiles_max
+		&& (nclosed=coadd_evictinput(index, infield, inwfield, cflag, n)))
+        nopenfiles -= nclosed;
 /*---- (re-)Open images if needed */
-      if ((closeflag = !infield[n]->cat->file))
+      if (!coadd->wonlyflag && !infield[n]->cat->file)
         {
         if (open_cat(infield[n]->cat, READ_ONLY) != RETURN_OK)
           error(EXIT_FAILURE,"*Error*: cannot open for reading ",
 		infield[n]->filename);
         nopenfiles++;
+        perf_count(reopenflag? PERF_FILEREOPEN : PERF_FILEOPEN, 1);
         }
-      if (inwfield[n] && (closeflag = !inwfield[n]->cat->file))
+      if (inwfield[n] && !inwfield[n]->cat->file)
         {
         if (open_cat(inwfield[n]->cat, READ_ONLY) != RETURN_OK)
           error(EXIT_FAILURE,"*Error*: cannot open for reading ",
 		inwfield[n]->filename);
         nopenfiles++;
+        perf_count(reopenflag? PERF_FILEREOPEN : PERF_FILEOPEN, 1);
         }
 /*---- Refill the buffers with new data */
-      if ((iflag && coadd_iload(infield[n], inwfield[n],
-			multiibuf+dy*multiwidth, multiwibuf+dy*multiwidth,
-			multinbuf+dy*(size_t)outwidth,
+      t0 = perf_start();
+      if ((coadd->iflag && coadd_iload(coadd, infield[n], inwfield[n],
+			coadd->multiibuf+dy*multiwidth,
+			coadd->multiwibuf+dy*multiwidth,
+			coadd->multinbuf+dy*(size_t)outwidth,
 			bufpos, bufmin, bufmax, nbuflines2, outwidth, omax)
 		!= RETURN_OK)
-	|| ((!iflag)&&coadd_load(infield[n], inwfield[n],
-			multibuf+dy*multiwidth, multiobuf+dy*multiwidth,
-			multiwbuf+dy*multiwidth,
-			multinbuf+dy*(size_t)outwidth,
+	|| ((!coadd->iflag)&&coadd_load(coadd, infield[n], inwfield[n],
+			coadd->multibuf+dy*multiwidth,
+			coadd->multiobuf+dy*multiwidth,
+			coadd->multiwbuf+dy*multiwidth,
+			coadd->multinbuf+dy*(size_t)outwidth,
 			bufpos, bufmin, bufmax, nbuflines2, outwidth, omax, n)
 		!= RETURN_OK))
 /*---- End of the image, we can close the file */
         {
-        close_cat(infield[n]->cat);
-        nopenfiles--;
-        if (inwfield[n])
+        if (infield[n]->cat->file)
           {
+          close_cat(infield[n]->cat);
           nopenfiles--;
-          close_cat(inwfield[n]->cat);
           }
-        cflag[n] ^= COADDFLAG_OPEN;
-        cflag[n] |= COADDFLAG_FINISHED;
-        }
-      if (prefs.nopenfiles_max && nopenfiles >= prefs.nopenfiles_max)
-        {
-        if (close_cat(infield[n]->cat) != RETURN_OK)
-          error(EXIT_FAILURE,"*Error*: cannot close ", infield[n]->filename);
-        nopenfiles--;
         if (inwfield[n])
           {
-          if (close_cat(inwfield[n]->cat) != RETURN_OK)
-            error(EXIT_FAILURE,"*Error*: cannot close ", inwfield[n]->filename);
           nopenfiles--;
+          close_cat(inwfield[n]->cat);
           }
+        cflag[n] ^= COADDFLAG_OPEN;
+        cflag[n] |= COADDFLAG_FINISHED;
         }
-
+      perf_add(PERF_COADDLOAD, coadd->perfslot, t0,
+		(double)nbuflines2*infield[n]->width,
+		(double)nbuflines2*infield[n]->width*((coadd->wonlyflag? 0
+			: infield[n]->tab->bytepix)
+		+ (inwfield[n]? inwfield[n]->tab->bytepix : 0)));
+      if (!coadd->concflag)
+        perf_endinput(infield[n]->inputno);
       }
 
-    NPRINTF(OUTPUT, "\33[1M> Co-adding line:%7d / %-7d\n\33[1A", y+1,height);
+    prune_coaddindex(index, cflag);
+
+/*-- Read ahead the data of the next buffer while co-adding this one */
+    prefetch_coaddindex(index, coadd->wonlyflag? NULL : infield, inwfield,
+	cflag, ybufmax, nbuflinesmax);
+
+    if (!coadd->concflag)
+      NPRINTF(OUTPUT, "\33[1M> Co-adding line:%7d / %-7d\n\33[1A",
+	y+1,height);
 /*-- Now perform the coaddition itself */
 #ifdef USE_THREADS
-    QPTHREAD_MUTEX_LOCK(&coaddmutex);
-    pthread_bufline = 0;
-    pthread_nbuflines = nbuflines;
-    QPTHREAD_MUTEX_UNLOCK(&coaddmutex);
-    pthread_baseline_y = &y;
-    threads_gate_sync(pthread_startgate);
+    if (coadd->nthreads)
+      {
+      QPTHREAD_MUTEX_LOCK(&coadd->mutex);
+      coadd_splitlines(coadd, nbuflines);
+      QPTHREAD_MUTEX_UNLOCK(&coadd->mutex);
+      coadd->baseline_y = &y;
+      threads_gate_sync(coadd->startgate);
 /* ( Slave threads process the current buffer data here ) */
-    threads_gate_sync(pthread_stopgate);
-#else
-    if (iflag)
-      for (y2=0; y2<nbuflines; y2++)
-        coadd_iline(y2);
+      threads_gate_sync(coadd->stopgate);
+      }
     else
-      for (y2=0; y2<nbuflines; y2++)
-        coadd_line(y2, y, bufmin);
 #endif
-    NPRINTF(OUTPUT, "\33[1M> Writing   line:%7d / %-7d\n\33[1A", y+1,height);
-/*-- Write the image buffer lines */
-    if (iflag)
-      ipix = outibuf;
+      {
+      t0 = perf_start();
+      if (coadd->iflag)
+        for (y2=0; y2<nbuflines; y2++)
+          coadd_iline(coadd, y2);
+      else
+        for (y2=0; y2<nbuflines; y2++)
+          coadd_line(coadd, y2, y, bufmin);
+      perf_add(PERF_COADDLINE, coadd->nthreads? 1 : coadd->perfslot, t0,
+		(double)nbuflines*outwidth, 0.0);
+      }
+/*-- Merge with the previous state */
+    if (state)
+      for (y2=0; y2<nbuflines; y2++)
+        merge_state(state, ybuf+y2, coadd->sumbuf+y2*(size_t)outwidth,
+		coadd->sumwbuf+y2*(size_t)outwidth,
+		coadd->nsumbuf+y2*(size_t)outwidth,
+		coadd->outbuf+y2*(size_t)outwidth,
+		coadd->outwbuf+y2*(size_t)outwidth);
+    if (!coadd->concflag)
+      NPRINTF(OUTPUT, "\33[1M> Writing   line:%7d / %-7d\n\33[1A",
+	y+1,height);
+/*-- Write the image buffer lines (not in weight-only mode) */
+    t0 = perf_start();
+    if (coadd->iflag)
+      ipix = coadd->outibuf;
     else
-      pix = outbuf;
+      pix = coadd->outbuf;
     for (d=naxis; --d;)
       rawpos2[d] = rawpos[d];
-    for (y2=nlines; y2--;)
+    for (y2=coadd->wonlyflag? 0 : nlines; y2--;)
       {
 /*---- Skip empty lines */
       for (d=naxis; --d;)
         if (rawpos2[d]<bufmin[d] || rawpos2[d]>bufmax[d])
           break;
-      if (iflag)
+      if (coadd->iflag)
         {
         if (d>0)
-          write_ibody(outfield->tab, emptyibuf, width);
+          writer_line(writer, emptyibuf, width);
         else
           {
           memcpy(outiline+offbeg, ipix, outwidth*sizeof(FLAGTYPE));
-          write_ibody(outfield->tab, outiline, width);
+          writer_line(writer, outiline, width);
           ipix += outwidth;
           }
         }
       else
         {
         if (d>0)
-          write_body(outfield->tab, emptybuf, width);
+          writer_line(writer, emptybuf, width);
         else
           {
           memcpy(outline+offbeg, pix, outwidth*sizeof(PIXTYPE));
-          write_body(outfield->tab, outline, width);
+          writer_line(writer, outline, width);
           pix += outwidth;
           }
 	}
@@ -777,10 +1039,10 @@ int coadd_fields(fieldstruct **infield, fieldstruct **inwfield, int ninput,
           rawpos2[d] = 1;
       }
 
-    if (iflag)
-      wipix = outwibuf;
+    if (coadd->iflag)
+      wipix = coadd->outwibuf;
     else
-      wpix = outwbuf;
+      wpix = coadd->outwbuf;
 /*-- The weight buffer lines */
     for (y2=nlines; y2--;)
       {
@@ -788,26 +1050,26 @@ int coadd_fields(fieldstruct **infield, fieldstruct **inwfield, int ninput,
       for (d=naxis; --d;)
         if (rawpos[d]<bufmin[d] || rawpos[d]>bufmax[d])
           break;
-      if (iflag)
+      if (coadd->iflag)
         {
         if (d>0)
-          write_ibody(outwfield->tab, emptyibuf, width);
+          writer_line(wwriter, emptyibuf, width);
         else
           {
           memcpy(outiline+offbeg, wipix, outwidth*sizeof(PIXTYPE));
-          write_ibody(outwfield->tab, outiline, width);
+          writer_line(wwriter, outiline, width);
           wipix += outwidth;
           }
         }
       else
         {
         if (d>0)
-          write_body(outwfield->tab, emptybuf, width);
+          writer_line(wwriter, emptybuf, width);
         else
           {
           var_to_weight(wpix, outwidth);
           memcpy(outline+offbeg, wpix, outwidth*sizeof(PIXTYPE));
-          write_body(outwfield->tab, outline, width);
+          writer_line(wwriter, outline, width);
           wpix += outwidth;
           }
         }
@@ -818,47 +1080,87 @@ int coadd_fields(fieldstruct **infield, fieldstruct **inwfield, int ninput,
         else
           rawpos[d] = 1;
       }
+    perf_add(PERF_WRITE, coadd->perfslot, t0,
+	(coadd->wonlyflag? 1.0 : 2.0)*nlines*width,
+	(double)nlines*width*((coadd->wonlyflag? 0 : outfield->tab->bytepix)
+		+ outwfield->tab->bytepix));
     }
 
+/* Flush pending writes */
+  if (writer)
+    end_writer(writer);
+  end_writer(wwriter);
 
-/* FITS padding*/
-  pad_tab(outfield->cat, outfield->tab->tabsize);
-  pad_tab(outwfield->cat, outwfield->tab->tabsize);
+/* FITS padding (done by the last node in distributed mode) */
+  if (!nodeflag || prefs.node_index == prefs.nnodes-1)
+    {
+    if (!coadd->wonlyflag)
+      pad_tab(outfield->cat, outfield->tab->tabsize);
+    pad_tab(outwfield->cat, outwfield->tab->tabsize);
+    }
 
 /* Close files */
   close_cat(outfield->cat);
   close_cat(outwfield->cat);
+  if (nodeflag)
+    node_merge(outfield, outwfield);
+  else
+    {
+    if (end_bodysum(outfield->tab) != RETURN_OK)
+      warning("Cannot write checksum in ", outfield->filename);
+    if (end_bodysum(outwfield->tab) != RETURN_OK)
+      warning("Cannot write checksum in ", outwfield->filename);
+    }
   for (n = 0; n<ninput; n++)
     {
     close_cat(infield[n]->cat);
     if (inwfield[n])
       close_cat(inwfield[n]->cat);
     }
-  if (coadd_type == COADD_CLIPPED && prefs.clip_logflag)
-    fclose(cliplog);
+  if (coadd->clipownflag)
+    {
+    fclose(coadd->cliplog);
+    coadd->cliplog = NULL;
+    coadd->clipownflag = 0;
+    }
+  if (state)
+    {
+    end_state(state);
+    free(coadd->sumbuf);
+    free(coadd->sumwbuf);
+    free(coadd->nsumbuf);
+    coadd->sumbuf = coadd->sumwbuf = NULL;
+    coadd->nsumbuf = NULL;
+    }
   
 
 #ifdef USE_THREADS
-  pthread_endflag = 1;
+  coadd->endflag = 1;
 /* (Re-)activate existing threads... */
-  threads_gate_sync(pthread_startgate);
-  threads_gate_sync(pthread_startgate2);
+  if (coadd->nthreads)
+    threads_gate_sync(coadd->startgate);
+  threads_gate_sync(coadd->startgate2);
 /* ... and shutdown all threads */
-  for (p=0; p<nproc; p++)
-    QPTHREAD_JOIN(thread[p], NULL);
-  QPTHREAD_JOIN(movthread, NULL);
-  threads_gate_end(pthread_startgate);
-  threads_gate_end(pthread_stopgate);
-  threads_gate_end(pthread_startgate2);
-  threads_gate_end(pthread_stopgate2);
-  QPTHREAD_MUTEX_DESTROY(&coaddmutex);
+  QPTHREAD_JOIN(coadd->movthread, NULL);
+  threads_gate_end(coadd->startgate2);
+  threads_gate_end(coadd->stopgate2);
+  if (coadd->nthreads)
+    {
+    threads_job_end(job);
+    threads_gate_end(coadd->startgate);
+    threads_gate_end(coadd->stopgate);
+    if (coadd->nnode>1)
+      threads_gate_end(coadd->numagate);
+    free(task);
+    }
+  QPTHREAD_MUTEX_DESTROY(&coadd->mutex);
   QPTHREAD_ATTR_DESTROY(&pthread_attr);
-  free(proc);
-  free(thread);
 #endif
+  if (!coadd->concflag)
+    perf_endinput(-1);
 
 /* Free Buffers */
-  if (iflag)
+  if (coadd->iflag)
     {
     free(emptyibuf);
     free(outiline);
@@ -867,42 +1169,592 @@ int coadd_fields(fieldstruct **infield, fieldstruct **inwfield, int ninput,
     {
     free(emptybuf);
     free(outline);
-    free(coadd_pixstack);
-    free(coadd_pixfstack);
+    free(coadd->pixstack);
+    free(coadd->pixfstack);
     }
-  free(coadd_bias);
+  free(coadd->bias);
+  coadd->bias = NULL;
   free(cflag);
+  end_coaddindex(index);
   free(ybegbufline);
   free(yendbufline);
   if (outwidth)
     {
-    if (iflag)
-      {
-      free(multiibuf);
-      free(multiwibuf);
-      free(outibuf);
-      free(outwibuf);
-      }
-    else
-      {
-      free(multibuf);
-      free(multiobuf);
-      free(multiwbuf);
-      free(outbuf);
-      free(outwbuf);
-      }
-    free(multinbuf);
+    if (coadd->iflag)
+      {
+      numa_free(coadd->multiibuf, nbuflinesmax*multiwidth*sizeof(FLAGTYPE));
+      numa_free(coadd->multiwibuf, nbuflinesmax*multiwidth*sizeof(FLAGTYPE));
+      free(coadd->outibuf);
+      free(coadd->outwibuf);
+      }
+    else
+      {
+      numa_free(coadd->multibuf, nbuflinesmax*multiwidth*sizeof(PIXTYPE));
+      numa_free(coadd->multiobuf,
+		nbuflinesmax*multiwidth*sizeof(unsigned int));
+      numa_free(coadd->multiwbuf, nbuflinesmax*multiwidth*sizeof(PIXTYPE));
+      free(coadd->outbuf);
+      free(coadd->outwbuf);
+      }
+    free(coadd->multinbuf);
+    }
+  release_ram(bufsize, 0);
+
+#ifdef HAVE_CFITSIO
+  // CFITSIO close tile compressed files
+  if (prefs.tile_compress_flag) {
+
+	  if (!coadd->wonlyflag)
+		  closeTileCompressedFile(outfield);
+	  closeTileCompressedFile(outwfield);
+  }
+#endif // HAVE_CFITSIO
+  return RETURN_OK;
+  }
+
+
+/******* coadd_skytiles ******************************************************
+PROTO	int coadd_skytiles(fieldstruct **infield, fieldstruct **inwfield,
+			int ninput,
+			fieldstruct *outfield, fieldstruct *outwfield,
+			coaddenum coaddtype, PIXTYPE wthresh)
+PURPOSE	Split the output frame into sky tiles and coadd each tile separately.
+INPUT	Input field ptr array,
+	Input weight field ptr array,
+	number of input fields,
+	Output field ptr,
+	Output weight field ptr,
+	Coaddition type.
+OUTPUT	RETURN_OK if no error, or RETURN_ERROR in case of non-fatal error(s).
+NOTES   Tiles are written either as individual files, or as extensions of
+	a single MEF file, depending on prefs.skytile_type. Only the inputs
+	that overlap a tile are read for that tile. With at least as many
+	non-empty tiles as threads, tiles are co-added concurrently by pool
+	tasks, each within its share of the co-addition buffer. Otherwise
+	tiles are co-added one after the other, with multithreaded lines.
+	MEF extensions are always written in tile order.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+int coadd_skytiles(fieldstruct **infield, fieldstruct **inwfield, int ninput,
+			fieldstruct *outfield, fieldstruct *outwfield,
+			coaddenum coaddtype, PIXTYPE wthresh)
+
+  {
+#ifdef USE_THREADS
+   threads_job_t	*job;
+#endif
+   skytilesstruct	tiles;
+   skytilestruct	*tile;
+   fieldstruct		**tinfield, **tinwfield;
+   catstruct		*cat;
+   wcsstruct		*wcs;
+   int			tilesize[2], ntile[2], tpos[2],
+			d, n, t, nt, min, max, mefflag, wonlyflag, nrank;
+
+  mefflag = (prefs.skytile_type == SKYTILE_MEF);
+/* No science image is written in weight-only mode */
+  wonlyflag = (outfield->bitpix<0 && prefs.resamp_wonly != RESAMPWEIGHT_NONE);
+  for (d=0; d<2; d++)
+    {
+    tilesize[d] = (d<outfield->wcs->naxis) ? outfield->wcs->naxisn[d] : 1;
+    if (prefs.skytile_size[d] && prefs.skytile_size[d]<tilesize[d])
+      tilesize[d] = prefs.skytile_size[d];
+    ntile[d] = (d<outfield->wcs->naxis) ?
+	(outfield->wcs->naxisn[d] + tilesize[d] - 1) / tilesize[d] : 1;
+    }
+  QPRINTF(OUTPUT, "Sky tiling: %d x %d tile%s of %d x %d pixels\n",
+	ntile[0], ntile[1], ntile[0]*ntile[1]>1? "s" : "",
+	tilesize[0], tilesize[1]);
+
+  memset(&tiles, 0, sizeof(skytilesstruct));
+  tiles.outfield = outfield;
+  tiles.outwfield = outwfield;
+  tiles.coaddtype = coaddtype;
+  tiles.wthresh = wthresh;
+  tiles.exptime = outfield->exptime;
+  tiles.fieldno = outfield->fieldno;
+  tiles.status = RETURN_OK;
+
+/* Write the (empty) primary headers of MEF files */
+  if (mefflag)
+    {
+    cat = new_cat(1);
+    init_cat(cat);
+/*-- Primary HDUs have no data: their checksums depend on the header alone */
+    if (prefs.checksum_flag)
+      {
+      start_bodysum(cat->tab, 0);
+      update_checksum(cat->tab->headbuf, cat->tab->headnblock, 0);
+      }
+    if (!wonlyflag)
+      {
+      strcpy(cat->filename, outfield->filename);
+      if (open_cat(cat, WRITE_ONLY) != RETURN_OK)
+        error(EXIT_FAILURE, "*Error*: cannot open for writing ",
+		cat->filename);
+      QFWRITE(cat->tab->headbuf, cat->tab->headnblock*FBSIZE, cat->file,
+	cat->filename);
+      close_cat(cat);
+      }
+    strcpy(cat->filename, outwfield->filename);
+    if (open_cat(cat, WRITE_ONLY) != RETURN_OK)
+      error(EXIT_FAILURE, "*Error*: cannot open for writing ",
+		cat->filename);
+    QFWRITE(cat->tab->headbuf, cat->tab->headnblock*FBSIZE, cat->file,
+	cat->filename);
+/*-- Extensions follow the primary HDU */
+    tiles.mef.pos = tiles.mef.wpos = (OFF_T2)cat->tab->headnblock*FBSIZE;
+    free_cat(&cat, 1);
+    }
+
+/* Select the inputs whose footprint overlaps each tile */
+  QMALLOC(tinfield, fieldstruct *, ninput);
+  QMALLOC(tinwfield, fieldstruct *, ninput);
+  tiles.ntile = ntile[0]*ntile[1];
+  QCALLOC(tiles.tile, skytilestruct, tiles.ntile);
+  tile = tiles.tile;
+  nrank = 0;
+  for (tpos[1]=0; tpos[1]<ntile[1]; tpos[1]++)
+    for (tpos[0]=0; tpos[0]<ntile[0]; tpos[0]++, tile++)
+      {
+      for (d=0; d<2; d++)
+        {
+        tile->tpos[d] = tpos[d];
+        tile->tilemin[d] = tpos[d]*tilesize[d] + 1;
+        tile->tilesize[d] = tilesize[d];
+        if (d<outfield->wcs->naxis
+		&& tile->tilemin[d]+tile->tilesize[d]-1
+			> outfield->wcs->naxisn[d])
+          tile->tilesize[d] = outfield->wcs->naxisn[d] - tile->tilemin[d] + 1;
+        }
+      nt = 0;
+      for (n=0; n<ninput; n++)
+        {
+        wcs = infield[n]->wcs;
+        for (d=0; d<2 && d<wcs->naxis; d++)
+          {
+          min = (int)floor(outfield->wcs->crpix[d]-wcs->crpix[d] + 1.0);
+          max = min + wcs->naxisn[d] - 1;
+          if (max < tile->tilemin[d]
+		|| min > tile->tilemin[d]+tile->tilesize[d]-1)
+            break;
+          }
+        if (d<2 && d<wcs->naxis)
+          continue;
+        tinfield[nt] = infield[n];
+        tinwfield[nt++] = inwfield[n];
+        }
+      if ((tile->ninput = nt))
+        {
+        QMEMCPY(tinfield, tile->infield, fieldstruct *, nt);
+        QMEMCPY(tinwfield, tile->inwfield, fieldstruct *, nt);
+        }
+/*---- Extensions are ranked in the MEF files by tile order */
+      tile->mefrank = nt? nrank++ : -1;
+      }
+  free(tinfield);
+  free(tinwfield);
+
+/* All tiles share the same clipping log */
+  if (coaddtype==COADD_CLIPPED && prefs.clip_logflag && outfield->bitpix<0
+	&& !(tiles.cliplog = fopen(prefs.clip_logname,"w")))
+    error(EXIT_FAILURE, "*Error*: cannot open for writing ",
+		prefs.clip_logname);
+
+  tiles.nconc = 1;
+#ifdef USE_THREADS
+  QPTHREAD_MUTEX_INIT(&tiles.mutex, NULL);
+  QPTHREAD_MUTEX_INIT(&tiles.mef.mutex, NULL);
+  QPTHREAD_COND_INIT(&tiles.mef.cond, NULL);
+  if (threads_pool && prefs.nthreads>1 && nrank>=prefs.nthreads
+	&& skytile_concurrent(infield, inwfield, ninput))
+    tiles.nconc = prefs.nthreads;
+  if (tiles.nconc>1)
+    {
+/*-- One tile runner per pool worker */
+    job = threads_job_init(threads_pool);
+    for (t=0; t<tiles.nconc; t++)
+      threads_job_add(job, &pthread_skytiles, &tiles);
+    threads_job_end(job);
+/*-- Co-addition statistics are not related to any input */
+    perf_endinput(-1);
+    }
+  else
+#endif
+    for (t=0; t<tiles.ntile; t++)
+      if (skytile_coadd(&tiles, &tiles.tile[t], PERF_MAIN) != RETURN_OK)
+        tiles.status = RETURN_ERROR;
+
+#ifdef USE_THREADS
+  QPTHREAD_MUTEX_DESTROY(&tiles.mutex);
+  QPTHREAD_MUTEX_DESTROY(&tiles.mef.mutex);
+  QPTHREAD_COND_DESTROY(&tiles.mef.cond);
+#endif
+  if (tiles.cliplog)
+    fclose(tiles.cliplog);
+/* Propagate a few output meta-data to the parent field */
+  outfield->exptime = tiles.exptime;
+  outfield->fieldno = tiles.fieldno;
+  for (t=0; t<tiles.ntile; t++)
+    {
+    free(tiles.tile[t].infield);
+    free(tiles.tile[t].inwfield);
+    }
+  free(tiles.tile);
+
+  return tiles.status;
+  }
+
+
+/****i* skytile_coadd *********************************************************
+PROTO	int skytile_coadd(skytilesstruct *tiles, skytilestruct *tile, int slot)
+PURPOSE	Co-add a sky tile.
+INPUT	Pointer to the sky tiling,
+	pointer to the tile,
+	performance slot of the calling thread.
+OUTPUT	RETURN_OK if no error, or RETURN_ERROR in case of non-fatal error(s).
+NOTES   Concurrent tiles (tiles->nconc>1) are co-added by the calling thread
+	from private views of the input fields. Output field set-up and
+	clean-up are serialized.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+static int	skytile_coadd(skytilesstruct *tiles, skytilestruct *tile,
+			int slot)
+  {
+   coaddstruct		coadd;
+   fieldstruct		**infield, **inwfield,
+			*outfield, *tilefield, *tilewfield;
+   char			filename[MAXCHAR], wfilename[MAXCHAR],
+			extname[32];
+   int			n, mefflag, wonlyflag, status;
+
+  outfield = tiles->outfield;
+  mefflag = (prefs.skytile_type == SKYTILE_MEF);
+  wonlyflag = (outfield->bitpix<0 && prefs.resamp_wonly != RESAMPWEIGHT_NONE);
+#ifdef USE_THREADS
+  QPTHREAD_MUTEX_LOCK(&tiles->mutex);
+#endif
+  NFPRINTF(OUTPUT, "");
+  QPRINTF(OUTPUT, "-------------- Sky tile %d,%d: %d input%s\n",
+	tile->tpos[0]+1, tile->tpos[1]+1, tile->ninput,
+	tile->ninput>1? "s" : "");
+  if (!tile->ninput)
+    {
+#ifdef USE_THREADS
+    QPTHREAD_MUTEX_UNLOCK(&tiles->mutex);
+#endif
+    return RETURN_OK;
+    }
+/* Build tile filenames */
+  if (mefflag)
+    {
+    strcpy(filename, outfield->filename);
+    strcpy(wfilename, tiles->outwfield->filename);
+    }
+  else
+    {
+    skytile_filename(filename, outfield->filename, tile->tpos);
+    skytile_filename(wfilename, tiles->outwfield->filename, tile->tpos);
+    }
+  tilefield = init_tilefield(outfield, filename, tile->tilemin,
+	tile->tilesize);
+  if (mefflag)
+    {
+    ext_head(tilefield->tab);
+    sprintf(extname, "TILE_%03d_%03d", tile->tpos[0]+1, tile->tpos[1]+1);
+    addkeywordto_head(tilefield->tab, "EXTNAME ", "Sky tile name");
+    fitswrite(tilefield->tab->headbuf, "EXTNAME ", extname, H_STRING,
+	T_STRING);
+    }
+  tilewfield = init_weight(wfilename, tilefield);
+/* Extensions are written in place in the MEF files */
+  if (mefflag)
+    {
+    if (!wonlyflag)
+      {
+      if (!(tilefield->cat->file = fopen(filename, "r+b")))
+        error(EXIT_FAILURE, "*Error*: cannot open for writing ", filename);
+      tilefield->cat->access_type = WRITE_ONLY;
+      }
+    if (!(tilewfield->cat->file = fopen(wfilename, "r+b")))
+      error(EXIT_FAILURE, "*Error*: cannot open for writing ", wfilename);
+    tilewfield->cat->access_type = WRITE_ONLY;
+    }
+  infield = tile->infield;
+  inwfield = tile->inwfield;
+/* Concurrent tiles may share inputs: each tile reads through its own views */
+  if (tiles->nconc>1)
+    {
+    QMALLOC(infield, fieldstruct *, tile->ninput);
+    QMALLOC(inwfield, fieldstruct *, tile->ninput);
+    for (n=0; n<tile->ninput; n++)
+      {
+      infield[n] = skytile_view(tile->infield[n]);
+      inwfield[n] = tile->inwfield[n]? skytile_view(tile->inwfield[n]) : NULL;
+      }
+    }
+#ifdef USE_THREADS
+  QPTHREAD_MUTEX_UNLOCK(&tiles->mutex);
+#endif
+
+/* Concurrent tiles share the co-addition buffer and the file handles */
+  memset(&coadd, 0, sizeof(coaddstruct));
+  coadd.bufsize = (size_t)prefs.coaddbuf_size*1024*1024/tiles->nconc;
+  coadd.nopenfiles_max = prefs.nopenfiles_max/tiles->nconc;
+  if (prefs.nopenfiles_max && coadd.nopenfiles_max<2)
+    coadd.nopenfiles_max = 2;
+  if (tiles->nconc>1)
+    {
+    coadd.concflag = 1;
+    coadd.perfslot = slot;
+#ifdef USE_THREADS
+    coadd.lock = &tiles->mutex;
+#endif
+    }
+  else
+    {
+    coadd.nthreads = prefs.nthreads;
+    coadd.perfslot = PERF_MAIN;
+    }
+  coadd.cliplog = tiles->cliplog;
+  if (mefflag)
+    {
+    coadd.mef = &tiles->mef;
+    coadd.mefrank = tile->mefrank;
+    }
+  status = coadd_frame(&coadd, infield, inwfield, tile->ninput,
+	tilefield, tilewfield, tiles->coaddtype, tiles->wthresh);
+
+#ifdef USE_THREADS
+  QPTHREAD_MUTEX_LOCK(&tiles->mutex);
+#endif
+/* Meta-data are propagated to the parent field once all tiles are done */
+  if (tilefield->exptime > tiles->exptime)
+    tiles->exptime = tilefield->exptime;
+  if (tilefield->fieldno > tiles->fieldno)
+    tiles->fieldno = tilefield->fieldno;
+  end_field(tilefield);
+  end_field(tilewfield);
+  if (tiles->nconc>1)
+    {
+    for (n=0; n<tile->ninput; n++)
+      {
+      skytile_endview(infield[n]);
+      if (inwfield[n])
+        skytile_endview(inwfield[n]);
+      }
+    free(infield);
+    free(inwfield);
+    }
+#ifdef USE_THREADS
+  QPTHREAD_MUTEX_UNLOCK(&tiles->mutex);
+#endif
+
+  return status;
+  }
+
+
+/****i* skytile_concurrent ****************************************************
+PROTO	int skytile_concurrent(fieldstruct **infield, fieldstruct **inwfield,
+			int ninput)
+PURPOSE	Tell whether sky tiles can be co-added concurrently.
+INPUT	Input field ptr array,
+	Input weight field ptr array,
+	number of input fields.
+OUTPUT	1 if tiles can be co-added concurrently, 0 otherwise.
+NOTES   Compressed inputs keep a decompression state in their tab structure,
+	and CFITSIO handles cannot be duplicated: they are read by one tile
+	at a time. Without pwrite(), output bodies are written synchronously
+	through the static buffer of write_body().
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+static int	skytile_concurrent(fieldstruct **infield, fieldstruct **inwfield,
+			int ninput)
+  {
+   fieldstruct	*field;
+   int		n, w;
+
+#ifndef HAVE_PWRITE
+  return 0;
+#endif
+#ifdef HAVE_CFITSIO
+  if (prefs.tile_compress_flag)
+    return 0;
+#endif
+  for (n=0; n<ninput; n++)
+    for (w=0; w<2; w++)
+      {
+      if (!(field = w? inwfield[n] : infield[n]))
+        continue;
+      if (field->tab->compress_type != COMPRESS_NONE
+		|| field->tab->isTileCompressed)
+        return 0;
+#ifdef HAVE_CFITSIO
+      if (field->cat->cfitsio_flag || field->cat->cfitsio_infptr)
+        return 0;
+#endif
+      }
+
+  return 1;
+  }
+
+
+/****i* skytile_view **********************************************************
+PROTO	fieldstruct *skytile_view(fieldstruct *field)
+PURPOSE	Create a private view of an input field for concurrent reading.
+INPUT	Pointer to the input field.
+OUTPUT	Pointer to the new view.
+NOTES   The view has its own file handle, read position, mapping bounds and
+	packing buffers. Everything else (headers, footprint, compact line
+	table) is shared with the parent field and must not be modified.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+static fieldstruct	*skytile_view(fieldstruct *field)
+  {
+   fieldstruct		*view;
+   catstruct		*cat;
+   tabstruct		*tab;
+   compactstruct	*compact;
+   size_t		size;
+
+  QMALLOC(view, fieldstruct, 1);
+  *view = *field;
+  QMALLOC(cat, catstruct, 1);
+  *cat = *field->cat;
+  cat->file = NULL;
+#ifdef HAVE_CFITSIO
+  cat->cfitsio_infptr = NULL;
+#endif
+  QMALLOC(tab, tabstruct, 1);
+  *tab = *field->tab;
+  tab->cat = cat;
+  tab->prevtab = tab->nexttab = tab;
+  cat->tab = tab;
+  cat->ntab = 1;
+  view->cat = cat;
+  view->tab = tab;
+/* Only the mapping bounds of the WCS are updated during co-additions */
+  if (field->wcs)
+    {
+    QMALLOC(view->wcs, wcsstruct, 1);
+    *view->wcs = *field->wcs;
+    }
+  if (field->compact)
+    {
+    QMALLOC(compact, compactstruct, 1);
+    *compact = *field->compact;
+/*-- Same packing buffer size as in init_compact() */
+    size = 4*compact->width+compact->width/32+16;
+    QMALLOC(compact->buf, unsigned char, size);
+    QMALLOC(compact->buf2, unsigned char, size);
+    view->compact = compact;
+    }
+
+  return view;
+  }
+
+
+/****i* skytile_endview *******************************************************
+PROTO	void skytile_endview(fieldstruct *view)
+PURPOSE	Free a view created by skytile_view().
+INPUT	Pointer to the view.
+OUTPUT	-.
+NOTES   Data shared with the parent field are left untouched.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+static void	skytile_endview(fieldstruct *view)
+  {
+  close_cat(view->cat);
+  if (view->compact)
+    {
+    free(view->compact->buf);
+    free(view->compact->buf2);
+    free(view->compact);
+    }
+  free(view->wcs);
+  free(view->tab);
+  free(view->cat);
+  free(view);
+
+  return;
+  }
+
+
+/****i* coadd_mefpos **********************************************************
+PROTO	void coadd_mefpos(coaddmefstruct *mef, int rank,
+			fieldstruct *outfield, fieldstruct *outwfield,
+			int wonlyflag)
+PURPOSE	Position the output files at the beginning of a MEF extension.
+INPUT	Pointer to the MEF placement structure,
+	rank of the extension,
+	output field pointer,
+	output weight field pointer,
+	weight-only flag.
+OUTPUT	-.
+NOTES   Extension headers must be complete. Extensions are placed in rank
+	order: the caller waits for the extensions of lower ranks to be
+	placed.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+static void	coadd_mefpos(coaddmefstruct *mef, int rank,
+			fieldstruct *outfield, fieldstruct *outwfield,
+			int wonlyflag)
+  {
+#ifdef USE_THREADS
+  QPTHREAD_MUTEX_LOCK(&mef->mutex);
+  while (mef->next != rank)
+    QPTHREAD_COND_WAIT(&mef->cond, &mef->mutex);
+#endif
+  if (!wonlyflag)
+    {
+    QFSEEK(outfield->cat->file, mef->pos, SEEK_SET, outfield->filename);
+    mef->pos += (OFF_T2)outfield->tab->headnblock*FBSIZE
+	+ PADTOTAL(outfield->tab->tabsize);
     }
+  QFSEEK(outwfield->cat->file, mef->wpos, SEEK_SET, outwfield->filename);
+  mef->wpos += (OFF_T2)outwfield->tab->headnblock*FBSIZE
+	+ PADTOTAL(outwfield->tab->tabsize);
+  mef->next++;
+#ifdef USE_THREADS
+  QPTHREAD_COND_BROADCAST(&mef->cond);
+  QPTHREAD_MUTEX_UNLOCK(&mef->mutex);
+#endif
 
-#ifdef HAVE_CFITSIO
-  // CFITSIO close tile compressed files
-  if (prefs.tile_compress_flag) {
-
-	  closeTileCompressedFile(outfield);
-	  closeTileCompressedFile(outwfield);
+  return;
   }
-#endif // HAVE_CFITSIO
-  return RETURN_OK;
+
+
+/****i* skytile_filename ******************************************************
+PROTO	void skytile_filename(char *filename, char *reffilename, int *tpos)
+PURPOSE	Build the filename of a sky tile by inserting the tile indices before
+	the filename extension.
+INPUT	Pointer to the output filename string,
+	pointer to the reference filename,
+	pointer to the tile position in the tile grid.
+OUTPUT	-.
+NOTES   -.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+static void	skytile_filename(char *filename, char *reffilename, int *tpos)
+  {
+   char	*pstr, *pstr2;
+
+  strcpy(filename, reffilename);
+  pstr = strrchr(filename, '.');
+  pstr2 = strrchr(filename, '/');
+  if (!pstr || (pstr2 && pstr<pstr2))
+    pstr = filename + strlen(filename);
+  sprintf(pstr, "_%03d_%03d%s", tpos[0]+1, tpos[1]+1,
+	reffilename + (pstr - filename));
+
+  return;
   }
 
 
@@ -1034,7 +1886,7 @@ static void	max_clique_recur(unsigned int *array, int nnode, int *old,
 /*-- Count disconnections */
     for (j=ne; j<ce && count < minnod; j++)
       {
-      if (!ARRAY_BIT(p,old[j]))
+      if (!ARRAY_BIT(array,nnode,p,old[j]))
         {
         count++;
 /*------ Save position of potential candidate */
@@ -1069,13 +1921,13 @@ static void	max_clique_recur(unsigned int *array, int nnode, int *old,
 /*-- Fill new set "not" */
     newne = 0;
     for (i=0; i<ne; i++)
-      if (ARRAY_BIT(sel,old[i]))
+      if (ARRAY_BIT(array,nnode,sel,old[i]))
         new[newne++] = old[i];
 
 /*-- Fill new set "cand" */
     newce = newne;
     for (i=ne+1; i<ce; i++)
-      if (ARRAY_BIT(sel,old[i]))
+      if (ARRAY_BIT(array,nnode,sel,old[i]))
         new[newce++] = old[i];
 
 /*-- Add to compsub */
@@ -1101,7 +1953,7 @@ static void	max_clique_recur(unsigned int *array, int nnode, int *old,
     ne++;
     if (nod > 1)
 /*---- Select a candidate disconnected to the fixed point */
-      for (s=ne; ARRAY_BIT(fixp,old[s]); s++);
+      for (s=ne; ARRAY_BIT(array,nnode,fixp,old[s]); s++);
     }
   free(new);
 
@@ -1109,84 +1961,511 @@ static void	max_clique_recur(unsigned int *array, int nnode, int *old,
   }
 
 
+/******* init_coaddindex ****************************************************
+PROTO	coaddindexstruct *init_coaddindex(int *ybegbufline, int ninput)
+PURPOSE	Build a sweep-line index of input footprints along buffer lines.
+INPUT	Pointer to the array of first buffer lines of inputs,
+	number of inputs.
+OUTPUT	Pointer to the new index.
+NOTES	Buffer lines must be processed in increasing order.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+static coaddindexstruct	*init_coaddindex(int *ybegbufline, int ninput)
+  {
+   coaddindexstruct	*index;
+   int			*pair,
+			n;
+
+  QCALLOC(index, coaddindexstruct, 1);
+  index->ninput = ninput;
+  index->ybeg = ybegbufline;
+  QMALLOC(index->order, int, ninput);
+  QMALLOC(index->active, int, ninput);
+  QMALLOC(index->work, int, ninput);
+/* Sort (first line, input index) pairs */
+  QMALLOC(pair, int, 2*ninput);
+  for (n=0; n<ninput; n++)
+    {
+    pair[2*n] = ybegbufline[n];
+    pair[2*n+1] = n;
+    }
+  qsort(pair, ninput, 2*sizeof(int), coaddindex_cmp);
+  for (n=0; n<ninput; n++)
+    index->order[n] = pair[2*n+1];
+  free(pair);
+
+  return index;
+  }
+
+
+/******* update_coaddindex **************************************************
+PROTO	void update_coaddindex(coaddindexstruct *index, int ybufmax)
+PURPOSE	Activate inputs that begin before the end of the current buffer.
+INPUT	Pointer to the index,
+	first buffer line beyond the current buffer.
+OUTPUT	-.
+NOTES	Active inputs are kept in increasing index order, so that the
+	co-addition does not depend on the index.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+static void	update_coaddindex(coaddindexstruct *index, int ybufmax)
+  {
+   int	*new, *active, *work,
+	a, b, n, nnew, nactive;
+
+  new = index->order + index->next;
+  for (nnew=0; index->next<index->ninput
+	&& index->ybeg[index->order[index->next]] < ybufmax; nnew++)
+    index->next++;
+  if (!nnew)
+    return;
+
+/* Merge the new inputs with the active ones */
+  qsort(new, nnew, sizeof(int), int_cmp);
+  active = index->active;
+  nactive = index->nactive;
+  work = index->work;
+  for (a=b=n=0; a<nactive || b<nnew; n++)
+    work[n] = (b>=nnew || (a<nactive && active[a]<new[b]))?
+			active[a++] : new[b++];
+  index->work = active;
+  index->active = work;
+  index->nactive = n;
+
+  return;
+  }
+
+
+/******* prune_coaddindex ***************************************************
+PROTO	void prune_coaddindex(coaddindexstruct *index, unsigned int *cflag)
+PURPOSE	Remove inputs that have been fully co-added from the active set.
+INPUT	Pointer to the index,
+	pointer to the array of input co-addition flags.
+OUTPUT	-.
+NOTES	-.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+static void	prune_coaddindex(coaddindexstruct *index, unsigned int *cflag)
+  {
+   int	a, nactive;
+
+  for (a=nactive=0; a<index->nactive; a++)
+    if (!(cflag[index->active[a]] & COADDFLAG_FINISHED))
+      index->active[nactive++] = index->active[a];
+  index->nactive = nactive;
+
+  return;
+  }
+
+
+/******* end_coaddindex *****************************************************
+PROTO	void end_coaddindex(coaddindexstruct *index)
+PURPOSE	Free an input footprint index.
+INPUT	Pointer to the index.
+OUTPUT	-.
+NOTES	-.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+static void	end_coaddindex(coaddindexstruct *index)
+  {
+  free(index->order);
+  free(index->active);
+  free(index->work);
+  free(index);
+
+  return;
+  }
+
+
+/******* coadd_evictinput *************************************************
+PROTO	int coadd_evictinput(coaddindexstruct *index,
+			fieldstruct **infield, fieldstruct **inwfield,
+			unsigned int *cflag, int n)
+PURPOSE	Close the open input whose data will be needed last, to make room for
+	opening input n.
+INPUT	Pointer to the index,
+	pointer to the array of input field pointers,
+	pointer to the array of input weight field pointers,
+	pointer to the array of input co-addition flags,
+	index of the input about to be read.
+OUTPUT	Number of file handles released (0 if none could be).
+NOTES	Active inputs are read in increasing index order at every buffer, so
+	the next use of an input comes sooner if it follows n in the current
+	pass, and later if it has already been read in this pass. Evicting the
+	input used farthest ahead (rather than the least recently used one,
+	which is needed first in a cyclic sweep) minimizes reopens.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+static int	coadd_evictinput(coaddindexstruct *index,
+			fieldstruct **infield, fieldstruct **inwfield,
+			unsigned int *cflag, int n)
+  {
+   int	a, m, mmax, rank, rankmax, nclosed;
+
+  mmax = -1;
+  rankmax = -1;
+  for (a=0; a<index->nactive; a++)
+    {
+    m = index->active[a];
+    if (m==n || (cflag[m] & COADDFLAG_FINISHED)
+	|| !(infield[m]->cat->file || (inwfield[m] && inwfield[m]->cat->file)))
+      continue;
+    rank = m>n? m : index->ninput + m;
+    if (rank > rankmax)
+      {
+      rankmax = rank;
+      mmax = m;
+      }
+    }
+
+  if (mmax<0)
+    return 0;
+
+  nclosed = 0;
+  if (infield[mmax]->cat->file)
+    {
+    if (close_cat(infield[mmax]->cat) != RETURN_OK)
+      error(EXIT_FAILURE,"*Error*: cannot close ", infield[mmax]->filename);
+    nclosed++;
+    }
+  if (inwfield[mmax] && inwfield[mmax]->cat->file)
+    {
+    if (close_cat(inwfield[mmax]->cat) != RETURN_OK)
+      error(EXIT_FAILURE,"*Error*: cannot close ", inwfield[mmax]->filename);
+    nclosed++;
+    }
+  perf_count(PERF_FILEEVICT, 1);
+
+  return nclosed;
+  }
+
+
+/******* prefetch_coaddindex ************************************************
+PROTO	void prefetch_coaddindex(coaddindexstruct *index,
+			fieldstruct **infield, fieldstruct **inwfield,
+			unsigned int *cflag, int ybuf, int nbuflines)
+PURPOSE	Start reading ahead the input data that overlap a range of buffer
+	lines.
+INPUT	Pointer to the index,
+	pointer to the array of input field pointers (or NULL),
+	pointer to the array of input weight field pointers,
+	pointer to the array of input co-addition flags,
+	first buffer line of the range,
+	number of buffer lines in the range.
+OUTPUT	-.
+NOTES	Both active inputs and inputs yet to be activated are considered.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+static void	prefetch_coaddindex(coaddindexstruct *index,
+			fieldstruct **infield, fieldstruct **inwfield,
+			unsigned int *cflag, int ybuf, int nbuflines)
+  {
+   int	a, n;
+
+  for (a=0; a<index->nactive; a++)
+    {
+    n = index->active[a];
+    if (cflag[n] & COADDFLAG_FINISHED)
+      continue;
+    coadd_prefetch(infield? infield[n] : NULL, index->ybeg[n], ybuf,
+	nbuflines);
+    coadd_prefetch(inwfield[n], index->ybeg[n], ybuf, nbuflines);
+    }
+
+  for (a=index->next; a<index->ninput
+	&& index->ybeg[n=index->order[a]] < ybuf+nbuflines; a++)
+    {
+    coadd_prefetch(infield? infield[n] : NULL, index->ybeg[n], ybuf,
+	nbuflines);
+    coadd_prefetch(inwfield[n], index->ybeg[n], ybuf, nbuflines);
+    }
+
+  return;
+  }
+
+
+/******* coaddindex_cmp *****************************************************
+PROTO	int coaddindex_cmp(const void *p1, const void *p2)
+PURPOSE	Sorting function for (first line, input index) pairs in qsort().
+INPUT	Pointer to first element,
+	pointer to second element.
+OUTPUT	1 if *p1>*p2, 0 if *p1=*p2, and -1 otherwise.
+NOTES	-.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+static int	coaddindex_cmp(const void *p1, const void *p2)
+  {
+   const int	*i1=(const int *)p1,
+		*i2=(const int *)p2;
+
+  if (i1[0] != i2[0])
+    return i1[0]>i2[0]? 1 : -1;
+  return i1[1]>i2[1]? 1 : (i1[1]<i2[1]? -1 : 0);
+  }
+
+
+/******* int_cmp ************************************************************
+PROTO	int int_cmp(const void *p1, const void *p2)
+PURPOSE	Sorting function for ints in qsort().
+INPUT	Pointer to first element,
+	pointer to second element.
+OUTPUT	1 if *p1>*p2, 0 if *p1=*p2, and -1 otherwise.
+NOTES	-.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+static int	int_cmp(const void *p1, const void *p2)
+  {
+   int	i1=*((const int *)p1),
+	i2=*((const int *)p2);
+
+  return i1>i2? 1 : (i1<i2? -1 : 0);
+  }
+
+
 #ifdef USE_THREADS
 
 /****** pthread_coadd_lines ****************************************************
 PROTO	void *pthread_coadd_lines(void *arg)
-PURPOSE	thread that takes care of coadding image "lines"
-INPUT	Pointer to the thread number.
+PURPOSE	Pool task that takes care of coadding image "lines"
+INPUT	Pointer to the task (context and task number).
 OUTPUT	-.
-NOTES	-.
-AUTHOR	E. Bertin (IAP)
-VERSION	10/03/2014
+NOTES	All co-addition tasks must run concurrently, as they are synchronized
+	through gates. NUMA placement follows the pool worker running the task.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
  ***/
 void	*pthread_coadd_lines(void *arg)
   {
-   int	*bufmin,
-	bufline;
+   coaddstruct	*coadd;
+   double	t0;
+   int		bufline, node, slot, t;
 
   bufline = -1;
-  bufmin = (int *)arg;
-  threads_gate_sync(pthread_startgate);
-  while (!pthread_endflag)
+  coadd = ((coaddtaskstruct *)arg)->coadd;
+  slot = ((coaddtaskstruct *)arg)->p + 1;
+  if ((t = threads_pool_self(threads_pool)) < 0)
+    t = slot-1;
+  node = numa_threadnode(t);
+  if (coadd->nnode>1)
     {
-    QPTHREAD_MUTEX_LOCK(&coaddmutex);
-    if (pthread_bufline<pthread_nbuflines)
+    coadd_touchlines(coadd, t);
+    threads_gate_sync(coadd->numagate);
+    }
+  threads_gate_sync(coadd->startgate);
+  while (!coadd->endflag)
+    {
+    QPTHREAD_MUTEX_LOCK(&coadd->mutex);
+    if ((bufline = coadd_nextline(coadd, node)) >= 0)
       {
-      bufline = pthread_bufline++;
-      QPTHREAD_MUTEX_UNLOCK(&coaddmutex);
-      if (iflag)
-        coadd_iline(bufline);
+      QPTHREAD_MUTEX_UNLOCK(&coadd->mutex);
+      t0 = perf_start();
+      if (coadd->iflag)
+        coadd_iline(coadd, bufline);
       else
-        coadd_line(bufline, *pthread_baseline_y, bufmin);
+        coadd_line(coadd, bufline, *coadd->baseline_y, coadd->bufmin);
+      perf_add(PERF_COADDLINE, slot, t0, (double)coadd->width, 0.0);
       }
     else
       {
-      QPTHREAD_MUTEX_UNLOCK(&coaddmutex);
+      QPTHREAD_MUTEX_UNLOCK(&coadd->mutex);
 /*---- Wait for the input buffer to be updated */
-      threads_gate_sync(pthread_stopgate);
+      threads_gate_sync(coadd->stopgate);
 /*---- (Master thread process loads and saves new data here, ... */
 /*---- ... including base line pointer) */
-      threads_gate_sync(pthread_startgate);
+      threads_gate_sync(coadd->startgate);
       }
     }
 
-  pthread_exit(NULL);
+  return (void *)NULL;
+  }
+
+
+/****** pthread_skytiles *****************************************************
+PROTO	void *pthread_skytiles(void *arg)
+PURPOSE	Pool task that co-adds sky tiles until none is left.
+INPUT	Pointer to the sky tiling.
+OUTPUT	-.
+NOTES	Tiles are taken in order, so that MEF extensions are placed without
+	waiting for a tile that has not started.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+static void	*pthread_skytiles(void *arg)
+  {
+   skytilesstruct	*tiles;
+   int			t, slot;
+
+  tiles = (skytilesstruct *)arg;
+  slot = threads_pool_self(threads_pool) + 1;
+  for (;;)
+    {
+    QPTHREAD_MUTEX_LOCK(&tiles->mutex);
+    t = tiles->next<tiles->ntile? tiles->next++ : -1;
+    QPTHREAD_MUTEX_UNLOCK(&tiles->mutex);
+    if (t<0)
+      break;
+    if (skytile_coadd(tiles, &tiles->tile[t], slot) != RETURN_OK)
+      {
+      QPTHREAD_MUTEX_LOCK(&tiles->mutex);
+      tiles->status = RETURN_ERROR;
+      QPTHREAD_MUTEX_UNLOCK(&tiles->mutex);
+      }
+    }
 
   return (void *)NULL;
   }
 
+
+/****** coadd_splitlines *****************************************************
+PROTO	void coadd_splitlines(coaddstruct *coadd, int nbuflines)
+PURPOSE	Distribute the lines of the co-addition buffer among NUMA nodes.
+INPUT	Pointer to the co-addition context,
+	number of buffer lines to co-add.
+OUTPUT	-.
+NOTES	Node n is given a contiguous range of lines, which matches the range
+	first touched by its threads in coadd_touchlines(). Must be called
+	with the context mutex locked once threads are running.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+static void	coadd_splitlines(coaddstruct *coadd, int nbuflines)
+  {
+   int	n;
+
+  for (n=0; n<coadd->nnode; n++)
+    {
+    coadd->nodebufline[n] = (int)((size_t)nbuflines*n/coadd->nnode);
+    coadd->nodebufend[n] = (int)((size_t)nbuflines*(n+1)/coadd->nnode);
+    }
+
+  return;
+  }
+
+
+/****** coadd_nextline *******************************************************
+PROTO	int coadd_nextline(coaddstruct *coadd, int node)
+PURPOSE	Pick the next buffer line to co-add for a thread.
+INPUT	Pointer to the co-addition context,
+	NUMA node of the thread.
+OUTPUT	Buffer line index, or -1 if all lines have been dispatched.
+NOTES	Lines from the thread's own node come first; lines from other nodes
+	are taken only when the local range is exhausted, to keep the load
+	balanced. Must be called with the context mutex locked.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+static int	coadd_nextline(coaddstruct *coadd, int node)
+  {
+   int	k, n;
+
+  for (k=0; k<coadd->nnode; k++)
+    {
+    n = (node+k)%coadd->nnode;
+    if (coadd->nodebufline[n] < coadd->nodebufend[n])
+      return coadd->nodebufline[n]++;
+    }
+
+  return -1;
+  }
+
+
+/****** coadd_touchlines *****************************************************
+PROTO	void coadd_touchlines(coaddstruct *coadd, int t)
+PURPOSE	First-touch the buffer lines of a thread's NUMA node, so that they
+	are allocated on that node.
+INPUT	Pointer to the co-addition context,
+	worker thread index.
+OUTPUT	-.
+NOTES	The node line range is shared among the threads of the node. Must be
+	called before the buffers are used for the first time.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+static void	coadd_touchlines(coaddstruct *coadd, int t)
+  {
+   size_t	multiwidth, lbeg, lend, nm, no;
+   int		node, p, rank, nrank, nbeg, nend;
+
+  node = numa_threadnode(t);
+  rank = nrank = 0;
+  for (p=0; p<coadd->nthreads; p++)
+    if (numa_threadnode(p) == node)
+      {
+      if (p<t)
+        rank++;
+      nrank++;
+      }
+  nbeg = (int)((size_t)coadd->nbuflinesmax*node/coadd->nnode);
+  nend = (int)((size_t)coadd->nbuflinesmax*(node+1)/coadd->nnode);
+  lbeg = nbeg + (size_t)(nend-nbeg)*rank/nrank;
+  lend = nbeg + (size_t)(nend-nbeg)*(rank+1)/nrank;
+  multiwidth = (size_t)coadd->width*coadd->nomax;
+  nm = (lend-lbeg)*multiwidth;
+  no = (lend-lbeg)*(size_t)coadd->width;
+  if (coadd->iflag)
+    {
+    memset(coadd->multiibuf+lbeg*multiwidth, 0, nm*sizeof(FLAGTYPE));
+    memset(coadd->multiwibuf+lbeg*multiwidth, 0, nm*sizeof(FLAGTYPE));
+    memset(coadd->outibuf+lbeg*coadd->width, 0, no*sizeof(FLAGTYPE));
+    memset(coadd->outwibuf+lbeg*coadd->width, 0, no*sizeof(FLAGTYPE));
+    }
+  else
+    {
+    memset(coadd->multibuf+lbeg*multiwidth, 0, nm*sizeof(PIXTYPE));
+    memset(coadd->multiobuf+lbeg*multiwidth, 0, nm*sizeof(unsigned int));
+    memset(coadd->multiwbuf+lbeg*multiwidth, 0, nm*sizeof(PIXTYPE));
+    memset(coadd->outbuf+lbeg*coadd->width, 0, no*sizeof(PIXTYPE));
+    memset(coadd->outwbuf+lbeg*coadd->width, 0, no*sizeof(PIXTYPE));
+    }
+  memset(coadd->multinbuf+lbeg*coadd->width, 0, no*sizeof(unsigned int));
+
+  return;
+  }
+
 #endif
 
 
 /******* coadd_iline **********************************************************
-PROTO	int coadd_iline(int l)
+PROTO	int coadd_iline(coaddstruct *coadd, int l)
 PURPOSE	Coadd a line of integer pixels.
-INPUT	Current line number.
+INPUT	Pointer to the co-addition context,
+	current line number.
 OUTPUT	RETURN_OK if no error, or RETURN_ERROR in case of non-fatal error(s).
-NOTES   Requires many global variables (for multithreading).
-AUTHOR  E. Bertin (IAP)
-VERSION	27/01/2021
+NOTES   Buffers are shared through the co-addition context (for
+	multithreading).
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
  ***/
-int coadd_iline(int l)
+int coadd_iline(coaddstruct *coadd, int l)
 
   {
    FLAGTYPE		*inipix,*inipixt,*outipix, *inwipix,*inwipixt,*outwipix,
 			ival;
    unsigned int	*inn;
-   size_t		lcoadd_width = l * (size_t)coadd_width;
-   int			i,x, ninput,ninput2;
-
-  inipix = multiibuf + lcoadd_width * coadd_nomax;
-  inwipix = multiwibuf + lcoadd_width * coadd_nomax;
-  inn = multinbuf + lcoadd_width;
-  outipix = outibuf + lcoadd_width;
-  outwipix = outwibuf + lcoadd_width;
-  switch(coadd_type)
+   size_t		lcoadd_width;
+   int			i,x, ninput,ninput2, nomax, width;
+
+  nomax = coadd->nomax;
+  width = coadd->width;
+  lcoadd_width = l * (size_t)width;
+  inipix = coadd->multiibuf + lcoadd_width * nomax;
+  inwipix = coadd->multiwibuf + lcoadd_width * nomax;
+  inn = coadd->multinbuf + lcoadd_width;
+  outipix = coadd->outibuf + lcoadd_width;
+  outwipix = coadd->outwibuf + lcoadd_width;
+  switch(coadd->type)
     {
     case COADD_AND:
     case COADD_NAND:
-      for (x=coadd_width; x--; inipix+=coadd_nomax, inwipix+=coadd_nomax)
+      for (x=width; x--; inipix+=nomax, inwipix+=nomax)
         {
         ninput = *(inn++);
         ninput2 = 0;
@@ -1199,13 +2478,13 @@ int coadd_iline(int l)
           ninput2 += *(inwipixt++);
           }
         ival = ninput2? ival : 0;
-        *(outipix++) = (coadd_type==COADD_NAND)? ~ival : ival;
+        *(outipix++) = (coadd->type==COADD_NAND)? ~ival : ival;
         *(outwipix++) = ninput2;
         }
       break;
     case COADD_OR:
     case COADD_NOR:
-      for (x=coadd_width; x--; inipix+=coadd_nomax, inwipix+=coadd_nomax)
+      for (x=width; x--; inipix+=nomax, inwipix+=nomax)
         {
         ninput = *(inn++);
         ninput2 = 0;
@@ -1217,7 +2496,7 @@ int coadd_iline(int l)
           ival |= *(inipixt++);
           ninput2 += *(inwipixt++);
           }
-        *(outipix++) = (coadd_type==COADD_NOR)? ~ival : ival;
+        *(outipix++) = (coadd->type==COADD_NOR)? ~ival : ival;
         *(outwipix++) = ninput2;
         }
       break;
@@ -1242,42 +2521,62 @@ int coadd_iline(int l)
 
 
 /******* coadd_line **********************************************************
-PROTO	int coadd_line(int l, int b, int *bufmin)
+PROTO	int coadd_line(coaddstruct *coadd, int l, int b, int *bufmin)
 PURPOSE	Coadd a line of pixels.
-INPUT	Current line number within the buffer,
+INPUT	Pointer to the co-addition context,
+	current line number within the buffer,
 	buffer base line number,
 	offset of arrays w.r.t. final output (required for correcting
 	clipped pixel coordinates)
 OUTPUT	RETURN_OK if no error, or RETURN_ERROR in case of non-fatal error(s).
-NOTES	Requires many global variables (for multithreading).
+NOTES	Buffers are shared through the co-addition context (for
+	multithreading).
 AUTHOR	E. Bertin (IAP), D. Gruen (USM)
-VERSION	27/01/2021
+VERSION	19/10/2026
  ***/
-int	coadd_line(int l, int b, int *bufmin)
+int	coadd_line(coaddstruct *coadd, int l, int b, int *bufmin)
 
   {
    PIXTYPE		*inpix,*inwpix,*inpixt,*inwpixt,
 			*pixstack, *pixfstack, *pixwstack, *pixt,*pixft, *pixwt,
 			*pixstackbuf, *outpix,*outwpix,
-			fval2, mu;
-   double		val,val0,val2,val3, wval,wval0,wval2,wval3;
-   unsigned int		*inn, *inorigin, *inorigint, *pixostack, *pixot;
-   size_t		lcoadd_width = l * (size_t)coadd_width;
-   int			i,x, ninput, ninput2, blankflag, origin2;
+			fval2, mu, wthresh;
+   double		*sumpix, *sumwpix,
+			val,val0,val2,val3, wval,wval0,wval2,wval3;
+   unsigned int		*inn, *inorigin, *inorigint, *pixostack, *pixot,
+			*nsumpix;
+   size_t		lcoadd_width;
+   int			i,x, ninput, ninput2, blankflag, origin2, nomax, width;
 
 
   blankflag = prefs.blank_flag;
-  inpix = multibuf + lcoadd_width * coadd_nomax;
-  inwpix = multiwbuf + lcoadd_width * coadd_nomax;
-  inn = multinbuf + lcoadd_width;
-  outpix = outbuf + lcoadd_width;
-  outwpix = outwbuf + lcoadd_width;
-  pixstack = coadd_pixstack + (size_t)l * coadd_nomax;
-  pixfstack = coadd_pixfstack + (size_t)l * coadd_nomax;
-  switch(coadd_type)
+  nomax = coadd->nomax;
+  width = coadd->width;
+  wthresh = coadd->wthresh;
+  lcoadd_width = l * (size_t)width;
+  inpix = coadd->multibuf + lcoadd_width * nomax;
+  inwpix = coadd->multiwbuf + lcoadd_width * nomax;
+  inn = coadd->multinbuf + lcoadd_width;
+  outpix = coadd->outbuf + lcoadd_width;
+  outwpix = coadd->outwbuf + lcoadd_width;
+  pixstack = coadd->pixstack + (size_t)l * nomax;
+  pixfstack = coadd->pixfstack + (size_t)l * nomax;
+/* Keep the accumulators for incremental co-additions */
+  if (coadd->sumbuf)
+    {
+    sumpix = coadd->sumbuf + lcoadd_width;
+    sumwpix = coadd->sumwbuf + lcoadd_width;
+    nsumpix = coadd->nsumbuf + lcoadd_width;
+    }
+  else
+    {
+    sumpix = sumwpix = NULL;
+    nsumpix = NULL;
+    }
+  switch(coadd->type)
     {
     case COADD_WEIGHTED:
-      for (x=coadd_width; x--; inpix+=coadd_nomax, inwpix+=coadd_nomax)
+      for (x=width; x--; inpix+=nomax, inwpix+=nomax)
         {
         ninput = *(inn++);
         ninput2 = 0;
@@ -1289,7 +2588,7 @@ int	coadd_line(int l, int b, int *bufmin)
           {
           fval2 = *(inpixt++);
           wval2 = *(inwpixt++);
-          if (wval2<coadd_wthresh && fval2>-BIG/2)
+          if (wval2<wthresh && fval2>-BIG/2)
             {
             ninput2++;
             wval += (wval2=1.0/wval2);
@@ -1298,6 +2597,12 @@ int	coadd_line(int l, int b, int *bufmin)
           else
             *(pixft++) = fval2;            
           }
+        if (sumpix)
+          {
+          *(sumpix++) = val;
+          *(sumwpix++) = wval;
+          *(nsumpix++) = ninput2;
+          }
         if (ninput2)
           {
           *(outwpix++) = (wval= 1.0/wval);
@@ -1313,13 +2618,13 @@ int	coadd_line(int l, int b, int *bufmin)
       break;
 
     case COADD_CLIPPED:
-      QMALLOC(pixstack,  PIXTYPE, coadd_nomax);
-      QMALLOC(pixwstack, PIXTYPE, coadd_nomax);
-      QMALLOC(pixstackbuf, PIXTYPE, coadd_nomax);
-      QMALLOC(pixostack, unsigned int, coadd_nomax);
-      inorigin = multiobuf + lcoadd_width * coadd_nomax;
-      for (x=coadd_width; x--; inpix+=coadd_nomax, inwpix+=coadd_nomax,
-		inorigin += coadd_nomax) // for each pixel in the line
+      QMALLOC(pixstack,  PIXTYPE, nomax);
+      QMALLOC(pixwstack, PIXTYPE, nomax);
+      QMALLOC(pixstackbuf, PIXTYPE, nomax);
+      QMALLOC(pixostack, unsigned int, nomax);
+      inorigin = coadd->multiobuf + lcoadd_width * nomax;
+      for (x=width; x--; inpix+=nomax, inwpix+=nomax,
+		inorigin += nomax) // for each pixel in the line
         {
         ninput2 = 0;
         val2 = 0.0;
@@ -1336,7 +2641,7 @@ int	coadd_line(int l, int b, int *bufmin)
           wval2 = *(inwpixt++);
           origin2 = *(inorigint++);
 
-          if (wval2<coadd_wthresh && val2>-BIG/2)
+          if (wval2<wthresh && val2>-BIG/2)
             {
             ninput2++;
             *(pixt++) = val2;
@@ -1365,8 +2670,9 @@ int	coadd_line(int l, int b, int *bufmin)
 			o2 = *(pixostack+1);
              float	f1f2o2 = fabsf(*(pixstack)+*(pixstack+1)) / 2.0,
 			sumw = *(pixwstack) + *(pixwstack+1),
-			sigmaeff = sqrtf(sumw + f1f2o2*(1.0/infields[o1]->fgain
-				+ 1.0/infields[o2]->fgain)),
+			sigmaeff = sqrtf(sumw
+				+ f1f2o2*(1.0/coadd->infield[o1]->fgain
+				+ 1.0/coadd->infield[o2]->fgain)),
 			dpix = *(pixstack)-*(pixstack+1);
             if (fabs(dpix) <= prefs.clip_sigma*sigmaeff +
 		prefs.clip_ampfrac*f1f2o2)
@@ -1383,14 +2689,14 @@ int	coadd_line(int l, int b, int *bufmin)
                 {
                 mu = (dpix > 0.0 ? 1.0 : -1.0) *
 			(fabsf(dpix ) - prefs.clip_ampfrac*f1f2o2) / sigmaeff;
-                fprintf(cliplog, "%4d %6d %6d %+10g\n",
+                fprintf(coadd->cliplog, "%4d %6d %6d %+10g\n",
 			o1,
-			((int)(outpix - outbuf))%coadd_width + bufmin[0],
+			((int)(outpix - coadd->outbuf))%width + bufmin[0],
 			b + l + (b==0 ? bufmin[1] : 1),
 			mu);
-                fprintf(cliplog, "%4d %6d %6d %+10g\n",
+                fprintf(coadd->cliplog, "%4d %6d %6d %+10g\n",
 			o2,
-			((int)(outpix - outbuf))%coadd_width + bufmin[0],
+			((int)(outpix - coadd->outbuf))%width + bufmin[0],
 			b + l + (b==0 ? bufmin[1] : 1),
 			-mu);
                 }
@@ -1399,7 +2705,7 @@ int	coadd_line(int l, int b, int *bufmin)
 	    break;
 
           default: // 3 or more, take a median and discard incompatible values
-            memcpy(pixstackbuf, pixstack, sizeof(PIXTYPE)*coadd_nomax);
+            memcpy(pixstackbuf, pixstack, sizeof(PIXTYPE)*nomax);
             mu = fast_median(pixstackbuf,ninput2);
              float amu = fabsf(mu);
 
@@ -1408,7 +2714,8 @@ int	coadd_line(int l, int b, int *bufmin)
             for(i=0; i<ninput2; i++)
               {
                int	o = *(pixostack+i);
-               float	sigmaeff = sqrtf(*(pixwstack+i)+amu/infields[o]->fgain);
+               float	sigmaeff = sqrtf(*(pixwstack+i)
+				+ amu/coadd->infield[o]->fgain);
               if (fabsf(*(pixstack+i) - mu) <= prefs.clip_sigma*sigmaeff +
 			prefs.clip_ampfrac*amu)
                 {
@@ -1416,9 +2723,9 @@ int	coadd_line(int l, int b, int *bufmin)
                 val  += wval2 * *(pixstack+i);
                 }
               else if (prefs.clip_logflag)
-                fprintf(cliplog, "%4d %6d %6d %+10g\n",
+                fprintf(coadd->cliplog, "%4d %6d %6d %+10g\n",
 			o,
-			((int)(outpix - outbuf))%coadd_width + bufmin[0],
+			((int)(outpix - coadd->outbuf))%width + bufmin[0],
 			b + l + (b==0 ? bufmin[1] : 1),
 			((*(pixstack+i) - mu > 0.0)?1.0 : -1.0) *
 				(fabsf(fabsf(*(pixstack+i) - mu) -
@@ -1443,7 +2750,7 @@ int	coadd_line(int l, int b, int *bufmin)
       break;
 
     case COADD_MEDIAN:
-      for (x=coadd_width; x--; inpix+=coadd_nomax, inwpix+=coadd_nomax)
+      for (x=width; x--; inpix+=nomax, inwpix+=nomax)
         {
         ninput = *(inn++);
         ninput2 = 0;
@@ -1456,7 +2763,7 @@ int	coadd_line(int l, int b, int *bufmin)
           {
           fval2 = *(inpixt++);
           wval2 = *(inwpixt++);        
-          if (wval2 < coadd_wthresh && fval2>-BIG/2)
+          if (wval2 < wthresh && fval2>-BIG/2)
             {
             *(pixt++) = fval2;
             wval += 1.0/sqrt(wval2);
@@ -1484,7 +2791,7 @@ int	coadd_line(int l, int b, int *bufmin)
         }
       break;
     case COADD_AVERAGE:
-      for (x=coadd_width; x--; inpix+=coadd_nomax, inwpix+=coadd_nomax)
+      for (x=width; x--; inpix+=nomax, inwpix+=nomax)
         {
         ninput = *(inn++);
         ninput2 = 0;
@@ -1496,7 +2803,7 @@ int	coadd_line(int l, int b, int *bufmin)
           {
           fval2 = *(inpixt++);
           wval2 = *(inwpixt++);
-          if (wval2<coadd_wthresh && fval2>-BIG/2)
+          if (wval2<wthresh && fval2>-BIG/2)
             {
             ninput2++;
             val += fval2;
@@ -1505,6 +2812,12 @@ int	coadd_line(int l, int b, int *bufmin)
           else
             *(pixft++) = fval2;
           }
+        if (sumpix)
+          {
+          *(sumpix++) = val;
+          *(sumwpix++) = wval;
+          *(nsumpix++) = ninput2;
+          }
         if (ninput2)
           {
           *(outpix++) = val/ninput2;
@@ -1519,7 +2832,7 @@ int	coadd_line(int l, int b, int *bufmin)
         }
       break;
     case COADD_MIN:
-      for (x=coadd_width; x--; inpix+=coadd_nomax, inwpix+=coadd_nomax)
+      for (x=width; x--; inpix+=nomax, inwpix+=nomax)
         {
         ninput = *(inn++);
         ninput2 = 0;
@@ -1530,7 +2843,7 @@ int	coadd_line(int l, int b, int *bufmin)
           {
           val2 = *(inpixt++);
           wval2 = *(inwpixt++);
-          if (wval2<coadd_wthresh && val2>-BIG/2)
+          if (wval2<wthresh && val2>-BIG/2)
             {
             ninput2++;
             if (val2<val)
@@ -1552,7 +2865,7 @@ int	coadd_line(int l, int b, int *bufmin)
         }
       break;
     case COADD_MAX:
-      for (x=coadd_width; x--; inpix+=coadd_nomax, inwpix+=coadd_nomax)
+      for (x=width; x--; inpix+=nomax, inwpix+=nomax)
         {
         ninput = *(inn++);
         ninput2 = 0;
@@ -1563,7 +2876,7 @@ int	coadd_line(int l, int b, int *bufmin)
           {
           val2 = *(inpixt++);
           wval2 = *(inwpixt++);
-          if (wval2<coadd_wthresh && val2>-BIG/2)
+          if (wval2<wthresh && val2>-BIG/2)
             {
             ninput2++;
             if (val2>val)
@@ -1586,7 +2899,7 @@ int	coadd_line(int l, int b, int *bufmin)
       break;
     case COADD_CHI_OLD:
       wval0 = 1.0;
-      for (x=coadd_width; x--; inpix+=coadd_nomax, inwpix+=coadd_nomax)
+      for (x=width; x--; inpix+=nomax, inwpix+=nomax)
         {
         ninput = *(inn++);
         ninput2 = 0;
@@ -1598,7 +2911,7 @@ int	coadd_line(int l, int b, int *bufmin)
           {
           val2 = *(inpixt++);
           wval2 = *(inwpixt++);
-          if (wval2<coadd_wthresh && val2>-BIG/2)
+          if (wval2<wthresh && val2>-BIG/2)
             {
             ninput2++;
             wval0 = 1.0/wval2;
@@ -1622,7 +2935,7 @@ int	coadd_line(int l, int b, int *bufmin)
       break;
     case COADD_CHI_MODE:
       wval0 = 1.0;
-      for (x=coadd_width; x--; inpix+=coadd_nomax, inwpix+=coadd_nomax)
+      for (x=width; x--; inpix+=nomax, inwpix+=nomax)
         {
         ninput = *(inn++);
         ninput2 = 0;
@@ -1634,7 +2947,7 @@ int	coadd_line(int l, int b, int *bufmin)
           {
           val2 = *(inpixt++);
           wval2 = *(inwpixt++);
-          if (wval2<coadd_wthresh && val2>-BIG/2)
+          if (wval2<wthresh && val2>-BIG/2)
             {
             ninput2++;
             val0 = val2;
@@ -1646,7 +2959,7 @@ int	coadd_line(int l, int b, int *bufmin)
           }
         if (ninput2)
           {
-          mu = coadd_bias[ninput2-1];
+          mu = coadd->bias[ninput2-1];
           *(outpix++) = ninput2>1?
 		  (sqrt(val)-sqrt(ninput2-1.0))/sqrt(ninput2-mu*mu)
 		: val0*sqrt(wval0);
@@ -1662,7 +2975,7 @@ int	coadd_line(int l, int b, int *bufmin)
       break;
     case COADD_CHI_MEAN:
       wval0 = 1.0;
-      for (x=coadd_width; x--; inpix+=coadd_nomax, inwpix+=coadd_nomax)
+      for (x=width; x--; inpix+=nomax, inwpix+=nomax)
         {
         ninput = *(inn++);
         ninput2 = 0;
@@ -1674,7 +2987,7 @@ int	coadd_line(int l, int b, int *bufmin)
           {
           val2 = *(inpixt++);
           wval2 = *(inwpixt++);
-          if (wval2<coadd_wthresh && val2>-BIG/2)
+          if (wval2<wthresh && val2>-BIG/2)
             {
             ninput2++;
             val0 = val2;
@@ -1686,7 +2999,7 @@ int	coadd_line(int l, int b, int *bufmin)
           }
         if (ninput2)
           {
-          mu = coadd_bias[ninput2-1];
+          mu = coadd->bias[ninput2-1];
           *(outpix++) = ninput2>1?
 		  (sqrt(val)-mu)/sqrt(ninput2-mu*mu)
 		: val0*sqrt(wval0);
@@ -1701,7 +3014,7 @@ int	coadd_line(int l, int b, int *bufmin)
         }
       break;
     case COADD_SUM:
-      for (x=coadd_width; x--; inpix+=coadd_nomax, inwpix+=coadd_nomax)
+      for (x=width; x--; inpix+=nomax, inwpix+=nomax)
         {
         ninput = *(inn++);
         ninput2 = 0;
@@ -1712,7 +3025,7 @@ int	coadd_line(int l, int b, int *bufmin)
           {
           val2 = *(inpixt++);
           wval2 = *(inwpixt++);
-          if (wval2<coadd_wthresh && val2>-BIG/2)
+          if (wval2<wthresh && val2>-BIG/2)
             {
             ninput2++;
             val += val2;
@@ -1721,6 +3034,12 @@ int	coadd_line(int l, int b, int *bufmin)
           else
             val0 += val;
           }
+        if (sumpix)
+          {
+          *(sumpix++) = val;
+          *(sumwpix++) = wval;
+          *(nsumpix++) = ninput2;
+          }
         if (ninput2)
           {
           *(outpix++) = val;
@@ -1734,7 +3053,7 @@ int	coadd_line(int l, int b, int *bufmin)
         }
       break;
     case COADD_WEIGHTED_WEIGHT:
-      for (x=coadd_width; x--; inpix+=coadd_nomax, inwpix+=coadd_nomax)
+      for (x=width; x--; inpix+=nomax, inwpix+=nomax)
         {
         ninput = *(inn++);
         ninput2 = 0;
@@ -1746,7 +3065,7 @@ int	coadd_line(int l, int b, int *bufmin)
           fval2 = *(inpixt++);
           fval2 = fval2>(1.0/BIG)? 1.0/fval2 : BIG;
           wval2 = *(inwpixt++);
-          if (wval2<coadd_wthresh)
+          if (wval2<wthresh)
             {
             ninput2++;
             wval += (wval2=1.0/wval2);
@@ -1768,7 +3087,7 @@ int	coadd_line(int l, int b, int *bufmin)
         }
       break;
     case COADD_MEDIAN_WEIGHT:
-      for (x=coadd_width; x--; inpix+=coadd_nomax, inwpix+=coadd_nomax)
+      for (x=width; x--; inpix+=nomax, inwpix+=nomax)
         {
         ninput = *(inn++);
         ninput2 = 0;
@@ -1780,7 +3099,7 @@ int	coadd_line(int l, int b, int *bufmin)
           fval2 = *(inpixt++);
           fval2 = fval2>(1.0/BIG)? 1.0/fval2 : BIG;
           wval2 = *(inwpixt++);        
-          if (wval2 < coadd_wthresh)
+          if (wval2 < wthresh)
             {
             val += 1.0/sqrt(fval2);
             val3 += fval2;
@@ -1928,13 +3247,15 @@ PIXTYPE fast_median(PIXTYPE *arr, int n)
 #undef MEDIAN_SWAP
 
 /******* coadd_iload *********************************************************
-PROTO	int coadd_iload(fieldstruct *field, fieldstruct *wfield,
+PROTO	int coadd_iload(coaddstruct *coadd,
+			fieldstruct *field, fieldstruct *wfield,
 			FLAGTYPE *multibuf, FLAGTYPE *multiwibuf,
 			unsigned int *multinbuf,
 			int *rawpos, int *bufmin, int *bufmax,
 			int nlines, int outwidth, int multinmax)
 PURPOSE	Load integer images and weights to coadd in the current buffer.
-INPUT	Input field ptr array,
+INPUT	Pointer to the co-addition context,
+	Input field ptr array,
 	Input weight field ptr array,
 	Flag image buffer,
 	Weight image buffer,
@@ -1949,9 +3270,10 @@ OUTPUT	RETURN_ERROR in case no more data are worth reading,
 	RETURN_OK otherwise.
 NOTES   -.
 AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
-VERSION	21/03/2025
+VERSION	19/10/2026
  ***/
-int	coadd_iload(fieldstruct *field, fieldstruct *wfield,
+int	coadd_iload(coaddstruct *coadd,
+			fieldstruct *field, fieldstruct *wfield,
 			FLAGTYPE *multiibuf, FLAGTYPE *multiwibuf,
 			unsigned int *multinbuf,
 			int *rawpos, int *bufmin, int *bufmax,
@@ -1963,7 +3285,7 @@ int	coadd_iload(fieldstruct *field, fieldstruct *wfield,
     unsigned int	*multinbuf2,
 			d, y, nflag, naxis;
     int			rawpos2[NAXIS],
-			ival, inoffset, inbeg, muloffset, width;
+			cline, ival, inoffset, inbeg, muloffset, width;
 #ifdef USE_THREADS
     unsigned int	threadstep;
 #endif
@@ -1988,9 +3310,9 @@ int	coadd_iload(fieldstruct *field, fieldstruct *wfield,
 
 /* First, the data themselves */
 #ifdef USE_THREADS
-  pthread_wdataflag = 0;
-  pthread_npix = width;
-  pthread_step = multinmax;
+  coadd->mov_wdataflag = 0;
+  coadd->mov_npix = width;
+  coadd->mov_step = multinmax;
   threadstep = 0;
   QMALLOC(lineibuf, FLAGTYPE, 2*field->width);
 #else
@@ -2024,24 +3346,28 @@ int	coadd_iload(fieldstruct *field, fieldstruct *wfield,
           if (ival > 0)
             offset += (OFF_T2)ival*pixcount;
           }
-        QFSEEK(field->cat->file,
+        cline = (int)(offset/field->width);
+        if (!field->compact)
+          {
+          QFSEEK(field->cat->file,
 		field->tab->bodypos+offset*field->tab->bytepix,
 		SEEK_SET, field->filename);
 #ifdef HAVE_CFITSIO
-        field->tab->cfitsio_currentElement = (offset == 0) ? 1 : offset;
+          field->tab->cfitsio_currentElement = (offset == 0) ? 1 : offset;
 #endif // HAVE_CFITSIO
+          }
         }
 #ifdef USE_THREADS
       linei = lineibuf + (threadstep&1)*field->width;
-      read_ibody(field->tab, linei, field->width);
+      coadd_ireadline(field, field->footprint, cline++, linei);
       if (threadstep++)
-        threads_gate_sync(pthread_stopgate2);
-      pthread_lineibuf = linei+inoffset;
-      pthread_multiibuf = multiibuf+muloffset;
-      pthread_multinbuf = multinbuf2+inbeg;
-      threads_gate_sync(pthread_startgate2);
+        threads_gate_sync(coadd->stopgate2);
+      coadd->mov_lineibuf = linei+inoffset;
+      coadd->mov_multiibuf = multiibuf+muloffset;
+      coadd->mov_multinbuf = multinbuf2+inbeg;
+      threads_gate_sync(coadd->startgate2);
 #else
-      read_ibody(field->tab, linei, field->width);
+      coadd_ireadline(field, field->footprint, cline++, linei);
       coadd_moveidata(linei+inoffset,
 		multiibuf+muloffset, multinbuf2+inbeg, width, multinmax);
 #endif
@@ -2091,23 +3417,27 @@ int	coadd_iload(fieldstruct *field, fieldstruct *wfield,
             if (ival > 0)
               offset += ival*pixcount;
             }
-          QFSEEK(wfield->cat->file,
+          cline = (int)(offset/field->width);
+          if (!wfield->compact)
+            {
+            QFSEEK(wfield->cat->file,
 		wfield->tab->bodypos+offset*wfield->tab->bytepix,
 		SEEK_SET, wfield->filename);
 #ifdef HAVE_CFITSIO
-          wfield->tab->cfitsio_currentElement = (offset == 0) ? 1 : offset;
+            wfield->tab->cfitsio_currentElement = (offset == 0) ? 1 : offset;
 #endif // HAVE_CFITSIO
+            }
           }
-        read_ibody(wfield->tab, linei, field->width);
+        coadd_ireadline(wfield, field->footprint, cline++, linei);
         }
 #ifdef USE_THREADS
       if (threadstep++)
-        threads_gate_sync(pthread_stopgate2);
-      pthread_wdataflag = 1;
-      pthread_lineibuf = wfield? (linei+inoffset) : NULL;
-      pthread_multiibuf = multiwibuf+muloffset;
-      pthread_multinbuf = multinbuf2+inbeg;
-      threads_gate_sync(pthread_startgate2);
+        threads_gate_sync(coadd->stopgate2);
+      coadd->mov_wdataflag = 1;
+      coadd->mov_lineibuf = wfield? (linei+inoffset) : NULL;
+      coadd->mov_multiibuf = multiwibuf+muloffset;
+      coadd->mov_multinbuf = multinbuf2+inbeg;
+      threads_gate_sync(coadd->startgate2);
 #else
       coadd_movewidata(wfield? (linei+inoffset) : NULL,
 		multiwibuf+muloffset, multinbuf2+inbeg, width, multinmax);
@@ -2126,7 +3456,7 @@ int	coadd_iload(fieldstruct *field, fieldstruct *wfield,
 
 #ifdef USE_THREADS
   if (threadstep++)
-    threads_gate_sync(pthread_stopgate2);
+    threads_gate_sync(coadd->stopgate2);
 #endif
 
   free(lineibuf);
@@ -2143,13 +3473,15 @@ int	coadd_iload(fieldstruct *field, fieldstruct *wfield,
 
 
 /******* coadd_load **********************************************************
-PROTO	int coadd_load(fieldstruct *field, fieldstruct *wfield,
+PROTO	int coadd_load(coaddstruct *coadd,
+			fieldstruct *field, fieldstruct *wfield,
 			PIXTYPE *multibuf, unsigned int *multiobuf,
 			PIXTYPE *multiwbuf, unsigned int *multinbuf,
 			int *rawpos, int *bufmin, int *bufmax,
 			int nlines, int outwidth, int multinmax, int nfield)
 PURPOSE	Load images and weights to coadd in the current buffer.
-INPUT	Input field ptr array,
+INPUT	Pointer to the co-addition context,
+	Input field ptr array,
 	input weight field ptr array,
 	science image buffer,
         science image origin id buffer,
@@ -2164,11 +3496,13 @@ INPUT	Input field ptr array,
         input origin ID
 OUTPUT	RETURN_ERROR in case no more data are worth reading,
 	RETURN_OK otherwise.
-NOTES   -.
+NOTES   Image pixels are not read and are set to zero in weight-only mode.
+	Origins are only recorded for COADD_CLIPPED.
 AUTHOR  E. Bertin (IAP)
-VERSION 10/03/2014
+VERSION 19/10/2026
  ***/
-int	coadd_load(fieldstruct *field, fieldstruct *wfield,
+int	coadd_load(coaddstruct *coadd,
+			fieldstruct *field, fieldstruct *wfield,
 			PIXTYPE *multibuf, unsigned int *multiobuf,
 			PIXTYPE *multiwbuf, unsigned int *multinbuf,
 			int *rawpos, int *bufmin, int *bufmax,
@@ -2181,7 +3515,7 @@ int	coadd_load(fieldstruct *field, fieldstruct *wfield,
     unsigned int	*multinbuf2,
 			d, x,y, nflag, naxis;
     int			rawpos2[NAXIS],
-			ival, inoffset, inbeg, muloffset, width;
+			cline, ival, inoffset, inbeg, muloffset, width;
 #ifdef USE_THREADS
     unsigned int	threadstep;
 #endif
@@ -2204,15 +3538,15 @@ int	coadd_load(fieldstruct *field, fieldstruct *wfield,
   else if (width > field->width)
     width = field->width;
 
-/* First, the data themselves */
+/* First, the data themselves (left to zero in weight-only mode) */
 #ifdef USE_THREADS
-  pthread_wdataflag = 0;
-  pthread_npix = width;
-  pthread_step = multinmax;
+  coadd->mov_wdataflag = 0;
+  coadd->mov_npix = width;
+  coadd->mov_step = multinmax;
   threadstep = 0;
-  QMALLOC(linebuf, PIXTYPE, 2*field->width);
+  QCALLOC(linebuf, PIXTYPE, 2*field->width);
 #else
-  QMALLOC(linebuf, PIXTYPE, field->width);
+  QCALLOC(linebuf, PIXTYPE, field->width);
   line = linebuf;
 #endif
   for (d=naxis; --d;)
@@ -2242,29 +3576,38 @@ int	coadd_load(fieldstruct *field, fieldstruct *wfield,
           if (ival > 0)
             offset += (OFF_T2)ival*pixcount;
           }
-        QFSEEK(field->cat->file,
+        cline = (int)(offset/field->width);
+        if (!coadd->wonlyflag && !field->compact)
+          {
+          QFSEEK(field->cat->file,
 		field->tab->bodypos+offset*field->tab->bytepix,
 		SEEK_SET, field->filename);
 #ifdef HAVE_CFITSIO
-        field->tab->cfitsio_currentElement = (offset == 0) ? 1 : offset;
+          field->tab->cfitsio_currentElement = (offset == 0) ? 1 : offset;
 #endif // HAVE_CFITSIO
+          }
         }
 #ifdef USE_THREADS
       line = linebuf+(threadstep&1)*field->width;
-      read_body(field->tab, line, field->width);
+      if (!coadd->wonlyflag)
+        coadd_readline(field, field->footprint, cline, line);
+      cline++;
       if (threadstep++)
-        threads_gate_sync(pthread_stopgate2);
-      pthread_linebuf = line+inoffset;
-      pthread_multibuf = multibuf+muloffset;
-      pthread_multiobuf = multiobuf+muloffset;
-      pthread_origin    = &oid;
-      pthread_multinbuf = multinbuf2+inbeg;
-      threads_gate_sync(pthread_startgate2);
+        threads_gate_sync(coadd->stopgate2);
+      coadd->mov_linebuf = line+inoffset;
+      coadd->mov_multibuf = multibuf+muloffset;
+      coadd->mov_multiobuf = coadd->type==COADD_CLIPPED?
+					(multiobuf+muloffset) : NULL;
+      coadd->mov_origin    = &oid;
+      coadd->mov_multinbuf = multinbuf2+inbeg;
+      threads_gate_sync(coadd->startgate2);
 #else
-      read_body(field->tab, line, field->width);
-      coadd_movedata(line+inoffset,
-		multibuf+muloffset, multiobuf+muloffset, multinbuf2+inbeg,
-		width, multinmax, oid);
+      if (!coadd->wonlyflag)
+        coadd_readline(field, field->footprint, cline, line);
+      cline++;
+      coadd_movedata(line+inoffset, multibuf+muloffset,
+		coadd->type==COADD_CLIPPED? (multiobuf+muloffset) : NULL,
+		multinbuf2+inbeg, width, multinmax, oid);
 #endif
       multibuf += (size_t)outwidth*multinmax;
       multiobuf += outwidth*multinmax;
@@ -2313,14 +3656,18 @@ int	coadd_load(fieldstruct *field, fieldstruct *wfield,
             if (ival > 0)
               offset += ival*pixcount;
             }
-          QFSEEK(wfield->cat->file,
+          cline = (int)(offset/field->width);
+          if (!wfield->compact)
+            {
+            QFSEEK(wfield->cat->file,
 		wfield->tab->bodypos+offset*wfield->tab->bytepix,
 		SEEK_SET, wfield->filename);
 #ifdef HAVE_CFITSIO
-      	wfield->tab->cfitsio_currentElement = (offset == 0) ? 1 : offset;
+            wfield->tab->cfitsio_currentElement = (offset == 0) ? 1 : offset;
 #endif // HAVE_CFITSIO
+            }
           }
-        read_body(wfield->tab, line, field->width);
+        coadd_readline(wfield, field->footprint, cline++, line);
         if ((thresh=wfield->weight_thresh)>0.0)
           {
           linet = line;
@@ -2331,12 +3678,12 @@ int	coadd_load(fieldstruct *field, fieldstruct *wfield,
         }
 #ifdef USE_THREADS
       if (threadstep++)
-        threads_gate_sync(pthread_stopgate2);
-      pthread_wdataflag = 1;
-      pthread_linebuf = (wfield? (line+inoffset) : NULL);
-      pthread_multibuf = multiwbuf+muloffset;
-      pthread_multinbuf = multinbuf2+inbeg;
-      threads_gate_sync(pthread_startgate2);
+        threads_gate_sync(coadd->stopgate2);
+      coadd->mov_wdataflag = 1;
+      coadd->mov_linebuf = (wfield? (line+inoffset) : NULL);
+      coadd->mov_multibuf = multiwbuf+muloffset;
+      coadd->mov_multinbuf = multinbuf2+inbeg;
+      threads_gate_sync(coadd->startgate2);
 #else
       coadd_movewdata(wfield? (line+inoffset) : NULL,
 		multiwbuf+muloffset, multinbuf2+inbeg, width, multinmax);
@@ -2355,7 +3702,7 @@ int	coadd_load(fieldstruct *field, fieldstruct *wfield,
 
 #ifdef USE_THREADS
   if (threadstep++)
-    threads_gate_sync(pthread_stopgate2);
+    threads_gate_sync(coadd->stopgate2);
 #endif
 
   free(linebuf);
@@ -2371,44 +3718,196 @@ int	coadd_load(fieldstruct *field, fieldstruct *wfield,
   }
 
 
+/******* coadd_prefetch ******************************************************
+PROTO	void coadd_prefetch(fieldstruct *field, int ybeg, int ybuf,
+			int nbuflines)
+PURPOSE	Start reading ahead the lines of an input image that overlap a range
+	of buffer lines.
+INPUT	Input field ptr (can be NULL),
+	first buffer line of the input image,
+	first buffer line of the range,
+	number of buffer lines in the range.
+OUTPUT	-.
+NOTES	Read-ahead is asynchronous: this function returns immediately. The
+	input file is opened temporarily if needed. Only uncompressed 2D
+	images are handled.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+static void	coadd_prefetch(fieldstruct *field, int ybeg, int ybuf,
+			int nbuflines)
+  {
+#ifdef HAVE_POSIX_FADVISE
+   OFF_T2	linesize;
+   int		fd, ymin, ymax;
+
+  if (!field || field->compact || field->tab->naxis != 2
+	|| field->tab->compress_type != COMPRESS_NONE
+	|| field->tab->isTileCompressed)
+    return;
+/* Range of input lines */
+  if ((ymin = ybuf - ybeg) < 0)
+    ymin = 0;
+  if ((ymax = ybuf + nbuflines - ybeg) > field->height)
+    ymax = field->height;
+  if (ymax <= ymin)
+    return;
+
+  if (field->cat->file)
+    fd = fileno(field->cat->file);
+  else if ((fd = open(field->cat->filename, O_RDONLY)) == -1)
+    return;
+  linesize = (OFF_T2)field->width*field->tab->bytepix;
+  posix_fadvise(fd, (off_t)(field->tab->bodypos + ymin*linesize),
+	(off_t)((ymax-ymin)*linesize), POSIX_FADV_WILLNEED);
+  if (!field->cat->file)
+    close(fd);
+#endif
+
+  return;
+  }
+
+
+/******* coadd_readline ******************************************************
+PROTO	void coadd_readline(fieldstruct *field, footprintstruct *footprint,
+			int y, PIXTYPE *line)
+PURPOSE	Read a line of a (resampled) input image or weight-map.
+INPUT	Input field ptr,
+	footprint of the resampled image (can be NULL),
+	line number,
+	pointer to the output line.
+OUTPUT	-.
+NOTES	Without footprint, the FITS file must be positioned at the beginning
+	of the line. Pixels outside the footprint are set to zero without
+	being read, as written by resample_field().
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+static void	coadd_readline(fieldstruct *field, footprintstruct *footprint,
+			int y, PIXTYPE *line)
+  {
+   int	*xrange;
+
+  if (field->compact)
+    {
+    read_compact(field, y, line);
+    return;
+    }
+#ifdef HAVE_CFITSIO
+  if (field->cat->cfitsio_infptr)
+    footprint = NULL;
+#endif
+  if (!footprint)
+    {
+    read_body(field->tab, line, field->width);
+    return;
+    }
+
+  xrange = footprint->xrange + 2*y;
+  memset(line, 0, xrange[0]*sizeof(PIXTYPE));
+  memset(line+xrange[1], 0, (field->width-xrange[1])*sizeof(PIXTYPE));
+  if (xrange[1] > xrange[0])
+    {
+    QFSEEK(field->cat->file, field->tab->bodypos
+	+ ((OFF_T2)y*field->width + xrange[0])*field->tab->bytepix,
+	SEEK_SET, field->filename);
+    read_body(field->tab, line+xrange[0], xrange[1]-xrange[0]);
+    }
+
+  return;
+  }
+
+
+/******* coadd_ireadline *****************************************************
+PROTO	void coadd_ireadline(fieldstruct *field, footprintstruct *footprint,
+			int y, FLAGTYPE *line)
+PURPOSE	Read a line of a (resampled) input flag image or flag weight-map.
+INPUT	Input field ptr,
+	footprint of the resampled image (can be NULL),
+	line number,
+	pointer to the output line.
+OUTPUT	-.
+NOTES	See coadd_readline().
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+static void	coadd_ireadline(fieldstruct *field, footprintstruct *footprint,
+			int y, FLAGTYPE *line)
+  {
+   int	*xrange;
+
+  if (field->compact)
+    {
+    read_icompact(field, y, line);
+    return;
+    }
+#ifdef HAVE_CFITSIO
+  if (field->cat->cfitsio_infptr)
+    footprint = NULL;
+#endif
+  if (!footprint)
+    {
+    read_ibody(field->tab, line, field->width);
+    return;
+    }
+
+  xrange = footprint->xrange + 2*y;
+  memset(line, 0, xrange[0]*sizeof(FLAGTYPE));
+  memset(line+xrange[1], 0, (field->width-xrange[1])*sizeof(FLAGTYPE));
+  if (xrange[1] > xrange[0])
+    {
+    QFSEEK(field->cat->file, field->tab->bodypos
+	+ ((OFF_T2)y*field->width + xrange[0])*field->tab->bytepix,
+	SEEK_SET, field->filename);
+    read_ibody(field->tab, line+xrange[0], xrange[1]-xrange[0]);
+    }
+
+  return;
+  }
+
+
 #ifdef USE_THREADS
 
 /****** pthread_move_lines ***************************************************
 PROTO	void *pthread_move_lines(void *arg)
 PURPOSE	thread that takes care of moving image "lines" from the input to the
 	co-addition buffer
-INPUT	Pointer to the thread number (unused).
+INPUT	Pointer to the co-addition context.
 OUTPUT	-.
 NOTES	-.
-AUTHOR	E. Bertin (IAP)
-VERSION	10/03/2014
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
  ***/
 void	*pthread_move_lines(void *arg)
   {
-  threads_gate_sync(pthread_startgate2);
-  while (!pthread_endflag)
+   coaddstruct	*coadd;
+
+  coadd = (coaddstruct *)arg;
+  threads_gate_sync(coadd->startgate2);
+  while (!coadd->endflag)
     {
-    if (pthread_wdataflag)
+    if (coadd->mov_wdataflag)
       {
-      if (iflag)
-        coadd_movewidata(pthread_lineibuf, pthread_multiibuf, pthread_multinbuf,
-		pthread_npix, pthread_step);
+      if (coadd->iflag)
+        coadd_movewidata(coadd->mov_lineibuf, coadd->mov_multiibuf,
+		coadd->mov_multinbuf, coadd->mov_npix, coadd->mov_step);
       else
-        coadd_movewdata(pthread_linebuf, pthread_multibuf, pthread_multinbuf,
-		pthread_npix, pthread_step);
+        coadd_movewdata(coadd->mov_linebuf, coadd->mov_multibuf,
+		coadd->mov_multinbuf, coadd->mov_npix, coadd->mov_step);
       }
     else
       {
-      if (iflag)
-        coadd_moveidata(pthread_lineibuf, pthread_multiibuf, pthread_multinbuf,
-		pthread_npix, pthread_step);
+      if (coadd->iflag)
+        coadd_moveidata(coadd->mov_lineibuf, coadd->mov_multiibuf,
+		coadd->mov_multinbuf, coadd->mov_npix, coadd->mov_step);
       else
-        coadd_movedata(pthread_linebuf, pthread_multibuf, pthread_multiobuf,
-		pthread_multinbuf, pthread_npix, pthread_step, *pthread_origin);
+        coadd_movedata(coadd->mov_linebuf, coadd->mov_multibuf,
+		coadd->mov_multiobuf, coadd->mov_multinbuf, coadd->mov_npix,
+		coadd->mov_step, *coadd->mov_origin);
       }
-    threads_gate_sync(pthread_stopgate2);
+    threads_gate_sync(coadd->stopgate2);
 /*-- ( Master thread loads new data here ) */
-    threads_gate_sync(pthread_startgate2);
+    threads_gate_sync(coadd->startgate2);
     }
 
   pthread_exit(NULL);
@@ -2425,15 +3924,15 @@ PROTO	void coadd_movedata(PIXTYPE *linebuf, PIXTYPE *multibuf,
 PURPOSE	Move data from the input load buffer to the co-addition buffer.
 INPUT	Input Buffer,
 	co-addition buffer,
-        origin id buffer
+        origin id buffer (or NULL),
 	number-of-inputs buffer,
 	number of pixels to process,
 	step in pixels of the co-addition buffer
         origin id.
 OUTPUT	-.
-NOTES   -.
-AUTHOR  E. Bertin (IAP)
-VERSION 10/03/2014
+NOTES   Origins are only recorded if an origin id buffer is provided.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
  ***/
 void	coadd_movedata(PIXTYPE *linebuf, PIXTYPE *multibuf,
 			unsigned int *multiobuf, unsigned int *multinbuf,
@@ -2449,7 +3948,7 @@ void	coadd_movedata(PIXTYPE *linebuf, PIXTYPE *multibuf,
   for (x=npix; x--;  multi += step)
     *(multi+*(multin++)) = *(pix++);
 
-  if(coadd_type==COADD_CLIPPED)
+  if (multiobuf)
     {
     multo = multiobuf;
     multin = multinbuf;
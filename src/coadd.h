@@ -22,7 +22,7 @@
 *	You should have received a copy of the GNU General Public License
 *	along with SWarp. If not, see <http://www.gnu.org/licenses/>.
 *
-*	Last modified:		10/03/2014
+*	Last modified:		19/10/2026
 *
 *%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
 
@@ -34,10 +34,26 @@
 #include "field.h"
 #endif
 
+#ifndef _NUMA_H_
+#include "numa.h"
+#endif
+
+#ifdef USE_THREADS
+#include "threads.h"
+#endif
+
 #ifndef	_COADD_H_
 #define	_COADD_H_
 
 /*-------------------------------- macros -----------------------------------*/
+/* Bit (x,y) of the overlap graph of n inputs, stored as a bit array */
+#define	ARRAY_BIT(array,n,x,y) \
+	((array)[((y)/(8*sizeof(unsigned int)))*(n)+(x)] \
+		& (1U<<((y)%(8*sizeof(unsigned int)))))
+#define	SET_ARRAY_BIT(array,n,x,y) \
+	((array)[((y)/(8*sizeof(unsigned int)))*(n)+(x)] \
+		|= (1U<<((y)%(8*sizeof(unsigned int)))))
+
 /*------------------------------- constants ---------------------------------*/
 #define	COADDFLAG_OPEN		0x01
 #define	COADDFLAG_FINISHED	0x02
@@ -58,6 +74,122 @@ typedef struct coaddact
   enum {COADDACT_OPEN, COADDACT_CLOSE, COADDACT_LOAD}	com;
   }	coaddactstruct;
 
+/* Sweep-line index of input footprints along output buffer lines */
+typedef struct coaddindex
+  {
+  int	*order;			/* Input indices sorted by first buffer line */
+  int	*ybeg;			/* First buffer line of each input */
+  int	*active;		/* Active input indices (increasing order) */
+  int	*work;			/* Work array for merging new inputs */
+  int	ninput;			/* Total number of inputs */
+  int	nactive;		/* Number of active inputs */
+  int	next;			/* Next entry in order[] to activate */
+  }	coaddindexstruct;
+
+/* Co-addition context of an output frame */
+typedef struct coadd
+  {
+  coaddenum	type;			/* Co-addition type */
+  PIXTYPE	wthresh;		/* Weight threshold */
+  double	*bias;			/* Biases for CHI combine types */
+  double	*sumbuf, *sumwbuf;	/* Accumulators for COMBINE_STATE */
+  unsigned int	*nsumbuf;		/* Input counts for COMBINE_STATE */
+  PIXTYPE	*multibuf, *multiwbuf;	/* Packed input pixels and weights */
+  FLAGTYPE	*multiibuf, *multiwibuf;/* Packed input flags and weights */
+  unsigned int	*multinbuf;		/* Number of inputs per pixel */
+  unsigned int	*multiobuf;		/* Origin of packed input pixels */
+  PIXTYPE	*outbuf, *outwbuf;	/* Co-added pixels and weights */
+  FLAGTYPE	*outibuf, *outwibuf;	/* Co-added flags and weights */
+  PIXTYPE	*pixstack, *pixfstack;	/* Pixel stacks */
+  int		nomax;			/* Max. number of inputs per pixel */
+  int		width;			/* Useful width of buffer lines */
+  int		iflag;			/* Integer (flag) data? */
+  int		wonlyflag;		/* Weight-only mode? */
+  FILE		*cliplog;		/* Clipping log (COADD_CLIPPED) */
+  int		clipownflag;		/* Clipping log opened here? */
+  fieldstruct	**infield;		/* Input fields */
+  size_t	bufsize;		/* Co-addition buffer size (bytes) */
+  int		nopenfiles_max;		/* Max. number of open input files */
+  int		nthreads;		/* Co-addition threads (0=caller) */
+  int		perfslot;		/* Slot of the calling thread */
+  int		concflag;		/* Runs concurrently with others? */
+  struct coaddmef	*mef;		/* MEF extension positions (or NULL) */
+  int		mefrank;		/* Rank of the extension in MEFs */
+#ifdef USE_THREADS
+  pthread_mutex_t	*lock;		/* Lock on shared metadata (or NULL) */
+  pthread_t		movthread;	/* Data mover thread */
+  pthread_mutex_t	mutex;		/* Line dispatching mutex */
+  threads_gate_t	*startgate, *stopgate;	/* Co-addition gates */
+  threads_gate_t	*startgate2, *stopgate2;/* Data mover gates */
+  threads_gate_t	*numagate;		/* NUMA first-touch gate */
+  FLAGTYPE		*mov_lineibuf;		/* Flag line to move */
+  FLAGTYPE		*mov_multiibuf;		/* Flag destination */
+  PIXTYPE		*mov_linebuf;		/* Pixel line to move */
+  PIXTYPE		*mov_multibuf;		/* Pixel destination */
+  unsigned int		*mov_multinbuf;		/* Input counts to update */
+  unsigned int		*mov_multiobuf;		/* Origin destination */
+  unsigned int		*mov_origin;		/* Origin id of the line */
+  int			mov_npix, mov_step;	/* Moved line geometry */
+  int			mov_wdataflag;		/* Moving weights? */
+  int			*baseline_y;		/* First line of the buffer */
+  int			*bufmin;		/* Buffer lower limits */
+  int			nodebufline[NUMA_MAXNODE];	/* Next line per node */
+  int			nodebufend[NUMA_MAXNODE];	/* Last line per node */
+  int			nnode;			/* Number of NUMA nodes */
+  int			nbuflinesmax;		/* Number of buffer lines */
+  int			endflag;		/* End of co-addition? */
+#endif
+  }	coaddstruct;
+
+/* Co-addition task argument */
+typedef struct coaddtask
+  {
+  coaddstruct	*coadd;			/* Co-addition context */
+  int		p;			/* Task number */
+  }	coaddtaskstruct;
+
+/* Ordered placement of extensions in MEF outputs */
+typedef struct coaddmef
+  {
+  OFF_T2	pos, wpos;		/* Next extension positions */
+  int		next;			/* Rank of the next extension */
+#ifdef USE_THREADS
+  pthread_mutex_t	mutex;		/* Placement mutex */
+  pthread_cond_t	cond;		/* Signals a new placement */
+#endif
+  }	coaddmefstruct;
+
+/* Sky tile */
+typedef struct skytile
+  {
+  fieldstruct	**infield, **inwfield;	/* Overlapping inputs */
+  int		ninput;			/* Number of overlapping inputs */
+  int		tpos[2];		/* Position in the tile grid */
+  int		tilemin[2];		/* First output pixel */
+  int		tilesize[2];		/* Tile size (pixels) */
+  int		mefrank;		/* Rank of the extension in MEFs */
+  }	skytilestruct;
+
+/* Sky tiling of an output frame */
+typedef struct skytiles
+  {
+  skytilestruct	*tile;			/* Array of tiles */
+  int		ntile;			/* Number of tiles */
+  int		next;			/* Next tile to co-add */
+  fieldstruct	*outfield, *outwfield;	/* Output (parent) frames */
+  coaddenum	coaddtype;		/* Co-addition type */
+  PIXTYPE	wthresh;		/* Weight threshold */
+  int		nconc;			/* Number of concurrent tiles */
+  FILE		*cliplog;		/* Common clipping log (or NULL) */
+  double	exptime;		/* Max. exposure time of tiles */
+  int		fieldno;		/* Max. overlap density of tiles */
+  coaddmefstruct	mef;		/* MEF extension positions */
+  int		status;			/* Return status */
+#ifdef USE_THREADS
+  pthread_mutex_t	mutex;		/* Tile set-up and metadata mutex */
+#endif
+  }	skytilesstruct;
+
 /*----------------------- miscellaneous variables ---------------------------*/
 
 /*-------------------------------- protos -----------------------------------*/
@@ -66,6 +198,10 @@ extern int	coadd_fields(fieldstruct **infield, fieldstruct **inwfield,
 			int ninput, fieldstruct *outfield,
 			fieldstruct *outwfield,
 			coaddenum coaddtype, PIXTYPE wthresh),
+		coadd_skytiles(fieldstruct **infield, fieldstruct **inwfield,
+			int ninput, fieldstruct *outfield,
+			fieldstruct *outwfield,
+			coaddenum coaddtype, PIXTYPE wthresh),
 		max_clique(unsigned int *array, int nnode, int **max);
 extern void	coadd_movedata(PIXTYPE *linebuf, PIXTYPE *multibuf,
 			unsigned int *multiobuf, unsigned int *multinbuf,
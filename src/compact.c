@@ -0,0 +1,576 @@
+/*
+*				compact.c
+*
+* Read and write compact temporary files for resampled data.
+*
+*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+*
+*	This file part of:	SWarp
+*
+*	Copyright:		(C) 2026 CEA/AIM/UParisSaclay
+*
+*	License:		GNU General Public License
+*
+*	SWarp is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*	SWarp is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU General Public License for more details.
+*	You should have received a copy of the GNU General Public License
+*	along with SWarp. If not, see <http://www.gnu.org/licenses/>.
+*
+*	Last modified:		19/10/2026
+*
+*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+
+#ifdef HAVE_CONFIG_H
+#include	"config.h"
+#endif
+
+#ifdef HAVE_MATHIMF_H
+#include <mathimf.h>
+#else
+#include <math.h>
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "define.h"
+#include "globals.h"
+#include "fits/fitscat.h"
+#include "compact.h"
+#include "field.h"
+
+/*
+ A compact file starts with a small header (signature, packing type,
+ floating-point flag, line width, number of lines and position of the line
+ table), followed by the packed lines and by the line table. Only the
+ [xmin, xmin+npix[ range of non-zero pixels is stored for each line.
+ Compact files are native-endian temporary files; the line table is kept in
+ memory between resampling and co-addition.
+*/
+
+static unsigned short	compact_tohalf(float f);
+
+static float		compact_fromhalf(unsigned short h);
+
+static int		compact_pack(unsigned char *in, int n,
+				unsigned char *out),
+			compact_unpack(unsigned char *in, int nin,
+				unsigned char *out, int nout);
+
+static void		compact_shuffle(unsigned char *in, int npix,
+				unsigned char *out),
+			compact_unshuffle(unsigned char *in, int npix,
+				unsigned char *out);
+
+/****** init_compact *********************************************************
+PROTO	compactstruct *init_compact(fieldstruct *field, cpackenum pack,
+				int floatflag)
+PURPOSE	Prepare a field for being written as a compact temporary file.
+INPUT	Pointer to the field,
+	packing type,
+	floating-point flag (0 for integer pixels).
+OUTPUT	Pointer to the new compact structure.
+NOTES	The field catalog must have been opened for writing. FLOAT16 packing
+	falls back to lossless SHUFFLE packing for integer pixels.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+compactstruct	*init_compact(fieldstruct *field, cpackenum pack,
+				int floatflag)
+  {
+   compactstruct	*compact;
+   OFF_T2		tabpos;
+   int			head[4];
+
+  QCALLOC(compact, compactstruct, 1);
+  compact->pack = (pack==CPACK_FLOAT16 && !floatflag)? CPACK_SHUFFLE : pack;
+  compact->floatflag = floatflag;
+  compact->width = field->width;
+  compact->nlinemax = field->height;
+  QCALLOC(compact->line, compactlinestruct, compact->nlinemax);
+/* Worst case for byte-run packing is one extra byte per 128 bytes */
+  QMALLOC(compact->buf, unsigned char, 4*compact->width+compact->width/32+16);
+  QMALLOC(compact->buf2, unsigned char, 4*compact->width+compact->width/32+16);
+
+/* Write the file header; the table position is updated by end_compact() */
+  head[0] = (int)compact->pack;
+  head[1] = floatflag;
+  head[2] = compact->width;
+  head[3] = compact->nlinemax;
+  tabpos = 0;
+  QFWRITE(COMPACT_MAGIC, 8, field->cat->file, field->filename);
+  QFWRITE(head, sizeof(head), field->cat->file, field->filename);
+  QFWRITE(&tabpos, sizeof(tabpos), field->cat->file, field->filename);
+  compact->pos = 8 + sizeof(head) + sizeof(tabpos);
+
+  return compact;
+  }
+
+
+/****** write_compact ********************************************************
+PROTO	void write_compact(fieldstruct *field, void *ptr)
+PURPOSE	Crop, pack and write the next line of a compact file.
+INPUT	Pointer to the field,
+	pointer to the line (PIXTYPE or FLAGTYPE).
+OUTPUT	-.
+NOTES	Lines must be written in order.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+void	write_compact(fieldstruct *field, void *ptr)
+  {
+   compactstruct	*compact;
+   compactlinestruct	*cline;
+   unsigned int		*pix;
+   unsigned short	*hpix;
+   float		*fpix;
+   unsigned char	*data;
+   double		maxabs, val, scale;
+   int			x, xmin, xmax, npix, nbytes, expo;
+
+  compact = field->compact;
+  if (compact->nline >= compact->nlinemax)
+    error(EXIT_FAILURE, "*Internal Error*: too many lines written to ",
+	field->filename);
+
+/* Find the extent of non-zero pixels (zeros are checked bitwise) */
+  pix = (unsigned int *)ptr;
+  for (xmin=0; xmin<compact->width && !pix[xmin]; xmin++);
+  for (xmax=compact->width-1; xmax>=xmin && !pix[xmax]; xmax--);
+  npix = xmax - xmin + 1;
+
+  cline = compact->line + compact->nline++;
+  cline->pos = compact->pos;
+  cline->xmin = xmin;
+  cline->npix = npix;
+  cline->expo = 0;
+  if (!npix)
+    {
+    cline->nbytes = 0;
+    return;
+    }
+
+  switch(compact->pack)
+    {
+    case CPACK_SHUFFLE:
+      compact_shuffle((unsigned char *)(pix+xmin), npix, compact->buf2);
+      nbytes = compact_pack(compact->buf2, 4*npix, compact->buf);
+      data = compact->buf;
+      break;
+    case CPACK_FLOAT16:
+/*---- Choose a power-of-2 scaling that keeps the line within half range */
+      fpix = (float *)ptr + xmin;
+      maxabs = 0.0;
+      for (x=npix; x--; fpix++)
+        if (isfinite(*fpix) && (val=fabs(*fpix))>maxabs)
+          maxabs = val;
+      expo = 0;
+      if (maxabs>0.0)
+        {
+        frexp(maxabs, &expo);
+        expo = 15 - expo;
+        }
+      cline->expo = expo;
+      scale = ldexp(1.0, expo);
+      fpix = (float *)ptr + xmin;
+      hpix = (unsigned short *)compact->buf;
+      for (x=npix; x--;)
+        *(hpix++) = compact_tohalf((float)(*(fpix++)*scale));
+      nbytes = 2*npix;
+      data = compact->buf;
+      break;
+    case CPACK_NONE:
+    default:
+      nbytes = 4*npix;
+      data = (unsigned char *)(pix+xmin);
+      break;
+    }
+
+  QFWRITE(data, nbytes, field->cat->file, field->filename);
+  cline->nbytes = nbytes;
+  compact->pos += nbytes;
+  compact->nbytes += nbytes;
+
+  return;
+  }
+
+
+/****** end_compact **********************************************************
+PROTO	void end_compact(fieldstruct *field)
+PURPOSE	Write the line table of a compact file and update its header.
+INPUT	Pointer to the field.
+OUTPUT	-.
+NOTES	The line table remains available in memory for reading.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+void	end_compact(fieldstruct *field)
+  {
+   compactstruct	*compact;
+   OFF_T2		tabpos;
+
+  compact = field->compact;
+  tabpos = compact->pos;
+  QFWRITE(compact->line, compact->nline*sizeof(compactlinestruct),
+	field->cat->file, field->filename);
+  QFSEEK(field->cat->file, 8 + 4*sizeof(int), SEEK_SET, field->filename);
+  QFWRITE(&tabpos, sizeof(tabpos), field->cat->file, field->filename);
+
+  return;
+  }
+
+
+/****** free_compact *********************************************************
+PROTO	void free_compact(compactstruct *compact)
+PURPOSE	Free a compact structure.
+INPUT	Pointer to the compact structure.
+OUTPUT	-.
+NOTES	-.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+void	free_compact(compactstruct *compact)
+  {
+  free(compact->line);
+  free(compact->buf);
+  free(compact->buf2);
+  free(compact);
+
+  return;
+  }
+
+
+/****** read_compact *********************************************************
+PROTO	void read_compact(fieldstruct *field, int y, PIXTYPE *ptr)
+PURPOSE	Read and unpack a line of floating-point data from a compact file.
+INPUT	Pointer to the field,
+	line index,
+	pointer to the output line.
+OUTPUT	-.
+NOTES	The BSCALE and BZERO of the field are applied, and non-finite values
+	are converted to -BIG, as done by read_body().
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+void	read_compact(fieldstruct *field, int y, PIXTYPE *ptr)
+  {
+   compactstruct	*compact;
+   compactlinestruct	*cline;
+   PIXTYPE		*pix;
+   unsigned short	*hpix;
+   double		bs, bz, scale;
+   int			x, xmax;
+
+  compact = field->compact;
+  if (y<0 || y>=compact->nline)
+    error(EXIT_FAILURE, "*Internal Error*: line out of range in ",
+	field->filename);
+  cline = compact->line + y;
+  bs = field->tab->bscale;
+  bz = field->tab->bzero;
+
+/* Pixels outside the stored range are zero */
+  xmax = cline->xmin + cline->npix;
+  for (x=0; x<cline->xmin; x++)
+    ptr[x] = (PIXTYPE)bz;
+  for (x=xmax; x<compact->width; x++)
+    ptr[x] = (PIXTYPE)bz;
+  if (!cline->npix)
+    return;
+
+  QFSEEK(field->cat->file, cline->pos, SEEK_SET, field->filename);
+  QFREAD(compact->buf, cline->nbytes, field->cat->file, field->filename);
+  pix = ptr + cline->xmin;
+  switch(compact->pack)
+    {
+    case CPACK_SHUFFLE:
+      if (compact_unpack(compact->buf, cline->nbytes, compact->buf2,
+		4*cline->npix) != RETURN_OK)
+        error(EXIT_FAILURE, "*Error*: corrupted data in ", field->filename);
+      compact_unshuffle(compact->buf2, cline->npix, (unsigned char *)pix);
+      break;
+    case CPACK_FLOAT16:
+      scale = ldexp(1.0, -cline->expo);
+      hpix = (unsigned short *)compact->buf;
+      for (x=cline->npix; x--;)
+        *(pix++) = (PIXTYPE)(compact_fromhalf(*(hpix++))*scale);
+      pix = ptr + cline->xmin;
+      break;
+    case CPACK_NONE:
+    default:
+      memcpy(pix, compact->buf, cline->nbytes);
+      break;
+    }
+
+  for (x=cline->npix; x--; pix++)
+    *pix = ((0x7f800000&*(unsigned int *)pix) == 0x7f800000)?
+		-BIG : *pix*bs + bz;
+
+  return;
+  }
+
+
+/****** read_icompact ********************************************************
+PROTO	void read_icompact(fieldstruct *field, int y, FLAGTYPE *ptr)
+PURPOSE	Read and unpack a line of integer data from a compact file.
+INPUT	Pointer to the field,
+	line index,
+	pointer to the output line.
+OUTPUT	-.
+NOTES	-.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+void	read_icompact(fieldstruct *field, int y, FLAGTYPE *ptr)
+  {
+   compactstruct	*compact;
+   compactlinestruct	*cline;
+   int			xmax;
+
+  compact = field->compact;
+  if (y<0 || y>=compact->nline)
+    error(EXIT_FAILURE, "*Internal Error*: line out of range in ",
+	field->filename);
+  cline = compact->line + y;
+
+  xmax = cline->xmin + cline->npix;
+  memset(ptr, 0, cline->xmin*sizeof(FLAGTYPE));
+  memset(ptr+xmax, 0, (compact->width-xmax)*sizeof(FLAGTYPE));
+  if (!cline->npix)
+    return;
+
+  QFSEEK(field->cat->file, cline->pos, SEEK_SET, field->filename);
+  QFREAD(compact->buf, cline->nbytes, field->cat->file, field->filename);
+  if (compact->pack == CPACK_SHUFFLE)
+    {
+    if (compact_unpack(compact->buf, cline->nbytes, compact->buf2,
+		4*cline->npix) != RETURN_OK)
+      error(EXIT_FAILURE, "*Error*: corrupted data in ", field->filename);
+    compact_unshuffle(compact->buf2, cline->npix,
+		(unsigned char *)(ptr+cline->xmin));
+    }
+  else
+    memcpy(ptr+cline->xmin, compact->buf, cline->nbytes);
+
+  return;
+  }
+
+
+/****** compact_shuffle ******************************************************
+PROTO	void compact_shuffle(unsigned char *in, int npix, unsigned char *out)
+PURPOSE	Regroup the bytes of 4-byte pixels by significance.
+INPUT	Pointer to the input pixels,
+	number of pixels,
+	pointer to the output byte planes.
+OUTPUT	-.
+NOTES	Bytes with the same rank tend to be similar in smooth data, which
+	makes byte-run packing efficient.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+static void	compact_shuffle(unsigned char *in, int npix, unsigned char *out)
+  {
+   int	b, i;
+
+  for (b=0; b<4; b++)
+    for (i=0; i<npix; i++)
+      *(out++) = in[4*i+b];
+
+  return;
+  }
+
+
+/****** compact_unshuffle ****************************************************
+PROTO	void compact_unshuffle(unsigned char *in, int npix, unsigned char *out)
+PURPOSE	Rebuild 4-byte pixels from byte planes.
+INPUT	Pointer to the input byte planes,
+	number of pixels,
+	pointer to the output pixels.
+OUTPUT	-.
+NOTES	-.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+static void	compact_unshuffle(unsigned char *in, int npix,
+			unsigned char *out)
+  {
+   int	b, i;
+
+  for (b=0; b<4; b++)
+    for (i=0; i<npix; i++)
+      out[4*i+b] = *(in++);
+
+  return;
+  }
+
+
+/****** compact_pack *********************************************************
+PROTO	int compact_pack(unsigned char *in, int n, unsigned char *out)
+PURPOSE	Byte-run packing of a buffer.
+INPUT	Pointer to the input bytes,
+	number of input bytes,
+	pointer to the output buffer.
+OUTPUT	Number of packed bytes.
+NOTES	Control bytes < 128 introduce 1 to 128 literal bytes; control bytes
+	>= 128 introduce a run of 3 to COMPACT_RUNMAX identical bytes.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+static int	compact_pack(unsigned char *in, int n, unsigned char *out)
+  {
+   unsigned char	*out0;
+   int			i, l, r, start;
+
+  out0 = out;
+  for (i=0; i<n;)
+    {
+    for (r=1; i+r<n && r<COMPACT_RUNMAX && in[i+r]==in[i]; r++);
+    if (r>=3)
+      {
+      *(out++) = (unsigned char)(r-3+128);
+      *(out++) = in[i];
+      i += r;
+      }
+    else
+      {
+      start = i;
+      for (l=0; i<n && l<128; i++, l++)
+        if (i+2<n && in[i]==in[i+1] && in[i]==in[i+2])
+          break;
+      *(out++) = (unsigned char)(l-1);
+      memcpy(out, in+start, l);
+      out += l;
+      }
+    }
+
+  return (int)(out-out0);
+  }
+
+
+/****** compact_unpack *******************************************************
+PROTO	int compact_unpack(unsigned char *in, int nin, unsigned char *out,
+			int nout)
+PURPOSE	Unpack a byte-run packed buffer.
+INPUT	Pointer to the packed bytes,
+	number of packed bytes,
+	pointer to the output buffer,
+	expected number of output bytes.
+OUTPUT	RETURN_OK if the expected number of bytes was recovered,
+	RETURN_ERROR otherwise.
+NOTES	-.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+static int	compact_unpack(unsigned char *in, int nin, unsigned char *out,
+			int nout)
+  {
+   unsigned char	*inend;
+   int			c, l;
+
+  for (inend=in+nin; in<inend;)
+    {
+    if ((c = *(in++)) < 128)
+      {
+      if ((l=c+1) > nout || in+l > inend)
+        return RETURN_ERROR;
+      memcpy(out, in, l);
+      in += l;
+      }
+    else
+      {
+      if ((l=c-128+3) > nout || in >= inend)
+        return RETURN_ERROR;
+      memset(out, *(in++), l);
+      }
+    out += l;
+    nout -= l;
+    }
+
+  return nout? RETURN_ERROR : RETURN_OK;
+  }
+
+
+/****** compact_tohalf *******************************************************
+PROTO	unsigned short compact_tohalf(float f)
+PURPOSE	Convert a single precision value to IEEE 754 half precision.
+INPUT	Single precision value.
+OUTPUT	Half precision value.
+NOTES	Rounding is done to the nearest even value.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+static unsigned short	compact_tohalf(float f)
+  {
+   unsigned int	x, m, sign, half, rem, halfway;
+   int		e, shift;
+
+  memcpy(&x, &f, sizeof(x));
+  sign = (x>>16) & 0x8000;
+  e = (int)((x>>23) & 0xff);
+  m = x & 0x7fffff;
+  if (e == 255)
+    return (unsigned short)(sign | 0x7c00 | (m? 0x200 : 0));
+  e += 15 - 127;
+  if (e >= 31)
+    return (unsigned short)(sign | 0x7c00);
+  if (e <= 0)
+    {
+/*-- Subnormal (or zero) half */
+    if (e < -10)
+      return (unsigned short)sign;
+    m |= 0x800000;
+    shift = 14 - e;
+    half = m >> shift;
+    rem = m & ((1u<<shift)-1);
+    halfway = 1u<<(shift-1);
+    if (rem > halfway || (rem == halfway && (half&1)))
+      half++;
+    return (unsigned short)(sign | half);
+    }
+  half = sign | ((unsigned int)e<<10) | (m>>13);
+  rem = m & 0x1fff;
+/* A carry into the exponent is the correct rounding */
+  if (rem > 0x1000 || (rem == 0x1000 && (half&1)))
+    half++;
+
+  return (unsigned short)half;
+  }
+
+
+/****** compact_fromhalf *****************************************************
+PROTO	float compact_fromhalf(unsigned short h)
+PURPOSE	Convert an IEEE 754 half precision value to single precision.
+INPUT	Half precision value.
+OUTPUT	Single precision value.
+NOTES	-.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+static float	compact_fromhalf(unsigned short h)
+  {
+   float	f;
+   unsigned int	x, sign, e, m;
+
+  sign = ((unsigned int)h & 0x8000) << 16;
+  e = (h>>10) & 0x1f;
+  m = h & 0x3ff;
+  if (!e)
+    {
+    f = (float)ldexp((double)m, -24);
+    return sign? -f : f;
+    }
+  else if (e == 31)
+    x = sign | 0x7f800000 | (m<<13);
+  else
+    x = sign | ((e+127-15)<<23) | (m<<13);
+  memcpy(&f, &x, sizeof(f));
+
+  return f;
+  }
+
@@ -0,0 +1,81 @@
+/*
+*				compact.h
+*
+* Include file for compact.c.
+*
+*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+*
+*	This file part of:	SWarp
+*
+*	Copyright:		(C) 2026 CEA/AIM/UParisSaclay
+*
+*	License:		GNU General Public License
+*
+*	SWarp is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*	SWarp is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU General Public License for more details.
+*	You should have received a copy of the GNU General Public License
+*	along with SWarp. If not, see <http://www.gnu.org/licenses/>.
+*
+*	Last modified:		19/10/2026
+*
+*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+
+#ifndef _FITSCAT_H_
+#include "fits/fitscat.h"
+#endif
+
+#ifndef _FIELD_H_
+#include "field.h"
+#endif
+
+#ifndef	_COMPACT_H_
+#define	_COMPACT_H_
+
+/*------------------------------- constants ---------------------------------*/
+#define	COMPACT_MAGIC	"SWCPACK1"	/* Compact file signature */
+#define	COMPACT_EXT	".swc"		/* Compact file extension */
+#define	COMPACT_RUNMAX	130		/* Max. length of a byte run */
+
+/*--------------------------------- typedefs --------------------------------*/
+typedef enum	{CPACK_NONE, CPACK_SHUFFLE, CPACK_FLOAT16}	cpackenum;
+
+/*-------------------------- structure definitions --------------------------*/
+typedef struct compactline
+  {
+  OFF_T2	pos;			/* Position of packed line in file */
+  int		xmin;			/* First stored pixel in line */
+  int		npix;			/* Number of stored pixels */
+  int		nbytes;			/* Number of packed bytes */
+  int		expo;			/* Power-of-2 scaling (FLOAT16 only) */
+  }	compactlinestruct;
+
+typedef struct compact
+  {
+  cpackenum	pack;			/* Packing type */
+  int		floatflag;		/* Floating-point pixels? */
+  int		width;			/* Line width (pixels) */
+  int		nline;			/* Number of lines written */
+  int		nlinemax;		/* Total number of lines */
+  compactlinestruct	*line;		/* Line extent table */
+  unsigned char	*buf, *buf2;		/* Packing buffers */
+  OFF_T2	pos;			/* Current writing position */
+  OFF_T2	nbytes;			/* Total number of bytes written */
+  }	compactstruct;
+
+/*-------------------------------- protos -----------------------------------*/
+extern compactstruct	*init_compact(fieldstruct *field, cpackenum pack,
+				int floatflag);
+
+extern void		end_compact(fieldstruct *field),
+			free_compact(compactstruct *compact),
+			read_compact(fieldstruct *field, int y, PIXTYPE *ptr),
+			read_icompact(fieldstruct *field, int y, FLAGTYPE *ptr),
+			write_compact(fieldstruct *field, void *ptr);
+
+#endif
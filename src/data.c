@@ -22,7 +22,7 @@
 *	You should have received a copy of the GNU General Public License
 *	along with SWarp. If not, see <http://www.gnu.org/licenses/>.
 *
-*	Last modified:		04/02/2020
+*	Last modified:		19/10/2026
 *
 *%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
 
@@ -68,13 +68,16 @@ INPUT	Input field ptr,
 	Input weight field ptr,
 	Number of bits per pixel.
 OUTPUT	-.
-NOTES   -.
-AUTHOR  E. Bertin (IAP)
-VERSION 04/02/2020
+NOTES   If the raw pixels have already been loaded by preload_data(), they
+	are converted in place.
+AUTHOR  E. Bertin (CEA/AIM/UParisSaclay)
+VERSION 19/10/2026
  ***/
 void	read_data(fieldstruct *field, fieldstruct *wfield, int bitpix)
   {
-   char	str[MAXCHAR];
+   PIXTYPE	*pix;
+   char		str[MAXCHAR];
+   size_t	npix, n;
 
 /* Prepare static (global) variables */
   convert_width = field->width;
@@ -108,6 +111,13 @@ void	read_data(fieldstruct *field, fieldstruct *wfield, int bitpix)
       error(EXIT_FAILURE, str,
 		" try to increase MEM_MAX or VMEM_MAX");
     }
+  } else if (field->pix) {
+    pix = field->pix;
+    npix = field->tab->tabsize/field->tab->bytepix;
+    for (; npix; npix-=n, pix+=n) {
+      n = npix<(size_t)field->width? npix : (size_t)field->width;
+      convert_data(pix, (int)n);
+    }
   } else {
     if (!(field->pix = alloc_body(field->tab, convert_data))) {
       sprintf(str, "*Error*: Not enough memory "
@@ -128,6 +138,34 @@ void	read_data(fieldstruct *field, fieldstruct *wfield, int bitpix)
   }
 
 
+/******* preload_data *******************************************************
+PROTO	void preload_data(fieldstruct *field, fieldstruct *wfield)
+PURPOSE	Load raw image and weight pixels in memory, so that background
+	estimation, weight conversion and data conversion can all be done
+	from a single read of the input files.
+INPUT	Input field ptr (or NULL),
+	Input weight field ptr (or NULL).
+OUTPUT	-.
+NOTES   Pixels are left unconverted until read_weight() and read_data() are
+	called. Pixels that cannot be loaded (tile-compressed data, weights
+	derived from the background or lack of memory) are left to be read
+	from the files as before.
+AUTHOR  E. Bertin (CEA/AIM/UParisSaclay)
+VERSION 19/10/2026
+ ***/
+void	preload_data(fieldstruct *field, fieldstruct *wfield)
+  {
+  if (field && !field->tab->isTileCompressed)
+    field->pix = alloc_body(field->tab, NULL);
+
+  if (wfield && !(wfield->flags&BACKRMS_FIELD)
+	&& !wfield->tab->isTileCompressed)
+    wfield->pix = alloc_body(wfield->tab, NULL);
+
+  return;
+  }
+
+
 /******* convert_data ********************************************************
 PROTO	void convert_data(PIXTYPE *pix, int npix)
 PURPOSE	Read data and store them in internal format (interpolated,
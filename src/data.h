@@ -22,7 +22,7 @@
 *	You should have received a copy of the GNU General Public License
 *	along with SWarp. If not, see <http://www.gnu.org/licenses/>.
 *
-*	Last modified:		30/01/2012
+*	Last modified:		19/10/2026
 *
 *%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
 
@@ -39,6 +39,7 @@
 /*------------------------------- functions ---------------------------------*/
 
 extern void		convert_data(PIXTYPE *pix, int npix),
+			preload_data(fieldstruct *field, fieldstruct *wfield),
 			read_data(fieldstruct *field, fieldstruct *wfield,
 				int bitpix);
 
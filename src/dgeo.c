@@ -24,7 +24,7 @@
 *       You should have received a copy of the GNU General Public License
 *       along with SWarp. If not, see <http://www.gnu.org/licenses/>.
 *
-*	Last modified:		25/03/2025
+*	Last modified:		19/10/2026
 *
 *%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
 
@@ -55,13 +55,14 @@ INPUT	Cat structure pointer,
 OUTPUT	RETURN_OK if no error, or RETURN_ERROR in case of non-fatal error(s).
 NOTES   -.
 AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
-VERSION	25/03/2025
+VERSION	19/10/2026
  ***/
 fieldstruct *load_dgeo(catstruct *cat, fieldstruct *reffield,
 			int frameno, int fieldno, dgeoenum dgeotype)
   {
    fieldstruct	*dgeofield;
    tabstruct	*tab, *intab;
+   char		str[MAXCHAR];
    int	i, dgeoflags;
 
   dgeoflags = 0;	/* to avoid gcc -Wall warnings */
@@ -92,8 +93,8 @@ fieldstruct *load_dgeo(catstruct *cat, fieldstruct *reffield,
     else
       dgeofield->rfilename++;
 
-  sprintf(gstr, "Looking for %s ...", dgeofield->rfilename);
-  NFPRINTF(OUTPUT, gstr);
+  sprintf(str, "Looking for %s ...", dgeofield->rfilename);
+  NFPRINTF(OUTPUT, str);
 
 /* Check that the image exists and read important info (image size, etc...) */
   if (frameno >= cat->ntab)
@@ -24,7 +24,7 @@
 *	You should have received a copy of the GNU General Public License
 *	along with SWarp. If not, see <http://www.gnu.org/licenses/>.
 *
-*	Last modified:		21/03/2025
+*	Last modified:		19/10/2026
 *
 *%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
 
@@ -47,8 +47,10 @@
 #include "fitswcs.h"
 #include "back.h"
 #include "coadd.h"
+#include "compact.h"
 #include "data.h"
 #include "field.h"
+#include "footprint.h"
 #include "header.h"
 #include "key.h"
 #include "misc.h"
@@ -74,7 +76,8 @@ fieldstruct	*load_field(catstruct *cat, int frameno, int fieldno,
   {
    tabstruct	*tab, *intab;
    fieldstruct	*field;
-   char		*pstr;
+   char		str[MAXCHAR],
+		*pstr;
    int		i;
 
 /* First allocate memory for the new field (and nullify pointers) */
@@ -115,8 +118,8 @@ fieldstruct	*load_field(catstruct *cat, int frameno, int fieldno,
     sprintf(pstr, "%s", prefs.head_suffix);
   }
 
-  sprintf(gstr, "Looking for %s ...", field->rfilename);
-  NFPRINTF(OUTPUT, gstr);
+  sprintf(str, "Looking for %s ...", field->rfilename);
+  NFPRINTF(OUTPUT, str);
 
 /* Insert additional header informations from the "header" file */
   field->headflag = !read_aschead(field->hfilename, frameno, tab);
@@ -143,8 +146,8 @@ fieldstruct	*load_field(catstruct *cat, int frameno, int fieldno,
   if (prefs.celsys_type == CELSYS_PIXEL)
     for (i=0; i<tab->naxis; i++)
       {
-      sprintf(gstr, "CTYPE%-3d", i+1);
-      fitswrite(tab->headbuf, gstr, "PIXEL", H_STRING, T_STRING);
+      sprintf(str, "CTYPE%-3d", i+1);
+      fitswrite(tab->headbuf, str, "PIXEL", H_STRING, T_STRING);
       }
 
 /* Read WCS information in FITS header */
@@ -205,7 +208,7 @@ INPUT	Reference field pointer.
 OUTPUT	The new field pointer if OK, NULL otherwise.
 NOTES	-.
 AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
-VERSION	21/03/2025
+VERSION	19/10/2026
  ***/
 fieldstruct	*inherit_field(char *filename, fieldstruct *reffield,
 				int flags)
@@ -237,9 +240,12 @@ fieldstruct	*inherit_field(char *filename, fieldstruct *reffield,
   field->ipix = NULL;
   field->pix = NULL;
   field->backline = NULL;
+  field->backinterp = NULL;
   field->wcs = NULL;
   field->rawmin = NULL;
   field->rawmax = NULL;
+  field->compact = NULL;
+  field->footprint = NULL;
   field->reffield =reffield;
 
   strcpy(field->filename, filename);
@@ -256,7 +262,7 @@ INPUT	field structure pointer.
 OUTPUT	-.
 NOTES	-.
 AUTHOR	E. Bertin (IAP)
-VERSION	16/04/2000
+VERSION	19/10/2026
  ***/
 void	end_field(fieldstruct *field)
 
@@ -275,6 +281,10 @@ void	end_field(fieldstruct *field)
     field->tab = NULL;
     }
 
+  if (field->compact)
+    free_compact(field->compact);
+  if (field->footprint)
+    end_footprint(field->footprint);
   end_back(field);
   field->pix = NULL;
   field->ipix = NULL;
@@ -1012,6 +1022,57 @@ fieldstruct *init_field(fieldstruct **infield, int ninput, char *filename,
   }
 
 
+/******* init_tilefield ****************************************************
+PROTO	fieldstruct *init_tilefield(fieldstruct *reffield, char *filename,
+				int *tilemin, int *tilesize)
+PURPOSE	Create an output field covering a rectangular section (tile) of a
+	reference output field.
+INPUT	Reference output field pointer,
+	Filename,
+	pointer to the tile lower pixel coordinates in the reference field,
+	pointer to the tile dimensions.
+OUTPUT	Pointer to the new output tile field.
+NOTES	Only the first two axes are tiled. The tile shares its projection and
+	CRVALs with the reference field.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+fieldstruct *init_tilefield(fieldstruct *reffield, char *filename,
+				int *tilemin, int *tilesize)
+  {
+   fieldstruct		*field;
+   tabstruct		*tab;
+   wcsstruct		*wcs;
+   int			d;
+
+  field = inherit_field(filename, reffield, FIELD_WRITE);
+  if (!(field->rfilename = strrchr(field->filename, '/')))
+    field->rfilename = field->filename;
+  else
+    field->rfilename++;
+  tab = field->tab;
+
+/* Shift the reference pixel and crop the frame */
+  field->wcs = wcs = copy_wcs(reffield->wcs);
+  for (d=0; d<2 && d<wcs->naxis; d++)
+    {
+    wcs->crpix[d] -= (double)(tilemin[d] - 1);
+    wcs->naxisn[d] = tilesize[d];
+    }
+  init_wcs(wcs);
+  range_wcs(wcs);
+  write_wcs(tab, wcs);
+
+  field->width = tab->naxisn[0];
+  field->height = 1;
+  for (d=1; d<tab->naxis; d++)
+    field->height *= tab->naxisn[d];
+  field->npix = field->width*field->height;
+
+  return field;
+  }
+
+
 /******* scale_field *********************************************************
 PROTO	void scale_field(fieldstruct *field, fieldstruct *reffield,
 			int scaleflag)
@@ -22,7 +22,7 @@
 *	You should have received a copy of the GNU General Public License
 *	along with SWarp. If not, see <http://www.gnu.org/licenses/>.
 *
-*	Last modified:		04/11/2020
+*	Last modified:		19/10/2026
 *
 *%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
 
@@ -60,9 +60,12 @@ typedef struct field
   char		ident[80];		/* field identifier (read from FITS) */
   catstruct	*cat;			/* cat structure */
   tabstruct	*tab;			/* tab structure */
+  struct compact	*compact;		/* compact temporary file data */
+  struct footprint	*footprint;		/* footprint of resampled data */
 /* ---- main image parameters */
   int		fieldno;		/* pos of parent ima in command line */
   int		frameno;		/* pos in Multi-extension FITS file */
+  int		inputno;		/* pos among all input fields */
   int		version;		/* filename version */
   int		width, height;		/* x,y size of the field */
   size_t	npix;			/* total number of pixels */
@@ -94,6 +97,7 @@ typedef struct field
   PIXTYPE	*pix;			/* pixel data */
   FLAGTYPE	*ipix;			/* flag data */
   PIXTYPE	*backline;		/* current interpolated bkgnd line */
+  struct backinterp	*backinterp;	/* bkgnd line interpolation data */
   backenum     	back_type;		/* background type */
 /* ---- astrometric parameters */
   struct wcs	*wcs;			/* astrometric data */
@@ -117,6 +121,8 @@ extern fieldstruct	*inherit_field(char *filename, fieldstruct *reffield,
 					int fflags),
 			*init_field(fieldstruct **infield, int ninput,
 				char *filename, char *hfilename),
+			*init_tilefield(fieldstruct *reffield, char *filename,
+				int *tilemin, int *tilesize),
 			*load_field(catstruct *cat, int frameno, int fieldno,
 				char *hfilename);
 
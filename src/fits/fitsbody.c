@@ -27,7 +27,7 @@
 *	along with AstrOmatic software.
 *	If not, see <http://www.gnu.org/licenses/>.
 *
-*	Last modified:		25/03/2025
+*	Last modified:		19/10/2026
 *
 *%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
 
@@ -44,6 +44,9 @@
 #ifdef	HAVE_SYS_MMAN_H
 #include	<sys/mman.h>
 #endif
+#ifdef	USE_THREADS
+#include	<pthread.h>
+#endif
 #include	"fitscat_defs.h"
 #include	"fitscat.h"
 
@@ -52,8 +55,12 @@
 #endif
 
 size_t	body_maxram = BODY_DEFRAM,
-	body_maxvram = BODY_DEFVRAM,
-	body_ramleft, body_vramleft, body_ramflag;
+	body_maxvram = BODY_DEFVRAM;
+
+static size_t	body_ramused, body_vramused, body_rampeak;
+#ifdef	USE_THREADS
+static pthread_mutex_t	body_rammutex = PTHREAD_MUTEX_INITIALIZER;
+#endif
 
 int	body_vmnumber;
 
@@ -62,13 +69,15 @@ char	body_swapdirname[MAXCHARS] = BODY_DEFSWAPDIR;
 /******* alloc_body ***********************************************************
 PROTO	PIXTYPE *alloc_body(tabstruct *tab,
 		void (*func)(PIXTYPE *ptr, int npix))
-PURPOSE	Allocate memory for and read a FITS data body (read-only). If not
-	enough RAM is available, a swap file is created.
+PURPOSE	Allocate memory for and read a FITS data body. If not enough RAM is
+	available, a swap file is created.
 INPUT	Table (tab) structure.
 OUTPUT	Pointer to the mapped data if OK, or NULL otherwise.
 NOTES	The file pointer must be positioned at the beginning of the data.
+	Swap files are mapped read-write, so that the data may still be
+	processed in place after loading.
 AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
-VERSION	25/03/2025
+VERSION	19/10/2026
  ***/
 PIXTYPE	*alloc_body(tabstruct *tab, void (*func)(PIXTYPE *ptr, int npix))
   {
@@ -77,13 +86,6 @@ PIXTYPE	*alloc_body(tabstruct *tab, void (*func)(PIXTYPE *ptr, int npix))
    int  n;
    size_t	npix, size, sizeleft, spoonful;
 
-  if (!body_ramflag)
-    {
-    body_ramleft = body_maxram;
-    body_vramleft = body_maxvram;
-    body_ramflag = 1;
-    }
-
 /* Return a NULL pointer if size is zero */
   if (!tab->tabsize)
     return (PIXTYPE *)NULL;
@@ -105,7 +107,7 @@ PIXTYPE	*alloc_body(tabstruct *tab, void (*func)(PIXTYPE *ptr, int npix))
   npix = tab->tabsize/tab->bytepix;
 #endif
   size = npix*sizeof(PIXTYPE);
-  if (size < body_ramleft)
+  if (reserve_ram(size, 0, 0) == RETURN_OK)
     {
 /*-- There should be enough RAM left: try to do a malloc() */
     if ((tab->bodybuf = malloc(size)))
@@ -118,19 +120,24 @@ PIXTYPE	*alloc_body(tabstruct *tab, void (*func)(PIXTYPE *ptr, int npix))
 /*---- Apply pixel processing */
       if (func)
         (*func)((PIXTYPE *)tab->bodybuf, npix);
-      body_ramleft -= size;
 
       return (PIXTYPE *)tab->bodybuf;
       }
     else
+      {
       tab->bodybuf = NULL;
+      release_ram(size, 0);
+      }
     }
 
-  if (size < body_vramleft)
+  if (reserve_ram(size, 1, 0) == RETURN_OK)
     {
 /*-- Convert and copy the data to a swap file, and mmap() it */
     if (!(buffer = malloc(DATA_BUFSIZE)))
+      {
+      release_ram(size, 1);
       return NULL;
+      }
     sprintf(tab->swapname, "%s/vm%05ld_%05x.tmp",
 		body_swapdirname, (long)getpid(),
 		(unsigned int)++body_vmnumber) ;
@@ -158,10 +165,10 @@ PIXTYPE	*alloc_body(tabstruct *tab, void (*func)(PIXTYPE *ptr, int npix))
       QFWRITE(buffer, spoonful, file, tab->swapname);
       }
     free(buffer);
-    tab->bodybuf = mmap(NULL,size,PROT_READ,MAP_SHARED,fileno(file),(off_t)0);
+    tab->bodybuf = mmap(NULL,size,PROT_READ|PROT_WRITE,MAP_SHARED,
+		fileno(file),(off_t)0);
     fclose(file);
     tab->swapflag = 1;
-    body_vramleft -= size;
 
 /*-- Memory mapping problem */
     if (tab->bodybuf == (void *)-1)
@@ -192,13 +199,6 @@ FLAGTYPE	*alloc_ibody(tabstruct *tab,
    FLAGTYPE	*buffer;
    size_t	npix, size, sizeleft, spoonful;
 
-  if (!body_ramflag)
-    {
-    body_ramleft = body_maxram;
-    body_vramleft = body_maxvram;
-    body_ramflag = 1;
-    }
-
 /* Return a NULL pointer if size is zero */
   if (!tab->tabsize)
     return (FLAGTYPE *)NULL;
@@ -211,7 +211,7 @@ FLAGTYPE	*alloc_ibody(tabstruct *tab,
 /* Decide if the data will go in physical memory or on swap-space */
   npix = tab->tabsize/tab->bytepix;
   size = npix*sizeof(FLAGTYPE);
-  if (size < body_ramleft)
+  if (reserve_ram(size, 0, 0) == RETURN_OK)
     {
 /*-- There should be enough RAM left: try to do a malloc() */
     if ((tab->bodybuf = malloc(size)))
@@ -224,19 +224,24 @@ FLAGTYPE	*alloc_ibody(tabstruct *tab,
 /*---- Apply pixel processing */
       if (func)
         (*func)((FLAGTYPE *)tab->bodybuf, npix);
-      body_ramleft -= size;
 
       return (FLAGTYPE *)tab->bodybuf;
       }
     else
+      {
       tab->bodybuf = NULL;
+      release_ram(size, 0);
+      }
     }
 
-  if (size < body_vramleft)
+  if (reserve_ram(size, 1, 0) == RETURN_OK)
     {
 /*-- Convert and copy the data to a swap file, and mmap() it */
     if (!(buffer = malloc(DATA_BUFSIZE)))
+      {
+      release_ram(size, 1);
       return NULL;
+      }
     sprintf(tab->swapname, "%s/vm%05ld_%05x.tmp",
 		body_swapdirname, (long)getpid(),
 		(unsigned int)++body_vmnumber) ;
@@ -267,7 +272,6 @@ FLAGTYPE	*alloc_ibody(tabstruct *tab,
     tab->bodybuf = mmap(NULL,size,PROT_READ,MAP_SHARED,fileno(file),(off_t)0);
     fclose(file);
     tab->swapflag = 1;
-    body_vramleft -= size;
 
 /*-- Memory mapping problem */
     if (tab->bodybuf == (void *)-1)
@@ -304,7 +308,7 @@ void	free_body(tabstruct *tab)
         warning("Can't unmap ", tab->cat->filename);
       tab->swapflag = 0;
       tab->bodybuf = NULL;
-      body_vramleft += size;
+      release_ram(size, 1);
       if (unlink(tab->swapname))
         warning("Can't delete ", tab->swapname);
       remove_cleanupfilename(tab->swapname);
@@ -313,7 +317,7 @@ void	free_body(tabstruct *tab)
     else
       {
       QFREE(tab->bodybuf);
-      body_ramleft += size;
+      release_ram(size, 0);
       }
     }
 
@@ -408,14 +412,14 @@ INPUT	A pointer to the tab structure,
 	a pointer to the array in memory,
 	the number of elements to be read.
 OUTPUT	-.
-NOTES	.
+NOTES	Reentrant: the conversion buffer is allocated at each call.
 AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
-VERSION	21/03/2025
+VERSION	19/10/2026
  ***/
 void	read_body(tabstruct *tab, PIXTYPE *ptr, size_t size)
   {
   catstruct		*cat;
-  static double		bufdata0[DATA_BUFSIZE/sizeof(double)];
+  double		*bufdata0;
   unsigned char		cuval, cublank;
   char			*bufdata,
 			cval, cblank;
@@ -447,6 +451,7 @@ void	read_body(tabstruct *tab, PIXTYPE *ptr, size_t size)
     case COMPRESS_NONE:
       bowl = DATA_BUFSIZE/tab->bytepix;
       spoonful = size<bowl?size:bowl;
+      QMALLOC(bufdata0, double, spoonful*tab->bytepix/sizeof(double) + 1);
       for(; size>0; size -= spoonful)
         {
         if (spoonful>size)
@@ -657,6 +662,7 @@ void	read_body(tabstruct *tab, PIXTYPE *ptr, size_t size)
             break;
           }
         }
+      free(bufdata0);
       break;
 
 /*-- Compressed image */
@@ -765,14 +771,14 @@ INPUT	A pointer to the tab structure,
 	a pointer to the array in memory,
 	the number of elements to be read.
 OUTPUT	-.
-NOTES	.
-AUTHOR	E. Bertin (IAP)
-VERSION	26/08/2020
+NOTES	Reentrant: the conversion buffer is allocated at each call.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
  ***/
 void	read_ibody(tabstruct *tab, FLAGTYPE *ptr, size_t size)
   {
    catstruct		*cat;
-   static int		bufdata0[DATA_BUFSIZE/sizeof(int)];
+   int			*bufdata0;
    char			*bufdata;
    short		val16;
    unsigned short	ashort = 1;
@@ -790,6 +796,7 @@ void	read_ibody(tabstruct *tab, FLAGTYPE *ptr, size_t size)
     case COMPRESS_NONE:
       bowl = DATA_BUFSIZE/tab->bytepix;
       spoonful = size<bowl?size:bowl;
+      QMALLOC(bufdata0, int, spoonful*tab->bytepix/sizeof(int) + 1);
       for(; size>0; size -= spoonful)
         {
         if (spoonful>size)
@@ -860,6 +867,7 @@ void	read_ibody(tabstruct *tab, FLAGTYPE *ptr, size_t size)
             break;
           }
         }
+      free(bufdata0);
       break;
 
 /*-- Compressed image */
@@ -961,23 +969,26 @@ void	read_ibody(tabstruct *tab, FLAGTYPE *ptr, size_t size)
   }
 
 
-/******* write_body ***********************************************************
-PROTO	write_body(tabstruct *tab, PIXTYPE *ptr, long size)
-PURPOSE	Write values to a FITS body.
+/******* encode_body **********************************************************
+PROTO	void encode_body(tabstruct *tab, PIXTYPE *ptr, void *buf, size_t size)
+PURPOSE	Convert internal pixel values to the FITS body format of a table.
 INPUT	A pointer to the tab structure,
 	a pointer to the array in memory,
-	the number of elements to be written.
+	a pointer to the output buffer,
+	the number of elements to be converted.
 OUTPUT	-.
-NOTES	.
+NOTES	The output buffer must hold at least size*tab->bytepix bytes.
+	Unlike write_body(), this function is reentrant.
 AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
-VERSION	21/03/2025
+VERSION	19/10/2026
  ***/
-void	write_body(tabstruct *tab, PIXTYPE *ptr, size_t size)
+void	encode_body(tabstruct *tab, PIXTYPE *ptr, void *buf, size_t size)
   {
-   static double	bufdata0[DATA_BUFSIZE/sizeof(double)];
+#ifdef	HAVE_CFITSIO
    catstruct		*cat;
-   char			*cbufdata0;
-   size_t		i, bowl, spoonful;
+#endif
+   char			*cbuf;
+   size_t		i;
    PIXTYPE		bs,bz;
    unsigned short	ashort = 1;
    int			bswapflag;
@@ -986,132 +997,298 @@ void	write_body(tabstruct *tab, PIXTYPE *ptr, size_t size)
 
   bs = (PIXTYPE)tab->bscale;
   bz = (PIXTYPE)tab->bzero;
+#ifdef	HAVE_CFITSIO
   cat = tab->cat;
-  if (!cat)
-    error(EXIT_FAILURE, "*Internal Error*: no parent cat structure for table ",
-		tab->extname);
+#endif
+  cbuf = (char *)buf;
 
-  cbufdata0 = (char *)bufdata0;	/* A trick to remove gcc aliasing warnings */
- 
-  switch(tab->compress_type)
+  switch(tab->bitpix)
     {
-/*-- Uncompressed image */
-    case COMPRESS_NONE:
-      bowl = DATA_BUFSIZE/tab->bytepix;
-      spoonful = size<bowl?size:bowl;
-      for(; size>0; size -= spoonful)
+    case BP_BYTE:
+      if (tab->bitsgn)
         {
-        if (spoonful>size)
-          spoonful = size;
-        switch(tab->bitpix)
-          {
-          case BP_BYTE:
-            if (tab->bitsgn)
-              {
-               char	*bufdata = (char *)cbufdata0;
+         char	*bufdata = (char *)cbuf;
 #pragma ivdep
-              for (i=spoonful; i--;)
-                *(bufdata++) = (char)((*(ptr++)-bz)/bs+0.49999);
-              }
-            else
-              {
-               unsigned char	*bufdata = (unsigned char *)cbufdata0;
+        for (i=size; i--;)
+          *(bufdata++) = (char)((*(ptr++)-bz)/bs+0.49999);
+        }
+      else
+        {
+         unsigned char	*bufdata = (unsigned char *)cbuf;
 #pragma ivdep
-              for (i=spoonful; i--;)
-                *(bufdata++) = (unsigned char)((*(ptr++)-bz)/bs+0.49999);;
-              }
-            break;
+        for (i=size; i--;)
+          *(bufdata++) = (unsigned char)((*(ptr++)-bz)/bs+0.49999);;
+        }
+      break;
 
-          case BP_SHORT:
-            if (tab->bitsgn)
-              {
-               short	*bufdata = (short *)cbufdata0;
+    case BP_SHORT:
+      if (tab->bitsgn)
+        {
+         short	*bufdata = (short *)cbuf;
 #pragma ivdep
-              for (i=spoonful; i--;)
-                *(bufdata++) = (short)((*(ptr++)-bz)/bs+0.49999);
-              }
-            else
-              {
-               unsigned short	*bufdata = (unsigned short *)cbufdata0;
+        for (i=size; i--;)
+          *(bufdata++) = (short)((*(ptr++)-bz)/bs+0.49999);
+        }
+      else
+        {
+         unsigned short	*bufdata = (unsigned short *)cbuf;
 #pragma ivdep
-              for (i=spoonful; i--;)
-                *(bufdata++) = (unsigned short)((*(ptr++)-bz)/bs+0.49999);
-              }
-            if (bswapflag)
-              swapbytes(cbufdata0, 2, spoonful);
-            break;
+        for (i=size; i--;)
+          *(bufdata++) = (unsigned short)((*(ptr++)-bz)/bs+0.49999);
+        }
+      if (bswapflag)
+        swapbytes(cbuf, 2, size);
+      break;
 
-          case BP_LONG:
-           if (tab->bitsgn)
-              {
-               int	*bufdata = (int *)cbufdata0;
+    case BP_LONG:
+     if (tab->bitsgn)
+        {
+         int	*bufdata = (int *)cbuf;
 #pragma ivdep
-              for (i=spoonful; i--;)
-                *(bufdata++) = (int)((*(ptr++)-bz)/bs+0.49999);
-              }
-            else
-              {
-               unsigned int	*bufdata = (unsigned int *)cbufdata0;
+        for (i=size; i--;)
+          *(bufdata++) = (int)((*(ptr++)-bz)/bs+0.49999);
+        }
+      else
+        {
+         unsigned int	*bufdata = (unsigned int *)cbuf;
 #pragma ivdep
-              for (i=spoonful; i--;)
-                *(bufdata++) = (unsigned int)((*(ptr++)-bz)/bs+0.49999);
-              }
-            if (bswapflag)
-              swapbytes(cbufdata0, 4, spoonful);
-            break;
+        for (i=size; i--;)
+          *(bufdata++) = (unsigned int)((*(ptr++)-bz)/bs+0.49999);
+        }
+      if (bswapflag)
+        swapbytes(cbuf, 4, size);
+      break;
 
 #ifdef HAVE_LONG_LONG_INT
-          case BP_LONGLONG:
-           if (tab->bitsgn)
-              {
-               SLONGLONG	*bufdata = (SLONGLONG *)cbufdata0;
+    case BP_LONGLONG:
+     if (tab->bitsgn)
+        {
+         SLONGLONG	*bufdata = (SLONGLONG *)cbuf;
 #pragma ivdep
-              for (i=spoonful; i--;)
-                *(bufdata++) = (SLONGLONG)((*(ptr++)-bz)/bs+0.49999);
-              }
-            else
-              {
-               ULONGLONG	*bufdata = (ULONGLONG *)cbufdata0;
+        for (i=size; i--;)
+          *(bufdata++) = (SLONGLONG)((*(ptr++)-bz)/bs+0.49999);
+        }
+      else
+        {
+         ULONGLONG	*bufdata = (ULONGLONG *)cbuf;
 #pragma ivdep
-              for (i=spoonful; i--;)
-                *(bufdata++) = (ULONGLONG)((*(ptr++)-bz)/bs+0.49999);
-              }
-            if (bswapflag)
-              swapbytes(cbufdata0, 8, spoonful);
-            break;
+        for (i=size; i--;)
+          *(bufdata++) = (ULONGLONG)((*(ptr++)-bz)/bs+0.49999);
+        }
+      if (bswapflag)
+        swapbytes(cbuf, 8, size);
+      break;
 #endif
-          case BP_FLOAT:
-            {
-             float	*bufdata = (float *)cbufdata0;
+    case BP_FLOAT:
+      {
+       float	*bufdata = (float *)cbuf;
 #pragma ivdep
-            for (i=spoonful; i--;)
-              *(bufdata++) = (*(ptr++)-bz)/bs;
+      for (i=size; i--;)
+        *(bufdata++) = (*(ptr++)-bz)/bs;
 
 #ifdef	HAVE_CFITSIO
-            if (!cat->cfitsio_infptr && bswapflag)
+      if (!cat->cfitsio_infptr && bswapflag)
 #else
-            if (bswapflag)
+      if (bswapflag)
 #endif
-              swapbytes(cbufdata0, 4, spoonful);
-            }
-            break;
+        swapbytes(cbuf, 4, size);
+      }
+      break;
 
-          case BP_DOUBLE:
-            {
-             double	*bufdata = (double *)cbufdata0;
+    case BP_DOUBLE:
+      {
+       double	*bufdata = (double *)cbuf;
 #pragma ivdep
-            for (i=spoonful; i--;)
-              *(bufdata++) = (double)(*(ptr++)-bz)/bs;
-            if (bswapflag)
-              swapbytes(cbufdata0, 8, spoonful);
-            }
-            break;
+      for (i=size; i--;)
+        *(bufdata++) = (double)(*(ptr++)-bz)/bs;
+      if (bswapflag)
+        swapbytes(cbuf, 8, size);
+      }
+      break;
 
-          default:
-            error(EXIT_FAILURE,"*FATAL ERROR*: unknown BITPIX type in ",
-                                "read_body()");
-            break;
-          }
+    default:
+      error(EXIT_FAILURE,"*FATAL ERROR*: unknown BITPIX type in ",
+                          "encode_body()");
+      break;
+    }
+
+  return;
+  }
+
+
+/******* encode_ibody *********************************************************
+PROTO	void encode_ibody(tabstruct *tab, FLAGTYPE *ptr, void *buf, size_t size)
+PURPOSE	Convert internal integer values to the FITS body format of a table.
+INPUT	A pointer to the tab structure,
+	a pointer to the array in memory,
+	a pointer to the output buffer,
+	the number of elements to be converted.
+OUTPUT	-.
+NOTES	The output buffer must hold at least size*tab->bytepix bytes.
+	Unlike write_ibody(), this function is reentrant.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+void	encode_ibody(tabstruct *tab, FLAGTYPE *ptr, void *buf, size_t size)
+  {
+   char			*cbuf;
+   size_t		i;
+   unsigned short	ashort = 1;
+   double		bs,bz;
+   int			bswapflag;
+
+  bswapflag = *((char *)&ashort);	// Byte-swapping flag
+
+  bs = tab->bscale;
+  bz = tab->bzero;
+  cbuf = (char *)buf;
+
+  switch(tab->bitpix)
+    {
+    case BP_BYTE:
+      if (tab->bitsgn)
+        {
+         char	*bufdata = (char *)cbuf;
+#pragma ivdep
+        for (i=size; i--;)
+          *(bufdata++) = (char)*(ptr++);
+        }
+      else
+        {
+         unsigned char	*bufdata = (unsigned char *)cbuf;
+#pragma ivdep
+        for (i=size; i--;)
+          *(bufdata++) = (unsigned char)*(ptr++);
+        }
+      break;
+
+    case BP_SHORT:
+      if (tab->bitsgn)
+        {
+         short	*bufdata = (short *)cbuf;
+#pragma ivdep
+        for (i=size; i--;)
+          *(bufdata++) = (short)*(ptr++);
+        }
+      else
+        {
+         unsigned short	*bufdata = (unsigned short *)cbuf;
+#pragma ivdep
+        for (i=size; i--;)
+          *(bufdata++) = (unsigned short)*(ptr++);
+        }
+      if (bswapflag)
+        swapbytes(cbuf, 2, size);
+      break;
+
+    case BP_LONG:
+     if (tab->bitsgn)
+        {
+         int	*bufdata = (int *)cbuf;
+#pragma ivdep
+        for (i=size; i--;)
+          *(bufdata++) = (int)*(ptr++);
+        }
+      else
+        {
+         unsigned int	*bufdata = (unsigned int *)cbuf;
+#pragma ivdep
+        for (i=size; i--;)
+          *(bufdata++) = (unsigned int)*(ptr++);
+        }
+      if (bswapflag)
+        swapbytes(cbuf, 4, size);
+      break;
+
+#ifdef HAVE_LONG_LONG_INT
+    case BP_LONGLONG:
+     if (tab->bitsgn)
+        {
+         SLONGLONG	*bufdata = (SLONGLONG *)cbuf;
+#pragma ivdep
+        for (i=size; i--;)
+          *(bufdata++) = (SLONGLONG)*(ptr++);
+        }
+      else
+        {
+         ULONGLONG	*bufdata = (ULONGLONG *)cbuf;
+#pragma ivdep
+        for (i=size; i--;)
+          *(bufdata++) = (ULONGLONG)*(ptr++);
+        }
+      if (bswapflag)
+        swapbytes(cbuf, 8, size);
+      break;
+#endif
+    case BP_FLOAT:
+      {
+       float	*bufdata = (float *)cbuf;
+#pragma ivdep
+      for (i=size; i--;)
+        *(bufdata++) = (float)((double)*(ptr++)-bz)/bs;
+      if (bswapflag)
+        swapbytes(cbuf, 4, size);
+      }
+      break;
+
+    case BP_DOUBLE:
+      {
+       double	*bufdata = (double *)cbuf;
+#pragma ivdep
+      for (i=size; i--;)
+        *(bufdata++) = ((double)*(ptr++)-bz)/bs;
+      if (bswapflag)
+        swapbytes(cbuf, 8, size);
+      }
+      break;
+
+    default:
+      error(EXIT_FAILURE,"*FATAL ERROR*: unknown BITPIX type in ",
+                          "encode_ibody()");
+      break;
+    }
+
+  return;
+  }
+
+
+/******* write_body ***********************************************************
+PROTO	write_body(tabstruct *tab, PIXTYPE *ptr, long size)
+PURPOSE	Write values to a FITS body.
+INPUT	A pointer to the tab structure,
+	a pointer to the array in memory,
+	the number of elements to be written.
+OUTPUT	-.
+NOTES	The body checksum is updated on-the-fly if start_bodysum() was called.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+void	write_body(tabstruct *tab, PIXTYPE *ptr, size_t size)
+  {
+   static double	bufdata0[DATA_BUFSIZE/sizeof(double)];
+   catstruct		*cat;
+   char			*cbufdata0;
+   size_t		bowl, spoonful;
+
+  cat = tab->cat;
+  if (!cat)
+    error(EXIT_FAILURE, "*Internal Error*: no parent cat structure for table ",
+		tab->extname);
+
+  cbufdata0 = (char *)bufdata0;	/* A trick to remove gcc aliasing warnings */
+ 
+  switch(tab->compress_type)
+    {
+/*-- Uncompressed image */
+    case COMPRESS_NONE:
+      bowl = DATA_BUFSIZE/tab->bytepix;
+      spoonful = size<bowl?size:bowl;
+      for(; size>0; size -= spoonful)
+        {
+        if (spoonful>size)
+          spoonful = size;
+        encode_body(tab, ptr, cbufdata0, spoonful);
+        ptr += spoonful;
 
 #ifdef	HAVE_CFITSIO
           // if cfitsio output file has been set up, then proceed to write
@@ -1166,6 +1343,13 @@ void	write_body(tabstruct *tab, PIXTYPE *ptr, size_t size)
 #else
         QFWRITE(cbufdata0, spoonful*tab->bytepix, cat->file, cat->filename);
 #endif // HAVE_CFITSIO
+/*------ Update the checksum with the data just written */
+        if (tab->bodysumflag)
+          {
+          tab->bodysum = compute_bufsum(cbufdata0, spoonful*tab->bytepix,
+			tab->bodysumpos, tab->bodysum);
+          tab->bodysumpos += spoonful*tab->bytepix;
+          }
         }
       break;
 
@@ -1192,24 +1376,17 @@ INPUT	A pointer to the tab structure,
 	a pointer to the array in memory,
 	the number of elements to be written.
 OUTPUT	-.
-NOTES	.
-AUTHOR	E. Bertin (IAP)
-VERSION	11/02/2020
+NOTES	The body checksum is updated on-the-fly if start_bodysum() was called.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
  ***/
 void	write_ibody(tabstruct *tab, FLAGTYPE *ptr, size_t size)
   {
    static FLAGTYPE	bufdata0[DATA_BUFSIZE/sizeof(FLAGTYPE)];
    catstruct		*cat;
    char			*cbufdata0;
-   size_t		i, bowl, spoonful;
-   unsigned short	ashort = 1;
-   double		bs,bz;
-   int			bswapflag;
+   size_t		bowl, spoonful;
 
-  bswapflag = *((char *)&ashort);	// Byte-swapping flag
-
-  bs = tab->bscale;
-  bz = tab->bzero;
   cat = tab->cat;
   if (!cat)
     error(EXIT_FAILURE, "*Internal Error*: no parent cat structure for table ",
@@ -1227,111 +1404,16 @@ void	write_ibody(tabstruct *tab, FLAGTYPE *ptr, size_t size)
         {
         if (spoonful>size)
           spoonful = size;
-        switch(tab->bitpix)
+        encode_ibody(tab, ptr, cbufdata0, spoonful);
+        ptr += spoonful;
+        QFWRITE(cbufdata0, spoonful*tab->bytepix, cat->file, cat->filename);
+/*------ Update the checksum with the data just written */
+        if (tab->bodysumflag)
           {
-          case BP_BYTE:
-            if (tab->bitsgn)
-              {
-               char	*bufdata = (char *)cbufdata0;
-#pragma ivdep
-              for (i=spoonful; i--;)
-                *(bufdata++) = (char)*(ptr++);
-              }
-            else
-              {
-               unsigned char	*bufdata = (unsigned char *)cbufdata0;
-#pragma ivdep
-              for (i=spoonful; i--;)
-                *(bufdata++) = (unsigned char)*(ptr++);
-              }
-            break;
-
-          case BP_SHORT:
-            if (tab->bitsgn)
-              {
-               short	*bufdata = (short *)cbufdata0;
-#pragma ivdep
-              for (i=spoonful; i--;)
-                *(bufdata++) = (short)*(ptr++);
-              }
-            else
-              {
-               unsigned short	*bufdata = (unsigned short *)cbufdata0;
-#pragma ivdep
-              for (i=spoonful; i--;)
-                *(bufdata++) = (unsigned short)*(ptr++);
-              }
-            if (bswapflag)
-              swapbytes(cbufdata0, 2, spoonful);
-            break;
-
-          case BP_LONG:
-           if (tab->bitsgn)
-              {
-               int	*bufdata = (int *)cbufdata0;
-#pragma ivdep
-              for (i=spoonful; i--;)
-                *(bufdata++) = (int)*(ptr++);
-              }
-            else
-              {
-               unsigned int	*bufdata = (unsigned int *)cbufdata0;
-#pragma ivdep
-              for (i=spoonful; i--;)
-                *(bufdata++) = (unsigned int)*(ptr++);
-              }
-            if (bswapflag)
-              swapbytes(cbufdata0, 4, spoonful);
-            break;
-
-#ifdef HAVE_LONG_LONG_INT
-          case BP_LONGLONG:
-           if (tab->bitsgn)
-              {
-               SLONGLONG	*bufdata = (SLONGLONG *)cbufdata0;
-#pragma ivdep
-              for (i=spoonful; i--;)
-                *(bufdata++) = (SLONGLONG)*(ptr++);
-              }
-            else
-              {
-               ULONGLONG	*bufdata = (ULONGLONG *)cbufdata0;
-#pragma ivdep
-              for (i=spoonful; i--;)
-                *(bufdata++) = (ULONGLONG)*(ptr++);
-              }
-            if (bswapflag)
-              swapbytes(cbufdata0, 8, spoonful);
-            break;
-#endif
-          case BP_FLOAT:
-            {
-             float	*bufdata = (float *)cbufdata0;
-#pragma ivdep
-            for (i=spoonful; i--;)
-              *(bufdata++) = (float)((double)*(ptr++)-bz)/bs;
-            if (bswapflag)
-              swapbytes(cbufdata0, 4, spoonful);
-            }
-            break;
-
-          case BP_DOUBLE:
-            {
-             double	*bufdata = (double *)cbufdata0;
-#pragma ivdep
-            for (i=spoonful; i--;)
-              *(bufdata++) = ((double)*(ptr++)-bz)/bs;
-            if (bswapflag)
-              swapbytes(cbufdata0, 8, spoonful);
-            }
-            break;
-
-          default:
-            error(EXIT_FAILURE,"*FATAL ERROR*: unknown BITPIX type in ",
-                                "read_body()");
-            break;
+          tab->bodysum = compute_bufsum(cbufdata0, spoonful*tab->bytepix,
+			tab->bodysumpos, tab->bodysum);
+          tab->bodysumpos += spoonful*tab->bytepix;
           }
-        QFWRITE(cbufdata0, spoonful*tab->bytepix, cat->file, cat->filename);
         }
       break;
 
@@ -1395,6 +1477,126 @@ int set_maxvram(size_t maxvram)
   }
 
 
+/******* reserve_ram **********************************************************
+PROTO	int reserve_ram(size_t size, int vflag, int forceflag)
+PURPOSE	Book memory from the RAM (or virtual memory) budget set with
+	set_maxram() (or set_maxvram()).
+INPUT	Amount of memory (in bytes),
+	virtual memory flag (0 for RAM, 1 for virtual memory),
+	force flag (book memory even if the budget is exceeded).
+OUTPUT	RETURN_OK if memory was booked, RETURN_ERROR otherwise.
+NOTES	Thread-safe. Memory must be given back with release_ram().
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+int	reserve_ram(size_t size, int vflag, int forceflag)
+  {
+   size_t	*used, max;
+   int		status;
+
+#ifdef	USE_THREADS
+  pthread_mutex_lock(&body_rammutex);
+#endif
+  used = vflag? &body_vramused : &body_ramused;
+  max = vflag? body_maxvram : body_maxram;
+  if (forceflag || (*used < max && size < max - *used))
+    {
+    *used += size;
+    if (!vflag && body_ramused > body_rampeak)
+      body_rampeak = body_ramused;
+    status = RETURN_OK;
+    }
+  else
+    status = RETURN_ERROR;
+#ifdef	USE_THREADS
+  pthread_mutex_unlock(&body_rammutex);
+#endif
+
+  return status;
+  }
+
+
+/******* release_ram **********************************************************
+PROTO	void release_ram(size_t size, int vflag)
+PURPOSE	Give back memory booked with reserve_ram().
+INPUT	Amount of memory (in bytes),
+	virtual memory flag (0 for RAM, 1 for virtual memory).
+OUTPUT	-.
+NOTES	Thread-safe.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+void	release_ram(size_t size, int vflag)
+  {
+   size_t	*used;
+
+#ifdef	USE_THREADS
+  pthread_mutex_lock(&body_rammutex);
+#endif
+  used = vflag? &body_vramused : &body_ramused;
+  *used = size < *used? *used - size : 0;
+#ifdef	USE_THREADS
+  pthread_mutex_unlock(&body_rammutex);
+#endif
+
+  return;
+  }
+
+
+/******* get_ramleft **********************************************************
+PROTO	size_t get_ramleft(int vflag)
+PURPOSE	Return the amount of memory left in the RAM (or virtual memory)
+	budget.
+INPUT	Virtual memory flag (0 for RAM, 1 for virtual memory).
+OUTPUT	Amount of memory (in bytes).
+NOTES	Thread-safe.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+size_t	get_ramleft(int vflag)
+  {
+   size_t	used, max;
+
+#ifdef	USE_THREADS
+  pthread_mutex_lock(&body_rammutex);
+#endif
+  used = vflag? body_vramused : body_ramused;
+  max = vflag? body_maxvram : body_maxram;
+#ifdef	USE_THREADS
+  pthread_mutex_unlock(&body_rammutex);
+#endif
+
+  return used < max? max - used : 0;
+  }
+
+
+/******* get_rampeak **********************************************************
+PROTO	size_t get_rampeak(int resetflag)
+PURPOSE	Return the peak amount of RAM booked with reserve_ram().
+INPUT	Reset flag (restart peak measurement from the current usage).
+OUTPUT	Amount of memory (in bytes).
+NOTES	Thread-safe.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+size_t	get_rampeak(int resetflag)
+  {
+   size_t	peak;
+
+#ifdef	USE_THREADS
+  pthread_mutex_lock(&body_rammutex);
+#endif
+  peak = body_rampeak;
+  if (resetflag)
+    body_rampeak = body_ramused;
+#ifdef	USE_THREADS
+  pthread_mutex_unlock(&body_rammutex);
+#endif
+
+  return peak;
+  }
+
+
 /******* set_swapdir **********************************************************
 PROTO	int set_swapdir(char *dirname)
 PURPOSE	Set the path name of the directory that will be used for storing
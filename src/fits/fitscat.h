@@ -28,7 +28,7 @@
 *	along with AstrOmatic software.
 *	If not, see <http://www.gnu.org/licenses/>.
 *
-*	Last modified:		21/03/2025
+*	Last modified:		19/10/2026
 *
 *%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
 
@@ -202,6 +202,8 @@ typedef struct structtab
   int		swapflag;		/* mapped to a swap file ? */
   char		swapname[MAXCHARS];	/* name of the swapfile */
   unsigned int	bodysum;	/* Checksum of the FITS body */
+  OFF_T2	bodysumpos;	/* Current body position for checksum */
+  int		bodysumflag;	/* Checksum computed while writing? */
   int isTileCompressed;		/* is this a tile compressed image?  */
 #ifdef HAVE_CFITSIO
   int cfitsio_hdunum;				/* FITS HDU number for this 'table' */
@@ -231,7 +233,11 @@ extern keystruct	*name_to_key(tabstruct *tab, char *keyname),
 extern void	add_cleanupfilename(char *filename),
 		cleanup_files(void),
 		copy_tab_fromptr(tabstruct *tabin, catstruct *catout, int pos),
+		encode_body(tabstruct *tab, PIXTYPE *ptr, void *buf,
+			size_t size),
 		encode_checksum(unsigned int sum, char *str),
+		encode_ibody(tabstruct *tab, FLAGTYPE *ptr, void *buf,
+			size_t size),
 		end_readobj(tabstruct *keytab, tabstruct *tab, char *buf),
 		end_writeobj(catstruct *cat, tabstruct *tab, char *buf),
 		error(int code, const char *msg1, const char *msg2),
@@ -250,14 +256,18 @@ extern void	add_cleanupfilename(char *filename),
 		read_body(tabstruct *tab, PIXTYPE *ptr, size_t size),
 		read_ibody(tabstruct *tab, FLAGTYPE *ptr, size_t size),
 		readbasic_head(tabstruct *tab),
+		release_ram(size_t size, int vflag),
 		remove_cleanupfilename(char *filename),
 		save_cat(catstruct *cat, char *filename),
 		save_tab(catstruct *cat, tabstruct *tab),
+		start_bodysum(tabstruct *tab, OFF_T2 pos),
 		show_keys(tabstruct *tab, char **keynames, keystruct **keys,
 			int nkeys, unsigned char *mask, FILE *stream,
 			int strflag,int banflag, int leadflag,
                         output_type o_type),
 		swapbytes(void *, int, int),
+		update_checksum(char *headbuf, int headnblock,
+			unsigned int bodysum),
 		ttypeconv(void *ptrin, void *ptrout,
 			t_type ttypein, t_type ttypeout),
 		voprint_obj(FILE *stream, tabstruct *tab),
@@ -274,7 +284,10 @@ extern char	*tdisptoprintf(char *tdisp, char *str),
 		*warning_history(void);
 
 extern unsigned int
+		add_checksum(unsigned int sum1, unsigned int sum2),
 		compute_blocksum(char *buf, unsigned int sum),
+		compute_bufsum(char *buf, size_t size, OFF_T2 pos,
+			unsigned int sum),
 		compute_bodysum(tabstruct *tab, unsigned int sum),
 		decode_checksum(char *str);
 
@@ -327,6 +340,7 @@ extern int	about_cat(catstruct *cat, FILE *stream),
                 removekeywordfrom_head(tabstruct *tab, char *keyword),
 		remove_tab(catstruct *cat, char *tabname, int seg),
 		remove_tabs(catstruct *cat),
+		reserve_ram(size_t size, int vflag, int forceflag),
 		save_head(catstruct *cat, tabstruct *tab),
 		set_maxram(size_t maxram),
 		set_maxvram(size_t maxvram),
@@ -336,6 +350,7 @@ extern int	about_cat(catstruct *cat, FILE *stream),
 		tsizeof(char *str),
 		update_head(tabstruct *tab),
 		decomp_head(tabstruct *tab),
+		end_bodysum(tabstruct *tab),
 		update_tab(tabstruct *tab),
 		verify_checksum(tabstruct *tab),
 		write_obj(tabstruct *tab, char *buf),
@@ -347,4 +362,7 @@ extern PIXTYPE	*alloc_body(tabstruct *tab,
 extern FLAGTYPE	*alloc_ibody(tabstruct *tab,
 			void (*func)(FLAGTYPE *ptr, int npix));
 
+extern size_t	get_ramleft(int vflag),
+		get_rampeak(int resetflag);
+
 extern t_type	ttypeof(char *str);
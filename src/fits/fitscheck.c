@@ -23,7 +23,7 @@
 *	along with AstrOmatic software.
 *	If not, see <http://www.gnu.org/licenses/>.
 *
-*	Last modified:		11/02/2020
+*	Last modified:		19/10/2026
 *
 *%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
 
@@ -256,6 +256,204 @@ unsigned int	compute_bodysum(tabstruct *tab, unsigned int sum)
   }
 
 
+/****** compute_bufsum ******************************************************
+PROTO	unsigned int compute_bufsum(char *buf, size_t size, OFF_T2 pos,
+			unsigned int sum)
+PURPOSE	Update the checksum of a FITS body with an arbitrary chunk of data.
+INPUT	Pointer to the chunk,
+	chunk size (in bytes),
+	position of the chunk with respect to the start of the body (bytes),
+	checksum of the previous chunks.
+OUTPUT	The new computed checksum.
+NOTES	Chunks need not be aligned on FITS blocks nor on 32 bit words, and may
+	be provided in any order. Zero padding does not change the checksum.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+unsigned int	compute_bufsum(char *buf, size_t size, OFF_T2 pos,
+			unsigned int sum)
+  {
+   unsigned char	*cbuf;
+   unsigned long long	hi,lo, hicarry,locarry;
+   size_t		n;
+   int			phase;
+
+  cbuf = (unsigned char *)buf;
+  hi = (sum >> 16);
+  lo = (sum << 16) >> 16;
+/* Leading bytes, up to the next 32 bit boundary */
+  for (phase=(int)(pos&3); size && phase; phase=(phase+1)&3, size--)
+    switch(phase)
+      {
+      case 1:	hi += *(cbuf++);
+		break;
+      case 2:	lo += *(cbuf++)<<8;
+		break;
+      default:	lo += *(cbuf++);
+		break;
+      }
+/* Big-endian 16 bit words (no overflow possible with 64 bit accumulators) */
+  for (n=size/4; n--; cbuf+=4)
+    {
+    hi += (cbuf[0]<<8) + cbuf[1];
+    lo += (cbuf[2]<<8) + cbuf[3];
+    }
+/* Trailing bytes */
+  for (n=size%4, phase=0; n--; phase++)
+    switch(phase)
+      {
+      case 0:	hi += *(cbuf++)<<8;
+		break;
+      case 1:	hi += *(cbuf++);
+		break;
+      default:	lo += *(cbuf++)<<8;
+		break;
+      }
+
+  hicarry = hi>>16;     /* fold carry bits in */
+  locarry = lo>>16;
+  while (hicarry || locarry)
+    {
+    hi = (hi & 0xFFFF) + locarry;
+    lo = (lo & 0xFFFF) + hicarry;
+    hicarry = hi >> 16;
+    locarry = lo >> 16;
+    }
+
+  return (unsigned int)((hi << 16) + lo);
+  }
+
+
+/****** add_checksum *********************************************************
+PROTO	unsigned int add_checksum(unsigned int sum1, unsigned int sum2)
+PURPOSE	Combine the checksums of two disjoint parts of a FITS body.
+INPUT	First checksum,
+	second checksum.
+OUTPUT	The combined checksum.
+NOTES	Both parts must start on a 32 bit boundary of the body, or checksums
+	must have been computed with the actual positions of the data (see
+	compute_bufsum()).
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+unsigned int	add_checksum(unsigned int sum1, unsigned int sum2)
+  {
+   unsigned int	hi,lo, hicarry,locarry;
+
+  hi = (sum1 >> 16) + (sum2 >> 16);
+  lo = (sum1 & 0xFFFF) + (sum2 & 0xFFFF);
+  hicarry = hi>>16;
+  locarry = lo>>16;
+  while (hicarry || locarry)
+    {
+    hi = (hi & 0xFFFF) + locarry;
+    lo = (lo & 0xFFFF) + hicarry;
+    hicarry = hi >> 16;
+    locarry = lo >> 16;
+    }
+
+  return (hi << 16) + lo;
+  }
+
+
+/****** start_bodysum ********************************************************
+PROTO	void start_bodysum(tabstruct *tab, OFF_T2 pos)
+PURPOSE	Prepare the computation of the checksum of a FITS body on-the-fly,
+	while it is being written with write_body() or write_ibody().
+INPUT	Pointer to the tab,
+	position in the body of the first data to be written (bytes).
+OUTPUT	-.
+NOTES	Must be called before the header is written, as CHECKSUM, DATASUM and
+	CHECKVER keywords are added to it (which may change its size). The
+	header on disk is updated with end_bodysum().
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+void	start_bodysum(tabstruct *tab, OFF_T2 pos)
+  {
+  addkeywordto_head(tab, "CHECKSUM", "ASCII 1's complement checksum");
+  fitswrite(tab->headbuf, "CHECKSUM", "0000000000000000",
+	H_STRING, T_STRING);
+  addkeywordto_head(tab, "DATASUM ", "Checksum of data records");
+  fitswrite(tab->headbuf, "DATASUM ", "0", H_STRING, T_STRING);
+  addkeywordto_head(tab, "CHECKVER", "Checksum version ID");
+  fitswrite(tab->headbuf, "CHECKVER", "COMPLEMENT", H_STRING, T_STRING);
+  tab->bodysum = 0;
+  tab->bodysumpos = pos;
+  tab->bodysumflag = 1;
+
+  return;
+  }
+
+
+/****** update_checksum ******************************************************
+PROTO	void update_checksum(char *headbuf, int headnblock,
+			unsigned int bodysum)
+PURPOSE	Update the DATASUM and CHECKSUM keywords of a FITS header, given the
+	checksum of the body.
+INPUT	Pointer to the header buffer,
+	number of FITS blocks in the header,
+	checksum of the body.
+OUTPUT	-.
+NOTES	DATASUM and CHECKSUM keywords must already be present.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+void	update_checksum(char *headbuf, int headnblock, unsigned int bodysum)
+  {
+   char		str[32],
+		*buf;
+   unsigned int	sum;
+   int		i;
+
+  sprintf(str, "%u", bodysum);
+  fitswrite(headbuf, "DATASUM ", str, H_STRING, T_STRING);
+  fitswrite(headbuf, "CHECKSUM", "0000000000000000", H_STRING, T_STRING);
+  sum = bodysum;
+  buf = headbuf;
+  for (i=headnblock; i--; buf+=FBSIZE)
+    sum = compute_blocksum(buf, sum);
+/* Complement to 1 */
+  encode_checksum(~sum, str);
+  fitswrite(headbuf, "CHECKSUM", str, H_STRING, T_STRING);
+
+  return;
+  }
+
+
+/****** end_bodysum **********************************************************
+PROTO	int end_bodysum(tabstruct *tab)
+PURPOSE	Write the checksum of a FITS body computed on-the-fly to the header,
+	and update the header on disk.
+INPUT	Pointer to the tab.
+OUTPUT	RETURN_OK if successful (or nothing to do), RETURN_ERROR if the file
+	could not be updated.
+NOTES	The file must be closed. It is re-opened for update at the header
+	position (tab->headpos), which also works for files written in append
+	mode.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+int	end_bodysum(tabstruct *tab)
+  {
+   FILE		*file;
+   catstruct	*cat;
+
+  if (!tab->bodysumflag)
+    return RETURN_OK;
+
+  tab->bodysumflag = 0;
+  update_checksum(tab->headbuf, tab->headnblock, tab->bodysum);
+  if (!(cat=tab->cat) || !(file=fopen(cat->filename, "r+b")))
+    return RETURN_ERROR;
+  QFSEEK(file, tab->headpos, SEEK_SET, cat->filename);
+  QFWRITE(tab->headbuf, tab->headnblock*FBSIZE, file, cat->filename);
+  fclose(file);
+
+  return RETURN_OK;
+  }
+
+
 /****** write_checksum *****************************************************
 PROTO	void write_checksum(tabstruct *tab)
 PURPOSE	Compute and write the checksum to a FITS table
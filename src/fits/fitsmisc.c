@@ -23,7 +23,7 @@
 *	along with AstrOmatic software.
 *	If not, see <http://www.gnu.org/licenses/>.
 *
-*	Last modified:		20/11/2013
+*	Last modified:		19/10/2026
 *
 *%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
 
@@ -37,12 +37,19 @@
 #include	<string.h>
 #include	<time.h>
 
+#ifdef USE_THREADS
+#include	<pthread.h>
+#endif
+
 #include	"fitscat_defs.h"
 #include	"fitscat.h"
 
 static void	(*errorfunc)(const char *msg1, const char *msg2) = NULL;
 static char	warning_historystr[WARNING_NMAX][192]={""};
 static int	nwarning = 0, nwarning_history = 0, nerror = 0;
+#ifdef USE_THREADS
+static pthread_mutex_t	warningmutex = PTHREAD_MUTEX_INITIALIZER;
+#endif
 
 /********************************* error ************************************/
 /*
@@ -75,13 +82,16 @@ void	error_installfunc(void (*func)(const char *msg1, const char *msg2))
 
 /********************************* warning **********************************/
 /*
-Print a warning message on screen.
+Print a warning message on screen (may be called from several threads).
 */
 void    warning(char *msg1, char *msg2)
   {
    time_t	warntime;
    struct tm	*tm;
 
+#ifdef USE_THREADS
+  pthread_mutex_lock(&warningmutex);
+#endif
   warntime = time(NULL);
   tm = localtime(&warntime);
  
@@ -91,7 +101,9 @@ void    warning(char *msg1, char *msg2)
 	tm->tm_year+1900, tm->tm_mon+1, tm->tm_mday,
 	tm->tm_hour, tm->tm_min, tm->tm_sec,
 	msg1, msg2);
-
+#ifdef USE_THREADS
+  pthread_mutex_unlock(&warningmutex);
+#endif
 
   return;
   }
@@ -23,7 +23,7 @@
 *	along with AstrOmatic software.
 *	If not, see <http://www.gnu.org/licenses/>.
 *
-*	Last modified:		20/12/2019
+*	Last modified:		19/10/2026
 *
 *%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
 
@@ -39,6 +39,9 @@
 #include	<stdio.h>
 #include	<stdlib.h>
 #include	<string.h>
+#ifdef USE_THREADS
+#include	<pthread.h>
+#endif
 
 #include	"fits/fitscat_defs.h"
 #include	"fits/fitscat.h"
@@ -48,6 +51,23 @@
 #include	"wcs/lin.h"
 #include	"wcs/tnx.h"
 #include	"wcs/poly.h"
+#include	"wcs/wcstrig.h"
+
+static wcslineenum	wcsline_type(wcsstruct *wcs);
+
+static double		wcsline_cosd(double angle),
+			wcsline_sind(double angle);
+
+static int		wcsinv_getcache(wcsstruct *wcs, double *key, int nkey),
+			wcsinv_key(wcsstruct *wcs, int tnxflag, double **key);
+
+static void		wcsinv_putcache(wcsstruct *wcs, double *key, int nkey);
+
+static wcsinvstruct	wcsinvcache[WCS_INVCACHESIZE];
+static int		wcsinvcache_next;
+#ifdef USE_THREADS
+static pthread_mutex_t	wcsinvmutex = PTHREAD_MUTEX_INITIALIZER;
+#endif
 
 /******* copy_wcs ************************************************************
 PROTO	wcsstruct *copy_wcs(wcsstruct *wcsin)
@@ -56,8 +76,8 @@ INPUT	WCS structure to be copied.
 OUTPUT	pointer to a copy of the input structure.
 NOTES	Actually, only FITS parameters are copied. Lower-level structures
 	such as those created by the WCS or TNX libraries are generated.
-AUTHOR	E. Bertin (IAP)
-VERSION	06/12/2019
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
  ***/
 wcsstruct	*copy_wcs(wcsstruct *wcsin)
 
@@ -89,6 +109,7 @@ wcsstruct	*copy_wcs(wcsstruct *wcsin)
     wcs->inv_x = wcs->prj->inv_x = poly_copy(wcsin->inv_x);
   if (wcsin->inv_y)
     wcs->inv_y = wcs->prj->inv_y = poly_copy(wcsin->inv_y);
+  wcs->prj->inv_newton = wcsin->prj->inv_newton;
 /* Find the range of coordinates */
   range_wcs(wcs);  
 
@@ -785,6 +806,35 @@ void	end_wcs(wcsstruct *wcs)
   }
 
 
+/******* share_wcs ************************************************************
+PROTO	void share_wcs(wcsstruct *wcs)
+PURPOSE	Prepare a WCS structure for simultaneous use by several threads.
+INPUT	WCS structure.
+OUTPUT	-.
+NOTES	The WCS library sets up its internal structures on first use; this
+	is forced here in both directions, after which coordinate conversions
+	leave the WCS structure untouched. Must be called again after
+	init_wcs().
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+void	share_wcs(wcsstruct *wcs)
+
+  {
+   double	pixpos[NAXIS], wcspos[NAXIS];
+   int		i;
+
+  for (i=0; i<wcs->naxis; i++)
+    pixpos[i] = wcs->crpix[i];
+  if (raw_to_wcs(wcs, pixpos, wcspos) != RETURN_OK)
+    for (i=0; i<wcs->naxis; i++)
+      wcspos[i] = wcs->crval[i];
+  wcs_to_raw(wcs, wcspos, pixpos);
+
+  return;
+  }
+
+
 /******* wcs_supproj *********************************************************
 PROTO	int wcs_supproj(char *name)
 PURPOSE	Tell if a projection system is supported or not.
@@ -814,12 +864,16 @@ int	wcs_supproj(char *name)
 
 /******* invert_wcs ***********************************************************
 PROTO	void invert_wcs(wcsstruct *wcs)
-PURPOSE	Invert WCS projection mapping (using a polynomial).
+PURPOSE	Set up the inversion of TPV or TNX projection distortions.
 INPUT	WCS structure.
 OUTPUT	-.
-NOTES	.
-AUTHOR	E. Bertin (IAP)
-VERSION	06/12/2019
+NOTES	Inversion methods are tried in order of increasing cost on a grid of
+	points over the image: simple fixed-point iterations (TPV only), then
+	Newton's method with analytic Jacobians. If none meets WCS_INVACCURACY,
+	polynomial inverses are fitted, or retrieved from a cache of
+	previously fitted distortions.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
  ***/
 void	invert_wcs(wcsstruct *wcs)
 
@@ -827,18 +881,22 @@ void	invert_wcs(wcsstruct *wcs)
    polystruct		*poly;
    double		pixin[NAXIS],pixout[NAXIS], raw[NAXIS],rawmin[NAXIS];
    double		*outpos,*outpost, *lngpos,*lngpost,
-			*latpos,*latpost,
-			lngstep,latstep, rawsize, epsilon,
+			*latpos,*latpost, *key,
+			lngstep,latstep, epsilon,
 			errlng, errlat, maxerrlng, maxerrlat;
    int			group[] = {1,1};
 				/* Don't ask, this is needed by poly_init()! */
-   int		i,j,lng,lat,deg, tnxflag, maxflag, maxflagflag;
+   int		i,j,lng,lat,deg, tnxflag, maxflag, maxflagflag, nkey;
 
 /* Check first that inversion is not straightforward */
   lng = wcs->wcsprm->lng;
   lat = wcs->wcsprm->lat;
   if (!strcmp(wcs->wcsprm->pcode, "TNX"))
+    {
+    if (!wcs->tnx_lngcor || !wcs->tnx_latcor)
+      return;
     tnxflag = 1;
+    }
   else if ((!strcmp(wcs->wcsprm->pcode, "TAN")
 	|| !strcmp(wcs->wcsprm->pcode, "TPV"))
 		&& (wcs->projp[1+lng*100] || wcs->projp[1+lat*100]))
@@ -849,7 +907,7 @@ void	invert_wcs(wcsstruct *wcs)
 /* Compute the error margin of the inversion in degrees */
   for (i=0; i<wcs->naxis; i++)
     raw[i] = (wcs->naxisn[i] + 1.0) / 2.0;
-  epsilon = WCS_INVACCURACY * wcs_scale(wcs, raw);
+  epsilon = WCS_INVACCURACY * sqrt(wcs_scale(wcs, raw));
   if (epsilon < TINY)
     error(EXIT_FAILURE, "*Error*: incorrect pixel scale for ",
 		wcs->wcsprm->pcode);
@@ -867,7 +925,6 @@ void	invert_wcs(wcsstruct *wcs)
   outpost = outpos;
   lngpost = lngpos;
   latpost = latpos;
-  maxflag = 0;
   maxerrlng = maxerrlat = 0.0;
   for (j=WCS_NGRIDPOINTS; j--; raw[lat]+=latstep)
     {
@@ -899,66 +956,103 @@ void	invert_wcs(wcsstruct *wcs)
       }
     }
 
-  maxflag |= (maxerrlng > WCS_INVACCURACY || maxerrlat > WCS_INVACCURACY);
+/* Test if the simple TPV inversion is accurate enough */
+  if (!tnxflag && maxerrlng <= epsilon && maxerrlat <= epsilon)
+    goto invert_end;
 
-/// Test if polynomial inversion is required
-  if (maxflag) {
-/*-- Invert "longitude" */
-/*-- Find the lowest degree polynom */
-    poly = NULL;  /* to avoid gcc -Wall warnings */
-    maxflag = 1;
-    for (deg=1; deg<=WCS_INVMAXDEG && maxflag; deg++)
+/* Test Newton's method */
+  maxflag = 0;
+  outpost = outpos;
+  lngpost = lngpos;
+  latpost = latpos;
+  for (i=WCS_NGRIDPOINTS2; i--; outpost+=2)
+    {
+    if (tnxflag)
+      maxflag = tnx_to_raw_newton(wcs->prj, *outpost, *(outpost+1),
+		&pixout[lng], &pixout[lat]);
+    else
+      maxflag = pv_to_raw_newton(wcs->prj, *outpost, *(outpost+1),
+		&pixout[lng], &pixout[lat]);
+    if (maxflag || fabs(pixout[lng] - *(lngpost++)) > epsilon
+	|| fabs(pixout[lat] - *(latpost++)) > epsilon)
       {
-      if (deg>1)
-        poly_end(poly);
-      poly = poly_init(group, 2, &deg, 1);
-      poly_fit(poly, outpos, lngpos, NULL, WCS_NGRIDPOINTS2, NULL,
-	1.0e-9/WCS_NGRIDPOINTS2);
-      maxflag = 0;
-      outpost = outpos;
-      lngpost = lngpos;
-      for (i=WCS_NGRIDPOINTS2; i--; outpost+=2)
-        if (fabs(poly_func(poly, outpost)-*(lngpost++))>epsilon)
-          {
-          maxflag = 1;
-          break;
-          }
+      maxflag = 1;
+      break;
       }
+    }
 
-/*-- Now link the created structure */
-    wcs->prj->inv_x = wcs->inv_x = poly;
+  if (!maxflag)
+    {
+    wcs->prj->inv_newton = 1;
+    goto invert_end;
+    }
 
-    maxflagflag = maxflag;
+/* Fall back to polynomial inversion: check first if it has been done before */
+  nkey = wcsinv_key(wcs, tnxflag, &key);
+  if (wcsinv_getcache(wcs, key, nkey) == RETURN_OK)
+    {
+    free(key);
+    goto invert_end;
+    }
 
-/*-- Invert "latitude" */
-/*-- Find the lowest degree polynom */
-    maxflag = 1;
-    for (deg=1; deg<=WCS_INVMAXDEG && maxflag; deg++)
-      {
-      if (deg>1)
-        poly_end(poly);
-      poly = poly_init(group, 2, &deg, 1);
-      poly_fit(poly, outpos, latpos, NULL, WCS_NGRIDPOINTS2, NULL,
+/* Invert "longitude" */
+/* Find the lowest degree polynom */
+  poly = NULL;  /* to avoid gcc -Wall warnings */
+  maxflag = 1;
+  for (deg=1; deg<=WCS_INVMAXDEG && maxflag; deg++)
+    {
+    if (deg>1)
+      poly_end(poly);
+    poly = poly_init(group, 2, &deg, 1);
+    poly_fit(poly, outpos, lngpos, NULL, WCS_NGRIDPOINTS2, NULL,
 	1.0e-9/WCS_NGRIDPOINTS2);
-      maxflag = 0;
-      outpost = outpos;
-      latpost = latpos;
-      for (i=WCS_NGRIDPOINTS2; i--; outpost+=2)
-        if (fabs(poly_func(poly, outpost)-*(latpost++))>epsilon)
-          {
-          maxflag = 1;
-          break;
-          }
-      }
-/*-- Now link the created structure */
-    wcs->prj->inv_y = wcs->inv_y = poly;
+    maxflag = 0;
+    outpost = outpos;
+    lngpost = lngpos;
+    for (i=WCS_NGRIDPOINTS2; i--; outpost+=2)
+      if (fabs(poly_func(poly, outpost)-*(lngpost++))>epsilon)
+        {
+        maxflag = 1;
+        break;
+        }
+    }
 
-    maxflagflag |= maxflag;
+/* Now link the created structure */
+  wcs->prj->inv_x = wcs->inv_x = poly;
 
-    if (maxflagflag)
-      warning("Significant inaccuracy likely to occur in projection","");
-  }
+  maxflagflag = maxflag;
 
+/* Invert "latitude" */
+/* Find the lowest degree polynom */
+  maxflag = 1;
+  for (deg=1; deg<=WCS_INVMAXDEG && maxflag; deg++)
+    {
+    if (deg>1)
+      poly_end(poly);
+    poly = poly_init(group, 2, &deg, 1);
+    poly_fit(poly, outpos, latpos, NULL, WCS_NGRIDPOINTS2, NULL,
+	1.0e-9/WCS_NGRIDPOINTS2);
+    maxflag = 0;
+    outpost = outpos;
+    latpost = latpos;
+    for (i=WCS_NGRIDPOINTS2; i--; outpost+=2)
+      if (fabs(poly_func(poly, outpost)-*(latpost++))>epsilon)
+        {
+        maxflag = 1;
+        break;
+        }
+    }
+/* Now link the created structure */
+  wcs->prj->inv_y = wcs->inv_y = poly;
+
+  maxflagflag |= maxflag;
+
+  if (maxflagflag)
+    warning("Significant inaccuracy likely to occur in projection","");
+
+  wcsinv_putcache(wcs, key, nkey);
+
+invert_end:
 /* Free memory */
   free(outpos);
   free(lngpos);
@@ -968,15 +1062,188 @@ void	invert_wcs(wcsstruct *wcs)
   }
 
 
+/******* wcsinv_key ***********************************************************
+PROTO	int wcsinv_key(wcsstruct *wcs, int tnxflag, double **key)
+PURPOSE	Build the list of parameters that define the polynomial inverse of a
+	projection distortion.
+INPUT	WCS structure,
+	TNX flag (0 for TPV),
+	pointer to the parameter array (allocated by the function).
+OUTPUT	Number of parameters.
+NOTES	Polynomial inverses are fitted on a grid of image pixels, hence the
+	key includes the image size and the linear part of the WCS, but not
+	the reference sky coordinates.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+static int	wcsinv_key(wcsstruct *wcs, int tnxflag, double **key)
+
+  {
+   tnxaxisstruct	*axis[2];
+   double		*keyt;
+   int			a, i, naxis, nkey;
+
+  naxis = wcs->naxis;
+  nkey = 1 + 2*naxis + naxis*naxis;
+  axis[0] = wcs->tnx_lngcor;
+  axis[1] = wcs->tnx_latcor;
+  if (tnxflag)
+    {
+    for (a=0; a<2; a++)
+      if (axis[a])
+        nkey += 8 + axis[a]->ncoeff;
+    }
+  else
+    nkey += 200;
+
+  QMALLOC(*key, double, nkey);
+  keyt = *key;
+  *(keyt++) = (double)tnxflag;
+  for (i=0; i<naxis; i++)
+    {
+    *(keyt++) = (double)wcs->naxisn[i];
+    *(keyt++) = wcs->crpix[i];
+    }
+  for (i=0; i<naxis*naxis; i++)
+    *(keyt++) = wcs->cd[i];
+  if (tnxflag)
+    {
+    for (a=0; a<2; a++)
+      if (axis[a])
+        {
+        *(keyt++) = (double)axis[a]->type;
+        *(keyt++) = (double)axis[a]->xorder;
+        *(keyt++) = (double)axis[a]->yorder;
+        *(keyt++) = (double)axis[a]->xterms;
+        *(keyt++) = axis[a]->xrange;
+        *(keyt++) = axis[a]->yrange;
+        *(keyt++) = axis[a]->xmaxmin;
+        *(keyt++) = axis[a]->ymaxmin;
+        for (i=0; i<axis[a]->ncoeff; i++)
+          *(keyt++) = axis[a]->coeff[i];
+        }
+    }
+  else
+    for (i=0; i<200; i++)
+      *(keyt++) = wcs->prj->p[i];
+
+  return nkey;
+  }
+
+
+/******* wcsinv_getcache ******************************************************
+PROTO	int wcsinv_getcache(wcsstruct *wcs, double *key, int nkey)
+PURPOSE	Look for a cached polynomial inverse and copy it to a WCS structure.
+INPUT	WCS structure,
+	pointer to the key parameters,
+	number of key parameters.
+OUTPUT	RETURN_OK if found in the cache, RETURN_ERROR otherwise.
+NOTES	Thread-safe.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+static int	wcsinv_getcache(wcsstruct *wcs, double *key, int nkey)
+
+  {
+   wcsinvstruct	*inv;
+   int		c, status;
+
+  status = RETURN_ERROR;
+#ifdef USE_THREADS
+  pthread_mutex_lock(&wcsinvmutex);
+#endif
+  for (c=0, inv=wcsinvcache; c<WCS_INVCACHESIZE; c++, inv++)
+    if (inv->key && inv->nkey==nkey
+	&& !memcmp(inv->key, key, nkey*sizeof(double)))
+      {
+      wcs->prj->inv_x = wcs->inv_x = poly_copy(inv->inv_x);
+      wcs->prj->inv_y = wcs->inv_y = poly_copy(inv->inv_y);
+      status = RETURN_OK;
+      break;
+      }
+#ifdef USE_THREADS
+  pthread_mutex_unlock(&wcsinvmutex);
+#endif
+
+  return status;
+  }
+
+
+/******* wcsinv_putcache ******************************************************
+PROTO	void wcsinv_putcache(wcsstruct *wcs, double *key, int nkey)
+PURPOSE	Store the polynomial inverse of a WCS structure in the cache.
+INPUT	WCS structure,
+	pointer to the key parameters,
+	number of key parameters.
+OUTPUT	-.
+NOTES	The key array is handed over to the cache. When the cache is full the
+	oldest entry is replaced. Thread-safe.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+static void	wcsinv_putcache(wcsstruct *wcs, double *key, int nkey)
+
+  {
+   wcsinvstruct	*inv;
+
+#ifdef USE_THREADS
+  pthread_mutex_lock(&wcsinvmutex);
+#endif
+  inv = wcsinvcache + wcsinvcache_next;
+  wcsinvcache_next = (wcsinvcache_next+1)%WCS_INVCACHESIZE;
+  free(inv->key);
+  poly_end(inv->inv_x);
+  poly_end(inv->inv_y);
+  inv->key = key;
+  inv->nkey = nkey;
+  inv->inv_x = poly_copy(wcs->inv_x);
+  inv->inv_y = poly_copy(wcs->inv_y);
+#ifdef USE_THREADS
+  pthread_mutex_unlock(&wcsinvmutex);
+#endif
+
+  return;
+  }
+
+
+/******* end_wcsinvcache ******************************************************
+PROTO	void end_wcsinvcache(void)
+PURPOSE	Free the cache of polynomial inverses.
+INPUT	-.
+OUTPUT	-.
+NOTES	-.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+void	end_wcsinvcache(void)
+
+  {
+   wcsinvstruct	*inv;
+   int		c;
+
+  for (c=0, inv=wcsinvcache; c<WCS_INVCACHESIZE; c++, inv++)
+    {
+    free(inv->key);
+    poly_end(inv->inv_x);
+    poly_end(inv->inv_y);
+    memset(inv, 0, sizeof(wcsinvstruct));
+    }
+  wcsinvcache_next = 0;
+
+  return;
+  }
+
+
 /******* range_wcs ***********************************************************
 PROTO	void range_wcs(wcsstruct *wcs)
 PURPOSE	Find roughly the range of WCS coordinates on all axes,
 	and typical pixel scales.
 INPUT	WCS structure.
 OUTPUT	-.
-NOTES	.
-AUTHOR	E. Bertin (IAP)
-VERSION	24/08/2010
+NOTES	Reentrant: the exploration of the image for a mappable "center" uses
+	a local, deterministic pseudo-random sequence.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
  ***/
 void	range_wcs(wcsstruct *wcs)
 
@@ -985,10 +1252,12 @@ void	range_wcs(wcsstruct *wcs)
 			world[NAXIS], world2[NAXIS];
    double		*worldmin, *worldmax, *scale, *worldc,
 			rad, radmax, lc;
+   unsigned int		seed;
    int			linecount[NAXIS];
    int			i,j, naxis, npoints, lng,lat;
 
   naxis = wcs->naxis;
+  seed = 1;
 
 /* World range */
   npoints = 1;
@@ -1007,7 +1276,7 @@ void	range_wcs(wcsstruct *wcs)
     for (j=0; j<100; j++)
       {
       for (i=0; i<naxis; i++)
-        raw[i] += wcs->naxisn[i]/100.0*(0.5-(double)rand()/RAND_MAX);      
+        raw[i] += wcs->naxisn[i]/100.0*(0.5-(double)rand_r(&seed)/RAND_MAX);
       if (!raw_to_wcs(wcs, raw, world))
         break;
       }
@@ -1400,6 +1669,608 @@ int	wcs_to_raw(wcsstruct *wcs, double *wcspos, double *pixpos)
   }
 
 
+/******* raw_to_wcs_line ******************************************************
+PROTO	int raw_to_wcs_line(wcsstruct *wcs, double *pixpos, double *wcspos,
+			int npos)
+PURPOSE	Convert an array of raw (pixel) coordinates to WCS (World Coordinate
+	System).
+INPUT	WCS structure,
+	Pointer to the array of input coordinates,
+	Pointer to the array of output coordinates,
+	Number of positions.
+OUTPUT	Number of positions that could not be mapped.
+NOTES	Positions are stored as consecutive vectors of naxis coordinates.
+	Unmapped positions are set to WCS_NOCOORD. The projection is resolved
+	once for the whole array, and the most common ones (TAN, TPV, TNX,
+	orthographic SIN, ZEA and CAR) are processed by dedicated kernels that
+	give the same results as raw_to_wcs(). Kernels work on blocks of
+	WCSLINE_BLOCK positions in separate passes (linear transformation,
+	projection corrections, projection and spherical rotation), with the
+	projection selected outside of the loops.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+int	raw_to_wcs_line(wcsstruct *wcs, double *pixpos, double *wcspos,
+			int npos)
+  {
+   struct linprm	*lin;
+   struct prjprm	*prj;
+   double		xb[WCSLINE_BLOCK],yb[WCSLINE_BLOCK],
+			phib[WCSLINE_BLOCK],thetab[WCSLINE_BLOCK],
+			img[NAXIS],
+			*pix, *world, *eul, *buf0,*buf1,
+			x,y, xp,yp, r,s, phi,theta, dphi, sinthe,costhe,
+			sinphi,cosphi, lng,lat, img0,img1, temp,temp2,
+			m00,m01,m10,m11, crpix0,crpix1, crval0,crval1;
+   wcslineenum		type;
+   int			i,ij,j, k, n,nb, naxis, lngi,lati, nerr;
+
+  if (npos<1)
+    return 0;
+  naxis = wcs->naxis;
+  lin = wcs->lin;
+  prj = wcs->prj;
+  eul = wcs->cel->euler;
+/* The first position goes through the generic transformation, which also */
+/* sets up the WCS library; the projection kernel is found after that */
+  nerr = (raw_to_wcs(wcs, pixpos, wcspos) != RETURN_OK);
+  if ((type = wcsline_type(wcs)) == WCSLINE_NONE)
+    {
+    pix = pixpos;
+    world = wcspos;
+    for (n=1; n<npos; n++)
+      if (raw_to_wcs(wcs, pix+=naxis, world+=naxis) != RETURN_OK)
+        nerr++;
+    return nerr;
+    }
+  lngi = wcs->wcsprm->lng;
+  lati = wcs->wcsprm->lat;
+/* With 2 axes, the first and second ones go directly to the right buffers */
+  buf0 = lngi? yb : xb;
+  buf1 = lngi? xb : yb;
+  if (naxis == 2)
+    {
+    m00 = lin->piximg[0];
+    m01 = lin->piximg[1];
+    m10 = lin->piximg[2];
+    m11 = lin->piximg[3];
+    crpix0 = lin->crpix[0];
+    crpix1 = lin->crpix[1];
+    crval0 = wcs->crval[0];
+    crval1 = wcs->crval[1];
+    }
+  else
+    m00 = m01 = m10 = m11 = crpix0 = crpix1 = crval0 = crval1 = 0.0;
+  for (n=1; n<npos; n+=nb)
+    {
+    nb = npos-n < WCSLINE_BLOCK? npos-n : WCSLINE_BLOCK;
+/*-- Linear transformation */
+    pix = pixpos + n*naxis;
+    world = wcspos + n*naxis;
+    if (naxis == 2)
+/*---- Celestial pair only: no inner loops nor axis indexing */
+      for (k=0; k<nb; k++)
+        {
+        temp = pix[2*k] - crpix0;
+        temp2 = pix[2*k+1] - crpix1;
+        img0 = 0.0 + m00*temp;
+        img0 += m01*temp2;
+        img1 = 0.0 + m10*temp;
+        img1 += m11*temp2;
+        world[2*k] = img0 + crval0;
+        world[2*k+1] = img1 + crval1;
+        buf0[k] = img0;
+        buf1[k] = img1;
+        }
+    else
+      for (k=0; k<nb; k++, pix+=naxis, world+=naxis)
+        {
+        for (i=0; i<naxis; i++)
+          img[i] = 0.0;
+        for (j=0; j<naxis; j++)
+          {
+          temp = pix[j] - lin->crpix[j];
+          for (i=0, ij=j; i<naxis; i++, ij+=naxis)
+            img[i] += lin->piximg[ij]*temp;
+          }
+        for (j=0; j<naxis; j++)
+          world[j] = img[j] + wcs->crval[j];
+        xb[k] = img[lngi];
+        yb[k] = img[lati];
+        }
+/*-- Projection corrections */
+    if (type == WCSLINE_TNX)
+      for (k=0; k<nb; k++)
+        {
+        x = xb[k];
+        y = yb[k];
+        xb[k] = x + raw_to_tnxaxis(prj->tnx_lngcor, x, y);
+        yb[k] = y + raw_to_tnxaxis(prj->tnx_latcor, x, y);
+        }
+    else if (type == WCSLINE_TAN && prj->n)
+      for (k=0; k<nb; k++)
+        raw_to_pv(prj, xb[k],yb[k], &xb[k], &yb[k]);
+/*-- Projection (unmapped positions are flagged with a phi out of range) */
+    switch(type)
+      {
+      case WCSLINE_TAN:
+      case WCSLINE_TNX:
+        for (k=0; k<nb; k++)
+          {
+          xp = xb[k];
+          yp = yb[k];
+          r = sqrt(xp*xp+yp*yp);
+          phib[k] = (r == 0.0)? 0.0 : wcs_atan2d(xp, -yp);
+          thetab[k] = wcs_atan2d(prj->r0, r);
+          }
+        break;
+      case WCSLINE_SIN:
+        for (k=0; k<nb; k++)
+          {
+          xp = xb[k]*prj->w[0];
+          yp = yb[k]*prj->w[0];
+          r = xp*xp + yp*yp;
+          phib[k] = (r != 0.0)? wcs_atan2d(xp, -yp) : 0.0;
+          if (r < 0.5)
+            thetab[k] = wcs_acosd(sqrt(r));
+          else if (r <= 1.0)
+            thetab[k] = wcs_asind(sqrt(1.0 - r));
+          else
+            phib[k] = WCS_NOCOORD;
+          }
+        break;
+      case WCSLINE_ZEA:
+        for (k=0; k<nb; k++)
+          {
+          x = xb[k];
+          y = yb[k];
+          r = sqrt(x*x + y*y);
+          phib[k] = (r == 0.0)? 0.0 : wcs_atan2d(x, -y);
+          s = r*prj->w[1];
+          if (fabs(s) > 1.0)
+            {
+            if (fabs(r - prj->w[0]) < 1.0e-12)
+              thetab[k] = -90.0;
+            else
+              phib[k] = WCS_NOCOORD;
+            }
+          else
+            thetab[k] = 90.0 - 2.0*wcs_asind(s);
+          }
+        break;
+      case WCSLINE_CAR:
+        for (k=0; k<nb; k++)
+          {
+          phi = prj->w[1]*xb[k];
+          if (phi>180.0)
+            phi -= 360.0;
+          else if (phi<-180.0)
+            phi += 360.0;
+          phib[k] = phi;
+          thetab[k] = prj->w[1]*yb[k];
+          }
+        break;
+      default:
+        for (k=0; k<nb; k++)
+          phib[k] = WCS_NOCOORD;
+        break;
+      }
+
+/*-- Spherical rotation to celestial coordinates */
+    world = wcspos + n*naxis;
+    for (k=0; k<nb; k++, world+=naxis)
+      {
+      phi = phib[k];
+      theta = thetab[k];
+      if (fabs(phi)>180.0 || fabs(theta)>90.0)
+        {
+        for (i=0; i<naxis; i++)
+          world[i] = WCS_NOCOORD;
+        nerr++;
+        continue;
+        }
+      sinthe = wcsline_sind(theta);
+      costhe = wcsline_cosd(theta);
+      dphi = phi - eul[2];
+      sinphi = wcsline_sind(dphi);
+      cosphi = wcsline_cosd(dphi);
+      x = sinthe*eul[4] - costhe*eul[3]*cosphi;
+      if (fabs(x) < 1.0e-5)
+        x = -wcsline_cosd(theta+eul[1]) + costhe*eul[3]*(1.0 - cosphi);
+      y = -costhe*sinphi;
+      lng = eul[0] + ((x != 0.0 || y != 0.0)? wcs_atan2d(y, x) : dphi + 180.0);
+      if (eul[0] >= 0.0)
+        {
+        if (lng < 0.0)
+          lng += 360.0;
+        }
+      else if (lng > 0.0)
+        lng -= 360.0;
+      if (lng > 360.0)
+        lng -= 360.0;
+      else if (lng < -360.0)
+        lng += 360.0;
+      if (dphi == floor(dphi) && fmod(dphi,180.0) == 0.0)
+        {
+        lat = theta + cosphi*eul[1];
+        if (lat >  90.0)
+          lat =  180.0 - lat;
+        if (lat < -90.0)
+          lat = -180.0 - lat;
+        }
+      else
+        {
+        s = sinthe*eul[3] + costhe*eul[4]*cosphi;
+        if (fabs(s) > 0.99)
+          lat = (s<0.0)? -wcs_acosd(sqrt(x*x+y*y)) : wcs_acosd(sqrt(x*x+y*y));
+        else
+          lat = wcs_asind(s);
+        }
+      world[lngi] = lng;
+      world[lati] = lat;
+/*---- If needed, convert from a different coordinate system to equatorial */
+      if (wcs->celsysconvflag)
+        celsys_to_eq(wcs, world);
+      }
+    }
+
+  return nerr;
+  }
+
+
+/******* wcs_to_raw_line ******************************************************
+PROTO	int wcs_to_raw_line(wcsstruct *wcs, double *wcspos, double *pixpos,
+			int npos)
+PURPOSE	Convert an array of WCS (World Coordinate System) coordinates to raw
+	(pixel) coordinates.
+INPUT	WCS structure,
+	Pointer to the array of input coordinates,
+	Pointer to the array of output coordinates,
+	Number of positions.
+OUTPUT	Number of positions that could not be mapped.
+NOTES	See raw_to_wcs_line(). Input positions set to WCS_NOCOORD are left
+	unmapped. As with wcs_to_raw(), input coordinates may be modified if a
+	celestial system conversion is required.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+int	wcs_to_raw_line(wcsstruct *wcs, double *wcspos, double *pixpos,
+			int npos)
+  {
+   struct linprm	*lin;
+   struct prjprm	*prj;
+   double		xb[WCSLINE_BLOCK],yb[WCSLINE_BLOCK],
+			phib[WCSLINE_BLOCK],thetab[WCSLINE_BLOCK],
+			img[NAXIS], xpp[2],
+			*pix, *world, *eul, *buf0,*buf1,
+			x,y,z, r,s,t, phi,theta, dlng, sinlat,coslat,
+			sinlng,coslng, costhe, img0,img1,
+			m00,m01,m10,m11, crpix0,crpix1;
+   wcslineenum		type;
+   int			i,ij,j, k, n,nb, naxis, lngi,lati, nerr;
+
+  naxis = wcs->naxis;
+  lin = wcs->lin;
+  prj = wcs->prj;
+  eul = wcs->cel->euler;
+  type = WCSLINE_NONE;
+  nerr = 0;
+  world = wcspos;
+  pix = pixpos;
+/* The first mapped position goes through the generic transformation, which */
+/* also sets up the WCS library; the projection kernel is found after that */
+  for (n=0; n<npos && type == WCSLINE_NONE; n++, pix+=naxis, world+=naxis)
+    {
+    if (*world == WCS_NOCOORD)
+      {
+      for (i=0; i<naxis; i++)
+        pix[i] = WCS_NOCOORD;
+      nerr++;
+      continue;
+      }
+    if (wcs_to_raw(wcs, world, pix) != RETURN_OK)
+      nerr++;
+    if ((type = wcsline_type(wcs)) == WCSLINE_NONE)
+      type = WCSLINE_GENERIC;
+    }
+  if (type == WCSLINE_GENERIC)
+    {
+    for (; n<npos; n++, pix+=naxis, world+=naxis)
+      if (*world == WCS_NOCOORD)
+        {
+        for (i=0; i<naxis; i++)
+          pix[i] = WCS_NOCOORD;
+        nerr++;
+        }
+      else if (wcs_to_raw(wcs, world, pix) != RETURN_OK)
+        nerr++;
+    return nerr;
+    }
+  lngi = wcs->wcsprm->lng;
+  lati = wcs->wcsprm->lat;
+/* With 2 axes, the first and second ones come directly from the right */
+/* buffers */
+  buf0 = lngi? yb : xb;
+  buf1 = lngi? xb : yb;
+  if (naxis == 2)
+    {
+    m00 = lin->imgpix[0];
+    m01 = lin->imgpix[1];
+    m10 = lin->imgpix[2];
+    m11 = lin->imgpix[3];
+    crpix0 = lin->crpix[0];
+    crpix1 = lin->crpix[1];
+    }
+  else
+    m00 = m01 = m10 = m11 = crpix0 = crpix1 = 0.0;
+  for (; n<npos; n+=nb)
+    {
+    nb = npos-n < WCSLINE_BLOCK? npos-n : WCSLINE_BLOCK;
+/*-- Spherical rotation to native coordinates (unmapped positions are */
+/*-- flagged with a theta out of range) */
+    world = wcspos + n*naxis;
+    for (k=0; k<nb; k++, world+=naxis)
+      {
+      if (*world == WCS_NOCOORD)
+        {
+        thetab[k] = WCS_NOCOORD;
+        continue;
+        }
+/*---- If needed, convert to a coordinate system different from equatorial */
+      if (wcs->celsysconvflag)
+        eq_to_celsys(wcs, world);
+      sinlat = wcsline_sind(world[lati]);
+      coslat = wcsline_cosd(world[lati]);
+      dlng = world[lngi] - eul[0];
+      sinlng = wcsline_sind(dlng);
+      coslng = wcsline_cosd(dlng);
+      x = sinlat*eul[4] - coslat*eul[3]*coslng;
+      if (fabs(x) < 1.0e-5)
+        x = -wcsline_cosd(world[lati]+eul[1]) + coslat*eul[3]*(1.0 - coslng);
+      y = -coslat*sinlng;
+      phi = eul[2] + ((x != 0.0 || y != 0.0)? wcs_atan2d(y, x) : dlng - 180.0);
+      if (phi > 180.0)
+        phi -= 360.0;
+      else if (phi < -180.0)
+        phi += 360.0;
+      if (dlng == floor(dlng) && fmod(dlng,180.0) == 0.0)
+        {
+        theta = world[lati] + coslng*eul[1];
+        if (theta >  90.0)
+          theta =  180.0 - theta;
+        if (theta < -90.0)
+          theta = -180.0 - theta;
+        }
+      else
+        {
+        z = sinlat*eul[3] + coslat*eul[4]*coslng;
+        if (fabs(z) > 0.99)
+          theta = (z<0.0)? -wcs_acosd(sqrt(x*x+y*y)) : wcs_acosd(sqrt(x*x+y*y));
+        else
+          theta = wcs_asind(z);
+        }
+      phib[k] = phi;
+      thetab[k] = theta;
+      }
+/*-- Projection (unmapped positions are flagged by setting x and y to */
+/*-- WCS_NOCOORD) */
+    switch(type)
+      {
+      case WCSLINE_TAN:
+      case WCSLINE_TNX:
+        for (k=0; k<nb; k++)
+          {
+          if ((theta = thetab[k]) == WCS_NOCOORD
+		|| (s = wcsline_sind(theta)) == 0.0
+		|| (prj->flag == PRJSET && s < 0.0))
+            {
+            xb[k] = yb[k] = WCS_NOCOORD;
+            continue;
+            }
+          r = prj->r0*wcsline_cosd(theta)/s;
+          xb[k] = r*wcsline_sind(phib[k]);
+          yb[k] = -r*wcsline_cosd(phib[k]);
+          }
+        break;
+      case WCSLINE_SIN:
+        for (k=0; k<nb; k++)
+          {
+          if ((theta = thetab[k]) == WCS_NOCOORD
+		|| (prj->flag == PRJSET && theta < 0.0))
+            {
+            xb[k] = yb[k] = WCS_NOCOORD;
+            continue;
+            }
+          t = (90.0 - fabs(theta))*WCSLINE_D2R;
+          if (t < 1.0e-5)
+            {
+            z = (theta > 0.0)? -t*t/2.0 : -2.0 + t*t/2.0;
+            costhe = t;
+            }
+          else
+            {
+            z = wcsline_sind(theta) - 1.0;
+            costhe = wcsline_cosd(theta);
+            }
+          xb[k] =  prj->r0*(costhe*wcsline_sind(phib[k]) + prj->p[1]*z);
+          yb[k] = -prj->r0*(costhe*wcsline_cosd(phib[k]) + prj->p[2]*z);
+          }
+        break;
+      case WCSLINE_ZEA:
+        for (k=0; k<nb; k++)
+          {
+          if ((theta = thetab[k]) == WCS_NOCOORD)
+            {
+            xb[k] = yb[k] = WCS_NOCOORD;
+            continue;
+            }
+          r = prj->w[0]*wcsline_sind((90.0 - theta)/2.0);
+          xb[k] =  r*wcsline_sind(phib[k]);
+          yb[k] = -r*wcsline_cosd(phib[k]);
+          }
+        break;
+      case WCSLINE_CAR:
+        for (k=0; k<nb; k++)
+          {
+          if ((theta = thetab[k]) == WCS_NOCOORD)
+            {
+            xb[k] = yb[k] = WCS_NOCOORD;
+            continue;
+            }
+          xb[k] = prj->w[0]*phib[k];
+          yb[k] = prj->w[0]*theta;
+          }
+        break;
+      default:
+        for (k=0; k<nb; k++)
+          xb[k] = yb[k] = WCS_NOCOORD;
+        break;
+      }
+/*-- Projection corrections */
+    if (type == WCSLINE_TNX && prj->inv_newton)
+      {
+      for (k=0; k<nb; k++)
+        if (xb[k] != WCS_NOCOORD
+		&& tnx_to_raw_newton(prj, xb[k],yb[k], &xb[k],&yb[k]))
+          xb[k] = yb[k] = WCS_NOCOORD;
+      }
+    else if (type == WCSLINE_TNX
+	|| (type == WCSLINE_TAN && prj->n && prj->inv_x && prj->inv_y))
+      {
+      for (k=0; k<nb; k++)
+        if (xb[k] != WCS_NOCOORD)
+          {
+          xpp[0] = xb[k];
+          xpp[1] = yb[k];
+          xb[k] = prj->inv_x? poly_func_r(prj->inv_x, xpp) : xpp[0];
+          yb[k] = prj->inv_y? poly_func_r(prj->inv_y, xpp) : xpp[1];
+          }
+      }
+    else if (type == WCSLINE_TAN && prj->n && prj->inv_newton)
+      {
+      for (k=0; k<nb; k++)
+        if (xb[k] != WCS_NOCOORD
+		&& pv_to_raw_newton(prj, xb[k],yb[k], &xb[k],&yb[k]))
+          xb[k] = yb[k] = WCS_NOCOORD;
+      }
+    else if (type == WCSLINE_TAN && prj->n)
+      {
+      for (k=0; k<nb; k++)
+        if (xb[k] != WCS_NOCOORD)
+          pv_to_raw(prj, xb[k],yb[k], &xb[k],&yb[k]);
+      }
+/*-- Linear transformation */
+    world = wcspos + n*naxis;
+    pix = pixpos + n*naxis;
+    if (naxis == 2)
+/*---- Celestial pair only: no inner loops nor axis indexing; unmapped */
+/*---- positions are dealt with afterwards */
+      for (k=0; k<nb; k++)
+        {
+        img0 = 0.0 + m00*buf0[k];
+        img0 += m01*buf1[k];
+        img1 = 0.0 + m10*buf0[k];
+        img1 += m11*buf1[k];
+        pix[2*k] = img0 + crpix0;
+        pix[2*k+1] = img1 + crpix1;
+        }
+    else
+      for (k=0; k<nb; k++, world+=naxis, pix+=naxis)
+        {
+        for (j=0; j<naxis; j++)
+          img[j] = world[j] - wcs->crval[j];
+        img[lngi] = xb[k];
+        img[lati] = yb[k];
+        for (i=0, ij=0; i<naxis; i++)
+          {
+          pix[i] = 0.0;
+          for (j=0; j<naxis; j++, ij++)
+            pix[i] += lin->imgpix[ij]*img[j];
+          }
+        for (j=0; j<naxis; j++)
+          pix[j] += lin->crpix[j];
+        }
+    pix = pixpos + n*naxis;
+    for (k=0; k<nb; k++, pix+=naxis)
+      if (xb[k] == WCS_NOCOORD)
+        {
+        for (i=0; i<naxis; i++)
+          pix[i] = WCS_NOCOORD;
+        nerr++;
+        }
+    }
+
+  return nerr;
+  }
+
+
+/******* wcsline_type *********************************************************
+PROTO	wcslineenum wcsline_type(wcsstruct *wcs)
+PURPOSE	Find the line transformation kernel suited to a WCS structure.
+INPUT	WCS structure.
+OUTPUT	Kernel type, or WCSLINE_NONE if none applies.
+NOTES	The WCS library structures must have been initialized.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+static wcslineenum	wcsline_type(wcsstruct *wcs)
+  {
+   struct celprm	*cel;
+   struct prjprm	*prj;
+
+  cel = wcs->cel;
+  prj = wcs->prj;
+  if (wcs->naxis<2 || wcs->wcsprm->lng<0 || wcs->wcsprm->lat<0
+	|| wcs->wcsprm->flag != WCSSET || wcs->wcsprm->cubeface != -1
+	|| wcs->lin->flag != LINSET || cel->flag != CELSET)
+    return WCSLINE_NONE;
+  if (cel->prjrev == tanrev && abs(prj->flag) == PRJSET)
+    return WCSLINE_TAN;
+  if (cel->prjrev == tnxrev && abs(prj->flag) == PRJSET)
+    return WCSLINE_TNX;
+  if (cel->prjrev == sinrev && abs(prj->flag) == PRJSET && prj->w[1] == 0.0)
+    return WCSLINE_SIN;
+  if (cel->prjrev == zearev && prj->flag == PRJSET)
+    return WCSLINE_ZEA;
+  if (cel->prjrev == carrev && prj->flag == PRJSET)
+    return WCSLINE_CAR;
+
+  return WCSLINE_NONE;
+  }
+
+
+/******* wcsline_sind *********************************************************
+PROTO	double wcsline_sind(double angle)
+PURPOSE	Sine of an angle in degrees.
+INPUT	Angle (deg).
+OUTPUT	Sine of the angle.
+NOTES	Same results as wcs_sind(), but the exact handling of multiples of
+	90 deg is only attempted for integer arguments.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+static double	wcsline_sind(double angle)
+  {
+  return angle == floor(angle)? wcs_sind(angle) : sin(angle*WCSLINE_D2R);
+  }
+
+
+/******* wcsline_cosd *********************************************************
+PROTO	double wcsline_cosd(double angle)
+PURPOSE	Cosine of an angle in degrees.
+INPUT	Angle (deg).
+OUTPUT	Cosine of the angle.
+NOTES	Same results as wcs_cosd(), but the exact handling of multiples of
+	90 deg is only attempted for integer arguments.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+static double	wcsline_cosd(double angle)
+  {
+  return angle == floor(angle)? wcs_cosd(angle) : cos(angle*WCSLINE_D2R);
+  }
+
+
 /******* red_to_raw **********************************************************
 PROTO	int red_to_raw(wcsstruct *, double *, double *)
 PURPOSE	Convert reduced (World Coordinate System) coords to raw (pixel)
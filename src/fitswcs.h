@@ -23,7 +23,7 @@
 *	along with AstrOmatic software.
 *	If not, see <http://www.gnu.org/licenses/>.
 *
-*	Last modified:		20/12/2019
+*	Last modified:		19/10/2026
 *
 *%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
 
@@ -57,13 +57,20 @@
 #define		WCS_NGRIDPOINTS2	(WCS_NGRIDPOINTS*WCS_NGRIDPOINTS)
 #define		WCS_INVMAXDEG	7	/* Maximum inversion polynom degree */
 #define		WCS_INVACCURACY	0.001	/* Maximum inversion error (pixels) */
+#define		WCS_INVCACHESIZE 64	/* Number of cached inverse polynoms */
 #define		WCS_NRANGEPOINTS 32	/* Number of WCS range points / axis */
+#define		WCSLINE_D2R	(3.141592653589793238462643/180.0)
+					/* deg to rad, as in the WCS library */
+#define		WCSLINE_BLOCK	256	/* Positions per line kernel pass */
 
 /*-------------------------------- typedefs ---------------------------------*/
 
 typedef  enum {CELSYS_NATIVE, CELSYS_PIXEL, CELSYS_EQUATORIAL, CELSYS_GALACTIC,
 	CELSYS_ECLIPTIC, CELSYS_SUPERGALACTIC}	celsysenum;
 
+typedef  enum {WCSLINE_NONE, WCSLINE_GENERIC, WCSLINE_TAN, WCSLINE_TNX,
+	WCSLINE_SIN, WCSLINE_ZEA, WCSLINE_CAR}	wcslineenum;	/* Line kernels */
+
 /*------------------------------- structures --------------------------------*/
 
 typedef struct wcs
@@ -114,6 +121,14 @@ typedef struct wcs
   struct poly	*inv_y;			/* Proj. correction polynom in y */
   }	wcsstruct;
 
+/* Polynomial inverses of a given distortion (for reuse with other images) */
+typedef struct wcsinv
+  {
+  double	*key;			/* Distortion and grid parameters */
+  int		nkey;			/* Number of key parameters */
+  struct poly	*inv_x, *inv_y;		/* Inverse polynoms */
+  }	wcsinvstruct;
+
 /*------------------------------- functions ---------------------------------*/
 
 extern wcsstruct	*create_wcs(char **ctype, double *crval, double *crpix,
@@ -144,6 +159,8 @@ extern int		celsys_to_eq(wcsstruct *wcs, double *wcspos),
 				double *pixpos, double *redpos),
 			raw_to_wcs(wcsstruct *wcs,
 				double *pixpos, double *wcspos),
+			raw_to_wcs_line(wcsstruct *wcs,
+				double *pixpos, double *wcspos, int npos),
 			reaxe_wcs(wcsstruct *wcs, int lng, int lat),
 			red_to_raw(wcsstruct *wcs,
 				double *redpos, double *pixpos),
@@ -151,7 +168,9 @@ extern int		celsys_to_eq(wcsstruct *wcs, double *wcspos),
 			wcs_chirality(wcsstruct *wcs),
 			wcs_supproj(char *name),
 			wcs_to_raw(wcsstruct *wcs,
-				double *wcspos, double *pixpos);
+				double *wcspos, double *pixpos),
+			wcs_to_raw_line(wcsstruct *wcs,
+				double *wcspos, double *pixpos, int npos);
 
 extern char		*degtosexal(double alpha, char *str),
 			*degtosexde(double delta, char *str);
@@ -159,6 +178,7 @@ extern char		*degtosexal(double alpha, char *str),
 extern void		b2j(double yearobs, double alphain, double deltain,
 				double *alphaout, double *deltaout),
 			end_wcs(wcsstruct *wcs),
+			end_wcsinvcache(void),
 			init_wcs(wcsstruct *wcs),
 			init_wcscelsys(wcsstruct *wcs),
 			invert_wcs(wcsstruct *wcs),
@@ -170,6 +190,7 @@ extern void		b2j(double yearobs, double alphain, double deltain,
 			precess_wcs(wcsstruct *wcs, double yearin,
 				double yearout),
 			range_wcs(wcsstruct *wcs),
+			share_wcs(wcsstruct *wcs),
 			wipe_wcs(tabstruct *tab),
 			write_wcs(tabstruct *tab, wcsstruct *wcs);
 
@@ -0,0 +1,409 @@
+/*
+*				footprint.c
+*
+* Footprints of resampled images.
+*
+*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+*
+*	This file part of:	SWarp
+*
+*	Copyright:		(C) 2026 CEA/AIM/UParisSaclay
+*
+*	License:		GNU General Public License
+*
+*	SWarp is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*	SWarp is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU General Public License for more details.
+*	You should have received a copy of the GNU General Public License
+*	along with SWarp. If not, see <http://www.gnu.org/licenses/>.
+*
+*	Last modified:		19/10/2026
+*
+*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+
+#ifdef HAVE_CONFIG_H
+#include	"config.h"
+#endif
+
+#ifdef HAVE_MATHIMF_H
+#include <mathimf.h>
+#else
+#include <math.h>
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "define.h"
+#include "globals.h"
+#include "fits/fitscat.h"
+#include "fitswcs.h"
+#include "footprint.h"
+
+/*
+ The footprint of a resampled image is the boundary of the input image
+ projected onto the resampled pixel grid, approximated by a polygon. The
+ margin accounts for the distance between the true boundary and the polygon
+ edges. Pixels of a given line can only receive data if they lie within the
+ x-range of the polygon edges found within +/- margin of the line, extended
+ by the margin on both sides. The footprint only saves work: it must never
+ be relied upon to reject positions that the WCS transformations map
+ wrongly, since no footprint is available in some cases (see
+ init_footprint()).
+*/
+
+static void	footprint_xrange(footprintstruct *footprint);
+
+
+/****** init_footprint *******************************************************
+PROTO	footprintstruct *init_footprint(wcsstruct *wcsin, wcsstruct *wcsout)
+PURPOSE	Compute the footprint of an input image on a resampled frame.
+INPUT	Input WCS structure,
+	WCS structure of the resampled frame.
+OUTPUT	Pointer to the new footprint structure, or NULL if the footprint
+	cannot be determined safely.
+NOTES	Only 2D images are supported. No footprint is returned if part of the
+	input boundary has no counterpart in the resampled frame, or if the
+	projected boundary is discontinuous (e.g. across a projection
+	boundary).
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+footprintstruct	*init_footprint(wcsstruct *wcsin, wcsstruct *wcsout)
+  {
+   footprintstruct	*footprint;
+   double		rawin[NAXIS], rawout[NAXIS], world[NAXIS],
+			cornerx[4], cornery[4],
+			*point,*pointc,*vert,
+			worldc, u, xmin,xmax,ymin,ymax, dx,dy, dpx,dpy,
+			len2, dist, distmax, maxstep;
+   int			e,i,k, nedge, npoint, nseg, swapflag;
+
+  if (wcsin->naxis!=2 || wcsout->naxis!=2)
+    return NULL;
+
+/* Check if lng and lat are swapped between in and out wcs */
+  swapflag = (((wcsin->lng != wcsout->lng) || (wcsin->lat != wcsout->lat))
+	&& (wcsin->lng != wcsin->lat) && (wcsout->lng != wcsout->lat));
+
+/* Sample the boundary of input positions accepted by interpolate_pix() */
+/* (truncation towards zero lets positions down to -0.5 through) */
+  cornerx[0] = cornerx[3] = cornery[0] = cornery[1] = -0.5;
+  cornerx[1] = cornerx[2] = wcsin->naxisn[0] + 0.5;
+  cornery[2] = cornery[3] = wcsin->naxisn[1] + 0.5;
+  nedge = FOOTPRINT_NSEG*FOOTPRINT_NSUB;
+  npoint = 4*nedge;
+  QMALLOC(point, double, 2*npoint);
+  pointc = point;
+  xmin = ymin = BIG;
+  xmax = ymax = -BIG;
+  for (e=0; e<4; e++)
+    for (i=0; i<nedge; i++, pointc+=2)
+      {
+      u = (double)i/nedge;
+      rawin[0] = cornerx[e] + u*(cornerx[(e+1)%4] - cornerx[e]);
+      rawin[1] = cornery[e] + u*(cornery[(e+1)%4] - cornery[e]);
+      if (raw_to_wcs(wcsin, rawin, world) != RETURN_OK)
+        {
+        free(point);
+        return NULL;
+        }
+      if (swapflag)
+        {
+        worldc = world[wcsout->lat];
+        world[wcsout->lat] = world[wcsin->lat];
+        world[wcsin->lat] = worldc;
+        }
+      if (wcs_to_raw(wcsout, world, rawout) != RETURN_OK)
+        {
+        free(point);
+        return NULL;
+        }
+      pointc[0] = rawout[0];
+      pointc[1] = rawout[1];
+      if (rawout[0]<xmin)
+        xmin = rawout[0];
+      if (rawout[0]>xmax)
+        xmax = rawout[0];
+      if (rawout[1]<ymin)
+        ymin = rawout[1];
+      if (rawout[1]>ymax)
+        ymax = rawout[1];
+      }
+
+/* Reject discontinuous boundaries */
+  maxstep = FOOTPRINT_MAXJUMP*(xmax - xmin + ymax - ymin);
+  for (i=0; i<npoint; i++)
+    {
+    k = (i+1)%npoint;
+    if (fabs(point[2*k] - point[2*i]) + fabs(point[2*k+1] - point[2*i+1])
+	> maxstep)
+      {
+      free(point);
+      return NULL;
+      }
+    }
+
+/* Keep one sample out of FOOTPRINT_NSUB as polygon vertices */
+  QCALLOC(footprint, footprintstruct, 1);
+  nseg = footprint->nvert = 4*FOOTPRINT_NSEG;
+  QMALLOC(footprint->vert, double, 2*nseg);
+  distmax = 0.0;
+  for (k=0; k<nseg; k++)
+    {
+    vert = footprint->vert + 2*k;
+    pointc = point + 2*k*FOOTPRINT_NSUB;
+    vert[0] = pointc[0];
+    vert[1] = pointc[1];
+/*-- Maximum distance between boundary samples and the polygon edge */
+    dx = point[(2*(k+1)*FOOTPRINT_NSUB)%(2*npoint)] - vert[0];
+    dy = point[(2*(k+1)*FOOTPRINT_NSUB)%(2*npoint)+1] - vert[1];
+    len2 = dx*dx + dy*dy;
+    for (i=1; i<FOOTPRINT_NSUB; i++)
+      {
+      dpx = pointc[2*i] - vert[0];
+      dpy = pointc[2*i+1] - vert[1];
+      u = len2>0.0? (dpx*dx + dpy*dy)/len2 : 0.0;
+      if (u<0.0)
+        u = 0.0;
+      else if (u>1.0)
+        u = 1.0;
+      dpx -= u*dx;
+      dpy -= u*dy;
+      if ((dist = dpx*dpx + dpy*dpy) > distmax)
+        distmax = dist;
+      }
+    }
+  free(point);
+  footprint->margin = FOOTPRINT_MARGIN + sqrt(distmax);
+  footprint->width = wcsout->naxisn[0];
+  footprint->height = wcsout->naxisn[1];
+  footprint_xrange(footprint);
+
+  return footprint;
+  }
+
+
+/****** end_footprint ********************************************************
+PROTO	void end_footprint(footprintstruct *footprint)
+PURPOSE	Free a footprint structure.
+INPUT	Pointer to the footprint structure.
+OUTPUT	-.
+NOTES	-.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+void	end_footprint(footprintstruct *footprint)
+  {
+  free(footprint->vert);
+  free(footprint->xrange);
+  free(footprint);
+
+  return;
+  }
+
+
+/****** write_footprint ******************************************************
+PROTO	void write_footprint(footprintstruct *footprint, tabstruct *tab)
+PURPOSE	Record a footprint in a FITS header.
+INPUT	Pointer to the footprint structure (or NULL),
+	pointer to the tab structure.
+OUTPUT	-.
+NOTES	With a NULL footprint, any footprint inherited by the header is
+	invalidated.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+void	write_footprint(footprintstruct *footprint, tabstruct *tab)
+  {
+   char		key[16];
+   int		v;
+
+  if (!footprint)
+    {
+    removekeywordfrom_head(tab, "FPNVERT ");
+    return;
+    }
+
+  addkeywordto_head(tab, "FPNVERT ", "Number of footprint polygon vertices");
+  fitswrite(tab->headbuf, "FPNVERT ", &footprint->nvert, H_INT, T_LONG);
+  addkeywordto_head(tab, "FPMARGIN", "Footprint polygon tolerance (pixels)");
+  fitswrite(tab->headbuf, "FPMARGIN", &footprint->margin, H_EXPO, T_DOUBLE);
+  for (v=0; v<footprint->nvert; v++)
+    {
+    sprintf(key, "FPVX%-4d", v+1);
+    addkeywordto_head(tab, key, "Footprint vertex x coordinate");
+    fitswrite(tab->headbuf, key, &footprint->vert[2*v], H_EXPO, T_DOUBLE);
+    sprintf(key, "FPVY%-4d", v+1);
+    addkeywordto_head(tab, key, "Footprint vertex y coordinate");
+    fitswrite(tab->headbuf, key, &footprint->vert[2*v+1], H_EXPO, T_DOUBLE);
+    }
+
+  return;
+  }
+
+
+/****** read_footprint *******************************************************
+PROTO	footprintstruct *read_footprint(tabstruct *tab)
+PURPOSE	Read a footprint recorded in a FITS header.
+INPUT	Pointer to the tab structure.
+OUTPUT	Pointer to the new footprint structure, or NULL if none is available.
+NOTES	-.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+footprintstruct	*read_footprint(tabstruct *tab)
+  {
+   footprintstruct	*footprint;
+   char			key[16];
+   int			v, nvert;
+
+  if (!tab->headbuf || tab->naxis!=2
+	|| fitsread(tab->headbuf, "FPNVERT ", &nvert, H_INT, T_LONG)
+		!= RETURN_OK
+	|| nvert<3)
+    return NULL;
+
+  QCALLOC(footprint, footprintstruct, 1);
+  footprint->nvert = nvert;
+  QMALLOC(footprint->vert, double, 2*nvert);
+  if (fitsread(tab->headbuf, "FPMARGIN", &footprint->margin, H_EXPO, T_DOUBLE)
+	!= RETURN_OK)
+    {
+    end_footprint(footprint);
+    return NULL;
+    }
+  for (v=0; v<nvert; v++)
+    {
+    sprintf(key, "FPVX%-4d", v+1);
+    if (fitsread(tab->headbuf, key, &footprint->vert[2*v], H_EXPO, T_DOUBLE)
+	!= RETURN_OK)
+      {
+      end_footprint(footprint);
+      return NULL;
+      }
+    sprintf(key, "FPVY%-4d", v+1);
+    if (fitsread(tab->headbuf, key, &footprint->vert[2*v+1], H_EXPO,
+	T_DOUBLE) != RETURN_OK)
+      {
+      end_footprint(footprint);
+      return NULL;
+      }
+    }
+  footprint->width = tab->naxisn[0];
+  footprint->height = tab->naxisn[1];
+  footprint_xrange(footprint);
+
+  return footprint;
+  }
+
+
+/****** footprint_xrange *****************************************************
+PROTO	void footprint_xrange(footprintstruct *footprint)
+PURPOSE	Compute the range of pixels that may lie within a footprint on each
+	line.
+INPUT	Pointer to the footprint structure.
+OUTPUT	-.
+NOTES	Line y covers pixel indices [xrange[2*y], xrange[2*y+1][; empty lines
+	have xrange[2*y] = xrange[2*y+1] = 0.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+static void	footprint_xrange(footprintstruct *footprint)
+  {
+   double	*xlim, *vert1,*vert2,
+		margin, x1,y1,x2,y2, ylo,yhi, yb1,yb2, xa,xb,xt, slope;
+   int		*xrange,
+		v, y, ymin,ymax, width, height;
+
+  width = footprint->width;
+  height = footprint->height;
+  margin = footprint->margin;
+  QMALLOC(xlim, double, 2*height);
+  for (y=0; y<height; y++)
+    {
+    xlim[2*y] = BIG;
+    xlim[2*y+1] = -BIG;
+    }
+
+/* Pixel y (starting from 0) is centred on coordinate y+1 */
+  for (v=0; v<footprint->nvert; v++)
+    {
+    vert1 = footprint->vert + 2*v;
+    vert2 = footprint->vert + 2*((v+1)%footprint->nvert);
+    x1 = vert1[0];
+    y1 = vert1[1];
+    x2 = vert2[0];
+    y2 = vert2[1];
+    ylo = y1<y2? y1 : y2;
+    yhi = y1<y2? y2 : y1;
+    if (ylo - margin > height + 1.0 || yhi + margin < 0.0)
+      continue;
+    ymin = (int)ceil(ylo - margin - 1.0);
+    if (ymin<0)
+      ymin = 0;
+    ymax = (int)floor(yhi + margin - 1.0);
+    if (ymax>=height)
+      ymax = height-1;
+    slope = yhi>ylo? (x2 - x1)/(y2 - y1) : 0.0;
+    for (y=ymin; y<=ymax; y++)
+      {
+/*---- Part of the edge within the band of the current line */
+      if (yhi>ylo)
+        {
+        yb1 = y + 1.0 - margin;
+        yb2 = y + 1.0 + margin;
+        if (yb1<ylo)
+          yb1 = ylo;
+        if (yb2>yhi)
+          yb2 = yhi;
+        xa = x1 + (yb1 - y1)*slope;
+        xb = x1 + (yb2 - y1)*slope;
+        }
+      else
+        {
+        xa = x1;
+        xb = x2;
+        }
+      if (xa>xb)
+        {
+        xt = xa;
+        xa = xb;
+        xb = xt;
+        }
+      if (xa<xlim[2*y])
+        xlim[2*y] = xa;
+      if (xb>xlim[2*y+1])
+        xlim[2*y+1] = xb;
+      }
+    }
+
+/* Convert to pixel index ranges */
+  QMALLOC(xrange, int, 2*height);
+  for (y=0; y<height; y++)
+    {
+    xa = ceil(xlim[2*y] - margin) - 1.0;
+    xb = floor(xlim[2*y+1] + margin);
+    if (xa<0.0)
+      xa = 0.0;
+    if (xb>(double)width)
+      xb = (double)width;
+    if (xa<xb)
+      {
+      xrange[2*y] = (int)xa;
+      xrange[2*y+1] = (int)xb;
+      }
+    else
+      xrange[2*y] = xrange[2*y+1] = 0;
+    }
+  free(xlim);
+  footprint->xrange = xrange;
+
+  return;
+  }
+
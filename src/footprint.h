@@ -0,0 +1,64 @@
+/*
+*				footprint.h
+*
+* Include file for footprint.c.
+*
+*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+*
+*	This file part of:	SWarp
+*
+*	Copyright:		(C) 2026 CEA/AIM/UParisSaclay
+*
+*	License:		GNU General Public License
+*
+*	SWarp is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*	SWarp is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU General Public License for more details.
+*	You should have received a copy of the GNU General Public License
+*	along with SWarp. If not, see <http://www.gnu.org/licenses/>.
+*
+*	Last modified:		19/10/2026
+*
+*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+
+#ifndef _FITSCAT_H_
+#include "fits/fitscat.h"
+#endif
+
+#ifndef _FITSWCS_H_
+#include "fitswcs.h"
+#endif
+
+#ifndef	_FOOTPRINT_H_
+#define	_FOOTPRINT_H_
+
+/*------------------------------- constants ---------------------------------*/
+#define	FOOTPRINT_NSEG		8	/* Polygon segments per image edge */
+#define	FOOTPRINT_NSUB		32	/* Boundary samples per segment */
+#define	FOOTPRINT_MARGIN	2.0	/* Safety margin (pixels) */
+#define	FOOTPRINT_MAXJUMP	0.125	/* Max. sample step / footprint size */
+
+/*-------------------------- structure definitions --------------------------*/
+typedef struct footprint
+  {
+  int		nvert;			/* Number of polygon vertices */
+  double	*vert;			/* x,y pixel coordinates of vertices */
+  double	margin;			/* Tolerance around polygon (pixels) */
+  int		width, height;		/* Field width and number of lines */
+  int		*xrange;		/* Per-line [xmin,xmax[ pixel ranges */
+  }	footprintstruct;
+
+/*-------------------------------- protos -----------------------------------*/
+extern footprintstruct	*init_footprint(wcsstruct *wcsin, wcsstruct *wcsout),
+			*read_footprint(tabstruct *tab);
+
+extern void		end_footprint(footprintstruct *footprint),
+			write_footprint(footprintstruct *footprint,
+				tabstruct *tab);
+
+#endif
@@ -22,7 +22,7 @@
 *	You should have received a copy of the GNU General Public License
 *	along with SWarp. If not, see <http://www.gnu.org/licenses/>.
 *
-*	Last modified:		03/12/2019
+*	Last modified:		19/10/2026
 *
 *%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
 
@@ -43,6 +43,7 @@
 #include "fits/fitscat.h"
 #include "fitswcs.h"
 #include "field.h"
+#include "footprint.h"
 #include "header.h"
 #include "key.h"
 #include "prefs.h"
@@ -132,8 +133,8 @@ INPUT	Pointer to the field structure,
 	Tab structure.
 OUTPUT	-.
 NOTES	-.
-AUTHOR	E. Bertin (IAP)
-VERSION	25/06/2007
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
  ***/
 void	readfitsinfo_field(fieldstruct *field, tabstruct *tab)
   {
@@ -151,7 +152,8 @@ void	readfitsinfo_field(fieldstruct *field, tabstruct *tab)
 		{if (fitsread(buf,k,str, H_STRING,T_STRING) != RETURN_OK) \
 		   strcpy(str, (def)); \
 		}
-   char		*buf;
+   char		str[MAXCHAR],
+		*buf;
    wcsstruct	*wcs;
    int		l;
 
@@ -161,10 +163,12 @@ void	readfitsinfo_field(fieldstruct *field, tabstruct *tab)
     return;
   for (l=0; l<tab->naxis; l++)
     {
-    sprintf(gstr, "COMIN%-3d", l+1);
-    FITSREADI(buf, gstr, wcs->outmin[l], 1);
+    sprintf(str, "COMIN%-3d", l+1);
+    FITSREADI(buf, str, wcs->outmin[l], 1);
     wcs->outmax[l] = wcs->outmin[l] + wcs->naxisn[l] - 1;
     }
+/* Footprint of resampled images */
+  field->footprint = read_footprint(tab);
   FITSREADF(buf, "BACKMEAN", field->backmean, 0.0);
   FITSREADF(buf, "BACKSIG ", field->backsig, 0.0);
 /* Set the flux scale */
@@ -22,7 +22,7 @@
 *	You should have received a copy of the GNU General Public License
 *	along with SWarp. If not, see <http://www.gnu.org/licenses/>.
 *
-*	Last modified:		18/11/2020
+*	Last modified:		19/10/2026
 *
 *%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
 
@@ -232,6 +232,117 @@ int	interpolate_pix(fieldstruct *field, fieldstruct *wfield,
   }
 
 
+/****** interpolate_weight ****************************************************
+PROTO	int interpolate_weight(fieldstruct *field, fieldstruct *wfield,
+		fieldstruct *dgeofield, ikernelstruct ikernel, double *pos,
+		PIXTYPE *wpixout)
+PURPOSE	"Interpolate" weight (variance) data only.
+INPUT	Pointer to image field,
+	pointer to weight field,
+	pointer to differentiel geometry field,
+	pointer to interpolation kernel,
+	position vector,
+	pointer to the output weight.
+OUTPUT	RETURN_OK if pixel falls within the input frame, RETURN_ERROR
+	otherwise.
+NOTES	The output variance is the maximum over the kernel footprint, as in
+	interpolate_pix(), but image pixels are not accessed: without a weight
+	map, the variance is derived from the background RMS alone.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+int	interpolate_weight(fieldstruct *field, fieldstruct *wfield,
+		fieldstruct *dgeofield, ikernelstruct *ikernel, double *pos,
+		PIXTYPE *woutpix)
+
+  {
+   PIXTYPE		*pixin,
+			max, val;
+   long			step[INTERP_MAXDIM];
+   long			start, fac;
+   int			linecount[INTERP_MAXDIM];
+   int			*naxisn,
+			i,j,n, ival, naxis, kwidth,width;
+
+  naxis = field->tab->naxis;
+  naxisn = field->tab->naxisn;
+
+  start = 0;
+  fac = 1;
+  if (dgeofield) {
+    pixin = dgeofield->pix;
+    for (n=0; n<naxis; n++) {
+      ival = (int)(pos[n]-0.50001); // We take the shift of the nearest pixel
+      if (ival < 0 || ival >= naxisn[n]) {
+        start = -1;
+        break;
+      }
+      start += ival * fac;
+      fac *= naxisn[n];
+    }
+    if (start >= 0)
+      for (n=0; n<naxis; n++) {
+        pos[n] += (double)pixin[start];
+        start += fac;
+      }
+  }
+
+  start = 0;
+  fac = 1;
+
+  for (n=0; n<naxis; n++)
+    {
+    width = *(naxisn++);
+/*-- Get the integer part of the current coordinate or nearest neighbour */
+    ival = (ikernel->interptype[n]==INTERP_NEARESTNEIGHBOUR)?
+					(int)(*(pos++)-0.50001):(int)*(pos++);
+/*-- Check if interpolation start/end exceed image boundary... */
+    kwidth = ikernel->width[n];
+    ival-=kwidth/2;
+    if (ival<0 || ival+kwidth<=0 || ival+kwidth>width)
+      {
+      *woutpix = BIG;
+      return RETURN_ERROR;
+      }
+/*-- Update starting pointer */
+    start += ival*fac;
+/*-- Update step between interpolated regions */
+    step[n] = fac*(width-kwidth);
+    linecount[n] = 0;
+    fac *= width;
+    }
+
+  if (!wfield)
+    {
+    *woutpix = (PIXTYPE)(field->backsig*field->backsig);
+    return RETURN_OK;
+    }
+
+/* Maximum variance over the kernel footprint, in a single pass */
+  kwidth = ikernel->width[0];
+  pixin = wfield->pix+start;
+  max = 0.0;
+  for (j=ikernel->nlines; j--;)
+    {
+    for (i=kwidth; i--;)
+      if ((val = *(pixin++))>max)
+        max = val;
+    for (n=1; n<naxis; n++)
+      {
+      pixin+=step[n-1];
+      if (++linecount[n]<ikernel->width[n])
+        break;
+      else
+        linecount[n] = 0;
+      }
+    }
+
+  *woutpix = max;
+
+  return RETURN_OK;
+  }
+
+
 /****** interpolate_ipix ******************************************************
 PROTO	int interpolate_ipix(fieldstruct *field, fieldstruct *wfield,
 		fieldstruct *dgeofield, double *pos,
@@ -22,7 +22,7 @@
 *	You should have received a copy of the GNU General Public License
 *	along with SWarp. If not, see <http://www.gnu.org/licenses/>.
 *
-*	Last modified:		18/11/2020
+*	Last modified:		19/10/2026
 *
 *%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
 
@@ -61,7 +61,10 @@ extern int	interpolate_ipix(fieldstruct *field, fieldstruct *wfield,
 			FLAGTYPE *outipix, FLAGTYPE *woutpix),
 		interpolate_pix(fieldstruct *field, fieldstruct *wfield,
 			fieldstruct *dgeofield, ikernelstruct *ikernel,
-			double *pos, PIXTYPE *outipix, PIXTYPE *woutpix);
+			double *pos, PIXTYPE *outipix, PIXTYPE *woutpix),
+		interpolate_weight(fieldstruct *field, fieldstruct *wfield,
+			fieldstruct *dgeofield, ikernelstruct *ikernel,
+			double *pos, PIXTYPE *woutpix);
 
 extern ikernelstruct	*init_ikernel(interpenum *interptype, int naxis);
 
@@ -22,7 +22,7 @@
 *	You should have received a copy of the GNU General Public License
 *	along with SWarp. If not, see <http://www.gnu.org/licenses/>.
 *
-*	Last modified:		10/03/2014
+*	Last modified:		19/10/2026
 *
 *%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
 
@@ -38,6 +38,7 @@
 #include	"define.h"
 #include	"globals.h"
 #include	"fits/fitscat.h"
+#include	"perf.h"
 #include	"prefs.h"
 
 #define		SYNTAX \
@@ -139,6 +140,7 @@ int	main(int argc, char *argv[])
   free(argval);
 
   makeit();
+  end_perf();
 
   free(listbuf);
 
@@ -24,7 +24,7 @@
 *	You should have received a copy of the GNU General Public License
 *	along with SWarp. If not, see <http://www.gnu.org/licenses/>.
 *
-*	Last modified:		19/05/2025
+*	Last modified:		19/10/2026
 *
 *%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
 
@@ -47,34 +47,52 @@
 #include "fits/fitscat.h"
 #include "fitswcs.h"
 #include "back.h"
+#include "coadd.h"
 #include "data.h"
 #include "field.h"
 #include "header.h"
+#include "meta.h"
 #include "misc.h"
+#include "node.h"
+#include "numa.h"
+#include "perf.h"
 #include "prefs.h"
 #include "resample.h"
+#ifdef USE_THREADS
+#include "threads.h"
+#endif
 #include "xml.h"
 
 #define	NFIELD	128	/* Increment in the number of fields */
 
 static int	selectext(char *filename);
+static void	scan_file(int i, int slot),
+		scan_files(int nfile);
+#ifdef USE_THREADS
+static void	*pthread_scan_files(void *arg);
+#endif
+
 time_t		thetime, thetime2;
 char		gstr[MAXCHAR];
 
+/* Input fields found in each input file by the input data scan */
+static fieldstruct	***scan_field, ***scan_wfield, ***scan_dgeofield;
+static int		*scan_next;
+
 /********************************** makeit ***********************************/
 void	makeit(void)
   {
    fieldstruct		**infield, **inwfield, **indgeofield,
+			**selfield, **selwfield,
    			*outfield,*outwfield;
-   catstruct		*cat, *dcat, *wcat;
    tabstruct		*tab;
    keystruct		*key;
    struct tm		*tm;
-   double		dtime, dtimef;
+   double		dtime, dtimef, t0, nbytes;
    char			*rfilename;
-   int		       	*next;
-   int			i,j,k,l, ninfield, ntinfield,ntinfield2,
-			nfield,	jima, jweight, jdgeo, version;
+   int		       	*next, *selflag;
+   int			i,j,k,l, ninfield, ntinfield,ntinfield2, nselfield,
+			nfield,	version;
 
 /* Install error logging */
   error_installfunc(write_error);
@@ -87,6 +105,12 @@ void	makeit(void)
   thetime = time(NULL);
   tm = localtime(&thetime);
   dtime = counter_seconds();
+  init_perf(prefs.nthreads+1, prefs.ntrace_name && *prefs.trace_name[0]);
+  init_numa(prefs.nthreads);
+#ifdef USE_THREADS
+/* Worker threads are shared by all processing stages */
+  threads_pool = threads_pool_init(prefs.nthreads);
+#endif
   sprintf(prefs.sdate_start,"%04d-%02d-%02d",
         tm->tm_year+1900, tm->tm_mon+1, tm->tm_mday);
   sprintf(prefs.stime_start,"%02d:%02d:%02d",
@@ -104,7 +128,7 @@ void	makeit(void)
 
 /* Install the signal-catching routines for temporary file cleanup */
 #ifdef USE_THREADS
-  install_cleanup(cancel_resample_threads);
+  install_cleanup(threads_pool_cancel);
 #else
   install_cleanup(NULL);
 #endif
@@ -118,71 +142,13 @@ void	makeit(void)
   QMALLOC(inwfield, fieldstruct *, nfield);
   QMALLOC(indgeofield, fieldstruct *, nfield);
   NFPRINTF(OUTPUT, "Examining input data ...")
+  scan_files(ninfield);
+  perf_endinput(-1);
   for (i=0; i<ninfield; i++)
     {
-/*-- Test if the filename contains a bracket indicating a particular extension*/
-    jima = selectext(prefs.infield_name[i]);
-    if (!(cat=read_cat(prefs.infield_name[i])))
-      {
-      sprintf(gstr, "*Error*: %s not found", prefs.infield_name[i]);
-      error(EXIT_FAILURE, gstr,"");
-      }
-    if (jima >= cat->ntab)
-        error(EXIT_FAILURE, "Not enough valid FITS image extensions in ",
-		prefs.infield_name[i]);
-/*-- Examine all extensions */
-//-- Weights
-    wcat = NULL;
-    jweight= RETURN_ERROR;		/* to avoid gcc -Wall warnings */
-    if (prefs.weight_type[i] && prefs.weight_type[i] != WEIGHT_FROMBACK)
-      {
-      jweight = selectext(prefs.inwfield_name[i]);
-      if (!(wcat=read_cat(prefs.inwfield_name[i])))
-        {
-        sprintf(gstr, "*Error*: %s not found", prefs.inwfield_name[i]);
-        error(EXIT_FAILURE, gstr,"");
-        }
-      if (jweight >= wcat->ntab)
-        error(EXIT_FAILURE, "Not enough valid FITS image extensions in ",
-		prefs.inwfield_name[i]);
-      }
-      
-//-- Dgeo maps
-    dcat = NULL;
-    jdgeo = RETURN_ERROR;		/* to avoid gcc -Wall warnings */
-    if (prefs.dgeo_type[i])
-      {
-      jdgeo = selectext(prefs.indgeo_name[i]);
-      if (!(dcat=read_cat(prefs.indgeo_name[i])))
-        {
-        sprintf(gstr, "*Error*: %s not found", prefs.indgeo_name[i]);
-        error(EXIT_FAILURE, gstr,"");
-        }
-      if (jdgeo >= dcat->ntab)
-        error(EXIT_FAILURE, "Not enough valid FITS image extensions in ",
-		prefs.indgeo_name[i]);
-      }
-
-    tab=cat->tab;
-    for (j=0; j<cat->ntab; j++,tab=tab->nexttab)
+    next[i] = scan_next[i];
+    for (j=0; j<next[i]; j++, k++)
       {
-#ifdef HAVE_CFITSIO
-      if ((jima>=0 && j!=jima) || (jima < 0 && (!tab->naxis ||
-	!(tab->isTileCompressed || (tab->naxis >= 2
-		&& strncmp(tab->xtension, "BINTABLE", 8)
-		&& strncmp(tab->xtension, "ASCTABLE", 8))))))
-        continue;
-#else
-      if ((jima>=0 && j!=jima) || (jima < 0 && (!tab->naxis ||
-	(tab->naxis >= 2
-	&& strncmp(tab->xtension, "BINTABLE", 8)
-	&& strncmp(tab->xtension, "ASCTABLE", 8))))) {
-        if (tab->isTileCompressed)
-	  warning(BANNER " has been compiled without CFITSIO support: "
-		"compressed image skipped in ", prefs.infield_name[i]);
-        continue;
-      }
-#endif
       if (k >= nfield)
         {
         nfield += NFIELD;
@@ -190,13 +156,10 @@ void	makeit(void)
         QREALLOC(inwfield,fieldstruct *, nfield);
         QREALLOC(indgeofield,fieldstruct *, nfield);
         }
-      infield[k] = load_field(cat, j, i, prefs.inhead_name[i]);
-      inwfield[k] = load_weight(wcat, infield[k], jweight<0? j:jweight, i,
-				prefs.weight_type[i]);
-      indgeofield[k] = load_dgeo(dcat, infield[k], jdgeo<0? j:jdgeo, i,
-				prefs.dgeo_type[i]);
-      next[i]++;
-      k++;
+      infield[k] = scan_field[i][j];
+      infield[k]->inputno = k;
+      inwfield[k] = scan_wfield[i][j];
+      indgeofield[k] = scan_dgeofield[i][j];
       }
 /*-- Put version to reduced filenames (to avoid duplicated resamps later) */
     if (k)
@@ -219,13 +182,18 @@ void	makeit(void)
       }
     ntinfield += next[i];
     if (!next[i])
-      warning("No suitable data found in ", cat->filename);
-    free_cat(&cat, 1);
-    if (wcat)
-      free_cat(&wcat, 1);
-    if (dcat)
-      free_cat(&dcat, 1);
+      warning("No suitable data found in ", prefs.infield_name[i]);
+    free(scan_field[i]);
+    free(scan_wfield[i]);
+    free(scan_dgeofield[i]);
     }
+  free(scan_field);
+  free(scan_wfield);
+  free(scan_dgeofield);
+  free(scan_next);
+
+/* Flag inputs processed by the current node */
+  QMALLOC(selflag, int, ntinfield);
 
 /* Initialize the XML stack */
   if (prefs.xml_flag)
@@ -264,6 +232,10 @@ void	makeit(void)
     goto the_end;
     }
 
+/* Identify the distributed run before any node can complete its share */
+  if (NODE_ACTIVE && prefs.combine_flag)
+    node_init(outfield, outwfield, infield, ntinfield);
+
 /* Read and transform the data */
   NFPRINTF(OUTPUT, "Loading input data ...")
   k = 0;
@@ -285,6 +257,16 @@ void	makeit(void)
         frame_wcs(infield[k]->wcs, outfield->wcs);
         scale_field(infield[k],outfield,prefs.fscalastro_type!=FSCALASTRO_NONE);
         }
+      else if (NODE_ACTIVE)
+        frame_wcs(infield[k]->wcs, outfield->wcs);
+/*---- Skip inputs that are processed by other nodes */
+      selflag[k] = NODE_ACTIVE? node_select(infield[k], outfield, k) : 1;
+      if (!selflag[k])
+        {
+        if (indgeofield[k])
+          end_field(indgeofield[k]);
+        continue;
+        }
 
       printinfo_field(infield[k], inwfield[k], indgeofield[k]);
 
@@ -308,8 +290,22 @@ void	makeit(void)
 /*------ Pre-compute the background map */
         if (prefs.outfield_bitpix<0)
           {
+/*-------- Read image and weight data only once */
+          sprintf(gstr, "Reading %s", infield[k]->filename);
+          NFPRINTF(OUTPUT, gstr)
+          t0 = perf_start();
+          if (prefs.resamp_wonly == RESAMPWEIGHT_NONE)
+            preload_data(infield[k], inwfield[k]);
+          else
+            preload_data(NULL, inwfield[k]);
+          perf_add(PERF_READ, PERF_MAIN, t0, 0.0,
+		(infield[k]->pix? (double)infield[k]->tab->tabsize : 0.0)
+		+ ((inwfield[k] && inwfield[k]->pix)?
+			(double)inwfield[k]->tab->tabsize : 0.0));
           FPRINTF(OUTPUT, "\n");
+          t0 = perf_start();
           make_back(infield[k], inwfield[k], prefs.wscale_flag[i]);
+          perf_add(PERF_BACK, PERF_MAIN, t0, (double)infield[k]->npix, 0.0);
           FPRINTF(OUTPUT, "\n");
           }
         }
@@ -327,7 +323,11 @@ void	makeit(void)
           {
           sprintf(gstr, "Reading %s ...", inwfield[k]->filename);
           NFPRINTF(OUTPUT, gstr)
+          t0 = perf_start();
+          nbytes = inwfield[k]->pix? 0.0 : (double)inwfield[k]->tab->tabsize;
           read_weight(inwfield[k]);
+          perf_add(PERF_READ, PERF_MAIN, t0, (double)inwfield[k]->npix,
+		nbytes);
           }
 /*------ Read (and convert) the weight data */
         if (indgeofield[k])
@@ -336,10 +336,19 @@ void	makeit(void)
           NFPRINTF(OUTPUT, gstr)
           read_dgeo(indgeofield[k]);
           }
-/*------ Read (and convert) the data */
-        sprintf(gstr, "Reading %s", infield[k]->filename);
-        NFPRINTF(OUTPUT, gstr)
-        read_data(infield[k], inwfield[k], prefs.outfield_bitpix);
+/*------ Read (and convert) the data (not needed for weight maps only) */
+        if (prefs.resamp_wonly == RESAMPWEIGHT_NONE
+		|| prefs.outfield_bitpix>0)
+          {
+          sprintf(gstr, "Reading %s", infield[k]->filename);
+          NFPRINTF(OUTPUT, gstr)
+          t0 = perf_start();
+          nbytes = (infield[k]->pix || infield[k]->ipix)?
+			0.0 : (double)infield[k]->tab->tabsize;
+          read_data(infield[k], inwfield[k], prefs.outfield_bitpix);
+          perf_add(PERF_READ, PERF_MAIN, t0, (double)infield[k]->npix,
+		nbytes);
+          }
 /*------ Resample the data (no need to close catalogs) */
         sprintf(gstr, "Resampling %s ...", infield[k]->filename);
         NFPRINTF(OUTPUT, gstr)
@@ -358,6 +367,7 @@ void	makeit(void)
       infield[k]->time_diff = counter_seconds() - dtimef;
       if (prefs.xml_flag)
         update_xml(infield[k], inwfield[k]);
+      perf_endinput(k);
       }
     }
 
@@ -386,13 +396,34 @@ void	makeit(void)
       infield[k]->fgain /= infield[k]->fscale;
       infield[k]->fsaturation *= infield[k]->fscale;
       }
+/*-- Saturation levels are with respect to the subtracted background */
+    if (prefs.subback_flag[k]
+	&& infield[k]->fsaturation > infield[k]->fbackmean)
+      infield[k]->fsaturation -= infield[k]->fbackmean;
     if (inwfield[k])
       inwfield[k]->cat->tab->bscale /= (infield[k]->fscale*infield[k]->fscale);
     }
 
+/* Keep only the inputs processed by the current node */
+  QMALLOC(selfield, fieldstruct *, ntinfield);
+  QMALLOC(selwfield, fieldstruct *, ntinfield);
+  nselfield = 0;
+  for (k=0; k<ntinfield; k++)
+    if (selflag[k])
+      {
+      selfield[nselfield] = infield[k];
+      selwfield[nselfield++] = inwfield[k];
+      }
+
 /* Go! */
-  coadd_fields(infield, inwfield, ntinfield, outfield, outwfield,
+  if (prefs.skytile_size[0] || prefs.skytile_size[1])
+    coadd_skytiles(selfield, selwfield, nselfield, outfield, outwfield,
 		prefs.coadd_type, BIG);
+  else
+    coadd_fields(selfield, selwfield, nselfield, outfield, outwfield,
+		prefs.coadd_type, BIG);
+  free(selfield);
+  free(selwfield);
 
 the_end:
 /* Update the output field meta-data */
@@ -408,11 +439,18 @@ the_end:
       end_field(inwfield[k]);
     }
   free(next);
+  free(selflag);
   free(infield);
   free(inwfield);
 
   end_field(outfield);
   end_field(outwfield);
+  end_wcsinvcache();
+#ifdef USE_THREADS
+  threads_pool_end(threads_pool);
+  threads_pool = NULL;
+#endif
+  end_numa();
   cleanup_files();
 
 /* Processing end date and time */
@@ -424,6 +462,11 @@ the_end:
         tm->tm_hour, tm->tm_min, tm->tm_sec);
   prefs.time_diff = counter_seconds() - dtime;
 
+/* Write the timeline of processing stages */
+  if (prefs.ntrace_name && *prefs.trace_name[0]
+	&& write_perftrace(prefs.trace_name[0]) != RETURN_OK)
+    warning("Cannot write ", prefs.trace_name[0]);
+
 /* Write XML */
   if (prefs.xml_flag)
     {
@@ -435,6 +478,186 @@ the_end:
   }
 
 
+/****** scan_files ***********************************************************
+PROTO	void scan_files(int nfile)
+PURPOSE	Examine the metadata of all input files, in parallel if possible.
+INPUT	Number of input files.
+OUTPUT	-.
+NOTES	Results are stored in the scan_field, scan_wfield, scan_dgeofield and
+	scan_next static arrays, in the order of input files.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+static void	scan_files(int nfile)
+  {
+#ifdef USE_THREADS
+   threads_job_t		*job;
+   int				*sfile;
+#endif
+   int				i;
+
+  QCALLOC(scan_field, fieldstruct **, nfile);
+  QCALLOC(scan_wfield, fieldstruct **, nfile);
+  QCALLOC(scan_dgeofield, fieldstruct **, nfile);
+  QCALLOC(scan_next, int, nfile);
+
+#ifdef USE_THREADS
+  if (threads_pool && threads_pool->nthreads > 1 && nfile > 1)
+    {
+/*-- One task per input file */
+    QMALLOC(sfile, int, nfile);
+    job = threads_job_init(threads_pool);
+    for (i=0; i<nfile; i++)
+      {
+      sfile[i] = i;
+      threads_job_add(job, &pthread_scan_files, &sfile[i]);
+      }
+    threads_job_end(job);
+    free(sfile);
+    return;
+    }
+#endif
+
+  for (i=0; i<nfile; i++)
+    scan_file(i, PERF_MAIN);
+
+  return;
+  }
+
+
+#ifdef USE_THREADS
+/****** pthread_scan_files ***************************************************
+PROTO	void *pthread_scan_files(void *arg)
+PURPOSE	Input data scan task: examine an input file.
+INPUT	Pointer to the input file index.
+OUTPUT	NULL void pointer.
+NOTES	Statistics go to the slot of the pool worker running the task (or to
+	the main slot if the task is run by the main thread).
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+static void	*pthread_scan_files(void *arg)
+  {
+  scan_file(*((int *)arg), threads_pool_self(threads_pool) + 1);
+
+  return (void *)NULL;
+  }
+#endif
+
+
+/****** scan_file ************************************************************
+PROTO	void scan_file(int i, int slot)
+PURPOSE	Examine the metadata of an input file and load the relevant fields,
+	weight-maps and differential geometry maps.
+INPUT	Input file index,
+	thread slot (for performance statistics).
+OUTPUT	-.
+NOTES	Reentrant for different file indices. Image, weight and dgeo headers
+	go through the metadata cache if one is set.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+static void	scan_file(int i, int slot)
+  {
+   catstruct		*cat, *dcat, *wcat;
+   tabstruct		*tab;
+   char			str[MAXCHAR],
+			*cachedir;
+   double		t0;
+   size_t		nbytes;
+   int			j,k, jima, jweight, jdgeo;
+
+  t0 = perf_start();
+  cachedir = prefs.nmetacache_name? prefs.metacache_name[0] : NULL;
+/* Test if the filename contains a bracket indicating a particular extension*/
+  jima = selectext(prefs.infield_name[i]);
+  if (!(cat=read_metacat(prefs.infield_name[i], cachedir)))
+    {
+    sprintf(str, "*Error*: %s not found", prefs.infield_name[i]);
+    error(EXIT_FAILURE, str,"");
+    }
+  if (jima >= cat->ntab)
+      error(EXIT_FAILURE, "Not enough valid FITS image extensions in ",
+		prefs.infield_name[i]);
+/* Examine all extensions */
+/* Weights */
+  wcat = NULL;
+  jweight= RETURN_ERROR;		/* to avoid gcc -Wall warnings */
+  if (prefs.weight_type[i] && prefs.weight_type[i] != WEIGHT_FROMBACK)
+    {
+    jweight = selectext(prefs.inwfield_name[i]);
+    if (!(wcat=read_metacat(prefs.inwfield_name[i], cachedir)))
+      {
+      sprintf(str, "*Error*: %s not found", prefs.inwfield_name[i]);
+      error(EXIT_FAILURE, str,"");
+      }
+    if (jweight >= wcat->ntab)
+      error(EXIT_FAILURE, "Not enough valid FITS image extensions in ",
+		prefs.inwfield_name[i]);
+    }
+
+/* Dgeo maps */
+  dcat = NULL;
+  jdgeo = RETURN_ERROR;		/* to avoid gcc -Wall warnings */
+  if (prefs.dgeo_type[i])
+    {
+    jdgeo = selectext(prefs.indgeo_name[i]);
+    if (!(dcat=read_metacat(prefs.indgeo_name[i], cachedir)))
+      {
+      sprintf(str, "*Error*: %s not found", prefs.indgeo_name[i]);
+      error(EXIT_FAILURE, str,"");
+      }
+    if (jdgeo >= dcat->ntab)
+      error(EXIT_FAILURE, "Not enough valid FITS image extensions in ",
+		prefs.indgeo_name[i]);
+    }
+
+  QMALLOC(scan_field[i], fieldstruct *, cat->ntab);
+  QMALLOC(scan_wfield[i], fieldstruct *, cat->ntab);
+  QMALLOC(scan_dgeofield[i], fieldstruct *, cat->ntab);
+  k = 0;
+  nbytes = 0;
+  tab=cat->tab;
+  for (j=0; j<cat->ntab; j++,tab=tab->nexttab)
+    {
+    nbytes += (size_t)tab->headnblock*FBSIZE;
+#ifdef HAVE_CFITSIO
+    if ((jima>=0 && j!=jima) || (jima < 0 && (!tab->naxis ||
+	!(tab->isTileCompressed || (tab->naxis >= 2
+		&& strncmp(tab->xtension, "BINTABLE", 8)
+		&& strncmp(tab->xtension, "ASCTABLE", 8))))))
+      continue;
+#else
+    if ((jima>=0 && j!=jima) || (jima < 0 && (!tab->naxis ||
+	(tab->naxis >= 2
+	&& strncmp(tab->xtension, "BINTABLE", 8)
+	&& strncmp(tab->xtension, "ASCTABLE", 8))))) {
+      if (tab->isTileCompressed)
+	warning(BANNER " has been compiled without CFITSIO support: "
+		"compressed image skipped in ", prefs.infield_name[i]);
+      continue;
+    }
+#endif
+    scan_field[i][k] = load_field(cat, j, i, prefs.inhead_name[i]);
+    scan_wfield[i][k] = load_weight(wcat, scan_field[i][k],
+				jweight<0? j:jweight, i, prefs.weight_type[i]);
+    scan_dgeofield[i][k] = load_dgeo(dcat, scan_field[i][k],
+				jdgeo<0? j:jdgeo, i, prefs.dgeo_type[i]);
+    k++;
+    }
+  scan_next[i] = k;
+  perf_add(PERF_HEADER, slot, t0, 0.0, (double)nbytes);
+
+  free_cat(&cat, 1);
+  if (wcat)
+    free_cat(&wcat, 1);
+  if (dcat)
+    free_cat(&dcat, 1);
+
+  return;
+  }
+
+
 /****** selectext ************************************************************
 PROTO 	int selectext(char *filename)
 PURPOSE	Return the user-selected extension number [%d] from the file name.
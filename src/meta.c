@@ -0,0 +1,339 @@
+/*
+*				meta.c
+*
+* Persistent cache of input image metadata.
+*
+*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+*
+*	This file part of:	SWarp
+*
+*	Copyright:		(C) 2026 CEA/AIM/UParisSaclay
+*
+*	License:		GNU General Public License
+*
+*	SWarp is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*	SWarp is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU General Public License for more details.
+*	You should have received a copy of the GNU General Public License
+*	along with SWarp. If not, see <http://www.gnu.org/licenses/>.
+*
+*	Last modified:		19/10/2026
+*
+*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+
+#ifdef HAVE_CONFIG_H
+#include	"config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "define.h"
+#include "globals.h"
+#include "fits/fitscat.h"
+#include "meta.h"
+
+static catstruct	*meta_load(char *filename, char *cachename,
+				metaheadstruct *head);
+static void		meta_save(catstruct *cat, char *cachename,
+				metaheadstruct *head);
+
+/*
+ A metadata cache file contains a header (metaheadstruct) identifying the
+ input file, followed for every HDU by its position in the file
+ (metatabstruct) and its FITS header blocks. Cache files are written in the
+ native binary format of the machine, and are named after a hash of the
+ absolute input filename. A cache file that does not match the current
+ input file is simply ignored (and replaced).
+*/
+
+/****** read_metacat *********************************************************
+PROTO	catstruct *read_metacat(char *filename, char *cachedir)
+PURPOSE	``Read'' a FITS file, using the metadata cache if available.
+INPUT	FITS filename,
+	cache directory (NULL or empty string = no cache).
+OUTPUT	catstruct pointer, or NULL if the file cannot be read.
+NOTES	Drop-in replacement for read_cat(). The file is left open only if
+	the metadata were not found in the cache.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+catstruct	*read_metacat(char *filename, char *cachedir)
+  {
+   metaheadstruct	head;
+   struct stat		st;
+   catstruct		*cat;
+   char			cachename[MAXCHAR],
+			*path;
+
+  if (!cachedir || !*cachedir || stat(filename, &st)
+	|| !(path = realpath(filename, NULL)))
+    return read_cat(filename);
+
+  meta_cachename(cachedir, path, META_EXT, cachename);
+  memset(&head, 0, sizeof(head));
+  memcpy(head.magic, META_MAGIC, 8);
+  strncpy(head.filename, path, MAXCHAR-1);
+  head.size = (long long)st.st_size;
+  head.mtime = (long long)st.st_mtime;
+  head.mtimensec = (long long)st.st_mtim.tv_nsec;
+  head.ino = (long long)st.st_ino;
+  free(path);
+
+  if ((cat = meta_load(filename, cachename, &head)))
+    return cat;
+
+  if ((cat = read_cat(filename)))
+    meta_save(cat, cachename, &head);
+
+  return cat;
+  }
+
+
+/****** meta_load ************************************************************
+PROTO	catstruct *meta_load(char *filename, char *cachename,
+			metaheadstruct *head)
+PURPOSE	Rebuild a catalog from a metadata cache file.
+INPUT	FITS filename,
+	cache filename,
+	pointer to the expected cache header.
+OUTPUT	catstruct pointer, or NULL if the cache file is missing or does not
+	match.
+NOTES	The FITS file itself is not opened.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+static catstruct	*meta_load(char *filename, char *cachename,
+				metaheadstruct *head)
+  {
+   metaheadstruct	chead;
+   metatabstruct	mtab;
+   FILE			*file;
+   catstruct		*cat;
+   tabstruct		*tab, *prevtab;
+   unsigned int		sum;
+   int			t;
+
+  if (!(file = fopen(cachename, "rb")))
+    return NULL;
+  if (fread(&chead, sizeof(chead), 1, file) != 1
+	|| strncmp(chead.magic, head->magic, 8)
+	|| strncmp(chead.filename, head->filename, MAXCHAR)
+	|| chead.size != head->size || chead.mtime != head->mtime
+	|| chead.mtimensec != head->mtimensec
+	|| chead.ino != head->ino || chead.ntab < 1)
+    {
+    fclose(file);
+    return NULL;
+    }
+
+  cat = new_cat(1);
+  strcpy(cat->filename, filename);
+  cat->access_type = READ_ONLY;
+  prevtab = NULL;
+  sum = META_CHECKSUMINIT;
+  for (t=0; t<chead.ntab; t++)
+    {
+    if (fread(&mtab, sizeof(mtab), 1, file) != 1
+	|| mtab.headnblock < 1 || mtab.headnblock > META_MAXNBLOCK)
+      break;
+    QCALLOC(tab, tabstruct, 1);
+    tab->cat = cat;
+    tab->nseg = tab->seg = 1;
+    if (prevtab)
+      {
+      tab->prevtab = prevtab;
+      prevtab->nexttab = tab;
+      }
+    else
+      cat->tab = tab;
+    prevtab = tab;
+    cat->ntab++;
+    tab->headpos = (OFF_T2)mtab.headpos;
+    tab->bodypos = (OFF_T2)mtab.bodypos;
+    tab->headnblock = mtab.headnblock;
+    QMALLOC(tab->headbuf, char, mtab.headnblock*FBSIZE);
+    if (fread(tab->headbuf, mtab.headnblock*FBSIZE, 1, file) != 1)
+      break;
+    sum = meta_checksum(sum, &mtab, sizeof(mtab));
+    sum = meta_checksum(sum, tab->headbuf, mtab.headnblock*FBSIZE);
+    }
+  fclose(file);
+  if (prevtab)
+    {
+    prevtab->nexttab = cat->tab;
+    cat->tab->prevtab = prevtab;
+    }
+  if (t<chead.ntab || sum != chead.checksum)
+    {
+    free_cat(&cat, 1);
+    return NULL;
+    }
+
+/* Headers are now known to be safe to parse */
+  tab = cat->tab;
+  for (t=0; t<cat->ntab; t++, tab=tab->nexttab)
+    {
+    readbasic_head(tab);
+    readbintabparam_head(tab);
+#ifdef	HAVE_CFITSIO
+    tab->cfitsio_hdunum = t+1;
+#endif
+    }
+
+  return cat;
+  }
+
+
+/****** meta_save ************************************************************
+PROTO	void meta_save(catstruct *cat, char *cachename, metaheadstruct *head)
+PURPOSE	Save the metadata of a catalog to the cache.
+INPUT	Pointer to the catalog,
+	cache filename,
+	pointer to the cache header.
+OUTPUT	-.
+NOTES	The cache file is written under a temporary name and renamed, so
+	that concurrent processes never see partial files. Failures are
+	silently ignored. Empty and tile-compressed catalogs are not cached.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+static void	meta_save(catstruct *cat, char *cachename, metaheadstruct *head)
+  {
+   metatabstruct	*mtab;
+   FILE			*file;
+   tabstruct		*tab;
+   char			tmpname[MAXCHAR];
+   int			t, fd, status;
+
+  if (cat->ntab < 1)
+    return;
+  tab = cat->tab;
+  for (t=0; t<cat->ntab; t++, tab=tab->nexttab)
+    if (tab->isTileCompressed)
+      return;
+
+  QCALLOC(mtab, metatabstruct, cat->ntab);
+  head->ntab = cat->ntab;
+  head->checksum = META_CHECKSUMINIT;
+  tab = cat->tab;
+  for (t=0; t<cat->ntab; t++, tab=tab->nexttab)
+    {
+    mtab[t].headpos = (long long)tab->headpos;
+    mtab[t].bodypos = (long long)tab->bodypos;
+    mtab[t].headnblock = tab->headnblock;
+    head->checksum = meta_checksum(head->checksum, &mtab[t],
+				sizeof(metatabstruct));
+    head->checksum = meta_checksum(head->checksum, tab->headbuf,
+				tab->headnblock*FBSIZE);
+    }
+
+  sprintf(tmpname, "%.*sXXXXXX", MAXCHAR-8, cachename);
+  if ((fd = mkstemp(tmpname)) == -1)
+    {
+    free(mtab);
+    return;
+    }
+  if (!(file = fdopen(fd, "wb")))
+    {
+    close(fd);
+    remove(tmpname);
+    free(mtab);
+    return;
+    }
+  status = fwrite(head, sizeof(metaheadstruct), 1, file) != 1;
+  tab = cat->tab;
+  for (t=0; t<cat->ntab && !status; t++, tab=tab->nexttab)
+    status = fwrite(&mtab[t], sizeof(metatabstruct), 1, file) != 1
+	|| fwrite(tab->headbuf, tab->headnblock*FBSIZE, 1, file) != 1;
+  if (fclose(file) || status || rename(tmpname, cachename))
+    remove(tmpname);
+  free(mtab);
+
+  return;
+  }
+
+
+/****** meta_fileid *********************************************************
+PROTO	int meta_fileid(char *filename, char *id)
+PURPOSE	Build a string that identifies a given version of a file.
+INPUT	Filename,
+	pointer to the output string (at least 2*MAXCHAR bytes).
+OUTPUT	RETURN_OK if the file exists, RETURN_ERROR otherwise.
+NOTES	The identifier is made of the absolute filename, size, modification
+	time (down to the nanosecond) and inode number of the file.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+int	meta_fileid(char *filename, char *id)
+  {
+   struct stat	st;
+   char		*path;
+
+  if (stat(filename, &st) || !(path = realpath(filename, NULL)))
+    return RETURN_ERROR;
+  sprintf(id, "%.*s %lld %lld.%09ld %lld", MAXCHAR, path,
+	(long long)st.st_size, (long long)st.st_mtime, (long)st.st_mtim.tv_nsec,
+	(long long)st.st_ino);
+  free(path);
+
+  return RETURN_OK;
+  }
+
+
+/****** meta_cachename ******************************************************
+PROTO	void meta_cachename(char *cachedir, char *key, char *ext,
+			char *cachename)
+PURPOSE	Build the name of a cache file from a key string.
+INPUT	Cache directory,
+	key string,
+	cache file extension,
+	pointer to the output cache filename (MAXCHAR bytes).
+OUTPUT	-.
+NOTES	The cache filename is a (64 bit FNV-1a) hash of the key.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+void	meta_cachename(char *cachedir, char *key, char *ext, char *cachename)
+  {
+   unsigned long long	hash;
+   char			*pstr;
+
+  hash = 14695981039346656037ULL;
+  for (pstr=key; *pstr; pstr++)
+    hash = (hash ^ (unsigned char)*pstr) * 1099511628211ULL;
+  sprintf(cachename, "%.*s/%016llx%s", MAXCHAR-32, cachedir, hash, ext);
+
+  return;
+  }
+
+
+/****** meta_checksum ********************************************************
+PROTO	unsigned int meta_checksum(unsigned int sum, void *ptr, size_t size)
+PURPOSE	Update a (32 bit FNV-1a) checksum with a memory area.
+INPUT	Current checksum (META_CHECKSUMINIT to start),
+	pointer to the memory area,
+	size of the memory area in bytes.
+OUTPUT	Updated checksum.
+NOTES	-.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+unsigned int	meta_checksum(unsigned int sum, void *ptr, size_t size)
+  {
+   unsigned char	*cptr;
+
+  for (cptr=(unsigned char *)ptr; size--; cptr++)
+    sum = (sum ^ *cptr) * 16777619U;
+
+  return sum;
+  }
+
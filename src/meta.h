@@ -0,0 +1,74 @@
+/*
+*				meta.h
+*
+* Include file for meta.c.
+*
+*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+*
+*	This file part of:	SWarp
+*
+*	Copyright:		(C) 2026 CEA/AIM/UParisSaclay
+*
+*	License:		GNU General Public License
+*
+*	SWarp is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*	SWarp is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU General Public License for more details.
+*	You should have received a copy of the GNU General Public License
+*	along with SWarp. If not, see <http://www.gnu.org/licenses/>.
+*
+*	Last modified:		19/10/2026
+*
+*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+
+#ifndef _FITSCAT_H_
+#include "fits/fitscat.h"
+#endif
+
+#ifndef	_META_H_
+#define	_META_H_
+
+/*------------------------------- constants ---------------------------------*/
+#define	META_MAGIC	"SWMETA02"	/* Metadata cache file signature */
+#define	META_EXT	".meta"		/* Extension of metadata cache files */
+#define	META_MAXNBLOCK	100000		/* Max. number of blocks per header */
+#define	META_CHECKSUMINIT 2166136261U	/* FNV-1a offset basis */
+
+/*-------------------------- structure definitions --------------------------*/
+typedef struct metahead
+  {
+  char		magic[8];		/* File signature */
+  char		filename[MAXCHAR];	/* Absolute input filename */
+  long long	size;			/* Input file size (bytes) */
+  long long	mtime;			/* Input modification time (s) */
+  long long	mtimensec;		/* Input modification time (ns part) */
+  long long	ino;			/* Input inode number */
+  int		ntab;			/* Number of FITS HDUs */
+  unsigned int	checksum;		/* Checksum of HDU records and headers */
+  }	metaheadstruct;
+
+typedef struct metatab
+  {
+  long long	headpos;		/* Header position in file */
+  long long	bodypos;		/* Body position in file */
+  int		headnblock;		/* Number of FITS blocks in header */
+  int		dummy;			/* Padding */
+  }	metatabstruct;
+
+/*-------------------------------- protos -----------------------------------*/
+extern catstruct	*read_metacat(char *filename, char *cachedir);
+
+extern unsigned int	meta_checksum(unsigned int sum, void *ptr, size_t size);
+
+extern int		meta_fileid(char *filename, char *id);
+
+extern void		meta_cachename(char *cachedir, char *key, char *ext,
+				char *cachename);
+
+#endif
+
@@ -0,0 +1,440 @@
+/*
+*				node.c
+*
+* Split co-additions among several nodes or processes.
+*
+*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+*
+*	This file part of:	SWarp
+*
+*	Copyright:		(C) 2026 CEA/AIM/UParisSaclay
+*
+*	License:		GNU General Public License
+*
+*	SWarp is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*	SWarp is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU General Public License for more details.
+*	You should have received a copy of the GNU General Public License
+*	along with SWarp. If not, see <http://www.gnu.org/licenses/>.
+*
+*	Last modified:		19/10/2026
+*
+*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+
+#ifdef HAVE_CONFIG_H
+#include	"config.h"
+#endif
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "define.h"
+#include "globals.h"
+#include "fits/fitscat.h"
+#include "field.h"
+#include "meta.h"
+#include "node.h"
+#include "prefs.h"
+
+static int	node_done(fieldstruct *outfield),
+		node_readtoken(char *filename, char *token);
+
+static void	node_filename(char *filename, fieldstruct *field, char *ext,
+			int index),
+		node_updatehead(fieldstruct *field, int headnblock,
+			unsigned int bodysum, int metaflag);
+
+static char	node_token[NODE_TOKENSIZE];
+
+/*
+ With NNODES > 1, node NODE_INDEX co-adds a contiguous strip of the output
+ frame along the last axis. All nodes write to the same output files at the
+ relevant byte offsets. Each node leaves a small metadata file when done;
+ the last node to finish merges the metadata and updates the output headers.
+ Every metadata file carries a token derived from the definition of the run
+(output headers, number of nodes and input files), which every node computes
+independently of the others. Files left over by a different run are never
+merged, whatever the order in which nodes are started.
+*/
+
+/****** node_strip ***********************************************************
+PROTO	void node_strip(fieldstruct *outfield, int *zmin, int *zmax)
+PURPOSE	Compute the range of output coordinates along the last axis that is
+	processed by the current node.
+INPUT	Pointer to the output field,
+	pointer to the first coordinate (output),
+	pointer to the last coordinate (output).
+OUTPUT	-.
+NOTES	The range is empty (*zmin > *zmax) if there are more nodes than
+	positions along the last axis.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+void	node_strip(fieldstruct *outfield, int *zmin, int *zmax)
+  {
+   long long	n;
+
+  n = (long long)outfield->tab->naxisn[outfield->tab->naxis-1];
+  *zmin = (int)(prefs.node_index*n/prefs.nnodes) + 1;
+  *zmax = (int)((prefs.node_index+1)*n/prefs.nnodes);
+
+  return;
+  }
+
+
+/****** node_select **********************************************************
+PROTO	int node_select(fieldstruct *field, fieldstruct *outfield, int n)
+PURPOSE	Tell whether an input field must be processed by the current node.
+INPUT	Pointer to the input field,
+	pointer to the output field,
+	input field index.
+OUTPUT	1 if the field must be processed, 0 otherwise.
+NOTES	The input frame limits in the output frame must have been computed
+	(e.g., with frame_wcs()). Without co-addition, input fields are simply
+	shared among nodes.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+int	node_select(fieldstruct *field, fieldstruct *outfield, int n)
+  {
+   int	d, zmin, zmax;
+
+  if (!prefs.combine_flag)
+    return (n%prefs.nnodes) == prefs.node_index;
+
+  node_strip(outfield, &zmin, &zmax);
+  d = outfield->tab->naxis-1;
+
+  return zmin<=zmax && field->wcs->outmax[d]>=zmin
+	&& field->wcs->outmin[d]<=zmax;
+  }
+
+
+/****** node_init ************************************************************
+PROTO	void node_init(fieldstruct *outfield, fieldstruct *outwfield,
+			fieldstruct **infield, int ninput)
+PURPOSE	Compute the token that identifies the current distributed run, and
+	clean up files left over by the current node.
+INPUT	Pointer to the output field,
+	pointer to the output weight field,
+	pointer to the array of input fields,
+	number of input fields.
+OUTPUT	-.
+NOTES	Must be called by every node before input data are loaded, with the
+	output headers as built by init_field() and init_weight(). No merging
+	can be in progress at this stage, hence a lock file is necessarily a
+	leftover.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+void	node_init(fieldstruct *outfield, fieldstruct *outwfield,
+			fieldstruct **infield, int ninput)
+  {
+   char		filename[MAXCHAR], id[2*MAXCHAR];
+   unsigned int	sum, isum;
+   int		n;
+
+  if (outfield->tab->naxis<2)
+    return;
+
+  sum = meta_checksum(META_CHECKSUMINIT, &prefs.nnodes, sizeof(int));
+  sum = meta_checksum(sum, outfield->tab->headbuf,
+		outfield->tab->headnblock*FBSIZE);
+  sum = meta_checksum(sum, outwfield->tab->headbuf,
+		outwfield->tab->headnblock*FBSIZE);
+  isum = META_CHECKSUMINIT;
+  for (n=0; n<ninput; n++)
+    {
+    if (meta_fileid(infield[n]->filename, id) != RETURN_OK)
+      sprintf(id, "%.*s", MAXCHAR, infield[n]->filename);
+    isum = meta_checksum(isum, id, strlen(id)+1);
+    }
+  sprintf(node_token, "%08x%08x", sum, isum);
+
+  node_filename(filename, outfield, NODE_EXT, prefs.node_index);
+  remove(filename);
+  node_filename(filename, outfield, NODE_LOCKEXT, -1);
+  if (!access(filename, F_OK))
+    {
+    warning("Removing leftover lock file ", filename);
+    remove(filename);
+    }
+
+  return;
+  }
+
+
+/****** node_openfile ********************************************************
+PROTO	void node_openfile(fieldstruct *field)
+PURPOSE	Open an output file shared among nodes, without truncating it.
+INPUT	Pointer to the output field.
+OUTPUT	-.
+NOTES	The file is created if it does not exist yet. Its final size is set by
+	the merging node (see node_updatehead()).
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+void	node_openfile(fieldstruct *field)
+  {
+   int	fd;
+
+  if ((fd=open(field->filename, O_RDWR|O_CREAT, 0666)) == -1
+	|| !(field->cat->file = fdopen(fd, "r+b")))
+    error(EXIT_FAILURE, "*Error*: cannot open for writing ",
+	field->filename);
+  field->cat->access_type = WRITE_ONLY;
+
+  return;
+  }
+
+
+/****** node_filename ********************************************************
+PROTO	void node_filename(char *filename, fieldstruct *field, char *ext,
+			int index)
+PURPOSE	Build the name of a file attached to a shared output file.
+INPUT	Pointer to the name (output, MAXCHAR bytes),
+	pointer to the output field,
+	extension,
+	node index (none if < 0).
+OUTPUT	-.
+NOTES	Exits with an error if the name does not fit.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+static void	node_filename(char *filename, fieldstruct *field, char *ext,
+			int index)
+  {
+   int	n;
+
+  if (index<0)
+    n = snprintf(filename, MAXCHAR, "%s%s", field->filename, ext);
+  else
+    n = snprintf(filename, MAXCHAR, "%s%s%04d", field->filename, ext, index);
+  if (n<0 || n>=MAXCHAR)
+    error(EXIT_FAILURE, "*Error*: file name too long for node metadata: ",
+	field->filename);
+
+  return;
+  }
+
+
+/****** node_readtoken *******************************************************
+PROTO	int node_readtoken(char *filename, char *token)
+PURPOSE	Read the run token at the beginning of a node file.
+INPUT	File name,
+	pointer to the token (output, NODE_TOKENSIZE bytes).
+OUTPUT	RETURN_OK if a token was read, RETURN_ERROR otherwise.
+NOTES	-.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+static int	node_readtoken(char *filename, char *token)
+  {
+   FILE	*file;
+   int	status;
+
+  if (!(file = fopen(filename, "r")))
+    return RETURN_ERROR;
+  status = fscanf(file, "%" NODE_TOKENFMT "s", token)==1?
+		RETURN_OK : RETURN_ERROR;
+  fclose(file);
+
+  return status;
+  }
+
+
+/****** node_done ************************************************************
+PROTO	int node_done(fieldstruct *outfield)
+PURPOSE	Tell whether all nodes of the current run have saved their metadata.
+INPUT	Pointer to the output field.
+OUTPUT	1 if all nodes are done, 0 otherwise.
+NOTES	-.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+static int	node_done(fieldstruct *outfield)
+  {
+   char	filename[MAXCHAR], token[NODE_TOKENSIZE];
+   int	i;
+
+  for (i=0; i<prefs.nnodes; i++)
+    {
+    node_filename(filename, outfield, NODE_EXT, i);
+    if (node_readtoken(filename, token) != RETURN_OK
+	|| strcmp(token, node_token))
+      return 0;
+    }
+
+  return 1;
+  }
+
+
+/****** node_updatehead *****************************************************
+PROTO	void node_updatehead(fieldstruct *field, int headnblock,
+			unsigned int bodysum, int metaflag)
+PURPOSE	Update the merged metadata in an output header already on disk, and
+	set the final file size.
+INPUT	Pointer to the output field,
+	number of FITS blocks in the header,
+	checksum of the whole body,
+	flag set to update the merged EXPTIME, GAIN and SATURATE values.
+OUTPUT	-.
+NOTES	The header is read back from the file, as header contents (e.g.
+	copied keywords) may differ from node to node. Checksum keywords are
+	updated only if WRITE_CHECKSUM is set. The file is truncated to its
+	final size, in case it was larger before the run.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+static void	node_updatehead(fieldstruct *field, int headnblock,
+			unsigned int bodysum, int metaflag)
+  {
+   char		*headbuf;
+   OFF_T2	size;
+
+  QMALLOC(headbuf, char, headnblock*FBSIZE);
+  node_openfile(field);
+  QFREAD(headbuf, headnblock*FBSIZE, field->cat->file, field->filename);
+  if (metaflag)
+    {
+    fitswrite(headbuf, "EXPTIME ", &field->exptime, H_EXPO, T_DOUBLE);
+    fitswrite(headbuf, "GAIN    ", &field->fgain, H_EXPO, T_DOUBLE);
+    fitswrite(headbuf, "SATURATE", &field->fsaturation, H_EXPO, T_DOUBLE);
+    }
+  if (prefs.checksum_flag)
+    update_checksum(headbuf, headnblock, bodysum);
+  QFSEEK(field->cat->file, 0, SEEK_SET, field->filename);
+  QFWRITE(headbuf, headnblock*FBSIZE, field->cat->file, field->filename);
+  size = (OFF_T2)headnblock*FBSIZE + PADTOTAL((OFF_T2)field->tab->tabsize);
+  if (fflush(field->cat->file) || ftruncate(fileno(field->cat->file), size))
+    error(EXIT_FAILURE, "*Error*: cannot set the final size of ",
+	field->filename);
+  close_cat(field->cat);
+  free(headbuf);
+
+  return;
+  }
+
+
+/****** node_merge ***********************************************************
+PROTO	void node_merge(fieldstruct *outfield, fieldstruct *outwfield)
+PURPOSE	Save the output metadata of the current node, and merge those of all
+	nodes into the output headers if all nodes are done.
+INPUT	Pointer to the output field,
+	pointer to the output weight field.
+OUTPUT	-.
+NOTES	Output files must be closed and node_init() must have been called.
+	Only metadata files carrying the token of the current run are
+	considered. A lock file guarantees that only one node carries out the
+	merging. No output image is updated in weight-only mode.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+void	node_merge(fieldstruct *outfield, fieldstruct *outwfield)
+  {
+   FILE		*file;
+   char		filename[MAXCHAR], filename2[MAXCHAR], lockname[MAXCHAR],
+		token[NODE_TOKENSIZE];
+   double	exptime, gain, satlev,
+		exptime2, gain2, satlev2;
+   unsigned int	bodysum, wbodysum, bodysum2, wbodysum2;
+   int		i, fd, headnblock, wheadnblock, headnblock2, wheadnblock2,
+		fieldno, fieldno2;
+
+  if (!*node_token)
+    error(EXIT_FAILURE, "*Internal Error*: node token not initialized in ",
+	"node_merge()");
+
+/* Save the metadata of the current node */
+  node_filename(filename, outfield, NODE_EXT, prefs.node_index);
+  node_filename(filename2, outfield, NODE_EXT ".tmp", prefs.node_index);
+  if (!(file = fopen(filename2, "w")))
+    error(EXIT_FAILURE, "*Error*: cannot open for writing ", filename2);
+  fprintf(file, "%s %d %d %d %.17g %.17g %.17g %u %u\n", node_token,
+	outfield->tab->headnblock, outwfield->tab->headnblock,
+	outfield->fieldno, outfield->exptime, outfield->fgain,
+	outfield->fsaturation, outfield->tab->bodysum, outwfield->tab->bodysum);
+  if (fclose(file) || rename(filename2, filename))
+    error(EXIT_FAILURE, "*Error*: cannot write ", filename);
+
+/* Check that all nodes of the current run are done */
+  if (!node_done(outfield))
+    return;
+
+/* Only one node does the merging */
+  node_filename(lockname, outfield, NODE_LOCKEXT, -1);
+  if ((fd=open(lockname, O_WRONLY|O_CREAT|O_EXCL, 0666)) == -1)
+    {
+    if (errno != EEXIST)
+      error(EXIT_FAILURE, "*Error*: cannot create lock file ", lockname);
+    return;
+    }
+  close(fd);
+/* Another node may have completed the merging in the meantime */
+  if (!node_done(outfield))
+    {
+    remove(lockname);
+    return;
+    }
+
+  NFPRINTF(OUTPUT, "Merging node metadata...");
+  headnblock = outfield->tab->headnblock;
+  wheadnblock = outwfield->tab->headnblock;
+  fieldno = 0;
+  exptime = gain = 0.0;
+  satlev = BIG;
+  bodysum = wbodysum = 0;
+  for (i=0; i<prefs.nnodes; i++)
+    {
+    node_filename(filename, outfield, NODE_EXT, i);
+    if (!(file = fopen(filename, "r")))
+      error(EXIT_FAILURE, "*Error*: cannot open ", filename);
+    if (fscanf(file, "%" NODE_TOKENFMT "s %d %d %d %lf %lf %lf %u %u",
+	token, &headnblock2, &wheadnblock2, &fieldno2, &exptime2, &gain2,
+	&satlev2, &bodysum2, &wbodysum2) != 9 || strcmp(token, node_token))
+      error(EXIT_FAILURE, "*Error*: corrupted node metadata in ", filename);
+    fclose(file);
+    if (headnblock2 != headnblock || wheadnblock2 != wheadnblock)
+      error(EXIT_FAILURE, "*Error*: output header sizes differ among nodes ",
+	"in distributed co-addition");
+/*-- Each node derives the exposure time and gain from the densest overlap of
+    its inputs; like the single-process co-addition, keep the densest one */
+    if (!i || fieldno2 > fieldno || (fieldno2 == fieldno && exptime2 > exptime))
+      {
+      fieldno = fieldno2;
+      exptime = exptime2;
+      gain = gain2;
+      }
+    if (satlev2 < satlev)
+      satlev = satlev2;
+/*-- Node checksums are computed at the actual positions of their strips */
+    bodysum = add_checksum(bodysum, bodysum2);
+    wbodysum = add_checksum(wbodysum, wbodysum2);
+    remove(filename);
+    }
+
+  outfield->fieldno = fieldno;
+  outfield->exptime = exptime;
+  outfield->fgain = outfield->gain = gain;
+  outfield->fsaturation = outfield->saturation = satlev;
+
+/* Update the output headers written by the first node */
+  if (outfield->bitpix>0 || prefs.resamp_wonly == RESAMPWEIGHT_NONE)
+    node_updatehead(outfield, headnblock, bodysum, 1);
+  node_updatehead(outwfield, wheadnblock, wbodysum, 0);
+
+  remove(lockname);
+
+  return;
+  }
+
@@ -0,0 +1,59 @@
+/*
+*				node.h
+*
+* Include file for node.c.
+*
+*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+*
+*	This file part of:	SWarp
+*
+*	Copyright:		(C) 2026 CEA/AIM/UParisSaclay
+*
+*	License:		GNU General Public License
+*
+*	SWarp is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*	SWarp is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU General Public License for more details.
+*	You should have received a copy of the GNU General Public License
+*	along with SWarp. If not, see <http://www.gnu.org/licenses/>.
+*
+*	Last modified:		19/10/2026
+*
+*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+
+#ifndef _FIELD_H_
+#include "field.h"
+#endif
+
+#ifndef	_NODE_H_
+#define	_NODE_H_
+
+/*------------------------------- constants ---------------------------------*/
+#define	NODE_EXT	".node"		/* Extension of node metadata files */
+#define	NODE_LOCKEXT	".nodelock"	/* Extension of the merge lock file */
+#define	NODE_TOKENSIZE	32		/* Max. size of the run token + 1 */
+#define	NODE_TOKENFMT	"31"		/* scanf() width of the run token */
+
+/*----------------------------- Global macros -------------------------------*/
+#define	NODE_ACTIVE	(prefs.nnodes>1 && prefs.node_index>=0)
+
+/*-------------------------------- protos -----------------------------------*/
+extern int		node_select(fieldstruct *field, fieldstruct *outfield,
+				int n);
+
+extern void		node_merge(fieldstruct *outfield,
+				fieldstruct *outwfield),
+			node_init(fieldstruct *outfield,
+				fieldstruct *outwfield, fieldstruct **infield,
+				int ninput),
+			node_openfile(fieldstruct *field),
+			node_strip(fieldstruct *outfield, int *zmin,
+				int *zmax);
+
+#endif
+
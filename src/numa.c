@@ -0,0 +1,308 @@
+/*
+*				numa.c
+*
+* Placement of threads and buffers on NUMA nodes.
+*
+*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+*
+*	This file part of:	SWarp
+*
+*	Copyright:		(C) 2026 CEA/AIM/UParisSaclay
+*
+*	License:		GNU General Public License
+*
+*	SWarp is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*	SWarp is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU General Public License for more details.
+*	You should have received a copy of the GNU General Public License
+*	along with SWarp. If not, see <http://www.gnu.org/licenses/>.
+*
+*	Last modified:		19/10/2026
+*
+*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+
+#ifdef HAVE_CONFIG_H
+#include	"config.h"
+#endif
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif
+
+#include "define.h"
+#include "globals.h"
+#include "fits/fitscat.h"
+#include "numa.h"
+#include "prefs.h"
+
+/*
+With NUMA_AFFINITY set, worker thread t is assigned to node t*nnode/nthreads
+(consecutive threads share a node) and pinned to the CPUs of that node.
+Buffer lines processed by the threads of a node are first touched by these
+threads, so that the kernel allocates the underlying pages on that node.
+*/
+
+#ifdef HAVE_SCHED_SETAFFINITY
+static cpu_set_t	numa_cpuset[NUMA_MAXNODE];
+static int		numa_readlist(char *filename, int *list, int nmax);
+#endif
+static int		numa_nnodes = 1, numa_nthreads = 1, numa_flag,
+			numa_hugewarnflag;
+
+/****** init_numa ************************************************************
+PROTO	void init_numa(int nthreads)
+PURPOSE	Read the NUMA topology and assign worker threads to nodes.
+INPUT	Number of worker threads.
+OUTPUT	-.
+NOTES	Does nothing unless NUMA_AFFINITY is set. Nodes without CPUs are
+	ignored.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+void	init_numa(int nthreads)
+  {
+#ifdef HAVE_SCHED_SETAFFINITY
+   char		filename[MAXCHAR];
+   int		node[NUMA_MAXNODE], cpu[CPU_SETSIZE],
+		c, n, nnode, ncpu;
+#endif
+
+  numa_nthreads = nthreads>0? nthreads : 1;
+  numa_nnodes = 1;
+  numa_flag = numa_hugewarnflag = 0;
+  if (!prefs.numa_flag)
+    return;
+
+#ifdef HAVE_SCHED_SETAFFINITY
+  nnode = numa_readlist(NUMA_SYSDIR "/online", node, NUMA_MAXNODE);
+  numa_nnodes = 0;
+  for (n=0; n<nnode; n++)
+    {
+    sprintf(filename, NUMA_SYSDIR "/node%d/cpulist", node[n]);
+    if (!(ncpu = numa_readlist(filename, cpu, CPU_SETSIZE)))
+      continue;
+    CPU_ZERO(&numa_cpuset[numa_nnodes]);
+    for (c=0; c<ncpu; c++)
+      CPU_SET(cpu[c], &numa_cpuset[numa_nnodes]);
+    numa_nnodes++;
+    }
+  if (!numa_nnodes)
+    {
+    numa_nnodes = 1;
+    warning("Cannot read the NUMA topology in " NUMA_SYSDIR ": ",
+	"NUMA_AFFINITY ignored");
+    return;
+    }
+  numa_flag = 1;
+#else
+  warning("NUMA_AFFINITY ignored: ",
+	"thread pinning is not supported on this system");
+#endif
+
+  return;
+  }
+
+
+/****** end_numa *************************************************************
+PROTO	void end_numa(void)
+PURPOSE	Reset NUMA settings.
+INPUT	-.
+OUTPUT	-.
+NOTES	-.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+void	end_numa(void)
+  {
+  numa_nnodes = numa_nthreads = 1;
+  numa_flag = 0;
+
+  return;
+  }
+
+
+/****** numa_nnode ***********************************************************
+PROTO	int numa_nnode(void)
+PURPOSE	Return the number of NUMA nodes threads are distributed over.
+INPUT	-.
+OUTPUT	Number of nodes (1 if NUMA placement is off).
+NOTES	-.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+int	numa_nnode(void)
+  {
+  return numa_nnodes;
+  }
+
+
+/****** numa_threadnode ******************************************************
+PROTO	int numa_threadnode(int t)
+PURPOSE	Return the NUMA node assigned to a worker thread.
+INPUT	Worker thread index.
+OUTPUT	Node index (0 if NUMA placement is off).
+NOTES	-.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+int	numa_threadnode(int t)
+  {
+  return numa_flag? (t%numa_nthreads)*numa_nnodes/numa_nthreads : 0;
+  }
+
+
+/****** numa_pinthread *******************************************************
+PROTO	void numa_pinthread(int t)
+PURPOSE	Pin the calling worker thread to the CPUs of its NUMA node.
+INPUT	Worker thread index.
+OUTPUT	-.
+NOTES	Does nothing if NUMA placement is off. Failures are ignored: the
+	thread keeps running wherever the scheduler puts it.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+void	numa_pinthread(int t)
+  {
+#ifdef HAVE_SCHED_SETAFFINITY
+  if (numa_flag)
+    sched_setaffinity(0, sizeof(cpu_set_t), &numa_cpuset[numa_threadnode(t)]);
+#endif
+
+  return;
+  }
+
+
+/****** numa_malloc **********************************************************
+PROTO	void *numa_malloc(size_t size)
+PURPOSE	Allocate a large buffer, possibly backed by huge pages.
+INPUT	Size in bytes.
+OUTPUT	Pointer to the buffer, or NULL if memory could not be allocated.
+NOTES	Pages are not touched, so that they end up on the node of the first
+	thread writing to them. Explicit huge pages (HUGE_PAGES EXPLICIT) fall
+	back to transparent huge pages if none are available.
+	The buffer must be freed with numa_free().
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+void	*numa_malloc(size_t size)
+  {
+#if defined(HAVE_MMAP) && defined(MAP_ANONYMOUS)
+   void	*ptr;
+
+  if (prefs.hugepage_type == HUGEPAGE_NONE)
+    return malloc(size);
+
+  size = ((size? size : 1) + NUMA_HUGEPAGESIZE-1)
+	/ NUMA_HUGEPAGESIZE * NUMA_HUGEPAGESIZE;
+#ifdef MAP_HUGETLB
+  if (prefs.hugepage_type == HUGEPAGE_EXPLICIT)
+    {
+    if ((ptr = mmap(NULL, size, PROT_READ|PROT_WRITE,
+	MAP_PRIVATE|MAP_ANONYMOUS|MAP_HUGETLB, -1, 0)) != MAP_FAILED)
+      return ptr;
+    if (!numa_hugewarnflag++)
+      warning("Not enough explicit huge pages: ",
+	"falling back to transparent huge pages");
+    }
+#endif
+  if ((ptr = mmap(NULL, size, PROT_READ|PROT_WRITE,
+	MAP_PRIVATE|MAP_ANONYMOUS, -1, 0)) == MAP_FAILED)
+    return NULL;
+#ifdef MADV_HUGEPAGE
+  madvise(ptr, size, MADV_HUGEPAGE);
+#endif
+  return ptr;
+#else
+  return malloc(size);
+#endif
+  }
+
+
+/****** numa_free ************************************************************
+PROTO	void numa_free(void *ptr, size_t size)
+PURPOSE	Free a buffer allocated with numa_malloc().
+INPUT	Pointer to the buffer,
+	size in bytes (as requested from numa_malloc()).
+OUTPUT	-.
+NOTES	-.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+void	numa_free(void *ptr, size_t size)
+  {
+  if (!ptr)
+    return;
+#if defined(HAVE_MMAP) && defined(MAP_ANONYMOUS)
+  if (prefs.hugepage_type != HUGEPAGE_NONE)
+    {
+    size = ((size? size : 1) + NUMA_HUGEPAGESIZE-1)
+	/ NUMA_HUGEPAGESIZE * NUMA_HUGEPAGESIZE;
+    munmap(ptr, size);
+    return;
+    }
+#endif
+  free(ptr);
+
+  return;
+  }
+
+
+#ifdef HAVE_SCHED_SETAFFINITY
+/****** numa_readlist ********************************************************
+PROTO	int numa_readlist(char *filename, int *list, int nmax)
+PURPOSE	Read a sysfs list of integers, such as "0-3,8-11".
+INPUT	File name,
+	pointer to the output array of integers,
+	maximum number of integers (larger values are skipped as well).
+OUTPUT	Number of integers read (0 if the file cannot be read).
+NOTES	-.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+static int	numa_readlist(char *filename, int *list, int nmax)
+  {
+   FILE		*file;
+   char		str[MAXCHAR], *pstr, *pstr2;
+   long		i, imin, imax;
+   int		n;
+
+  if (!(file = fopen(filename, "r")))
+    return 0;
+  if (!fgets(str, MAXCHAR, file))
+    *str = '\0';
+  fclose(file);
+
+  n = 0;
+  for (pstr=str; *pstr && *pstr!='\n'; pstr=pstr2+1)
+    {
+    imin = imax = strtol(pstr, &pstr2, 10);
+    if (pstr2 == pstr)
+      break;
+    if (*pstr2 == '-')
+      {
+      pstr = pstr2+1;
+      imax = strtol(pstr, &pstr2, 10);
+      }
+    for (i=imin; i<=imax && i<nmax && n<nmax; i++)
+      if (i>=0)
+        list[n++] = (int)i;
+    if (*pstr2 != ',')
+      break;
+    }
+
+  return n;
+  }
+#endif
@@ -0,0 +1,59 @@
+/*
+*				numa.h
+*
+* Include file for numa.c.
+*
+*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+*
+*	This file part of:	SWarp
+*
+*	Copyright:		(C) 2026 CEA/AIM/UParisSaclay
+*
+*	License:		GNU General Public License
+*
+*	SWarp is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*	SWarp is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU General Public License for more details.
+*	You should have received a copy of the GNU General Public License
+*	along with SWarp. If not, see <http://www.gnu.org/licenses/>.
+*
+*	Last modified:		19/10/2026
+*
+*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+
+#ifndef	_NUMA_H_
+#define	_NUMA_H_
+
+/*------------------------------- constants ---------------------------------*/
+#define	NUMA_MAXNODE		64	/* Max. number of NUMA nodes */
+#define	NUMA_HUGEPAGESIZE	(2*1024*1024)	/* Huge page size (bytes) */
+#define	NUMA_SYSDIR		"/sys/devices/system/node"
+
+/*--------------------------------- macros ----------------------------------*/
+#define	QNUMA_MALLOC(ptr, typ, nel) \
+		{if (!(ptr = (typ *)numa_malloc((size_t)(nel)*sizeof(typ)))) \
+		   { \
+		   sprintf(gstr, #ptr " (" #nel "=%zd elements) " \
+			"at line %d in module " __FILE__ " !", \
+			(size_t)(nel)*sizeof(typ), __LINE__); \
+		   error(EXIT_FAILURE, "Could not allocate memory for ", gstr);\
+                   }; \
+                 }
+
+/*------------------------------- functions ---------------------------------*/
+extern void	*numa_malloc(size_t size);
+
+extern int	numa_nnode(void),
+		numa_threadnode(int t);
+
+extern void	end_numa(void),
+		init_numa(int nthreads),
+		numa_free(void *ptr, size_t size),
+		numa_pinthread(int t);
+
+#endif
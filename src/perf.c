@@ -0,0 +1,511 @@
+/*
+*				perf.c
+*
+* Collect processing-stage timings and counters.
+*
+*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+*
+*	This file part of:	SWarp
+*
+*	Copyright:		(C) 2026 CEA/AIM/UParisSaclay
+*
+*	License:		GNU General Public License
+*
+*	SWarp is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*	SWarp is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU General Public License for more details.
+*	You should have received a copy of the GNU General Public License
+*	along with SWarp. If not, see <http://www.gnu.org/licenses/>.
+*
+*	Last modified:		19/10/2026
+*
+*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+
+#ifdef HAVE_CONFIG_H
+#include	"config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef	USE_THREADS
+#include	<pthread.h>
+#endif
+
+#include "define.h"
+#include "globals.h"
+#include "fits/fitscat.h"
+#include "misc.h"
+#include "perf.h"
+
+/*
+Each thread slot (0 for the main thread, t+1 for worker thread t) accumulates
+its measurements in its own "pending" statistics and trace buffer, without
+locking. Pending measurements are credited to an input (or to no input at all)
+by the main thread through perf_endinput(), at times when workers are idle.
+*/
+
+static perfstatstruct	*perf_pend, *perf_thread, *perf_input;
+static perftracestruct	**perf_trace;
+static double		perf_t0;
+static int		*perf_ntrace, *perf_ntracemax, *perf_ntraceflushed,
+			perf_nslots, perf_ninputs, perf_traceflag;
+
+static long		perf_counts[PERF_NCOUNT];
+#ifdef	USE_THREADS
+static pthread_mutex_t	perf_countmutex = PTHREAD_MUTEX_INITIALIZER;
+#endif
+static size_t		perf_mempeaks[PERF_NSTAGE];
+
+static char		*perf_names[PERF_NSTAGE] = {"header", "background",
+				"read", "resample", "coadd_load", "coadd_line",
+				"write"},
+			*perf_countnames[PERF_NCOUNT] = {"file_open",
+				"file_reopen", "file_evict"};
+
+/****** init_perf ************************************************************
+PROTO	void init_perf(int nslot, int traceflag)
+PURPOSE	Initialize processing-stage statistics.
+INPUT	Number of thread slots (main thread + workers),
+	Trace flag (record a timeline of events if non-zero).
+OUTPUT	-.
+NOTES	perf_add() does nothing until init_perf() has been called.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+void	init_perf(int nslot, int traceflag)
+  {
+  perf_nslots = nslot;
+  perf_ninputs = 0;
+  perf_input = NULL;
+  memset(perf_counts, 0, PERF_NCOUNT*sizeof(long));
+  memset(perf_mempeaks, 0, PERF_NSTAGE*sizeof(size_t));
+  get_rampeak(1);
+  QCALLOC(perf_thread, perfstatstruct, nslot*PERF_NSTAGE);
+  QCALLOC(perf_pend, perfstatstruct, nslot*PERF_NSTAGE);
+  if ((perf_traceflag = traceflag))
+    {
+    QCALLOC(perf_trace, perftracestruct *, nslot);
+    QCALLOC(perf_ntrace, int, nslot);
+    QCALLOC(perf_ntracemax, int, nslot);
+    QCALLOC(perf_ntraceflushed, int, nslot);
+    }
+  perf_t0 = counter_seconds();
+
+  return;
+  }
+
+
+/****** end_perf *************************************************************
+PROTO	void end_perf(void)
+PURPOSE	Free processing-stage statistics.
+INPUT	-.
+OUTPUT	-.
+NOTES	-.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+void	end_perf(void)
+  {
+   int	s;
+
+  if (perf_traceflag)
+    {
+    for (s=0; s<perf_nslots; s++)
+      free(perf_trace[s]);
+    free(perf_trace);
+    free(perf_ntrace);
+    free(perf_ntracemax);
+    free(perf_ntraceflushed);
+    perf_traceflag = 0;
+    }
+  free(perf_thread);
+  free(perf_pend);
+  free(perf_input);
+  perf_thread = perf_pend = perf_input = NULL;
+  perf_nslots = perf_ninputs = 0;
+
+  return;
+  }
+
+
+/****** perf_start ***********************************************************
+PROTO	double perf_start(void)
+PURPOSE	Return the starting time of a measurement.
+INPUT	-.
+OUTPUT	Time in seconds.
+NOTES	-.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+double	perf_start(void)
+  {
+  return perf_pend? counter_seconds() : 0.0;
+  }
+
+
+/****** perf_add *************************************************************
+PROTO	void perf_add(perfenum stage, int slot, double t0, double npix,
+			double nbytes)
+PURPOSE	Add a measurement to the pending statistics of a thread slot.
+INPUT	Processing stage,
+	thread slot,
+	starting time (from perf_start()),
+	number of pixels processed,
+	number of bytes read or written.
+OUTPUT	-.
+NOTES	Reentrant for different slots. Consecutive events of the same stage
+	separated by less than PERF_TRACEGAP are merged in the timeline.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+void	perf_add(perfenum stage, int slot, double t0, double npix,
+		double nbytes)
+  {
+   perfstatstruct	*stat;
+   perftracestruct	*trace;
+   double		t;
+
+  if (!perf_pend || slot<0 || slot>=perf_nslots)
+    return;
+
+  t = counter_seconds();
+  stat = perf_pend + slot*PERF_NSTAGE + stage;
+  if (slot == PERF_MAIN)
+    perf_memsample(stage);
+  stat->time += t - t0;
+  stat->npix += npix;
+  stat->nbytes += nbytes;
+  stat->ncall++;
+
+  if (perf_traceflag)
+    {
+    t0 -= perf_t0;
+    t -= perf_t0;
+    if (perf_ntrace[slot] > perf_ntraceflushed[slot])
+      {
+      trace = perf_trace[slot] + perf_ntrace[slot] - 1;
+      if (trace->stage == (int)stage && t0 - trace->end < PERF_TRACEGAP)
+        {
+        trace->end = t;
+        return;
+        }
+      }
+    if (perf_ntrace[slot] >= perf_ntracemax[slot])
+      {
+      perf_ntracemax[slot] += PERF_NTRACEINC;
+      if (perf_trace[slot])
+        {
+        QREALLOC(perf_trace[slot], perftracestruct, perf_ntracemax[slot]);
+        }
+      else
+        QMALLOC(perf_trace[slot], perftracestruct, perf_ntracemax[slot]);
+      }
+    trace = perf_trace[slot] + perf_ntrace[slot]++;
+    trace->start = t0;
+    trace->end = t;
+    trace->stage = (int)stage;
+    trace->input = -1;
+    }
+
+  return;
+  }
+
+
+/****** perf_endinput ********************************************************
+PROTO	void perf_endinput(int input)
+PURPOSE	Credit all pending measurements to an input and to thread statistics.
+INPUT	Input index (or -1 for measurements not related to a single input).
+OUTPUT	-.
+NOTES	Must be called from the main thread while no worker is active.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+void	perf_endinput(int input)
+  {
+   perfstatstruct	*pend, *thread, *in;
+   int			i, s, n;
+
+  if (!perf_pend)
+    return;
+
+  if (input >= perf_ninputs)
+    {
+    n = perf_ninputs;
+    perf_ninputs = input+1;
+    if (perf_input)
+      {
+      QREALLOC(perf_input, perfstatstruct, perf_ninputs*PERF_NSTAGE);
+      }
+    else
+      QMALLOC(perf_input, perfstatstruct, perf_ninputs*PERF_NSTAGE);
+    memset(perf_input+n*PERF_NSTAGE, 0,
+	(perf_ninputs-n)*PERF_NSTAGE*sizeof(perfstatstruct));
+    }
+
+  pend = perf_pend;
+  thread = perf_thread;
+  for (s=0; s<perf_nslots; s++)
+    {
+    in = input>=0? perf_input + input*PERF_NSTAGE : NULL;
+    for (i=0; i<PERF_NSTAGE; i++, pend++, thread++)
+      {
+      if (!pend->ncall)
+        continue;
+      thread->time += pend->time;
+      thread->npix += pend->npix;
+      thread->nbytes += pend->nbytes;
+      thread->ncall += pend->ncall;
+      if (in)
+        {
+        in[i].time += pend->time;
+        in[i].npix += pend->npix;
+        in[i].nbytes += pend->nbytes;
+        in[i].ncall += pend->ncall;
+        }
+      memset(pend, 0, sizeof(perfstatstruct));
+      }
+    if (perf_traceflag)
+      {
+      for (n=perf_ntraceflushed[s]; n<perf_ntrace[s]; n++)
+        perf_trace[s][n].input = input;
+      perf_ntraceflushed[s] = perf_ntrace[s];
+      }
+    }
+
+  return;
+  }
+
+
+/****** perf_ninput **********************************************************
+PROTO	int perf_ninput(void)
+PURPOSE	Return the number of inputs with statistics.
+INPUT	-.
+OUTPUT	Number of inputs.
+NOTES	-.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+int	perf_ninput(void)
+  {
+  return perf_ninputs;
+  }
+
+
+/****** perf_nslot ***********************************************************
+PROTO	int perf_nslot(void)
+PURPOSE	Return the number of thread slots.
+INPUT	-.
+OUTPUT	Number of thread slots (0 if statistics are not initialized).
+NOTES	-.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+int	perf_nslot(void)
+  {
+  return perf_nslots;
+  }
+
+
+/****** perf_inputstat *******************************************************
+PROTO	perfstatstruct *perf_inputstat(int input)
+PURPOSE	Return the statistics of an input.
+INPUT	Input index.
+OUTPUT	Pointer to an array of PERF_NSTAGE statistics.
+NOTES	-.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+perfstatstruct	*perf_inputstat(int input)
+  {
+  return perf_input + input*PERF_NSTAGE;
+  }
+
+
+/****** perf_threadstat ******************************************************
+PROTO	perfstatstruct *perf_threadstat(int slot)
+PURPOSE	Return the statistics of a thread slot.
+INPUT	Thread slot.
+OUTPUT	Pointer to an array of PERF_NSTAGE statistics.
+NOTES	-.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+perfstatstruct	*perf_threadstat(int slot)
+  {
+  return perf_thread + slot*PERF_NSTAGE;
+  }
+
+
+/****** perf_count ***********************************************************
+PROTO	void perf_count(perfcountenum count, long n)
+PURPOSE	Increment an event counter.
+INPUT	Counter,
+	increment.
+OUTPUT	-.
+NOTES	Thread-safe. Counters are reset by init_perf() but remain available
+	after end_perf().
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+void	perf_count(perfcountenum count, long n)
+  {
+#ifdef	USE_THREADS
+  pthread_mutex_lock(&perf_countmutex);
+#endif
+  perf_counts[count] += n;
+#ifdef	USE_THREADS
+  pthread_mutex_unlock(&perf_countmutex);
+#endif
+
+  return;
+  }
+
+
+/****** perf_counter *********************************************************
+PROTO	long perf_counter(perfcountenum count)
+PURPOSE	Return the value of an event counter.
+INPUT	Counter.
+OUTPUT	Counter value.
+NOTES	-.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+long	perf_counter(perfcountenum count)
+  {
+  return perf_counts[count];
+  }
+
+
+/****** perf_memsample ******************************************************
+PROTO	void perf_memsample(perfenum stage)
+PURPOSE	Credit the peak amount of memory booked since the last sample to a
+	processing stage.
+INPUT	Processing stage.
+OUTPUT	-.
+NOTES	Must be called by the main thread at the end of a stage (perf_add()
+	does it for main thread measurements). Stages run sequentially in
+	the main thread, hence the peak since the last sample belongs to the
+	current stage.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+void	perf_memsample(perfenum stage)
+  {
+   size_t	peak;
+
+  if ((peak = get_rampeak(1)) > perf_mempeaks[stage])
+    perf_mempeaks[stage] = peak;
+
+  return;
+  }
+
+
+/****** perf_mempeak *********************************************************
+PROTO	size_t perf_mempeak(perfenum stage)
+PURPOSE	Return the peak amount of memory booked during a processing stage.
+INPUT	Processing stage.
+OUTPUT	Amount of memory (in bytes).
+NOTES	Memory is booked through reserve_ram() (MEM_MAX budget). Peaks are
+	only measured for main thread stages. They are reset by init_perf()
+	but remain available after end_perf().
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+size_t	perf_mempeak(perfenum stage)
+  {
+  return perf_mempeaks[stage];
+  }
+
+
+/****** perf_countname *******************************************************
+PROTO	char *perf_countname(perfcountenum count)
+PURPOSE	Return the name of an event counter.
+INPUT	Counter.
+OUTPUT	Pointer to the name.
+NOTES	-.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+char	*perf_countname(perfcountenum count)
+  {
+  return perf_countnames[count];
+  }
+
+
+/****** perf_stagename *******************************************************
+PROTO	char *perf_stagename(perfenum stage)
+PURPOSE	Return the name of a processing stage.
+INPUT	Processing stage.
+OUTPUT	Pointer to the name.
+NOTES	-.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+char	*perf_stagename(perfenum stage)
+  {
+  return perf_names[stage];
+  }
+
+
+/****** write_perftrace ******************************************************
+PROTO	int write_perftrace(char *filename)
+PURPOSE	Save the timeline of processing events in Chrome trace (JSON) format.
+INPUT	Output filename.
+OUTPUT	RETURN_OK if everything went fine, RETURN_ERROR otherwise.
+NOTES	Timestamps are in microseconds from init_perf(). The file can be
+	viewed with chrome://tracing or Perfetto.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+int	write_perftrace(char *filename)
+  {
+   FILE			*file;
+   perftracestruct	*trace;
+   int			n, s, sepflag;
+
+  if (!perf_traceflag)
+    return RETURN_ERROR;
+
+  if (!(file = fopen(filename, "w")))
+    return RETURN_ERROR;
+
+  fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+  sepflag = 0;
+  for (s=0; s<perf_nslots; s++)
+    {
+    if (!perf_ntrace[s] && s!=PERF_MAIN)
+      continue;
+    if (s==PERF_MAIN)
+      fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,"
+	"\"tid\":%d,\"args\":{\"name\":\"main\"}}", sepflag? ",\n":"", s);
+    else
+      fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,"
+	"\"tid\":%d,\"args\":{\"name\":\"worker %d\"}}",
+	sepflag? ",\n":"", s, s-1);
+    sepflag = 1;
+    for (trace=perf_trace[s], n=perf_ntrace[s]; n--; trace++)
+      {
+      fprintf(file, ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\","
+	"\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%d",
+	perf_names[trace->stage], BANNER,
+	trace->start*1e6, (trace->end-trace->start)*1e6, s);
+      if (trace->input>=0)
+        fprintf(file, ",\"args\":{\"input\":%d}", trace->input+1);
+      fprintf(file, "}");
+      }
+    }
+  fprintf(file, "\n]}\n");
+
+  if (fclose(file))
+    return RETURN_ERROR;
+
+  return RETURN_OK;
+  }
+
@@ -0,0 +1,85 @@
+/*
+*				perf.h
+*
+* Include file for perf.c.
+*
+*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+*
+*	This file part of:	SWarp
+*
+*	Copyright:		(C) 2026 CEA/AIM/UParisSaclay
+*
+*	License:		GNU General Public License
+*
+*	SWarp is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*	SWarp is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU General Public License for more details.
+*	You should have received a copy of the GNU General Public License
+*	along with SWarp. If not, see <http://www.gnu.org/licenses/>.
+*
+*	Last modified:		19/10/2026
+*
+*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+
+#ifndef	_PERF_H_
+#define	_PERF_H_
+
+/*------------------------------- constants ---------------------------------*/
+#define	PERF_MAIN	0	/* Slot of the main thread */
+#define	PERF_TRACEGAP	1e-3	/* Max. gap for merging trace events (s) */
+#define	PERF_NTRACEINC	1024	/* Trace event buffer increment */
+
+/*--------------------------------- typedefs --------------------------------*/
+typedef enum	{PERF_HEADER, PERF_BACK, PERF_READ, PERF_WARP,
+		PERF_COADDLOAD, PERF_COADDLINE, PERF_WRITE, PERF_NSTAGE}
+		perfenum;
+typedef enum	{PERF_FILEOPEN, PERF_FILEREOPEN, PERF_FILEEVICT, PERF_NCOUNT}
+		perfcountenum;
+
+/*-------------------------- structure definitions --------------------------*/
+typedef struct perfstat
+  {
+  double	time;			/* Cumulated wall-clock time (s) */
+  double	npix;			/* Number of pixels processed */
+  double	nbytes;			/* Number of bytes read or written */
+  long		ncall;			/* Number of measurements */
+  }	perfstatstruct;
+
+typedef struct perftrace
+  {
+  double	start, end;		/* Event boundaries (s) */
+  int		stage;			/* Processing stage */
+  int		input;			/* Input index (or -1) */
+  }	perftracestruct;
+
+/*------------------------------- functions ---------------------------------*/
+extern double	perf_start(void);
+
+extern char	*perf_countname(perfcountenum count),
+		*perf_stagename(perfenum stage);
+
+extern long	perf_counter(perfcountenum count);
+
+extern int	perf_ninput(void),
+		perf_nslot(void),
+		write_perftrace(char *filename);
+
+extern size_t		perf_mempeak(perfenum stage);
+
+extern perfstatstruct	*perf_inputstat(int input),
+			*perf_threadstat(int slot);
+
+extern void	end_perf(void),
+		init_perf(int nslot, int traceflag),
+		perf_add(perfenum stage, int slot, double t0, double npix,
+			double nbytes),
+		perf_count(perfcountenum count, long n),
+		perf_endinput(int input),
+		perf_memsample(perfenum stage);
+
+#endif
@@ -22,7 +22,7 @@
 *	You should have received a copy of the GNU General Public License
 *	along with SWarp. If not, see <http://www.gnu.org/licenses/>.
 *
-*	Last modified:		25/11/2020
+*	Last modified:		19/10/2026
 *
 *%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
 
@@ -52,9 +52,12 @@ int idummy;
 
 pkeystruct key[] =
  {
+  {"BACK_CACHE", P_STRINGLIST, prefs.backcache_name, 0,0, 0.0,0.0,
+   {""}, 0, 1, &prefs.nbackcache_name},
   {"BACK_DEFAULT", P_FLOATLIST, prefs.back_default, 1,7, -BIG, BIG,
    {""}, 1, MAXINFIELD, &prefs.nback_default},
   {"BACK_FILTTHRESH", P_FLOAT, &prefs.back_fthresh, 0,0, -BIG, BIG},
+  {"BACK_SAMPLING", P_INT, &prefs.back_sampling, 1,1000000},
   {"BACK_SIZE", P_INTLIST, prefs.back_size, 1,2000000000, 0.0,0.0,
    {""}, 1, MAXINFIELD, &prefs.nback_size},
   {"BACK_FILTERSIZE", P_INTLIST, prefs.back_fsize, 1,7, 0.0,0.0,
@@ -82,6 +85,8 @@ pkeystruct key[] =
 	"CHI_OLD", "CHI-MODE", "CHI-MEAN", "SUM",
 	"WEIGHTED_WEIGHT", "MEDIAN_WEIGHT",
 	"AND", "NAND", "OR", "NOR", ""}},
+  {"COMBINE_STATE", P_KEY, &prefs.state_type, 0,0, 0.0,0.0,
+   {"NONE", "ADD", "REMOVE", ""}},
   {"COPY_KEYWORDS", P_STRINGLIST, prefs.copy_keywords, 0,0, 0.0, 0.0,
    {""}, 0, 1024, &prefs.ncopy_keywords},
   {"DELETE_TMPFILES", P_BOOL, &prefs.removetmp_flag},
@@ -106,15 +111,20 @@ pkeystruct key[] =
    {""}, 0, MAXINFIELD, &prefs.ninhead_name},
   {"HEADER_ONLY", P_BOOL, &prefs.headeronly_flag},
   {"HEADER_SUFFIX", P_STRING, prefs.head_suffix},
+  {"HUGE_PAGES", P_KEY, &prefs.hugepage_type, 0,0, 0.0,0.0,
+   {"NONE", "TRANSPARENT", "EXPLICIT", ""}},
   {"IMAGEOUT_NAME", P_STRING, prefs.outfield_name},
   {"IMAGE_SIZE", P_INTLIST, prefs.image_size, 0, 2000000000, 0.0, 0.0,
    {""}, 1, INTERP_MAXDIM, &prefs.nimage_size},
   {"INTERPOLATE", P_BOOLLIST, prefs.interp_flag, 0,0, 0.0,0.0,
    {""}, 1, MAXINFIELD, &prefs.ninterp_flag},
   {"MEM_MAX", P_INT, &prefs.mem_max, 1, 1000000000},
+  {"METADATA_CACHE", P_STRINGLIST, prefs.metacache_name, 0,0, 0.0,0.0,
+   {""}, 0, 1, &prefs.nmetacache_name},
   {"NNODES", P_INT, &prefs.nnodes, 1, 65535},
   {"NOPENFILES_MAX", P_INT, &prefs.nopenfiles_max, 0, 1000000000},
   {"NTHREADS", P_INT, &prefs.nthreads, 0, THREADS_PREFMAX},
+  {"NUMA_AFFINITY", P_BOOL, &prefs.numa_flag},
   {"NODE_INDEX", P_INT, &prefs.node_index, -1, 65534},
   {"OVERSAMPLING", P_INTLIST, prefs.oversamp, 0, 2000000000, 0.0,0.0,
    {""}, 1, INTERP_MAXDIM, &prefs.noversamp},
@@ -127,8 +137,14 @@ pkeystruct key[] =
    {""}, 1, MAXINFIELD, &prefs.nproj_err},
   {"PROJECTION_TYPE", P_STRING, prefs.projection_name},
   {"RESAMPLE", P_BOOL, &prefs.resample_flag},
+  {"RESAMPLE_COMPRESS", P_KEY, &prefs.resamp_pack, 0,0, 0.0,0.0,
+   {"NONE", "SHUFFLE", "FLOAT16", ""}},
   {"RESAMPLE_DIR", P_STRING, prefs.resampdir_name},
+  {"RESAMPLE_FORMAT", P_KEY, &prefs.resamp_format, 0,0, 0.0,0.0,
+   {"FITS", "COMPACT", ""}},
   {"RESAMPLE_SUFFIX", P_STRING, prefs.resamp_suffix},
+  {"RESAMPLE_WEIGHTONLY", P_KEY, &prefs.resamp_wonly, 0,0, 0.0,0.0,
+   {"NONE", "MAX", "AREA", ""}},
   {"RESAMPLING_TYPE", P_KEYLIST, prefs.resamp_type, 0,0, 0.0,0.0,
    {"FLAGS", "NEAREST", "BILINEAR", "LANCZOS2", "LANCZOS3", "LANCZOS4", ""},
    1, INTERP_MAXDIM, &prefs.nresamp_type},
@@ -136,11 +152,18 @@ pkeystruct key[] =
    {""}, 1, MAXINFIELD, &prefs.nwscale_flag},
   {"SATLEV_DEFAULT", P_FLOATLIST, prefs.sat_default, 0,0, -BIG, BIG,
    {""}, 1, MAXINFIELD, &prefs.nsat_default},
+  {"STATE_NAME", P_STRING, prefs.state_name},
+  {"SKYTILE_SIZE", P_INTLIST, prefs.skytile_size, 0, 2000000000, 0.0, 0.0,
+   {""}, 1, 2, &prefs.nskytile_size},
+  {"SKYTILE_TYPE", P_KEY, &prefs.skytile_type, 0,0, 0.0,0.0,
+   {"FILES", "MEF", ""}},
   {"SUBTRACT_BACK", P_BOOLLIST, prefs.subback_flag, 0,0, 0.0,0.0,
    {""}, 1, MAXINFIELD, &prefs.nsubback_flag},
 #ifdef HAVE_CFITSIO
   {"TILE_COMPRESS", P_BOOL, &prefs.tile_compress_flag},
 #endif
+  {"TRACE_NAME", P_STRINGLIST, prefs.trace_name, 0,0, 0.0,0.0,
+   {""}, 0, 1, &prefs.ntrace_name},
   {"VERBOSE_TYPE", P_KEY, &prefs.verbose_type, 0,0, 0.0,0.0,
    {"QUIET", "LOG", "NORMAL", "FULL", ""}},
   {"VMEM_DIR", P_STRING, prefs.swapdir_name},
@@ -154,6 +177,7 @@ pkeystruct key[] =
   {"WEIGHT_TYPE", P_KEYLIST, prefs.weight_type, 0,0, 0.0,0.0,
    {"NONE", "BACKGROUND", "MAP_RMS", "MAP_VARIANCE", "MAP_WEIGHT", ""},
    1, MAXINFIELD, &prefs.nweight_type},
+  {"WRITE_CHECKSUM", P_BOOL, &prefs.checksum_flag},
   {"WRITE_FILEINFO", P_BOOL, &prefs.writefileinfo_flag},
   {"WRITE_XML", P_BOOL, &prefs.xml_flag},
   {"XML_NAME", P_STRING, prefs.xml_name},
@@ -177,6 +201,8 @@ char *default_prefs[] =
 "*HEADER_NAME                            # Header filename if suffix not used",
 "HEADER_ONLY            N               # Only a header as an output file (Y/N)?",
 "HEADER_SUFFIX          .head           # Filename extension for additional headers",
+"*SKYTILE_SIZE           0               # Output sky tile size (0 = no tiling)",
+"*SKYTILE_TYPE           FILES           # FILES (one file per tile) or MEF",
 #ifdef HAVE_CFITSIO
 "*TILE_COMPRESS          N               # Write tile compressed output image (Y/N)?",
 #endif
@@ -215,6 +241,9 @@ char *default_prefs[] =
 "*CLIP_LOGNAME           clipped.log     # Name of output file with coordinates",
 "*                                       # of clipped pixels",
 "*BLANK_BADPIXELS        N               # Set to 0 pixels having a weight of 0",
+"*COMBINE_STATE          NONE            # Incremental co-addition: NONE, ADD",
+"*                                       # or REMOVE inputs from the state",
+"*STATE_NAME             coadd.state     # Co-addition state filename",
 " ",
 "#-------------------------------- Astrometry ----------------------------------",
 " ",
@@ -234,6 +263,13 @@ char *default_prefs[] =
 "RESAMPLE               Y               # Resample input images (Y/N)?",
 "RESAMPLE_DIR           .               # Directory path for resampled images",
 "RESAMPLE_SUFFIX        .resamp.fits    # filename extension for resampled images",
+"*RESAMPLE_FORMAT        FITS            # FITS or COMPACT (temporary files for",
+"*                                       # COMBINE only)",
+"*RESAMPLE_COMPRESS      NONE            # NONE, SHUFFLE (lossless) or FLOAT16",
+"*                                       # packing of COMPACT resampled files",
+"*RESAMPLE_WEIGHTONLY    NONE            # Resample only weights: NONE, MAX (over",
+"*                                       # the RESAMPLING_TYPE kernel) or AREA",
+"*                                       # (nearest, averaged over OVERSAMPLING)",
 " ",
 "RESAMPLING_TYPE        LANCZOS3        # NEAREST,BILINEAR,LANCZOS2,LANCZOS3",
 "                                       # LANCZOS4 (1 per axis) or FLAGS",
@@ -268,6 +304,10 @@ char *default_prefs[] =
 "                                       # (all or for each image)",
 "*BACK_FILTTHRESH        0.0             # Threshold above which the background-",
 "*                                       # map filter operates",
+"*BACK_SAMPLING          1               # Take background statistics from 1 line",
+"*                                       # out of BACK_SAMPLING (1 = all lines)",
+"*BACK_CACHE                             # Directory for caching background maps",
+"*                                       # between runs (none if empty)",
 " ",
 "#------------------------------ Memory management -----------------------------",
 " ",
@@ -275,6 +315,8 @@ char *default_prefs[] =
 "VMEM_MAX               2047            # Maximum amount of virtual memory (MB)",
 "MEM_MAX                256             # Maximum amount of usable RAM (MB)",
 "COMBINE_BUFSIZE        256             # RAM dedicated to co-addition(MB)",
+"*HUGE_PAGES             NONE            # Huge pages for co-addition buffers:",
+"*                                       # NONE, TRANSPARENT or EXPLICIT",
 " ",
 "#------------------------------ Miscellaneous ---------------------------------",
 " ",
@@ -284,10 +326,14 @@ char *default_prefs[] =
 "                                       # from the input to the output headers",
 "WRITE_FILEINFO         N               # Write information about each input",
 "                                       # file in the output image header?",
+"WRITE_CHECKSUM         N               # Write CHECKSUM and DATASUM keywords",
+"                                       # in output image headers (Y/N)?",
 "WRITE_XML              Y               # Write XML file (Y/N)?",
 "XML_NAME               swarp.xml       # Filename for XML output",
 "*XSL_URL                " XSL_URL,
 "*                                       # Filename for XSL style-sheet",
+"*TRACE_NAME                             # Filename for a JSON timeline of",
+"*                                       # processing stages (none if empty)",
 "VERBOSE_TYPE           NORMAL          # QUIET,LOG,NORMAL, or FULL",
 "*NNODES                 1               # Number of nodes (for clusters)",
 "*NODE_INDEX             0               # Node index (for clusters)",
@@ -299,8 +345,12 @@ char *default_prefs[] =
 #else
 "NTHREADS               1               # 1 single thread",
 #endif
+"*NUMA_AFFINITY          N               # Pin threads and place buffers on",
+"*                                       # NUMA nodes (Y/N)?",
 "*NOPENFILES_MAX         512             # Maximum number of files opened by "
 					BANNER,
+"*METADATA_CACHE                         # Directory for caching input headers",
+"*                                       # between runs (none if empty)",
 ""
  };
 
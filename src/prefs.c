@@ -24,7 +24,7 @@
 *	You should have received a copy of the GNU General Public License
 *	along with SWarp. If not, see <http://www.gnu.org/licenses/>.
 *
-*	Last modified:		04/11/2020
+*	Last modified:		19/10/2026
 *
 *%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
 
@@ -581,7 +581,73 @@ void	useprefs(void)
       }
     }   
 
-/* Check header filenames */ 
+/* Compact resampled files are only readable by the co-addition step */
+  if (prefs.resamp_format == RESAMPFORMAT_COMPACT && !prefs.combine_flag)
+    {
+    prefs.resamp_format = RESAMPFORMAT_FITS;
+    warning("RESAMPLE_FORMAT COMPACT requires COMBINE Y: ",
+	"Forcing to FITS");
+    }
+
+/* Distributed co-additions */
+  if (prefs.node_index >= prefs.nnodes)
+    error(EXIT_FAILURE, "*Error*: NODE_INDEX must be lower than NNODES", "");
+  if (prefs.nnodes>1 && prefs.node_index>=0)
+    {
+    if (prefs.state_type != STATE_NONE)
+      {
+      prefs.state_type = STATE_NONE;
+      warning("COMBINE_STATE is not compatible with NNODES > 1: ",
+	"Forcing to NONE");
+      }
+    if (prefs.skytile_size[0] || prefs.skytile_size[1])
+      {
+      prefs.skytile_size[0] = prefs.skytile_size[1] = 0;
+      warning("SKYTILE_SIZE is not compatible with NNODES > 1: ",
+	"Forcing to 0");
+      }
+    }
+
+/* Incremental co-additions only work with linear combinations */
+  if (prefs.state_type != STATE_NONE)
+    {
+    if (!prefs.combine_flag)
+      prefs.state_type = STATE_NONE;
+    else if (prefs.coadd_type != COADD_WEIGHTED
+	&& prefs.coadd_type != COADD_AVERAGE
+	&& prefs.coadd_type != COADD_SUM)
+      {
+      prefs.state_type = STATE_NONE;
+      warning("COMBINE_STATE requires COMBINE_TYPE WEIGHTED, AVERAGE or SUM: ",
+	"Forcing to NONE");
+      }
+    else if (prefs.skytile_size[0] || prefs.skytile_size[1])
+      {
+      prefs.state_type = STATE_NONE;
+      warning("COMBINE_STATE is not compatible with SKYTILE_SIZE: ",
+	"Forcing to NONE");
+      }
+    }
+
+/* Check the metadata cache directory */
+  if (prefs.nmetacache_name && *prefs.metacache_name[0]
+	&& access(prefs.metacache_name[0], W_OK|X_OK))
+    {
+    warning("Cannot write to metadata cache directory ",
+	prefs.metacache_name[0]);
+    prefs.nmetacache_name = 0;
+    }
+
+/* Check the background map cache directory */
+  if (prefs.nbackcache_name && *prefs.backcache_name[0]
+	&& access(prefs.backcache_name[0], W_OK|X_OK))
+    {
+    warning("Cannot write to background map cache directory ",
+	prefs.backcache_name[0]);
+    prefs.nbackcache_name = 0;
+    }
+
+/* Check header filenames */
   if (prefs.ninhead_name && prefs.ninhead_name != prefs.ninfield)
       warning("The numbers of input headers and images do not match: ",
 		"the last images will rely only on the header suffix");
@@ -802,6 +868,10 @@ void	useprefs(void)
   for (i=prefs.nimage_size; i<INTERP_MAXDIM; i++)
     prefs.image_size[i] = prefs.image_size[prefs.nimage_size-1];
   prefs.nimage_size = INTERP_MAXDIM;
+/* Sky tile size */
+  for (i=prefs.nskytile_size; i<2; i++)
+    prefs.skytile_size[i] = prefs.skytile_size[prefs.nskytile_size-1];
+  prefs.nskytile_size = 2;
 
 /* Check projection type */
   if (wcs_supproj(prefs.projection_name))
@@ -22,7 +22,7 @@
 *	You should have received a copy of the GNU General Public License
 *	along with SWarp. If not, see <http://www.gnu.org/licenses/>.
 *
-*	Last modified:		28/10/2020
+*	Last modified:		19/10/2026
 *
 *%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
 
@@ -42,6 +42,10 @@
 #include "coadd.h"
 #endif
 
+#ifndef _COMPACT_H_
+#include "compact.h"
+#endif
+
 #ifndef _INTERPOLATE_H_
 #include "interpolate.h"
 #endif
@@ -85,6 +89,10 @@ typedef struct
   char		*(outhead_name[MAXINFIELD]);/* Output header filename */
   int		nouthead_name;		/* 0 or 1 */
   int		outfield_bitpix;	/* Output image pixel type */
+  int		skytile_size[2];	/* Output sky tile size (0=no tiling) */
+  int		nskytile_size;		/* nb of params */
+  enum {SKYTILE_FILES, SKYTILE_MEF}
+		skytile_type;		/* Output sky tile file type */
 // Weight settings
   weightenum	weight_type[MAXINFIELD];/* Weight type */
   int		nweight_type;		/* nb of params */
@@ -110,6 +118,9 @@ typedef struct
   double	back_default[MAXINFIELD];/* Default background in MANUAL */
   int		nback_default;		/* nb of params */
   double	back_fthresh;		/* Background filter threshold */
+  int		back_sampling;		/* Background line sampling step */
+  char		*(backcache_name[1]);	/* Background map cache directory */
+  int		nbackcache_name;	/* 0 or 1 */
   char		gain_keyword[MAXCHAR];	/* FITS keyword for gain */
   double	gain_default[MAXINFIELD];/* Default gain (e-/ADU) */
   int		ngain_default;		/* nb of params */
@@ -131,6 +142,9 @@ typedef struct
   int		clip_logflag;		/* Save clipping logfile? */
   char		clip_logname[MAXCHAR];	/* filename for clipping log */
   int		blank_flag;		/* Blank pixels with a weight of 0? */
+  enum {STATE_NONE, STATE_ADD, STATE_REMOVE}
+		state_type;		/* Incremental co-addition mode */
+  char		state_name[MAXCHAR];	/* Co-addition state filename */
 /* Output image coordinates */
   char		projection_name[MAXCHAR];/* Projection WCS code */
   celsysenum	celsys_type;		/* Celestial system type */
@@ -157,23 +171,36 @@ typedef struct
   char		swapdir_name[MAXCHAR];	/* Name of virtual mem directory */
 
   char		resampdir_name[MAXCHAR];/* Name of resampling directory */
+  enum {RESAMPFORMAT_FITS, RESAMPFORMAT_COMPACT}
+		resamp_format;		/* Format of resampled files */
+  cpackenum	resamp_pack;		/* Packing of compact resampled files */
+  enum {RESAMPWEIGHT_NONE, RESAMPWEIGHT_MAX, RESAMPWEIGHT_AREA}
+		resamp_wonly;		/* Resample weight maps only? */
   int		coaddbuf_size;		/* Amount of RAM for coadd buffer */
 /* Multithreading */
   int		nthreads;		/* Number of active threads */
+  int		numa_flag;		/* Pin threads to NUMA nodes? */
+  enum {HUGEPAGE_NONE, HUGEPAGE_TRANSPARENT, HUGEPAGE_EXPLICIT}
+		hugepage_type;		/* Huge pages for large buffers */
 /* Misc */
   int		combine_flag;		/* Write coadded image? */
   int		headeronly_flag;	/* Restrict output to a header? */
   int		resample_flag;		/* Resample input images? */
   int		writefileinfo_flag;	/* Write info for each input file ? */
+  int		checksum_flag;		/* Write FITS checksums? */
   char		*(copy_keywords[1024]);	/* FITS keywords to be propagated */
   int		ncopy_keywords;		/* nb of params */
   int		nnodes;			/* Number of nodes (for clusters) */  
   int		node_index;		/* Node index (for multiprocessing) */ 
   int		nopenfiles_max;		/* Max. number of files opened */
+  char		*(metacache_name[1]);	/* Input metadata cache directory */
+  int		nmetacache_name;	/* 0 or 1 */
   enum {QUIET, LOG, NORM, FULL}	verbose_type;	/* display type */
   int		xml_flag;		/* Write XML file? */
   char		xml_name[MAXCHAR];	/* XML file name */
   char		xsl_name[MAXCHAR];	/* XSL file name (or URL) */
+  char		*(trace_name[1]);	/* Timeline (trace) file name */
+  int		ntrace_name;		/* 0 or 1 */
   char		sdate_start[12];	/* SWarp start date */
   char		stime_start[12];	/* SWarp start time */
   char		sdate_end[12];		/* SWarp end date */
@@ -22,7 +22,7 @@
 *	You should have received a copy of the GNU General Public License
 *	along with SWarp. If not, see <http://www.gnu.org/licenses/>.
 *
-*	Last modified:		19/07/2013
+*	Last modified:		19/10/2026
 *
 *%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
 
@@ -485,7 +485,7 @@ OUTPUT	-.
 NOTES	Pixel area are computed only if areaout != NULL.
 	Currently limited to 2D vectors.
 AUTHOR	E. Bertin (IAP)
-VERSION	03/01/2008
+VERSION	19/10/2026
  ***/
 void	projapp_line(projappstruct *projapp, double *startposin, double step,
 		int npos, double *posout, double *areaout)
@@ -547,7 +547,7 @@ void	projapp_line(projappstruct *projapp, double *startposin, double step,
     dy3 = (dy*dy*dy-dy);
     cdy3 = (cdy*cdy*cdy-cdy);
     ylstep = nbx*yl;
-    nxnodes = (int)(dx+npos*xstep) + 1;
+    nxnodes = (int)(dx+(npos-1)*xstep) + 2;
     if (nxnodes > (nbx-xl))
       nxnodes = nbx - xl;
     QMALLOC(node, double, nxnodes);	/* Interpolated map */
@@ -24,7 +24,7 @@
 *	You should have received a copy of the GNU General Public License
 *	along with SWarp. If not, see <http://www.gnu.org/licenses/>.
 *
-*	Last modified:		20/03/2025
+*	Last modified:		19/10/2026
 *
 *%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
 
@@ -45,11 +45,15 @@
 #include "types.h"
 #include "globals.h"
 #include "fits/fitscat.h"
+#include "compact.h"
 #include "fitswcs.h"
 #include "data.h"
 #include "field.h"
+#include "footprint.h"
 #include "header.h"
 #include "interpolate.h"
+#include "node.h"
+#include "perf.h"
 #include "prefs.h"
 #include "projapprox.h"
 #include "resample.h"
@@ -57,40 +61,50 @@
 #include "threads.h"
 #endif
 #include "weight.h"
+#include "writer.h"
 #include "wcs/wcs.h"
 
 #ifdef USE_THREADS
- pthread_t		*rthread;
  pthread_mutex_t	linemutex;
  pthread_cond_t		*linecond;
- tabstruct		*ftab, *wtab;
- int			*queue,*proc,*writeflag,
+ int			*queue,*proc,*writeflag, *nextseg,*segleft,
 			absline,procline,writeline;
 #else
  extern int		nproc;
 #endif
 
  fieldstruct		*infield, *inwfield, *indgeofield, *field, *wfield;
+ static writerstruct	*writer, *wwriter;
  ikernelstruct		**ikernel;
- wcsstruct		**wcsinp, **wcsoutp;
  projappstruct		*projapp;
  double			rawmin[NAXIS], rawmax[NAXIS],rawpos0[NAXIS],
 			stepover[NAXIS],
-			**rawposp, **rawbuf, **oversampbuf,**oversampwbuf,
-			**rawbufarea,
-			ascale;
+			**rawposp, **rawbuf, **rawdbuf, **rawbufarea, **wcsbuf,
+			**rawsubbuf, **rawsubbufarea,
+			*suboffset,
+			ascale, oversamperr;
  PIXTYPE		**routbuf,**routwbuf;
- FLAGTYPE		**routibuf,**routwibuf, **oversampibuf,**oversampwibuf;
- int			**oversampnbuf, *oversamp,
-			noversamp, oversampflag, width, height, naxis, nlines,
-			approxflag, dispstep, riflag;
+ FLAGTYPE		**routibuf,**routwibuf;
+ int			*oversamp,
+			noversamp, oversampflag, jacflag,
+			width, height, naxis, nlines, nseg, segwidth,
+			approxflag, dispstep, riflag, compactflag, swapflag,
+			wonlyflag;
 
 /*------------------------------ function -----------------------------------*/
 #ifdef USE_THREADS
-static int		pthread_nextline(int l);
+static int		pthread_nextline(int l, int t, int *s);
 static void		*pthread_warp_lines(void *arg);
 #endif
-static void		warp_line(int p);
+static int		warp_jacobian(int t, int x, double jac[][NAXIS]);
+static void		warp_coords(int t, double *rawpos, double step, int n,
+				double *rawout, double *areaout),
+			warp_line(int l, int t, int s),
+			warp_subcoords(int t, double *rawpos, int npix,
+				double *rawout, double *areaout),
+			warp_wcsline(int t, double *rawpos, double step, int n,
+				double *rawout, double *areaout),
+			write_line(int l, int t);
 
 
 /****** resample_field *******************************************************
@@ -108,9 +122,10 @@ INPUT	Input pointer to field structure pointer,
 	Output
 OUTPUT	-.
 NOTES	The structure pointers pointed by pinfield and and pinwfield are
-	updated and point to the resampled fields on output.
+	updated and point to the resampled fields on output. In weight-only
+	mode (RESAMPLE_WEIGHTONLY), resampled image pixels are set to zero.
 AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
-VERSION	20/03/2025
+VERSION	19/10/2026
  ***/
 void	resample_field(fieldstruct **pinfield, fieldstruct **pinwfield,
 		fieldstruct **pindgeofield,
@@ -118,18 +133,19 @@ void	resample_field(fieldstruct **pinfield, fieldstruct **pinwfield,
 		interpenum *interptype)
   {
 #ifdef USE_THREADS
-   static pthread_attr_t	pthread_attr;
-   int				p;
+   threads_job_t		*job;
 #else
    int				y;
 #endif
    wcsstruct		wcsloc,
 			*wcs;
+   interpenum		winterptype[INTERP_MAXDIM];
    static char		filename[MAXCHAR],filename2[MAXCHAR],
 			resampext1[MAXCHAR], resampext2[MAXCHAR];
    char			*pstr;
    double		ascale1, projerr;
-   int			d, l;
+   size_t		bufsize;
+   int			d, l, n, o, p;
 
   infield = *pinfield;
   inwfield = *pinwfield;
@@ -148,12 +164,30 @@ void	resample_field(fieldstruct **pinfield, fieldstruct **pinwfield,
     *pstr = '\0';
   if (infield->version>1)
     sprintf(pstr, "_v%d", infield->version);
+
+/* Get resampled suffix extension if available */
+  strcpy(resampext1, prefs.resamp_suffix);
+  *resampext2 = '\0';
+  if ((pstr=strrchr(resampext1, '.')))
+    {
+    strcpy(resampext2, pstr);
+    *pstr = '\0';
+    }
+/* Compact files have their own extension */
+  compactflag = (prefs.resamp_format == RESAMPFORMAT_COMPACT);
+  if (compactflag)
+    strcpy(resampext2, COMPACT_EXT);
+/* Nodes sharing an input must not share its resampled version */
+  if (NODE_ACTIVE && prefs.combine_flag)
+    sprintf(resampext1+strlen(resampext1), "%s%04d", NODE_EXT,
+		prefs.node_index);
+
   if (infield->frameno)
-    sprintf(filename, "%s/%s.%04d%s", prefs.resampdir_name, filename2,
-				infield->frameno, prefs.resamp_suffix);
+    sprintf(filename, "%s/%s.%04d%s%s", prefs.resampdir_name, filename2,
+				infield->frameno, resampext1, resampext2);
   else
-    sprintf(filename, "%s/%s%s", prefs.resampdir_name, filename2,
-				prefs.resamp_suffix);
+    sprintf(filename, "%s/%s%s%s", prefs.resampdir_name, filename2,
+				resampext1, resampext2);
 
 /* We make a copy of the output field */
   field = inherit_field(filename, outfield, FIELD_WRITE);
@@ -167,11 +201,21 @@ void	resample_field(fieldstruct **pinfield, fieldstruct **pinwfield,
   field->fsaturation = infield->fsaturation;
   field->exptime = infield->exptime;
   field->fieldno = infield->fieldno;
+  field->inputno = infield->inputno;
   field->fascale = infield->fascale;
   field->fscale = infield->fscale;
   field->headflag = infield->headflag;
   strcpy(field->ident, infield->ident);
   riflag = (outfield->bitpix>0);
+/* Weight-only resampling does not touch the image pixels */
+  wonlyflag = (!riflag && prefs.resamp_wonly != RESAMPWEIGHT_NONE);
+  if (wonlyflag && prefs.resamp_wonly == RESAMPWEIGHT_AREA)
+    {
+/*-- Area-weighting relies on nearest-neighbour sampling and oversampling */
+    for (d=0; d<INTERP_MAXDIM; d++)
+      winterptype[d] = INTERP_NEARESTNEIGHBOUR;
+    interptype = winterptype;
+    }
 
 /* Now modify some characteristics of the output file */
 /* We use a small "dirty" trick to frame the output */
@@ -206,26 +250,33 @@ void	resample_field(fieldstruct **pinfield, fieldstruct **pinwfield,
   height = field->height;
   field->npix = field->width*field->height;
 
+/* Per-line extents of the input footprint (not with distortion maps) */
+  field->footprint = indgeofield? NULL : init_footprint(infield->wcs, wcs);
+
 /* Add relevant information to FITS headers */
   writefitsinfo_field(field, infield);
+  write_footprint(field->footprint, field->tab);
 
-/* Write image header */
-  if (open_cat(field->cat, WRITE_ONLY) != RETURN_OK)
+/* Write image header (the image itself is not saved in weight-only mode) */
+  writer = NULL;
+  if (!wonlyflag)
+    {
+    if (open_cat(field->cat, WRITE_ONLY) != RETURN_OK)
       error(EXIT_FAILURE, "*Error*: cannot open for writing ", filename);
-  if (prefs.removetmp_flag && prefs.combine_flag)
-    add_cleanupfilename(filename);
-  QFTELL(field->cat->file, field->tab->headpos, filename);
-  QFWRITE(field->tab->headbuf, field->tab->headnblock*FBSIZE,
+    if (prefs.removetmp_flag && prefs.combine_flag)
+      add_cleanupfilename(filename);
+    if (compactflag)
+      field->compact = init_compact(field, prefs.resamp_pack, !riflag);
+    else
+      {
+      if (prefs.checksum_flag)
+        start_bodysum(field->tab, 0);
+      QFTELL(field->cat->file, field->tab->headpos, filename);
+      QFWRITE(field->tab->headbuf, field->tab->headnblock*FBSIZE,
 	field->cat->file, filename);
-  QFTELL(field->cat->file, field->tab->bodypos, filename);
-
-/* Get resampled suffix extension if available */
-  strcpy(resampext1, prefs.resamp_suffix);
-  *resampext2 = '\0';
-  if ((pstr=strrchr(resampext1, '.')))
-    {
-    strcpy(resampext2, pstr);
-    *pstr = '\0';
+      QFTELL(field->cat->file, field->tab->bodypos, filename);
+      writer = init_writer(field->tab, riflag);
+      }
     }
 
 /* Now go on with output weight-map */
@@ -254,10 +305,18 @@ void	resample_field(fieldstruct **pinfield, fieldstruct **pinwfield,
     error(EXIT_FAILURE, "*Error*: cannot open for writing ", filename);
   if (prefs.removetmp_flag && prefs.combine_flag)
     add_cleanupfilename(filename);
-  QFTELL(wfield->cat->file, wfield->tab->headpos, filename);
-  QFWRITE(wfield->tab->headbuf, wfield->tab->headnblock*FBSIZE,
+  if (compactflag)
+    wfield->compact = init_compact(wfield, prefs.resamp_pack, !riflag);
+  else
+    {
+    if (prefs.checksum_flag)
+      start_bodysum(wfield->tab, 0);
+    QFTELL(wfield->cat->file, wfield->tab->headpos, filename);
+    QFWRITE(wfield->tab->headbuf, wfield->tab->headnblock*FBSIZE,
 	wfield->cat->file, filename);
-  QFTELL(wfield->cat->file, wfield->tab->bodypos, filename);
+    QFTELL(wfield->cat->file, wfield->tab->bodypos, filename);
+    wwriter = init_writer(wfield->tab, riflag);
+    }
 
 /* Prepare oversampling stuff */
   ascale = 1.0;
@@ -281,6 +340,22 @@ void	resample_field(fieldstruct **pinfield, fieldstruct **pinwfield,
     && (projapp = projapp_init(infield->wcs, field->wcs, projerr,
 	prefs.fscalastro_type==FSCALASTRO_VARIABLE)));
 
+/* Sub-sample positions may be derived from the local Jacobian within the */
+/* same error budget, if at most one axis beyond x is oversampled */
+  jacflag = 0;
+  oversamperr = projerr;
+  if (oversampflag && projerr > 0.0)
+    {
+    for (n=0, d=1; d<naxis; d++)
+      n += (oversamp[d]>1);
+    jacflag = (n<=1);
+    }
+
+/* Check if lng and lat are swapped between in and out wcs (vicious idea!) */
+  swapflag = (((infield->wcs->lng != wcs->lng)
+		|| (infield->wcs->lat != wcs->lat))
+	&& (infield->wcs->lng != infield->wcs->lat) && (wcs->lng != wcs->lat));
+
 #ifdef USE_THREADS
 /* Set up multi-threading stuff */
 /* Number of active threads */
@@ -293,21 +368,36 @@ void	resample_field(fieldstruct **pinfield, fieldstruct **pinwfield,
     QPTHREAD_COND_INIT(&linecond[l], NULL);
     }
   QPTHREAD_MUTEX_INIT(&linemutex, NULL);
-  QPTHREAD_ATTR_INIT(&pthread_attr);
-  QPTHREAD_ATTR_SETDETACHSTATE(&pthread_attr, PTHREAD_CREATE_JOINABLE);
+/* Split heavy lines in segments that are processed by different threads */
+  nseg = (int)((double)width*noversamp/RESAMP_SEGSIZE);
+  if (nseg > nproc)
+    nseg = nproc;
+  if (nseg < 1)
+    nseg = 1;
 #else
-  nproc = nlines = 1;
+  nproc = nlines = nseg = 1;
 #endif
+  segwidth = (width+nseg-1)/nseg;
+  nseg = (width+segwidth-1)/segwidth;
 
-/* Initialize the astrometric vector */
+/* Initialize the astrometric vector (at the centre of output pixels) */
   for (d=0; d<naxis;d++)
     {
     stepover[d]=1.0/oversamp[d];
-    rawmin[d] = rawpos0[d] = 0.5 + 0.5*stepover[d];
+    rawmin[d] = rawpos0[d] = 1.0;
     rawmax[d] = (double)wcs->naxisn[d];
     }
 
-/*-- Allocate memory for buffer pointers */
+/* Sub-sample offsets with respect to the centre of output pixels */
+  if (oversampflag)
+    {
+    QMALLOC(suboffset, double, noversamp*naxis);
+    for (o=0; o<noversamp; o++)
+      for (n=o, d=0; d<naxis; n/=oversamp[d++])
+        suboffset[o*naxis+d] = ((n%oversamp[d])+0.5)*stepover[d] - 0.5;
+    }
+
+/* Allocate memory for the output line buffers */
   QMALLOC(rawposp, double *, nlines);
   if (riflag)
     {
@@ -319,26 +409,6 @@ void	resample_field(fieldstruct **pinfield, fieldstruct **pinwfield,
     QMALLOC(routbuf, PIXTYPE *, nlines)
     QMALLOC(routwbuf, PIXTYPE *, nlines);
     }
-  QMALLOC(rawbuf, double *, nlines);
-  QCALLOC(rawbufarea, double *, nlines);
-  QMALLOC(ikernel, ikernelstruct *, nlines);
-  QMALLOC(wcsinp, wcsstruct *, nlines);
-  QMALLOC(wcsoutp, wcsstruct *, nlines);
-  if (oversampflag)
-    {
-    if (riflag)
-      {
-      QMALLOC(oversampibuf, FLAGTYPE *, nlines)
-      QMALLOC(oversampwibuf, FLAGTYPE *, nlines);
-      }
-    else
-      {
-      QMALLOC(oversampbuf, double *, nlines)
-      QMALLOC(oversampwbuf, double *, nlines);
-      }
-    QMALLOC(oversampnbuf, int *, nlines);
-    }
-
   for (l=0; l<nlines; l++)
     {
 /*-- Allocate memory for the output buffers that contain the final data in */
@@ -353,51 +423,68 @@ void	resample_field(fieldstruct **pinfield, fieldstruct **pinwfield,
       QMALLOC(routbuf[l], PIXTYPE, width)
       QMALLOC(routwbuf[l], PIXTYPE, width);
       }
+    QMALLOC(rawposp[l], double, naxis);
+    }
+
+/* Allocate memory for the thread work buffers */
+  QMALLOC(rawbuf, double *, nproc);
+  QCALLOC(rawdbuf, double *, nproc);
+  QCALLOC(rawbufarea, double *, nproc);
+  QCALLOC(rawsubbuf, double *, nproc);
+  QCALLOC(rawsubbufarea, double *, nproc);
+  QMALLOC(wcsbuf, double *, nproc);
+  QMALLOC(ikernel, ikernelstruct *, nproc);
+  for (p=0; p<nproc; p++)
+    {
+/*-- Provide memory space for the current astrometric line segment */
+/*-- (with one more pixel on each side for oversampling) */
+    QMALLOC(rawbuf[p], double, naxis*(segwidth+2));
+    QMALLOC(wcsbuf[p], double, naxis*(oversamp[0]*segwidth+2));
+/*-- Lines one pixel away on both sides along the other axes */
+    if (jacflag && naxis>1)
+      QMALLOC(rawdbuf[p], double, 2*(naxis-1)*naxis*(segwidth+2));
+    if (prefs.fscalastro_type==FSCALASTRO_VARIABLE)
+      QMALLOC(rawbufarea[p], double, segwidth+2)
+/*-- Provide memory space for exact sub-sample coordinates */
     if (oversampflag)
-/*---- Provide memory space for integrating the content of oversampled pixels*/
       {
-      if (riflag)
-        {
-        QMALLOC(oversampibuf[l], FLAGTYPE, width)
-        QMALLOC(oversampwibuf[l], FLAGTYPE, width);
-        }
-      else
-        {
-        QMALLOC(oversampbuf[l], double, width)
-        QMALLOC(oversampwbuf[l], double, width);
-        }
-      QMALLOC(oversampnbuf[l], int, width);
+      QMALLOC(rawsubbuf[p], double, naxis*noversamp*segwidth);
+      if (prefs.fscalastro_type==FSCALASTRO_VARIABLE)
+        QMALLOC(rawsubbufarea[p], double, noversamp*segwidth);
       }
-/*-- Provide memory space for the current astrometric line */
-    QMALLOC(rawbuf[l], double, naxis*width);
-    if (prefs.fscalastro_type==FSCALASTRO_VARIABLE)
-      QMALLOC(rawbufarea[l], double, width)
-    QMALLOC(rawposp[l], double, naxis);
 /*-- Initialize interpolation kernel */
-    ikernel[l] = init_ikernel(interptype, naxis);
-/*-- Make copies of the WCS structure (the WCS library is not reentrant) */
-    wcsinp[l] = copy_wcs(infield->wcs);
-    wcsoutp[l] = copy_wcs(field->wcs);
+    ikernel[p] = init_ikernel(interptype, naxis);
     }
+/* Line and thread work buffers are part of the MEM_MAX budget */
+  bufsize = (size_t)nlines*(2*width*sizeof(PIXTYPE) + naxis*sizeof(double))
+	+ (size_t)nproc*((naxis*(2*naxis-1)+1)*(segwidth+2)
+		+ naxis*(oversamp[0]*segwidth+2)
+		+ (oversampflag? (naxis+1)*noversamp*segwidth : 0))
+	*sizeof(double);
+  reserve_ram(bufsize, 0, 1);
+
+/* Input and output WCS structures are shared among threads */
+  share_wcs(infield->wcs);
+  share_wcs(field->wcs);
 
 /* Compute reasonable line display-step */
   dispstep = (int)(nproc*50000.0/noversamp/width);
   if (!dispstep)
     dispstep = 1;
 
-/* Start threads! */
+/* Start threads! (one resampling task per pool worker) */
 #ifdef USE_THREADS
   QCALLOC(writeflag, int, nlines);
   QCALLOC(queue, int, nlines);
+  QCALLOC(nextseg, int, nlines);
+  QCALLOC(segleft, int, nlines);
   QMALLOC(proc, int, nproc);
-  QMALLOC(rthread, pthread_t, nproc);
-  ftab = field->tab;
-  wtab = wfield->tab;
   writeline = absline = procline = 0;
+  job = threads_job_init(threads_pool);
   for (p=0; p<nproc; p++)
     {
     proc[p] = p;
-    QPTHREAD_CREATE(&rthread[p], &pthread_attr, &pthread_warp_lines, &proc[p]);
+    threads_job_add(job, &pthread_warp_lines, &proc[p]);
     }
 #else
 /* The old single-threaded way */
@@ -414,44 +501,54 @@ void	resample_field(fieldstruct **pinfield, fieldstruct **pinwfield,
     if (!(y%dispstep))
       NPRINTF(OUTPUT, "\33[1M> Resampling line:%7d / %-7d\n\33[1A",
 	y, height);
-    warp_line(0);
-    if (riflag)
-      {
-      write_ibody(field->tab, routibuf[0], width);
-      write_ibody(wfield->tab, routwibuf[0], width);
-      }
-    else
-      {
-      write_body(field->tab, routbuf[0], width);
-      write_body(wfield->tab, routwbuf[0], width);
-      }
+    warp_line(0, 0, 0);
+    write_line(0, 0);
     }
 #endif
 
 #ifdef USE_THREADS
-  for (p=0; p<nproc; p++)
-    QPTHREAD_JOIN(rthread[p], NULL);
+  threads_job_end(job);
   QPTHREAD_MUTEX_DESTROY(&linemutex);
   for (l=0; l<nlines; l++)
     {
     QPTHREAD_COND_DESTROY(&linecond[l]);
     }
-  QPTHREAD_ATTR_DESTROY(&pthread_attr);
   free(linecond);
   free(writeflag);
   free(queue);
+  free(nextseg);
+  free(segleft);
   free(proc);
-  free(rthread);
 #endif
 
-/* FITS padding*/
-  pad_tab(field->cat, field->tab->tabsize);
-  pad_tab(wfield->cat, wfield->tab->tabsize);
+/* FITS padding or compact line tables */
+  if (compactflag)
+    {
+    if (!wonlyflag)
+      end_compact(field);
+    end_compact(wfield);
+    }
+  else
+    {
+    if (!wonlyflag)
+      {
+      end_writer(writer);
+      pad_tab(field->cat, field->tab->tabsize);
+      }
+    end_writer(wwriter);
+    pad_tab(wfield->cat, wfield->tab->tabsize);
+    }
 
 /* Close files */
   close_cat(field->cat);
   close_cat(wfield->cat);
 
+/* Update checksums in headers */
+  if (end_bodysum(field->tab) != RETURN_OK)
+    warning("Cannot write checksum in ", field->filename);
+  if (end_bodysum(wfield->tab) != RETURN_OK)
+    warning("Cannot write checksum in ", wfield->filename);
+
 /* Return back new field pointers */
   *pinfield = field;
   *pinwfield = wfield;
@@ -462,33 +559,32 @@ void	resample_field(fieldstruct **pinfield, fieldstruct **pinwfield,
     free(rawposp[l]);
     free(riflag? (void *)routibuf[l] : (void *)routbuf[l]);
     free(riflag? (void *)routwibuf[l]: (void *)routwbuf[l]);
-    if (oversampflag)
-      {
-      free(riflag? (void *)oversampibuf[l] : (void *)oversampbuf[l]);
-      free(riflag? (void *)oversampwibuf[l]: (void *)oversampwbuf[l]);
-      free(oversampnbuf[l]);
-      }
-    free(rawbuf[l]);
-    free(rawbufarea[l]);
-/*-- Free interpolation kernel */
-    free_ikernel(ikernel[l]);
-    end_wcs(wcsinp[l]);
-    end_wcs(wcsoutp[l]);
     }
   free(rawposp);
   free(riflag? (void *)routibuf : (void *)routbuf);
   free(riflag? (void *)routwibuf: (void *)routwbuf);
-  if (oversampflag)
+  for (p=0; p<nproc; p++)
     {
-    free(riflag? (void *)oversampibuf : (void *)oversampbuf);
-    free(riflag? (void *)oversampwibuf: (void *)oversampwbuf);
-    free(oversampnbuf);
+    free(rawbuf[p]);
+    free(rawdbuf[p]);
+    free(rawbufarea[p]);
+    free(rawsubbuf[p]);
+    free(rawsubbufarea[p]);
+    free(wcsbuf[p]);
+/*-- Free interpolation kernel */
+    free_ikernel(ikernel[p]);
     }
   free(rawbuf);
+  free(rawdbuf);
   free(rawbufarea);
+  free(rawsubbuf);
+  free(rawsubbufarea);
+  free(wcsbuf);
   free(ikernel);
-  free(wcsinp);
-  free(wcsoutp);
+  release_ram(bufsize, 0);
+  perf_memsample(PERF_WARP);
+  if (oversampflag)
+    free(suboffset);
 
   if (approxflag)
     projapp_end(projapp);
@@ -505,63 +601,71 @@ void	resample_field(fieldstruct **pinfield, fieldstruct **pinwfield,
 
 /****** pthread_warp_lines ****************************************************
 PROTO	void *pthread_warp_lines(void *arg)
-PURPOSE	thread that takes care of resampling image lines
-INPUT	Pointer to the thread number.
+PURPOSE	Pool task that takes care of resampling image lines
+INPUT	Pointer to the task number.
 OUTPUT	-.
-NOTES	-.
-AUTHOR	E. Bertin (IAP)
-VERSION	20/10/2003
+NOTES	All resampling tasks must run concurrently, as they wait for each
+	other to write lines in order.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
  ***/
 void	*pthread_warp_lines(void *arg)
   {
-   int	l;
+   int	l, s, t;
 
+  t = *((int *)arg);
   l = -1;
-  while ((l=pthread_nextline(l))!= -1)
-    warp_line(l);
-  
-  pthread_exit(NULL);
+  while ((l=pthread_nextline(l, t, &s))!= -1)
+    warp_line(l, t, s);
 
   return (void *)NULL;
   }
 
 
 /****** pthread_nextline ******************************************************
-PROTO	int pthread_nextline(int l)
-PURPOSE	Return the next available line to be resampled.
-INPUT	-.
+PROTO	int pthread_nextline(int l, int t, int *s)
+PURPOSE	Return the next available line segment to be resampled.
+INPUT	Index of the line whose segment has just been processed (or -1),
+	thread number,
+	pointer to the returned segment index.
 OUTPUT	Next available line index.
-NOTES	-.
-AUTHOR	E. Bertin (IAP)
-VERSION	26/08/2020
+NOTES	Segments of lines that have already been started are handed out
+	first, beginning with the oldest line. A line is written to disk once
+	all its segments are done.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
  ***/
-int	pthread_nextline(int l)
+int	pthread_nextline(int l, int t, int *s)
   {
    double	rawpos[NAXIS];
-   int		d, q, y;
+   int		d, i, q, y;
 
   QPTHREAD_MUTEX_LOCK(&linemutex);
 /* The newly processed line is ready to be written to disk */
-  if (l>=0)
-    writeflag[l] = 2;
-/* If we just finished the "right" line, write it to disk! */
-  if (l == writeline)
+  if (l>=0 && !--segleft[l])
     {
-    while (writeflag[writeline]==2)
+    writeflag[l] = 2;
+/*-- If we just finished the "right" line, write it to disk! */
+    if (l == writeline)
       {
-      if (riflag)
-        {
-        write_ibody(ftab, routibuf[writeline], width);
-        write_ibody(wtab, routwibuf[writeline], width);
-        }
-      else
+      while (writeflag[writeline]==2)
         {
-        write_body(ftab, routbuf[writeline], width);
-        write_body(wtab, routwbuf[writeline], width);
+        write_line(writeline, t);
+        writeflag[writeline] = 0;
+        QPTHREAD_COND_BROADCAST(&linecond[writeline]);
+        writeline = (writeline+1)%nlines;
         }
-      writeflag[writeline] = 0;
-      QPTHREAD_COND_BROADCAST(&linecond[writeline]);
-      writeline = (writeline+1)%nlines;
+      }
+    }
+/* Look for a pending segment in lines already started */
+  for (i=0; i<nlines; i++)
+    {
+    l = (writeline+i)%nlines;
+    if (writeflag[l]==1 && nextseg[l]<nseg)
+      {
+      *s = nextseg[l]++;
+      QPTHREAD_MUTEX_UNLOCK(&linemutex);
+      return l;
       }
     }
 /* If no more line to process, return a "-1" (meaning exit thread) */
@@ -589,9 +693,12 @@ int	pthread_nextline(int l)
     for (d=1; d<naxis; d++)
       rawposp[l][d] = rawpos[d];
     writeflag[l] = 1;
+    segleft[l] = nseg;
+    nextseg[l] = 1;
+    *s = 0;
     }
   QPTHREAD_MUTEX_UNLOCK(&linemutex);
-  if (!(y%dispstep))
+  if (l>=0 && !(y%dispstep))
     NPRINTF(OUTPUT, "\33[1M> Resampling line:%7d / %-7d\n\33[1A",
 	y, height);
 
@@ -599,219 +706,214 @@ int	pthread_nextline(int l)
   }
 
 
-/****** cancel_resample_threads ***********************************************
-PROTO   void clean_resample_threads(void)
-PURPOSE Cancel remaining active threads
-INPUT   -.
-OUTPUT  -.
-NOTES   -.
-AUTHOR  E. Bertin (IAP)
-VERSION 25/04/2002
- ***/
-void    cancel_resample_threads(void)
-  {
-   int  p;
-
-  for (p=0; p<nproc; p++)
-    QPTHREAD_CANCEL(rthread[p]);
-
-  return;
-  }
-
 #endif
 
 /****** warp_line *************************************************************
-PROTO	void warp_line(int p)
-PURPOSE	Resample an image line.
-INPUT	Thread number.
+PROTO	void warp_line(int l, int t, int s)
+PURPOSE	Resample a segment of an image line.
+INPUT	Line buffer index,
+	thread number,
+	segment index.
 OUTPUT	-.
-NOTES	-.
-AUTHOR	E. Bertin (IAP)
-VERSION	18/11/2020
+NOTES	With oversampling and a non-zero projection error budget, input
+	coordinates are computed only at the centre of output pixels and
+	sub-sample positions are derived from the local Jacobian of the
+	transformation (see warp_jacobian()). Sub-samples of pixels where
+	the linear approximation is not accurate enough are transformed
+	individually, as are all sub-samples with PROJECTION_ERR set to 0.
+	Pixels outside the footprint of the input image are set to zero
+	without being resampled.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
  ***/
-void	warp_line(int p)
+void	warp_line(int l, int t, int s)
   {
-   wcsstruct		*wcsin,*wcsout;
-   double		rawposover[NAXIS], wcspos[NAXIS],
-			*rawpos, *rawbufc, *oversampt,*oversampwt, *rawbufareac,
-			area, worldc;
+   double		jac[NAXIS][NAXIS], rawpos[NAXIS], subpos[NAXIS],
+			*rawbufc, *rawdbufc, *rawbufareac, *rawsubc, *subareac,
+			*subposc, *suboffsetc,
+			area, sum,wsum, dpos;
    PIXTYPE		*out, *outw,
 			pix,pixw;
-   FLAGTYPE		*outi,*outwi, *oversampit,*oversampwit,
-			ipix,ipixw;
-   int			nstepover[NAXIS],stepcount[NAXIS],
-			*oversampnt,
-			d, o, x, ninput, swapflag;
+   FLAGTYPE		*outi,*outwi,
+			ipix,ipixw, isum,iwsum;
+   double		t0;
+   char			*outc, *outwc;
+   size_t		esize;
+   int			*xrange,
+			d,i,k, o, x, n,ns, x0,xs, xmin,xmax, ninput,
+			exactflag, substep;
 
+  t0 = perf_start();
+  x0 = s*segwidth;
+  n = (x0+segwidth > width)? width-x0 : segwidth;
+  xs = 0;
+  ns = n;
+/* Pixels outside the input footprint are not worth resampling */
+  if (field->footprint)
+    {
+    xrange = field->footprint->xrange + 2*((int)rawposp[l][1] - 1);
+    xmin = xrange[0] > x0? xrange[0] : x0;
+    xmax = xrange[1] < x0+n? xrange[1] : x0+n;
+    if (xmax < xmin)
+      xmax = xmin;
+    esize = riflag? sizeof(FLAGTYPE) : sizeof(PIXTYPE);
+    outc = riflag? (char *)routibuf[l] : (char *)routbuf[l];
+    outwc = riflag? (char *)routwibuf[l] : (char *)routwbuf[l];
+    memset(outc + x0*esize, 0, (xmin-x0)*esize);
+    memset(outwc + x0*esize, 0, (xmin-x0)*esize);
+    memset(outc + xmax*esize, 0, (x0+n-xmax)*esize);
+    memset(outwc + xmax*esize, 0, (x0+n-xmax)*esize);
+    if (xmax == xmin)
+      return;
+/*-- Approximate coordinates depend on the starting point: these are */
+/*-- still computed (cheaply) over the whole segment */
+    if (approxflag)
+      {
+      xs = xmin - x0;
+      ns = xmax - xmin;
+      }
+    else
+      {
+      x0 = xmin;
+      n = ns = xmax - xmin;
+      }
+    }
   if (riflag)
     {
-    outi = routibuf[p];
-    outwi = routwibuf[p];
+    outi = routibuf[l] + x0 + xs;
+    outwi = routwibuf[l] + x0 + xs;
     }
   else
     {
-    out = routbuf[p];
-    outw = routwbuf[p];
+    out = routbuf[l] + x0 + xs;
+    outw = routwbuf[l] + x0 + xs;
     }
-  rawpos = rawposp[p];
-  wcsin = wcsinp[p];
-  wcsout = wcsoutp[p];
+  for (d=1; d<naxis; d++)
+    rawpos[d] = rawposp[l][d];
   area = infield->fascale;
-/* Check if lng and lat are swapped between in and out wcs (vicious idea!) */
-  swapflag = (((wcsin->lng != wcsout->lng) || (wcsin->lat != wcsout->lat))
-	&& (wcsin->lng != wcsin->lat) && (wcsout->lng != wcsout->lat));
 
-/* Compute all alpha's and delta's for the current line */
-  rawpos[0] = rawmin[0];
   if (oversampflag)
     {
 /*-- Oversampling is on */
-    for (d=0; d<naxis; d++)
-      {
-      stepcount[d] = nstepover[d] = 0;
-      rawposover[d] = rawpos[d];
-      }
-    if (riflag)
+    if (jacflag)
       {
-      memset(oversampibuf[p], 0, sizeof(FLAGTYPE)*width);
-      memset(oversampwibuf[p], 0, sizeof(FLAGTYPE)*width);
+/*---- Compute input coordinates at the centre of output pixels, from x0-1 */
+/*---- to x0+n (included) */
+      rawpos[0] = rawmin[0] + x0 - 1.0;
+      warp_coords(t, rawpos, 1.0, n+2, rawbuf[t], rawbufarea[t]);
+/*---- Same one pixel away on both sides along the other oversampled axis */
+      for (i=1; i<naxis; i++)
+        if (oversamp[i]>1)
+          {
+          rawdbufc = rawdbuf[t] + 2*(i-1)*naxis*(segwidth+2);
+          rawpos[i] -= 1.0;
+          warp_coords(t, rawpos, 1.0, n+2, rawdbufc, NULL);
+          rawpos[i] += 2.0;
+          warp_coords(t, rawpos, 1.0, n+2, rawdbufc + naxis*(segwidth+2),
+		NULL);
+          rawpos[i] -= 1.0;
+          }
       }
     else
       {
-      memset(oversampbuf[p], 0, sizeof(double)*width);
-      memset(oversampwbuf[p], 0, sizeof(double)*width);
+/*---- Compute the exact coordinates of all sub-samples */
+      rawpos[0] = rawmin[0] + x0;
+      warp_subcoords(t, rawpos, n, rawsubbuf[t], rawsubbufarea[t]);
       }
-    memset(oversampnbuf[p], 0, sizeof(int)*width);
-    for (o=noversamp; o--; )
+    for (x=xs; x<xs+ns; x++)
       {
-      rawbufc = rawbuf[p];
-      rawbufareac = rawbufarea[p];
-      if (approxflag)
-/*------ With approximation */
-        projapp_line(projapp, rawposover, 1.0, width, rawbufc, rawbufareac);
+      ninput = 0;
+      sum = wsum = 0.0;
+      isum = iwsum = 0;
+      rawbufc = rawbuf[t] + (x+1)*naxis;
+      exactflag = !jacflag || warp_jacobian(t, x, jac) != RETURN_OK;
+      if (!exactflag)
+        {
+        rawsubc = rawsubbuf[t];
+        subareac = NULL;
+        substep = 0;
+        if (rawbufarea[t])
+          area = rawbufarea[t][x+1];
+        }
+      else if (jacflag)
+/*------ The linear approximation is not good enough: transform each */
+/*------ sub-sample of this pixel */
+        {
+        rawpos[0] = rawmin[0] + x0 + x;
+        warp_subcoords(t, rawpos, 1, rawsubbuf[t], rawsubbufarea[t]);
+        rawsubc = rawsubbuf[t];
+        subareac = rawsubbufarea[t];
+        substep = oversamp[0];
+        }
       else
         {
-/*------ Without approximation */
-        for (x=width; x--; *rawposover+=1.0,  rawbufc+=naxis)
+        rawsubc = rawsubbuf[t] + x*oversamp[0]*naxis;
+        subareac = rawsubbufarea[t]? rawsubbufarea[t] + x*oversamp[0] : NULL;
+        substep = n*oversamp[0];
+        }
+/*---- Resample the current pixel */
+      suboffsetc = suboffset;
+      for (o=0; o<noversamp; o++, suboffsetc+=naxis)
+        {
+        if (exactflag)
           {
-          raw_to_wcs(wcsout, rawposover, wcspos);
-          if (*wcspos == WCS_NOCOORD)
-            *rawbufc = WCS_NOCOORD;
-          else
-            {
-            if (swapflag)
-              {
-              worldc = wcspos[wcsout->lat];
-              wcspos[wcsout->lat] = wcspos[wcsin->lat];
-              wcspos[wcsin->lat] = worldc;
-              }
-            wcs_to_raw(wcsin, wcspos, rawbufc);
-            if (rawbufareac)
-              *rawbufareac = wcs_scale(wcsout, rawposover)
-			/ wcs_scale(wcsin, rawbufc);
-            }
-          if (rawbufareac)
-            rawbufareac++;
+          k = (o/oversamp[0])*substep + o%oversamp[0];
+          subposc = rawsubc + k*naxis;
+          if (*subposc == WCS_NOCOORD)
+            continue;
+          if (subareac)
+            area = subareac[k];
           }
-	}
-/*---- Resample the current line */
-      if (riflag)
-        {
-        oversampit = oversampibuf[p];
-        oversampwit = oversampwibuf[p];
-        oversampnt = oversampnbuf[p];
-        rawbufc = rawbuf[p];
-        rawbufareac = rawbufarea[p];
-        for (x=width; x--; rawbufc+=naxis)
+        else
           {
-          if (rawbufareac)
-            area = *(rawbufareac++);
-          if (*rawbufc != WCS_NOCOORD
-		&& interpolate_ipix(infield, inwfield, indgeofield, rawbufc,
-			&ipix,&ipixw) == RETURN_OK)
+          for (d=0; d<naxis; d++)
             {
-            *(oversampit++) |= ipix;
-            *(oversampwit++) |= 1;
-            (*(oversampnt++))++;
-            }
-          else
-            {
-            oversampit++;
-            oversampwit++;
-            oversampnt++;
+            dpos = rawbufc[d];
+            for (i=0; i<naxis; i++)
+              dpos += jac[d][i]*suboffsetc[i];
+            subpos[d] = dpos;
             }
+          subposc = subpos;
           }
-        }
-      else
-        {
-        oversampt = oversampbuf[p];
-        oversampwt = oversampwbuf[p];
-        oversampnt = oversampnbuf[p];
-        rawbufc = rawbuf[p];
-        rawbufareac = rawbufarea[p];
-        for (x=width; x--; rawbufc+=naxis)
+        if (riflag)
           {
-          if (rawbufareac)
-            area = *(rawbufareac++);
-          if (*rawbufc != WCS_NOCOORD
-		&& (interpolate_pix(infield, inwfield, indgeofield, ikernel[p],
-			rawbufc, &pix,&pixw),pixw<BIG))
-            {
-            *(oversampt++) += area * (double)pix;
-            *(oversampwt++) += (double)pixw * area*area;
-            (*(oversampnt++))++;
-            }
-          else
+          if (interpolate_ipix(infield, inwfield, indgeofield, subposc,
+			&ipix,&ipixw) == RETURN_OK)
             {
-            oversampt++;
-            oversampwt++;
-            oversampnt++;
+            isum |= ipix;
+            iwsum |= 1;
+            ninput++;
             }
           }
-        }
-/*---- Update coordinate vector */
-      for (d=0; d<naxis; d++)
-        {
-        rawposover[d] = rawpos[d] + (++stepcount[d])*stepover[d];
-        if (++nstepover[d]<oversamp[d])
-          break;
-        else
+        else if ((wonlyflag?
+		(pix=0.0, interpolate_weight(infield, inwfield, indgeofield,
+			ikernel[t], subposc, &pixw))
+		: interpolate_pix(infield, inwfield, indgeofield,
+			ikernel[t], subposc, &pix,&pixw)),pixw<BIG)
           {
-          stepcount[d] = nstepover[d] = 0; /* No need to initialize it to 0! */
-          rawposover[d] = rawpos[d];
+          sum += area * (double)pix;
+          wsum += (double)pixw * area*area;
+          ninput++;
           }
         }
-      }
-/*-- Now transfer to the output line */
-    if (riflag)
-      {
-      oversampit = oversampibuf[p];
-      oversampwit = oversampwibuf[p];
-      oversampnt = oversampnbuf[p];
-      for (x=width; x--; oversampit++, oversampwit++)
+/*---- Now transfer to the output line */
+      if (riflag)
         {
-        if ((ninput = *(oversampnt++)))
+        if (ninput)
           {
-          *(outi++) = *oversampit;
-/*--------- Convert variances to weight */
-          *(outwi++) = *oversampwit;
+          *(outi++) = isum;
+          *(outwi++) = iwsum;
           }
         else
           *(outwi++) = *(outi++) = 0;
         }
-      }
-    else
-      {
-      oversampt = oversampbuf[p];
-      oversampwt = oversampwbuf[p];
-      oversampnt = oversampnbuf[p];
-      for (x=width; x--; oversampt++, oversampwt++)
+      else
         {
-        if ((ninput = *(oversampnt++)))
+        if (ninput)
           {
-          *(out++) = (PIXTYPE)(*oversampt/ninput);
-/*--------- Convert variances to weight */
-          *(outw++) = (PIXTYPE)((ninput / *oversampwt)*ascale);
+          *(out++) = (PIXTYPE)(sum/ninput);
+/*-------- Convert variances to weight */
+          *(outw++) = (PIXTYPE)((ninput / wsum)*ascale);
           }
         else
           *(out++) = *(outw++) = 0.0;
@@ -821,39 +923,13 @@ void	warp_line(int p)
   else
     {
 /*-- No oversampling */
-    rawbufc = rawbuf[p];
-    rawbufareac = rawbufarea[p];
-    if (approxflag)
-/*---- With approximation */
-      projapp_line(projapp, rawpos, 1.0, width, rawbufc, rawbufareac);
-    else
-/*---- Without approximation */
-      for (x=width; x--; (*rawpos)+=1.0,  rawbufc+=naxis)
-        {
-        raw_to_wcs(wcsout, rawpos, wcspos);
-        if (*wcspos == WCS_NOCOORD)
-          *rawbufc = WCS_NOCOORD;
-        else
-          {
-          if (swapflag)
-            {
-            worldc = wcspos[wcsout->lat];
-            wcspos[wcsout->lat] = wcspos[wcsin->lat];
-            wcspos[wcsin->lat] = worldc;
-            }
-          wcs_to_raw(wcsin, wcspos, rawbufc);
-          if (rawbufareac)
-            *rawbufareac = wcs_scale(wcsout, rawpos)
-			/ wcs_scale(wcsin, rawbufc);
-          }
-        if (rawbufareac)
-          rawbufareac++;
-        }
+    rawpos[0] = rawmin[0] + x0;
+    warp_coords(t, rawpos, 1.0, n, rawbuf[t], rawbufarea[t]);
 /*-- Resample the line */
-    rawbufc = rawbuf[p];
-    rawbufareac = rawbufarea[p];
+    rawbufc = rawbuf[t] + xs*naxis;
+    rawbufareac = rawbufarea[t]? rawbufarea[t] + xs : NULL;
     if (riflag)
-      for (x=width; x--; rawbufc+=naxis)
+      for (x=ns; x--; rawbufc+=naxis)
         {
         if (rawbufareac)
           area = *(rawbufareac++);
@@ -864,14 +940,21 @@ void	warp_line(int p)
           *(outwi++) = *(outi++) = 0;
         }
     else
-      for (x=width; x--; rawbufc+=naxis)
+      for (x=ns; x--; rawbufc+=naxis)
         {
         if (rawbufareac)
           area = *(rawbufareac++);
         if (*rawbufc != WCS_NOCOORD)
           {
-          interpolate_pix(infield, inwfield, indgeofield, ikernel[p], rawbufc,
-          	out,outw);
+          if (wonlyflag)
+            {
+            *out = 0.0;
+            interpolate_weight(infield, inwfield, indgeofield, ikernel[t],
+		rawbufc, outw);
+            }
+          else
+            interpolate_pix(infield, inwfield, indgeofield, ikernel[t],
+		rawbufc, out,outw);
           *(out++) *= area;
 /*------- Convert variance to weight */
           *outw = (*outw < BIG) ? 1.0/(*outw*area*area) : 0.0;
@@ -882,6 +965,253 @@ void	warp_line(int p)
         }
     }
 
+  perf_add(PERF_WARP, t+1, t0, (double)ns*noversamp, 0.0);
+
+  return;
+  }
+
+
+/****** warp_jacobian *********************************************************
+PROTO	int warp_jacobian(int t, int x, double jac[][NAXIS])
+PURPOSE	Estimate the local Jacobian of the transformation at the centre of an
+	output pixel, and check that it predicts sub-sample positions within
+	the projection error budget.
+INPUT	Thread number,
+	pixel index in the current segment,
+	pointer to the output Jacobian matrix.
+OUTPUT	RETURN_OK if the linear approximation is accurate enough,
+	RETURN_ERROR otherwise.
+NOTES	Derivatives are obtained from central differences with the
+	neighbouring pixels, whose coordinates must have been computed in
+	rawbuf[] and rawdbuf[]. The error of the linear approximation at
+	the farthest sub-sample is bounded to second order from the second
+	differences (cross terms included), and compared to PROJECTION_ERR.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+static int	warp_jacobian(int t, int x, double jac[][NAXIS])
+  {
+   double	err[NAXIS],
+		*rawc,*rawl,*rawr, *rawdc,*rawuc,
+		u0,ui;
+   int		d,i, linesize;
+
+  rawc = rawbuf[t] + (x+1)*naxis;
+  rawl = rawc - naxis;
+  rawr = rawc + naxis;
+  if (*rawc == WCS_NOCOORD || *rawl == WCS_NOCOORD || *rawr == WCS_NOCOORD)
+    return RETURN_ERROR;
+/* Largest sub-sample offset along x */
+  u0 = 0.5*(1.0 - stepover[0]);
+  for (d=0; d<naxis; d++)
+    {
+    jac[d][0] = 0.5*(rawr[d] - rawl[d]);
+    err[d] = 0.5*fabs(rawr[d] - 2.0*rawc[d] + rawl[d])*u0*u0;
+    }
+  linesize = naxis*(segwidth+2);
+  for (i=1; i<naxis; i++)
+    {
+    if (oversamp[i]<=1)
+      {
+      for (d=0; d<naxis; d++)
+        jac[d][i] = 0.0;
+      continue;
+      }
+    ui = 0.5*(1.0 - stepover[i]);
+    rawdc = rawdbuf[t] + 2*(i-1)*linesize + (x+1)*naxis;
+    rawuc = rawdc + linesize;
+    if (*rawdc == WCS_NOCOORD || *rawuc == WCS_NOCOORD
+	|| *(rawdc-naxis) == WCS_NOCOORD || *(rawdc+naxis) == WCS_NOCOORD
+	|| *(rawuc-naxis) == WCS_NOCOORD || *(rawuc+naxis) == WCS_NOCOORD)
+      return RETURN_ERROR;
+    for (d=0; d<naxis; d++)
+      {
+      jac[d][i] = 0.5*(rawuc[d] - rawdc[d]);
+      err[d] += 0.5*fabs(rawuc[d] - 2.0*rawc[d] + rawdc[d])*ui*ui
+		+ 0.25*fabs(rawuc[d+naxis] - rawuc[d-naxis]
+			- rawdc[d+naxis] + rawdc[d-naxis])*u0*ui;
+      }
+    }
+
+  for (d=0; d<naxis; d++)
+    if (err[d] > oversamperr)
+      return RETURN_ERROR;
+
+  return RETURN_OK;
+  }
+
+
+/****** warp_subcoords ********************************************************
+PROTO	void warp_subcoords(int t, double *rawpos, int npix, double *rawout,
+			double *areaout)
+PURPOSE	Compute the input pixel coordinates of all sub-samples of consecutive
+	output pixels along a line.
+INPUT	Thread number,
+	pointer to the coordinate vector of the centre of the first pixel,
+	number of pixels,
+	pointer to the output input-coordinate vectors,
+	pointer to the output pixel area ratios (or NULL).
+OUTPUT	-.
+NOTES	Sub-samples are stored by oversampled line: sub-sample o of pixel x
+	is at index (o/oversamp[0])*npix*oversamp[0] + x*oversamp[0]
+	+ o%oversamp[0].
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+static void	warp_subcoords(int t, double *rawpos, int npix, double *rawout,
+			double *areaout)
+  {
+   double	subpos[NAXIS],
+		*suboffsetc;
+   int		d, r, nrow, nsub;
+
+  nsub = npix*oversamp[0];
+  nrow = noversamp/oversamp[0];
+  suboffsetc = suboffset;
+  for (r=0; r<nrow; r++, suboffsetc+=oversamp[0]*naxis)
+    {
+    for (d=0; d<naxis; d++)
+      subpos[d] = rawpos[d] + suboffsetc[d];
+    warp_coords(t, subpos, stepover[0], nsub, rawout + r*nsub*naxis,
+		areaout? areaout + r*nsub : NULL);
+    }
+
+  return;
+  }
+
+
+/****** warp_coords ***********************************************************
+PROTO	void warp_coords(int t, double *rawpos, double step, int n,
+			double *rawout, double *areaout)
+PURPOSE	Compute the input pixel coordinates of regularly spaced output
+	positions along a line.
+INPUT	Thread number,
+	pointer to the first output coordinate vector,
+	step between output positions along x,
+	number of positions,
+	pointer to the output input-coordinate vectors,
+	pointer to the output pixel area ratios (or NULL).
+OUTPUT	-.
+NOTES	Uses the projection approximation if available.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+static void	warp_coords(int t, double *rawpos, double step, int n,
+			double *rawout, double *areaout)
+  {
+  if (approxflag)
+    projapp_line(projapp, rawpos, step, n, rawout, areaout);
+  else
+    warp_wcsline(t, rawpos, step, n, rawout, areaout);
+
+  return;
+  }
+
+
+/****** warp_wcsline **********************************************************
+PROTO	void warp_wcsline(int t, double *rawpos, double step, int n,
+			double *rawout, double *areaout)
+PURPOSE	Compute the input pixel coordinates of regularly spaced output
+	positions along a line, without approximation.
+INPUT	Thread number,
+	pointer to the first output coordinate vector,
+	step between output positions along x,
+	number of positions,
+	pointer to the output input-coordinate vectors,
+	pointer to the output pixel area ratios (or NULL).
+OUTPUT	-.
+NOTES	The whole line is transformed at once through the batched WCS
+	routines.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+static void	warp_wcsline(int t, double *rawpos, double step, int n,
+			double *rawout, double *areaout)
+  {
+   wcsstruct		*wcsin,*wcsout;
+   double		outpos[NAXIS],
+			*rawoutc, *wcsbufc,
+			worldc;
+   int			d, x;
+
+  wcsin = infield->wcs;
+  wcsout = field->wcs;
+/* Output pixel coordinates */
+  rawoutc = rawout;
+  for (x=0; x<n; x++, rawoutc+=naxis)
+    {
+    for (d=0; d<naxis; d++)
+      rawoutc[d] = rawpos[d];
+    rawoutc[0] += x*step;
+    }
+/* Output pixel coordinates to world coordinates */
+  raw_to_wcs_line(wcsout, rawout, wcsbuf[t], n);
+  if (swapflag)
+    {
+    wcsbufc = wcsbuf[t];
+    for (x=n; x--; wcsbufc+=naxis)
+      if (*wcsbufc != WCS_NOCOORD)
+        {
+        worldc = wcsbufc[wcsout->lat];
+        wcsbufc[wcsout->lat] = wcsbufc[wcsin->lat];
+        wcsbufc[wcsin->lat] = worldc;
+        }
+    }
+/* World coordinates to input pixel coordinates */
+  wcs_to_raw_line(wcsin, wcsbuf[t], rawout, n);
+/* Local pixel area ratios */
+  if (areaout)
+    {
+    for (d=0; d<naxis; d++)
+      outpos[d] = rawpos[d];
+    rawoutc = rawout;
+    for (x=n; x--; outpos[0]+=step, rawoutc+=naxis, areaout++)
+      if (*rawoutc != WCS_NOCOORD)
+        *areaout = wcs_scale(wcsout, outpos) / wcs_scale(wcsin, rawoutc);
+    }
+
+  return;
+  }
+
+
+/****** write_line ************************************************************
+PROTO	void write_line(int l, int t)
+PURPOSE	Write a resampled image line and its weights.
+INPUT	Line buffer index,
+	thread number.
+OUTPUT	-.
+NOTES	Lines must be written in order. Except in compact format, lines are
+	only queued here, and written to disk by the output writer threads.
+	Only weights are written in weight-only mode.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+void	write_line(int l, int t)
+  {
+   double	t0;
+
+  t0 = perf_start();
+  if (compactflag)
+    {
+    if (!wonlyflag)
+      write_compact(field, riflag? (void *)routibuf[l] : (void *)routbuf[l]);
+    write_compact(wfield, riflag? (void *)routwibuf[l] : (void *)routwbuf[l]);
+    }
+  else if (riflag)
+    {
+    writer_line(writer, routibuf[l], width);
+    writer_line(wwriter, routwibuf[l], width);
+    }
+  else
+    {
+    if (!wonlyflag)
+      writer_line(writer, routbuf[l], width);
+    writer_line(wwriter, routwbuf[l], width);
+    }
+  perf_add(PERF_WRITE, t+1, t0, (double)width,
+	(double)width*((wonlyflag? 0 : field->tab->bytepix)
+		+ wfield->tab->bytepix));
+
   return;
   }
 
@@ -22,7 +22,7 @@
 *	You should have received a copy of the GNU General Public License
 *	along with SWarp. If not, see <http://www.gnu.org/licenses/>.
 *
-*	Last modified:		04/11/2020
+*	Last modified:		19/10/2026
 *
 *%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
 
@@ -46,6 +46,8 @@
 
 #define	INTERP_MAXDIM		10	/* Max. number of image dimensions */
 #define	INTERP_MAXKERNELWIDTH	 8	/* Max. range of kernel (pixels) */
+#define	RESAMP_SEGSIZE		16384	/* Min. number of samples per line */
+					/* segment processed by a thread */
 
 /*--------------------------------- typedefs --------------------------------*/
 /*-------------------------- structure definitions --------------------------*/
@@ -54,10 +56,6 @@
 
 /*-------------------------------- protos -----------------------------------*/
 
-#ifdef USE_THREADS
-extern void	cancel_resample_threads(void);
-#endif
-
 extern void	resample_field(fieldstruct **pinfield, fieldstruct **pinwfield,
 			fieldstruct **pindgeofield,
 			fieldstruct *outfield, fieldstruct *outwfield,
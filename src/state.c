@@ -0,0 +1,449 @@
+/*
+*				state.c
+*
+* Manage co-addition states for incremental co-additions.
+*
+*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+*
+*	This file part of:	SWarp
+*
+*	Copyright:		(C) 2026 CEA/AIM/UParisSaclay
+*
+*	License:		GNU General Public License
+*
+*	SWarp is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*	SWarp is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU General Public License for more details.
+*	You should have received a copy of the GNU General Public License
+*	along with SWarp. If not, see <http://www.gnu.org/licenses/>.
+*
+*	Last modified:		19/10/2026
+*
+*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+
+#ifdef HAVE_CONFIG_H
+#include	"config.h"
+#endif
+
+#ifdef HAVE_MATHIMF_H
+#include <mathimf.h>
+#else
+#include <math.h>
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "define.h"
+#include "globals.h"
+#include "fits/fitscat.h"
+#include "fitswcs.h"
+#include "coadd.h"
+#include "field.h"
+#include "prefs.h"
+#include "state.h"
+
+/*
+ A state file contains a header (stateheadstruct), the list of inputs that
+ have been co-added so far (stateinputstruct), and, for every output line,
+ the running sums of pixel values, of variances (or inverse variances for
+ WEIGHTED) and the number of contributing inputs. State files are written
+ in the native binary format of the machine.
+*/
+
+/****** init_state ***********************************************************
+PROTO	statestruct *init_state(char *filename, fieldstruct *outfield,
+			coaddenum coaddtype, int removeflag)
+PURPOSE	Load an existing co-addition state, or initialize a new one.
+INPUT	State filename,
+	pointer to the output field,
+	co-addition type,
+	flag set if inputs are to be removed from the state.
+OUTPUT	Pointer to the new state structure.
+NOTES	The output frame must be identical to that of the existing state.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+statestruct	*init_state(char *filename, fieldstruct *outfield,
+			coaddenum coaddtype, int removeflag)
+  {
+   statestruct		*state;
+   stateheadstruct	*head;
+   wcsstruct		*wcs;
+   int			d;
+
+  if (coaddtype != COADD_WEIGHTED && coaddtype != COADD_AVERAGE
+	&& coaddtype != COADD_SUM)
+    error(EXIT_FAILURE, "*Error*: incremental co-addition requires ",
+	"COMBINE_TYPE WEIGHTED, AVERAGE or SUM");
+
+  QCALLOC(state, statestruct, 1);
+  strcpy(state->filename, filename);
+  sprintf(state->newfilename, "%s%s", filename, STATE_EXT);
+  state->removeflag = removeflag;
+  state->width = outfield->width;
+  head = &state->head;
+  wcs = outfield->wcs;
+
+  if ((state->file = fopen(filename, "rb")))
+    {
+/*-- Read the previous state and check its compatibility */
+    QFREAD(head, sizeof(stateheadstruct), state->file, filename);
+    if (strncmp(head->magic, STATE_MAGIC, 8))
+      error(EXIT_FAILURE, "*Error*: not a co-addition state file: ",
+	filename);
+    if (head->coadd_type != (int)coaddtype)
+      error(EXIT_FAILURE, "*Error*: COMBINE_TYPE differs from that of ",
+	filename);
+    if (head->naxis != wcs->naxis)
+      error(EXIT_FAILURE, "*Error*: output frame differs from that of ",
+	filename);
+    for (d=0; d<wcs->naxis; d++)
+      if (head->naxisn[d] != wcs->naxisn[d]
+	|| fabs(head->crpix[d] - wcs->crpix[d]) > 1e-6
+	|| fabs(head->crval[d] - wcs->crval[d]) > 1e-9)
+        error(EXIT_FAILURE, "*Error*: output frame differs from that of ",
+		filename);
+    for (d=0; d<wcs->naxis*wcs->naxis; d++)
+      if (fabs(head->cd[d] - wcs->cd[d]) > 1e-9*fabs(wcs->cd[d]))
+        error(EXIT_FAILURE, "*Error*: output frame differs from that of ",
+		filename);
+    if (head->ninput)
+      {
+      QMALLOC(state->input, stateinputstruct, head->ninput);
+      QFREAD(state->input, head->ninput*sizeof(stateinputstruct),
+		state->file, filename);
+      }
+    QFTELL(state->file, state->bodypos, filename);
+    }
+  else
+    {
+    if (removeflag)
+      error(EXIT_FAILURE, "*Error*: cannot open co-addition state ",
+	filename);
+    memcpy(head->magic, STATE_MAGIC, 8);
+    head->coadd_type = (int)coaddtype;
+    head->naxis = wcs->naxis;
+    for (d=0; d<wcs->naxis; d++)
+      {
+      head->naxisn[d] = wcs->naxisn[d];
+      head->crval[d] = wcs->crval[d];
+      head->crpix[d] = wcs->crpix[d];
+      }
+    for (d=0; d<wcs->naxis*wcs->naxis; d++)
+      head->cd[d] = wcs->cd[d];
+    }
+
+  QMALLOC(state->sum, double, state->width);
+  QMALLOC(state->sumw, double, state->width);
+  QMALLOC(state->nsum, unsigned int, state->width);
+
+  return state;
+  }
+
+
+/****** update_state *********************************************************
+PROTO	void update_state(statestruct *state, fieldstruct **infield,
+			int ninput, fieldstruct *outfield)
+PURPOSE	Add or remove inputs from the state, update the output exposure time,
+	gain and saturation level accordingly, and start the new state file.
+INPUT	Pointer to the state,
+	input field ptr array,
+	number of input fields,
+	pointer to the output field.
+OUTPUT	-.
+NOTES	Output metadata are computed from all the inputs in the state as
+	coadd_fields() does with its own inputs. Input frame limits in the
+	output frame and saturation levels must have been computed.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+void	update_state(statestruct *state, fieldstruct **infield,
+			int ninput, fieldstruct *outfield)
+  {
+   stateheadstruct	*head;
+   stateinputstruct	*input;
+   char			name[MAXCHAR],
+			*pstr;
+   double		exptime, w,w1,w2, mw, satlev;
+   unsigned int		*array;
+   int			*maxclique,
+			d, i, n,n1,n2, flag, fieldno, fieldnomax, omax, omax2;
+
+  head = &state->head;
+  fieldnomax = 0;
+  for (n=0; n<ninput; n++)
+    {
+/*-- Inputs are identified by their resampled file name without extension */
+    strcpy(name, (pstr=strrchr(infield[n]->filename, '/'))?
+		pstr+1 : infield[n]->filename);
+    if ((pstr=strrchr(name, '.')))
+      *pstr = '\0';
+    for (i=0; i<head->ninput; i++)
+      if (!strcmp(state->input[i].name, name))
+        break;
+    if (state->removeflag)
+      {
+      if (i==head->ninput)
+        error(EXIT_FAILURE, "*Error*: input not found in co-addition state: ",
+		name);
+      memmove(state->input+i, state->input+i+1,
+		(head->ninput-i-1)*sizeof(stateinputstruct));
+      head->ninput--;
+      }
+    else
+      {
+      if (i<head->ninput)
+        error(EXIT_FAILURE, "*Error*: input already in co-addition state: ",
+		name);
+      if (head->ninput)
+        {
+        QREALLOC(state->input, stateinputstruct, head->ninput+1);
+        }
+      else
+        {
+        QMALLOC(state->input, stateinputstruct, 1);
+        }
+      input = state->input + head->ninput++;
+      memset(input, 0, sizeof(stateinputstruct));
+      strcpy(input->name, name);
+      input->fileno = head->nfileno + infield[n]->fieldno;
+      if (infield[n]->fieldno > fieldnomax)
+        fieldnomax = infield[n]->fieldno;
+      for (d=0; d<infield[n]->wcs->naxis; d++)
+        {
+        input->outmin[d] = (int)infield[n]->wcs->outmin[d];
+        input->outmax[d] = (int)infield[n]->wcs->outmax[d];
+        }
+      input->exptime = infield[n]->exptime;
+      input->backsig = infield[n]->backsig;
+      input->fbacksig = infield[n]->fbacksig;
+      input->fgain = infield[n]->fgain;
+      input->fsaturation = infield[n]->fsaturation;
+      }
+    }
+  if (!state->removeflag)
+    head->nfileno += fieldnomax+1;
+
+/* Find the densest overlap among all inputs in the state */
+  ninput = head->ninput;
+  exptime = w1 = w2 = mw = 0.0;
+  satlev = BIG;
+  omax2 = 0;
+  if (ninput)
+    {
+    QCALLOC(array, unsigned int,
+	ninput*(1+(ninput-1)/(8*sizeof(unsigned int))));
+    for (n1=0; n1<ninput; n1++)
+      {
+      SET_ARRAY_BIT(array,ninput,n1,n1);
+      for (n2=n1+1; n2<ninput; n2++)
+        {
+        flag = 1;
+        for (d=0; d<head->naxis; d++)
+          if (state->input[n2].outmin[d] > state->input[n1].outmax[d]
+		|| state->input[n2].outmax[d] < state->input[n1].outmin[d])
+            {
+            flag = 0;
+            break;
+            }
+        if (flag)
+          {
+          SET_ARRAY_BIT(array,ninput,n1,n2);
+          SET_ARRAY_BIT(array,ninput,n2,n1);
+          }
+        }
+      }
+    omax = max_clique(array, ninput, &maxclique);
+    free(array);
+
+/*-- Compute maximum gain and maximum total exposure time */
+    fieldno = -1;
+    for (n=0; n<omax; n++)
+      {
+      input = state->input + maxclique[n];
+      if (input->fileno == fieldno)
+        continue;
+      omax2++;
+      fieldno = input->fileno;
+      exptime += input->exptime;
+      w = (head->coadd_type == COADD_WEIGHTED && input->backsig > 0.0)?
+		1.0/(input->fbacksig*input->fbacksig) : 1.0;
+      w1 += w;
+      if (input->fgain > 0.0)
+        {
+        w2 += w*w/input->fgain;
+        mw += input->fgain;
+        }
+      }
+    free(maxclique);
+
+/*-- Output saturation level (the minimum on all saturation) */
+    for (n=0; n<ninput; n++)
+      if (state->input[n].fsaturation < satlev)
+        satlev = state->input[n].fsaturation;
+    }
+
+  outfield->fieldno = omax2;
+  outfield->exptime = exptime;
+  outfield->fgain = 0.0;
+  if (w2 > 0.0)
+    outfield->fgain = (head->coadd_type == COADD_SUM)?
+		w1*w1/w2/omax2 : w1*w1/w2;
+  outfield->gain = outfield->fgain;
+  outfield->saturation = outfield->fsaturation = satlev;
+
+/* Start writing the updated state */
+  if (!(state->newfile = fopen(state->newfilename, "wb")))
+    error(EXIT_FAILURE, "*Error*: cannot open for writing ",
+	state->newfilename);
+  add_cleanupfilename(state->newfilename);
+  QFWRITE(head, sizeof(stateheadstruct), state->newfile, state->newfilename);
+  if (head->ninput)
+    {
+    QFWRITE(state->input, head->ninput*sizeof(stateinputstruct),
+	state->newfile, state->newfilename);
+    }
+
+  return;
+  }
+
+
+/****** merge_state **********************************************************
+PROTO	void merge_state(statestruct *state, int y, double *sum, double *sumw,
+			unsigned int *nsum, PIXTYPE *outpix, PIXTYPE *outwpix)
+PURPOSE	Merge the accumulators of an output line with those of the state and
+	compute the final pixel values and variances.
+INPUT	Pointer to the state,
+	output line index,
+	pointer to the line of pixel sums,
+	pointer to the line of variance (or inverse variance) sums,
+	pointer to the line of input counts,
+	pointer to the output pixel line,
+	pointer to the output variance line.
+OUTPUT	-.
+NOTES	Lines must be merged in order. Pixels with no input are blanked.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+void	merge_state(statestruct *state, int y, double *sum, double *sumw,
+			unsigned int *nsum, PIXTYPE *outpix, PIXTYPE *outwpix)
+  {
+   double		*ssum, *ssumw,
+			wval;
+   unsigned int		*snsum,
+			n;
+   size_t		linesize;
+   int			x, width;
+
+  width = state->width;
+  ssum = state->sum;
+  ssumw = state->sumw;
+  snsum = state->nsum;
+  linesize = width*(2*sizeof(double)+sizeof(unsigned int));
+  if (state->file)
+    {
+    QFSEEK(state->file, state->bodypos+(OFF_T2)y*linesize, SEEK_SET,
+	state->filename);
+    QFREAD(ssum, width*sizeof(double), state->file, state->filename);
+    QFREAD(ssumw, width*sizeof(double), state->file, state->filename);
+    QFREAD(snsum, width*sizeof(unsigned int), state->file, state->filename);
+    }
+  else
+    {
+    memset(ssum, 0, width*sizeof(double));
+    memset(ssumw, 0, width*sizeof(double));
+    memset(snsum, 0, width*sizeof(unsigned int));
+    }
+
+  if (state->removeflag)
+    for (x=0; x<width; x++)
+      {
+      if (nsum[x] >= snsum[x])
+        ssum[x] = ssumw[x] = snsum[x] = 0;	/* Avoid rounding residuals */
+      else
+        {
+        ssum[x] -= sum[x];
+        ssumw[x] -= sumw[x];
+        snsum[x] -= nsum[x];
+        }
+      }
+  else
+    for (x=0; x<width; x++)
+      {
+      ssum[x] += sum[x];
+      ssumw[x] += sumw[x];
+      snsum[x] += nsum[x];
+      }
+
+  QFWRITE(ssum, width*sizeof(double), state->newfile, state->newfilename);
+  QFWRITE(ssumw, width*sizeof(double), state->newfile, state->newfilename);
+  QFWRITE(snsum, width*sizeof(unsigned int), state->newfile,
+	state->newfilename);
+
+/* Final values, as in coadd_line() */
+  for (x=0; x<width; x++)
+    {
+    if (!(n=snsum[x]))
+      {
+      outpix[x] = 0.0;
+      outwpix[x] = BIG;
+      continue;
+      }
+    switch(state->head.coadd_type)
+      {
+      case COADD_WEIGHTED:
+        outwpix[x] = (wval = 1.0/ssumw[x]);
+        outpix[x] = ssum[x]*wval;
+        break;
+      case COADD_AVERAGE:
+        outpix[x] = ssum[x]/n;
+        outwpix[x] = ssumw[x]/((double)n*n);
+        break;
+      case COADD_SUM:
+      default:
+        outpix[x] = ssum[x];
+        outwpix[x] = ssumw[x];
+        break;
+      }
+    }
+
+  return;
+  }
+
+
+/****** end_state ************************************************************
+PROTO	void end_state(statestruct *state)
+PURPOSE	Replace the previous state file with the updated one and free memory.
+INPUT	Pointer to the state.
+OUTPUT	-.
+NOTES	-.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+void	end_state(statestruct *state)
+  {
+  if (state->file)
+    fclose(state->file);
+  if (state->newfile)
+    {
+    if (fclose(state->newfile))
+      error(EXIT_FAILURE, "*Error* while writing ", state->newfilename);
+    if (rename(state->newfilename, state->filename))
+      error(EXIT_FAILURE, "*Error*: cannot update ", state->filename);
+    remove_cleanupfilename(state->newfilename);
+    }
+  free(state->input);
+  free(state->sum);
+  free(state->sumw);
+  free(state->nsum);
+  free(state);
+
+  return;
+  }
+
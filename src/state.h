@@ -0,0 +1,105 @@
+/*
+*				state.h
+*
+* Include file for state.c.
+*
+*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+*
+*	This file part of:	SWarp
+*
+*	Copyright:		(C) 2026 CEA/AIM/UParisSaclay
+*
+*	License:		GNU General Public License
+*
+*	SWarp is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*	SWarp is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU General Public License for more details.
+*	You should have received a copy of the GNU General Public License
+*	along with SWarp. If not, see <http://www.gnu.org/licenses/>.
+*
+*	Last modified:		19/10/2026
+*
+*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+
+#ifndef _FITSCAT_H_
+#include "fits/fitscat.h"
+#endif
+
+#ifndef _COADD_H_
+#include "coadd.h"
+#endif
+
+#ifndef _FIELD_H_
+#include "field.h"
+#endif
+
+#ifndef _FITSWCS_H_
+#include "fitswcs.h"
+#endif
+
+#ifndef	_STATE_H_
+#define	_STATE_H_
+
+/*------------------------------- constants ---------------------------------*/
+#define	STATE_MAGIC	"SWSTATE1"	/* State file signature */
+#define	STATE_EXT	".tmp"		/* Extension of the updated state file */
+
+/*-------------------------- structure definitions --------------------------*/
+typedef struct stateinput
+  {
+  char		name[MAXCHAR];		/* Input identifier */
+  int		fileno;			/* File number (one per MEF file) */
+  int		outmin[NAXIS];		/* Lower limits in output frame */
+  int		outmax[NAXIS];		/* Upper limits in output frame */
+  double	exptime;		/* Exposure time (s) */
+  double	backsig;		/* Background RMS */
+  double	fbacksig;		/* Flux-scaled background RMS */
+  double	fgain;			/* Flux-scaled gain */
+  double	fsaturation;		/* Flux-scaled saturation */
+  }	stateinputstruct;
+
+typedef struct statehead
+  {
+  char		magic[8];		/* File signature */
+  int		coadd_type;		/* Co-addition type */
+  int		naxis;			/* Number of output axes */
+  int		naxisn[NAXIS];		/* Output frame size */
+  double	crval[NAXIS];		/* Output CRVALs */
+  double	crpix[NAXIS];		/* Output CRPIXs */
+  double	cd[NAXIS*NAXIS];	/* Output CD matrix */
+  int		ninput;			/* Number of inputs in the state */
+  int		nfileno;		/* Next available file number */
+  }	stateheadstruct;
+
+typedef struct state
+  {
+  char		filename[MAXCHAR];	/* State filename */
+  char		newfilename[MAXCHAR];	/* Updated state filename */
+  FILE		*file;			/* Previous state file (or NULL) */
+  FILE		*newfile;		/* Updated state file */
+  stateheadstruct	head;		/* Header of the state file */
+  stateinputstruct	*input;		/* Inputs already in the state */
+  int		width;			/* Line width (pixels) */
+  int		removeflag;		/* Remove instead of add inputs? */
+  OFF_T2	bodypos;		/* Start of pixel data in old file */
+  double	*sum, *sumw;		/* Line accumulators */
+  unsigned int	*nsum;			/* Line input counters */
+  }	statestruct;
+
+/*-------------------------------- protos -----------------------------------*/
+extern statestruct	*init_state(char *filename, fieldstruct *outfield,
+				coaddenum coaddtype, int removeflag);
+
+extern void		end_state(statestruct *state),
+			merge_state(statestruct *state, int y, double *sum,
+				double *sumw, unsigned int *nsum,
+				PIXTYPE *outpix, PIXTYPE *outwpix),
+			update_state(statestruct *state, fieldstruct **infield,
+				int ninput, fieldstruct *outfield);
+
+#endif
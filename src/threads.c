@@ -24,7 +24,7 @@
 *	along with AstrOmatic software.
 *	If not, see <http://www.gnu.org/licenses/>.
 *
-*	Last modified:		26/08/2020
+*	Last modified:		19/10/2026
 *
 *%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
 
@@ -44,12 +44,19 @@
 #include "types.h"
 #include "globals.h"
 #include "fits/fitscat.h"
+#include "numa.h"
 
 /*------------------- global variables for multithreading -------------------*/
 
  int		nproc;	/* Number of child threads */
 
 #ifdef USE_THREADS
+ threads_pool_t	*threads_pool;	/* Process-wide pool of workers */
+
+static threads_task_t	*threads_pool_pop(threads_pool_t *pool, int t,
+				threads_job_t *job);
+static void		threads_pool_done(threads_task_t *task),
+			*threads_pool_worker(void *arg);
 
 /******* threads_gate_init ***************************************************
 PROTO	threads_gate_t *threads_gate_init(int nthreads, void (*func)(void))
@@ -141,4 +148,323 @@ void threads_gate_sync(threads_gate_t *gate)
   return;
   }
 
+
+/*
+ The worker pool is created once for the whole run. Every worker owns a
+ queue of tasks; tasks queued by a worker go to its own queue, other tasks
+ are dealt round-robin. Idle workers take tasks from their own queue first,
+ and steal from the other queues when theirs is empty. Tasks are grouped in
+ jobs, whose completion can be waited for.
+*/
+
+/******* threads_pool_init ***************************************************
+PROTO	threads_pool_t *threads_pool_init(int nthreads)
+PURPOSE	Create a pool of worker threads.
+INPUT	Number of worker threads.
+OUTPUT	Pointer to the new pool.
+NOTES	Workers are pinned to their NUMA node (if NUMA_AFFINITY is set), hence
+	init_numa() must have been called first.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+threads_pool_t	*threads_pool_init(int nthreads)
+  {
+   threads_pool_t	*pool;
+   int			t;
+
+  QCALLOC(pool, threads_pool_t, 1);
+  pool->nthreads = nthreads>0? nthreads : 1;
+  QCALLOC(pool->worker, threads_worker_t, pool->nthreads);
+  QPTHREAD_MUTEX_INIT(&pool->mutex, NULL);
+  QPTHREAD_COND_INIT(&pool->cond, NULL);
+  if (pthread_key_create(&pool->key, NULL))
+    error(EXIT_FAILURE, "*Error*: pthread_key_create() failed for ",
+		"&pool->key");
+  for (t=0; t<pool->nthreads; t++)
+    {
+    pool->worker[t].pool = pool;
+    pool->worker[t].index = t;
+    QPTHREAD_CREATE(&pool->worker[t].thread, NULL, &threads_pool_worker,
+		&pool->worker[t]);
+    }
+
+  return pool;
+  }
+
+
+/******* threads_pool_end ****************************************************
+PROTO	void threads_pool_end(threads_pool_t *pool)
+PURPOSE	Shut down a pool of worker threads.
+INPUT	Pointer to the pool.
+OUTPUT	-.
+NOTES	Pending tasks are completed before the workers exit.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+void	threads_pool_end(threads_pool_t *pool)
+  {
+   int	t;
+
+  QPTHREAD_MUTEX_LOCK(&pool->mutex);
+  pool->endflag = 1;
+  QPTHREAD_COND_BROADCAST(&pool->cond);
+  QPTHREAD_MUTEX_UNLOCK(&pool->mutex);
+  for (t=0; t<pool->nthreads; t++)
+    QPTHREAD_JOIN(pool->worker[t].thread, NULL);
+  pthread_key_delete(pool->key);
+  QPTHREAD_MUTEX_DESTROY(&pool->mutex);
+  QPTHREAD_COND_DESTROY(&pool->cond);
+  free(pool->worker);
+  free(pool);
+
+  return;
+  }
+
+
+/******* threads_pool_cancel *************************************************
+PROTO	void threads_pool_cancel(void)
+PURPOSE	Cancel the workers of the process-wide pool.
+INPUT	-.
+OUTPUT	-.
+NOTES	Meant to be called from the cleanup routine on abnormal termination.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+void	threads_pool_cancel(void)
+  {
+   int	t;
+
+  if (!threads_pool)
+    return;
+  for (t=0; t<threads_pool->nthreads; t++)
+    QPTHREAD_CANCEL(threads_pool->worker[t].thread);
+
+  return;
+  }
+
+
+/******* threads_pool_self ***************************************************
+PROTO	int threads_pool_self(threads_pool_t *pool)
+PURPOSE	Return the index of the calling thread in a pool.
+INPUT	Pointer to the pool.
+OUTPUT	Worker index, or -1 if the caller is not a worker of the pool.
+NOTES	-.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+int	threads_pool_self(threads_pool_t *pool)
+  {
+   threads_worker_t	*worker;
+
+  if (!pool || !(worker=(threads_worker_t *)pthread_getspecific(pool->key)))
+    return -1;
+
+  return worker->index;
+  }
+
+
+/******* threads_job_init ****************************************************
+PROTO	threads_job_t *threads_job_init(threads_pool_t *pool)
+PURPOSE	Create a new (empty) job.
+INPUT	Pointer to the pool that will run the job tasks.
+OUTPUT	Pointer to the new job.
+NOTES	-.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+threads_job_t	*threads_job_init(threads_pool_t *pool)
+  {
+   threads_job_t	*job;
+
+  QCALLOC(job, threads_job_t, 1);
+  job->pool = pool;
+  QPTHREAD_COND_INIT(&job->done, NULL);
+
+  return job;
+  }
+
+
+/******* threads_job_add *****************************************************
+PROTO	void threads_job_add(threads_job_t *job, void *(*func)(void *),
+		void *arg)
+PURPOSE	Queue a new task for a job.
+INPUT	Pointer to the job,
+	pointer to the task function,
+	argument passed to the task function.
+OUTPUT	-.
+NOTES	Tasks that wait for each other (e.g. through gates) must not outnumber
+	the pool workers, and must not be queued from within another task.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+void	threads_job_add(threads_job_t *job, void *(*func)(void *), void *arg)
+  {
+   threads_pool_t	*pool;
+   threads_worker_t	*worker;
+   threads_task_t	*task;
+   int			t;
+
+  pool = job->pool;
+  QMALLOC(task, threads_task_t, 1);
+  task->func = func;
+  task->arg = arg;
+  task->job = job;
+  task->next = NULL;
+  QPTHREAD_MUTEX_LOCK(&pool->mutex);
+  if ((t = threads_pool_self(pool)) < 0)
+    {
+    t = pool->nextqueue;
+    pool->nextqueue = (t+1)%pool->nthreads;
+    }
+  worker = pool->worker + t;
+  if ((task->prev = worker->tail))
+    worker->tail->next = task;
+  else
+    worker->head = task;
+  worker->tail = task;
+  job->ntask++;
+  QPTHREAD_COND_BROADCAST(&pool->cond);
+  QPTHREAD_MUTEX_UNLOCK(&pool->mutex);
+
+  return;
+  }
+
+
+/******* threads_job_end *****************************************************
+PROTO	void threads_job_end(threads_job_t *job)
+PURPOSE	Wait for all the tasks of a job to be completed, and destroy it.
+INPUT	Pointer to the job.
+OUTPUT	-.
+NOTES	The calling thread runs pending tasks of the job while waiting.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+void	threads_job_end(threads_job_t *job)
+  {
+   threads_pool_t	*pool;
+   threads_task_t	*task;
+
+  pool = job->pool;
+  QPTHREAD_MUTEX_LOCK(&pool->mutex);
+  while (job->ntask)
+    if ((task = threads_pool_pop(pool, threads_pool_self(pool), job)))
+      {
+      QPTHREAD_MUTEX_UNLOCK(&pool->mutex);
+      task->func(task->arg);
+      QPTHREAD_MUTEX_LOCK(&pool->mutex);
+      threads_pool_done(task);
+      }
+    else
+      QPTHREAD_COND_WAIT(&job->done, &pool->mutex);
+  QPTHREAD_MUTEX_UNLOCK(&pool->mutex);
+  QPTHREAD_COND_DESTROY(&job->done);
+  free(job);
+
+  return;
+  }
+
+
+/******* threads_pool_pop ****************************************************
+PROTO	threads_task_t *threads_pool_pop(threads_pool_t *pool, int t,
+		threads_job_t *job)
+PURPOSE	Remove the next task to run from the pool queues.
+INPUT	Pointer to the pool,
+	index of the calling worker (-1 if not a worker),
+	pointer to a job the task must belong to (NULL for any job).
+OUTPUT	Pointer to the task, or NULL if no task is available.
+NOTES	The worker own queue is searched from its head first; other queues
+	are then searched from their tail (work stealing). Must be called with
+	the pool mutex locked.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+static threads_task_t	*threads_pool_pop(threads_pool_t *pool, int t,
+				threads_job_t *job)
+  {
+   threads_worker_t	*worker;
+   threads_task_t	*task;
+   int			k, w;
+
+  task = NULL;
+  for (k=0; k<pool->nthreads && !task; k++)
+    {
+    w = (t<0? k : t+k)%pool->nthreads;
+    worker = pool->worker + w;
+    if (w==t)
+      for (task=worker->head; task && job && task->job!=job;task=task->next);
+    else
+      for (task=worker->tail; task && job && task->job!=job;task=task->prev);
+    if (task)
+      {
+      if (task->prev)
+        task->prev->next = task->next;
+      else
+        worker->head = task->next;
+      if (task->next)
+        task->next->prev = task->prev;
+      else
+        worker->tail = task->prev;
+      }
+    }
+
+  return task;
+  }
+
+
+/******* threads_pool_done ***************************************************
+PROTO	void threads_pool_done(threads_task_t *task)
+PURPOSE	Account for a completed task and free it.
+INPUT	Pointer to the task.
+OUTPUT	-.
+NOTES	Must be called with the pool mutex locked.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+static void	threads_pool_done(threads_task_t *task)
+  {
+  if (!--task->job->ntask)
+    QPTHREAD_COND_BROADCAST(&task->job->done);
+  free(task);
+
+  return;
+  }
+
+
+/******* threads_pool_worker *************************************************
+PROTO	void *threads_pool_worker(void *arg)
+PURPOSE	Worker thread: run queued tasks until the pool is shut down.
+INPUT	Pointer to the worker structure.
+OUTPUT	NULL void pointer.
+NOTES	-.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+static void	*threads_pool_worker(void *arg)
+  {
+   threads_worker_t	*worker;
+   threads_pool_t	*pool;
+   threads_task_t	*task;
+
+  worker = (threads_worker_t *)arg;
+  pool = worker->pool;
+  pthread_setspecific(pool->key, worker);
+  numa_pinthread(worker->index);
+  QPTHREAD_MUTEX_LOCK(&pool->mutex);
+  for (;;)
+    {
+    while (!(task = threads_pool_pop(pool, worker->index, NULL))
+	&& !pool->endflag)
+      QPTHREAD_COND_WAIT(&pool->cond, &pool->mutex);
+    if (!task)
+      break;
+    QPTHREAD_MUTEX_UNLOCK(&pool->mutex);
+    task->func(task->arg);
+    QPTHREAD_MUTEX_LOCK(&pool->mutex);
+    threads_pool_done(task);
+    }
+  QPTHREAD_MUTEX_UNLOCK(&pool->mutex);
+
+  return (void *)NULL;
+  }
+
 #endif
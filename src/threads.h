@@ -23,7 +23,7 @@
 *	along with AstrOmatic software.
 *	If not, see <http://www.gnu.org/licenses/>.
 *
-*	Last modified:		26/08/2020
+*	Last modified:		19/10/2026
 *
 *%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
 
@@ -131,13 +131,57 @@ typedef struct _threads_gate_t
   pthread_cond_t	last;		/* To wake the remaining thread up */
   } threads_gate_t;
 
+typedef struct _threads_task_t
+  {
+  void			*(*func)(void *);	/* Task function */
+  void			*arg;		/* Argument passed to func() */
+  struct _threads_job_t	*job;		/* Job the task belongs to */
+  struct _threads_task_t *prev, *next;	/* Links in the worker queue */
+  } threads_task_t;
+
+typedef struct _threads_worker_t
+  {
+  struct _threads_pool_t *pool;		/* Pool the worker belongs to */
+  pthread_t		thread;		/* Worker thread */
+  threads_task_t	*head, *tail;	/* Queue of pending tasks */
+  int			index;		/* Worker index in the pool */
+  } threads_worker_t;
+
+typedef struct _threads_pool_t
+  {
+  int			nthreads;	/* Number of worker threads */
+  threads_worker_t	*worker;	/* Worker threads and their queues */
+  int			nextqueue;	/* Queue for tasks from other threads */
+  int			endflag;	/* Set at pool shutdown */
+  pthread_key_t		key;		/* Worker of the calling thread */
+  pthread_mutex_t	mutex;		/* Protects queues and jobs */
+  pthread_cond_t	cond;		/* Signaled when a task is queued */
+  } threads_pool_t;
+
+typedef struct _threads_job_t
+  {
+  threads_pool_t	*pool;		/* Pool running the tasks */
+  int			ntask;		/* Number of unfinished tasks */
+  pthread_cond_t	done;		/* Signaled when all tasks are done */
+  } threads_job_t;
+
 /*----------------------------- Global variables ----------------------------*/
  extern int		nproc;	/* Number of child threads */
+ extern threads_pool_t	*threads_pool;	/* Process-wide pool of workers */
 
 /*--------------------------------- Functions -------------------------------*/
 threads_gate_t		*threads_gate_init(int nthreads, void (*func)(void));
+threads_job_t		*threads_job_init(threads_pool_t *pool);
+threads_pool_t		*threads_pool_init(int nthreads);
+
+ extern int		threads_pool_self(threads_pool_t *pool);
 
  extern void		threads_gate_end(threads_gate_t *gate),
-			threads_gate_sync(threads_gate_t *gate);
+			threads_gate_sync(threads_gate_t *gate),
+			threads_job_add(threads_job_t *job,
+				void *(*func)(void *), void *arg),
+			threads_job_end(threads_job_t *job),
+			threads_pool_cancel(void),
+			threads_pool_end(threads_pool_t *pool);
 
 #endif // _THREADS_H_
@@ -23,7 +23,7 @@
 *	along with AstrOmatic software.
 *	If not, see <http://www.gnu.org/licenses/>.
 *
-*	Last modified:		03/12/2019
+*	Last modified:		19/10/2026
 *
 *%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
 
@@ -64,6 +64,8 @@
 			#ptrout " (" #nel " elements) !"); \
 		memcpy(ptrout, ptrin, (size_t)(nel)*sizeof(typ));};;}
 
+static double	poly_funcbasis(polystruct *poly, double *pos, double *basis);
+
 /********************************* qerror ************************************/
 /*
 I hope it will never be used!
@@ -231,9 +233,44 @@ AUTHOR  E. Bertin (IAP)
 VERSION 03/03/2004
  ***/
 double	poly_func(polystruct *poly, double *pos)
+  {
+  return poly_funcbasis(poly, pos, poly->basis);
+  }
+
+
+/****** poly_func_r **********************************************************
+PROTO   double poly_func_r(polystruct *poly, double *pos)
+PURPOSE Evaluate a multidimensional polynomial without modifying the polystruct.
+INPUT   polystruct pointer,
+        pointer to the 1D array of input vector data.
+OUTPUT  Polynom value.
+NOTES   Reentrant version of poly_func(): the same polystruct may be used
+	simultaneously by several threads. poly->basis is left untouched.
+AUTHOR  E. Bertin (CEA/AIM/UParisSaclay)
+VERSION 19/10/2026
+ ***/
+double	poly_func_r(polystruct *poly, double *pos)
+  {
+  return poly_funcbasis(poly, pos, NULL);
+  }
+
+
+/****** poly_funcbasis *******************************************************
+PROTO   double poly_funcbasis(polystruct *poly, double *pos, double *basis)
+PURPOSE Evaluate a multidimensional polynomial and optionally store the values
+	of the basis functions.
+INPUT   polystruct pointer,
+        pointer to the 1D array of input vector data,
+        pointer to the output basis function values (or NULL).
+OUTPUT  Polynom value.
+NOTES   -.
+AUTHOR  E. Bertin (CEA/AIM/UParisSaclay)
+VERSION 19/10/2026
+ ***/
+static double	poly_funcbasis(polystruct *poly, double *pos, double *basis)
   {
    double	xpol[POLY_MAXDIM+1];
-   double      	*post, *xpolt, *basis, *coeff, xval;
+   double      	*post, *xpolt, *coeff, xval;
    long double	val;
    int		expo[POLY_MAXDIM+1], gexpo[POLY_MAXDIM+1];
    int	       	*expot, *degree,*degreet, *group,*groupt, *gexpot,
@@ -241,7 +278,6 @@ double	poly_func(polystruct *poly, double *pos)
 
 /* Prepare the vectors and counters */
   ndim = poly->ndim;
-  basis = poly->basis;
   coeff = poly->coeff;
   group = poly->group;
   degree = poly->degree;
@@ -260,7 +296,8 @@ double	poly_func(polystruct *poly, double *pos)
 
 /* The constant term is handled separately */
   val = *(coeff++);
-  *(basis++) = 1.0;
+  if (basis)
+    *(basis++) = 1.0;
   *expo = 1;
   *xpol = *pos;
 
@@ -268,7 +305,9 @@ double	poly_func(polystruct *poly, double *pos)
   for (t=poly->ncoeff; --t; )
     {
 /*-- xpol[0] contains the current product of the x^n's */
-    val += (*(basis++)=*xpol)**(coeff++);
+    if (basis)
+      *(basis++) = *xpol;
+    val += *xpol**(coeff++);
 /*-- A complex recursion between terms of the polynom speeds up computations */
 /*-- Not too good for roundoff errors (prefer Horner's), but much easier for */
 /*-- multivariate polynomials: this is why we use a long double accumulator */
@@ -23,7 +23,7 @@
 *	along with AstrOmatic software.
 *	If not, see <http://www.gnu.org/licenses/>.
 *
-*	Last modified:		03/12/2019
+*	Last modified:		19/10/2026
 *
 *%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
 
@@ -59,7 +59,8 @@ typedef struct poly
 extern polystruct	*poly_copy(polystruct *poly),
 			*poly_init(int *group,int ndim,int *degree,int ngroup);
 
-extern double		poly_func(polystruct *poly, double *pos);
+extern double		poly_func(polystruct *poly, double *pos),
+			poly_func_r(polystruct *poly, double *pos);
 
 extern int		cholsolve(double *a, double *b, int n),
 			poly_fit(polystruct *poly, double *x, double *y,
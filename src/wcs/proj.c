@@ -24,7 +24,7 @@
 *	along with AstrOmatic software.
 *	If not, see <http://www.gnu.org/licenses/>.
 *
-*	Last modified:		31/03/2015
+*	Last modified:		19/10/2026
 *
 *%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
 /*============================================================================
@@ -258,6 +258,28 @@ const char *prjrev_errmsg[] = {
 
 #define wcs_copysign(X, Y) ((Y) < 0.0 ? -fabs(X) : fabs(X))
 
+static int	prj_newton(struct prjprm *prj, double x, double y,
+			double *xo, double *yo,
+			void (*func)(struct prjprm *, double, double,
+				double *, double *, double *));
+static void	pv_jacobian(double *c, int nterm, double u, double v,
+			double *dpdu, double *dpdv),
+		pv_func(struct prjprm *prj, double x, double y,
+			double *xo, double *yo, double *jac),
+		tnx_func(struct prjprm *prj, double x, double y,
+			double *xo, double *yo, double *jac);
+
+/* Exponents of u, v and r=sqrt(u^2+v^2) for the 40 TPV polynomial terms */
+static const int pv_expo[40][3] = {
+	{0,0,0}, {1,0,0}, {0,1,0}, {0,0,1},
+	{2,0,0}, {1,1,0}, {0,2,0},
+	{3,0,0}, {2,1,0}, {1,2,0}, {0,3,0}, {0,0,3},
+	{4,0,0}, {3,1,0}, {2,2,0}, {1,3,0}, {0,4,0},
+	{5,0,0}, {4,1,0}, {3,2,0}, {2,3,0}, {1,4,0}, {0,5,0}, {0,0,5},
+	{6,0,0}, {5,1,0}, {4,2,0}, {3,3,0}, {2,4,0}, {1,5,0}, {0,6,0},
+	{7,0,0}, {6,1,0}, {5,2,0}, {4,3,0}, {3,4,0}, {2,5,0}, {1,6,0}, {0,7,0},
+	{0,0,7}};
+
 /*============================================================================
 *   AZP: zenithal/azimuthal perspective projection.
 *
@@ -426,8 +448,10 @@ double *x, *y;
    xp[1] = -r*wcs_cosd(phi);
    if (prj->n) {
      if ((prj->inv_x) && (prj->inv_y)) {
-       *x = prj->inv_x? poly_func(prj->inv_x, xp) : xp[0];
-       *y = prj->inv_y? poly_func(prj->inv_y, xp) : xp[1];
+       *x = prj->inv_x? poly_func_r(prj->inv_x, xp) : xp[0];
+       *y = prj->inv_y? poly_func_r(prj->inv_y, xp) : xp[1];
+     } else if (prj->inv_newton) {
+       if (pv_to_raw_newton(prj, xp[0],xp[1], x,y)) return 2;
      } else
        pv_to_raw(prj, xp[0],xp[1], x,y);
    } else {
@@ -3675,8 +3699,12 @@ double *x, *y;
    r =  prj->r0*wcs_cosd(theta)/s;
    xp[0] =  r*wcs_sind(phi);
    xp[1] = -r*wcs_cosd(phi);
-   *x = prj->inv_x? poly_func(prj->inv_x, xp) : xp[0];
-   *y = prj->inv_y? poly_func(prj->inv_y, xp) : xp[1];
+   if (prj->inv_newton) {
+     if (tnx_to_raw_newton(prj, xp[0],xp[1], x,y)) return 2;
+   } else {
+     *x = prj->inv_x? poly_func_r(prj->inv_x, xp) : xp[0];
+     *y = prj->inv_y? poly_func_r(prj->inv_y, xp) : xp[1];
+   }
 
    if (prj->flag == PRJSET && s < 0.0) {
       return 2;
@@ -3879,6 +3907,160 @@ int pv_to_raw(struct prjprm *prj, double x, double y, double *xo, double *yo)
 
    return 0;
 }
+/*--------------------------------------------------------------------------*/
+/* Invert the TPV distortion with Newton's method, starting from the inverse
+   of its linear part. The Jacobian is derived analytically from the
+   polynomial. */
+
+int pv_to_raw_newton(struct prjprm *prj, double x, double y,
+		double *xo, double *yo)
+
+{
+   double	*a, *b, det;
+
+   if (abs(prj->flag) != PRJSET) {
+      if (tanset(prj)) return 1;
+   }
+
+   a = prj->p+100;		/* Latitude comes first for compatibility */
+   b = prj->p;			/* Longitude */
+   det = prj->n>1? a[1]*b[1] - a[2]*b[2] : a[1]*b[1];
+   if (det == 0.0) {
+      *xo = x;
+      *yo = y;
+   } else if (prj->n>1) {
+      *xo = (b[1]*(x-a[0]) - a[2]*(y-b[0]))/det;
+      *yo = (a[1]*(y-b[0]) - b[2]*(x-a[0]))/det;
+   } else {
+      *xo = (x-a[0])/a[1];
+      *yo = (y-b[0])/b[1];
+   }
+
+   return prj_newton(prj, x, y, xo, yo, pv_func);
+}
+
+/*--------------------------------------------------------------------------*/
+/* Invert the TNX distortion with Newton's method. */
+
+int tnx_to_raw_newton(struct prjprm *prj, double x, double y,
+		double *xo, double *yo)
+
+{
+   if (abs(prj->flag) != PRJSET) {
+      if (tnxset(prj)) return 1;
+   }
+
+   *xo = x;
+   *yo = y;
+
+   return prj_newton(prj, x, y, xo, yo, tnx_func);
+}
+
+/*--------------------------------------------------------------------------*/
+/* Newton iterations for solving func(xo,yo) = (x,y), with xo,yo containing
+   the initial guess. func() returns both the value and the Jacobian.
+   Returns 1 if the iterations did not converge (xo,yo still hold the last
+   estimate). */
+
+static int prj_newton(struct prjprm *prj, double x, double y,
+		double *xo, double *yo,
+		void (*func)(struct prjprm *, double, double,
+			double *, double *, double *))
+
+{
+   double	jac[4], xf,yf, dx,dy, det;
+   int		i;
+
+   for (i=PRJ_NEWTONMAXITER; i--;) {
+      func(prj, *xo, *yo, &xf, &yf, jac);
+      xf -= x;
+      yf -= y;
+      if ((det = jac[0]*jac[3] - jac[1]*jac[2]) == 0.0) break;
+      dx = (jac[3]*xf - jac[1]*yf)/det;
+      dy = (jac[0]*yf - jac[2]*xf)/det;
+      *xo -= dx;
+      *yo -= dy;
+      if (fabs(dx) + fabs(dy) < PRJ_NEWTONTOL) return 0;
+   }
+
+   return 1;
+}
+
+/*--------------------------------------------------------------------------*/
+/* TPV distortion and its Jacobian (dx'/dx, dx'/dy, dy'/dx, dy'/dy). */
+
+static void pv_func(struct prjprm *prj, double x, double y,
+		double *xo, double *yo, double *jac)
+
+{
+   int	nterm;
+
+   raw_to_pv(prj, x,y, xo,yo);
+   nterm = (prj->n && prj->n<40)? prj->n+1 : 40;
+   pv_jacobian(prj->p+100, nterm, x, y, jac, jac+1);
+   pv_jacobian(prj->p, nterm, y, x, jac+3, jac+2);
+
+   return;
+}
+
+/*--------------------------------------------------------------------------*/
+/* Partial derivatives of the TPV polynomial with coefficients c, for the
+   first nterm terms. */
+
+static void pv_jacobian(double *c, int nterm, double u, double v,
+		double *dpdu, double *dpdv)
+
+{
+   double	upow[8], vpow[8], r, rm, du, dv;
+   int		i,j,k,l,m;
+
+   upow[0] = vpow[0] = 1.0;
+   for (i=1; i<8; i++) {
+      upow[i] = upow[i-1]*u;
+      vpow[i] = vpow[i-1]*v;
+   }
+   r = sqrt(u*u + v*v);
+   du = dv = 0.0;
+   for (k=1; k<nterm; k++) {
+      if (c[k] == 0.0) continue;
+      i = pv_expo[k][0];
+      j = pv_expo[k][1];
+      if ((m = pv_expo[k][2])) {
+/*------ d(r^m)/du = m r^(m-2) u */
+         if (r > 0.0) {
+            for (rm=m/r, l=m-1; l--;) rm *= r;
+            du += c[k]*rm*u;
+            dv += c[k]*rm*v;
+         }
+      } else {
+         if (i) du += c[k]*i*upow[i-1]*vpow[j];
+         if (j) dv += c[k]*j*upow[i]*vpow[j-1];
+      }
+   }
+
+   *dpdu = du;
+   *dpdv = dv;
+
+   return;
+}
+
+/*--------------------------------------------------------------------------*/
+/* TNX distortion and its Jacobian (dx'/dx, dx'/dy, dy'/dx, dy'/dy). */
+
+static void tnx_func(struct prjprm *prj, double x, double y,
+		double *xo, double *yo, double *jac)
+
+{
+   *xo = x+raw_to_tnxaxis(prj->tnx_lngcor, x, y);
+   *yo = y+raw_to_tnxaxis(prj->tnx_latcor, x, y);
+   deriv_tnxaxis(prj->tnx_lngcor, x, y, jac, jac+1);
+   deriv_tnxaxis(prj->tnx_latcor, x, y, jac+2, jac+3);
+   jac[0] += 1.0;
+   jac[3] += 1.0;
+
+   return;
+}
+
 /*--------------------------------------------------------------------------*/
 
 int raw_to_cv(struct prjprm *prj, double x, double y, double *xo, double *yo)
@@ -24,7 +24,7 @@
 *	along with AstrOmatic software.
 *	If not, see <http://www.gnu.org/licenses/>.
 *
-*	Last modified:		04/12/2012
+*	Last modified:		19/10/2026
 *
 *%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
 /*=============================================================================
@@ -76,6 +76,7 @@ struct prjprm {
    struct tnxaxis	*tnx_lngcor;
    struct poly		*inv_x;
    struct poly		*inv_y;
+   int			inv_newton;	/* Invert distortions iteratively */
 };
 
 #if __STDC__ || defined(__cplusplus)
@@ -159,6 +160,8 @@ struct prjprm {
    int tnxrev(const double, const double, struct prjprm *, double *, double *);
    int raw_to_pv(struct prjprm *, double, double, double *, double *);
    int pv_to_raw(struct prjprm *, double, double, double *, double *);
+   int pv_to_raw_newton(struct prjprm *, double, double, double *, double *);
+   int tnx_to_raw_newton(struct prjprm *, double, double, double *, double *);
    int raw_to_cv(struct prjprm *, double, double, double *, double *);
    int cv_to_raw(struct prjprm *, double, double, double *, double *);
 #else
@@ -195,6 +198,8 @@ extern const char *prjfwd_errmsg[];
 extern const char *prjrev_errmsg[];
 */
 #define PRJSET 137
+#define PRJ_NEWTONMAXITER	20	/* Max. number of Newton iterations */
+#define PRJ_NEWTONTOL		1e-10	/* Newton convergence criterion (deg) */
 
 #ifdef __cplusplus
 };
@@ -23,7 +23,7 @@
 *	along with AstrOmatic software.
 *	If not, see <http://www.gnu.org/licenses/>.
 *
-*	Last modified:		10/10/2010
+*	Last modified:		19/10/2026
 *
 *%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
 
@@ -71,6 +71,9 @@ tnxaxisstruct	*read_tnxaxis(char *tnxstr)
 			(int)(atof(pstr)+0.5) : 0;
     tnxaxis->xterms = (pstr=strtok_r(NULL, " ", &ptr))?
 			(int)(atof(pstr)+0.5) : 0;
+    if (tnxaxis->xorder<1 || tnxaxis->xorder>TNX_MAXORDER
+	|| tnxaxis->yorder<1 || tnxaxis->yorder>TNX_MAXORDER)
+      return NULL;
     min = (pstr=strtok_r(NULL, " ", &ptr))? atof(pstr) : 0.0;
     max = (pstr=strtok_r(NULL, " ", &ptr))? atof(pstr) : 0.0;
     if (max <= min)
@@ -106,10 +109,6 @@ tnxaxisstruct	*read_tnxaxis(char *tnxstr)
       tnxaxis->coeff[i] = atof(pstr);
     if (i!=tnxaxis->ncoeff)
       return NULL;
-    if (!(tnxaxis->xbasis=malloc(tnxaxis->xorder*sizeof(double))))
-      return NULL;
-    if (!(tnxaxis->ybasis=malloc(tnxaxis->yorder*sizeof(double))))
-      return NULL;
     return tnxaxis;
     }
   else
@@ -144,14 +143,6 @@ tnxaxisstruct	*copy_tnxaxis(tnxaxisstruct *axis)
       return NULL;
     for (i=0; i<tnxaxis->ncoeff; i++)
       tnxaxis->coeff[i] = axis->coeff[i];
-    if (!(tnxaxis->xbasis=malloc(tnxaxis->xorder*sizeof(double))))
-      return NULL;
-    for (i=0; i<tnxaxis->xorder; i++)
-      tnxaxis->xbasis[i] = axis->xbasis[i];
-    if (!(tnxaxis->ybasis=malloc(tnxaxis->yorder*sizeof(double))))
-      return NULL;
-    for (i=0; i<tnxaxis->yorder; i++)
-      tnxaxis->ybasis[i] = axis->ybasis[i];
     return tnxaxis;
     }
 
@@ -176,8 +167,6 @@ void	free_tnxaxis(tnxaxisstruct *axis)
     {
     
     free(axis->coeff);
-    free(axis->xbasis);
-    free(axis->ybasis);
     free(axis);
     }
 
@@ -192,20 +181,26 @@ INPUT	TNXAXIS structure pointer,
 	x coordinate,
 	y coordinate.
 OUTPUT	Value on the TNXaxis.
-NOTES	-.
-AUTHOR	E. Bertin (IAP)
-VERSION	11/04/2000
+NOTES	Basis function values are stored on the stack, hence the same TNX axis
+	may be used simultaneously by several threads. A NULL axis pointer
+	means no correction.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
  ***/
 
 double	raw_to_tnxaxis(tnxaxisstruct *axis, double x, double y)
 
   {
-   double	*xbasis, *ybasis,*coeff,
+   double	xbasis0[TNX_MAXORDER], ybasis0[TNX_MAXORDER],
+		*xbasis, *ybasis,*coeff,
 		norm, accum, val;
    int		i, j, xorder,xorder0,yorder,maxorder,xterms;
 
-  xbasis = axis->xbasis;
-  ybasis = axis->ybasis;
+  if (!axis)
+    return 0.0;
+
+  xbasis = xbasis0;
+  ybasis = ybasis0;
   xorder = axis->xorder;
   yorder = axis->yorder;
   xterms = axis->xterms;
@@ -227,7 +222,7 @@ double	raw_to_tnxaxis(tnxaxisstruct *axis, double x, double y)
         ybasis[1] = norm = (y + axis->ymaxmin)*axis->yrange;
         if (yorder > 2)
           for (i = 2; i < yorder; i++)
-	    ybasis[i] = 2.0*norm*xbasis[i-1] - ybasis[i-2];
+	    ybasis[i] = 2.0*norm*ybasis[i-1] - ybasis[i-2];
         }
       break;
 
@@ -246,7 +241,7 @@ double	raw_to_tnxaxis(tnxaxisstruct *axis, double x, double y)
         {
         ybasis[1] = norm = (y + axis->ymaxmin)*axis->yrange;
         if (yorder > 2)
-          for (i = 2; (j=i) < xorder; i++)
+          for (i = 2; (j=i) < yorder; i++)
             ybasis[i] = ((2.0*j - 3.0) * norm * ybasis[i-1] -
                        (j - 2.0) * ybasis[i-2]) / (j - 1.0);
         }
@@ -284,7 +279,7 @@ double	raw_to_tnxaxis(tnxaxisstruct *axis, double x, double y)
     {
 /*-- Loop over the x basis functions */
     accum = 0.0;
-    xbasis = axis->xbasis;
+    xbasis = xbasis0;
     for (j = xorder; j--;)
       accum += *(coeff++) * *(xbasis++);
     val += accum**(ybasis++);
@@ -301,3 +296,140 @@ double	raw_to_tnxaxis(tnxaxisstruct *axis, double x, double y)
   }
 
 
+/******* deriv_tnxaxis ********************************************************
+PROTO	void deriv_tnxaxis(tnxaxisstruct *axis, double x, double y,
+			double *dx, double *dy)
+PURPOSE	Compute the partial derivatives of the correction on a TNX axis at
+	current position.
+INPUT	TNXAXIS structure pointer,
+	x coordinate,
+	y coordinate,
+	pointer to the derivative with respect to x (output),
+	pointer to the derivative with respect to y (output).
+OUTPUT	-.
+NOTES	Derivatives of the basis functions are obtained by differentiating the
+	recurrence relations used in raw_to_tnxaxis().
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+
+void	deriv_tnxaxis(tnxaxisstruct *axis, double x, double y,
+		double *dx, double *dy)
+
+  {
+   double	xbasis[TNX_MAXORDER], ybasis[TNX_MAXORDER],
+		dxbasis[TNX_MAXORDER], dybasis[TNX_MAXORDER],
+		*coeff, norm, accum, daccum, valx, valy;
+   int		i, j, xorder,xorder0,yorder,maxorder,xterms;
+
+  *dx = *dy = 0.0;
+  if (!axis)
+    return;
+
+  xorder = axis->xorder;
+  yorder = axis->yorder;
+  xterms = axis->xterms;
+  xbasis[0] = ybasis[0] = 1.0;
+  dxbasis[0] = dybasis[0] = 0.0;
+
+  switch (axis->type)
+    {
+    case TNX_CHEBYSHEV:
+      if (xorder > 1)
+        {
+        xbasis[1] = norm = (x + axis->xmaxmin)*axis->xrange;
+        dxbasis[1] = axis->xrange;
+        for (i = 2; i < xorder; i++)
+          {
+          xbasis[i] = 2.0*norm*xbasis[i-1] - xbasis[i-2];
+          dxbasis[i] = 2.0*(axis->xrange*xbasis[i-1] + norm*dxbasis[i-1])
+			- dxbasis[i-2];
+          }
+        }
+      if (yorder > 1)
+        {
+        ybasis[1] = norm = (y + axis->ymaxmin)*axis->yrange;
+        dybasis[1] = axis->yrange;
+        for (i = 2; i < yorder; i++)
+          {
+          ybasis[i] = 2.0*norm*ybasis[i-1] - ybasis[i-2];
+          dybasis[i] = 2.0*(axis->yrange*ybasis[i-1] + norm*dybasis[i-1])
+			- dybasis[i-2];
+          }
+        }
+      break;
+
+    case TNX_LEGENDRE:
+      if (xorder > 1)
+        {
+        xbasis[1] = norm = (x + axis->xmaxmin)*axis->xrange;
+        dxbasis[1] = axis->xrange;
+        for (i = 2; (j=i) < xorder; i++)
+          {
+          xbasis[i] = ((2.0*j - 3.0) * norm * xbasis[i-1] -
+                       (j - 2.0) * xbasis[i-2]) / (j - 1.0);
+          dxbasis[i] = ((2.0*j - 3.0)
+			* (axis->xrange*xbasis[i-1] + norm*dxbasis[i-1])
+			- (j - 2.0) * dxbasis[i-2]) / (j - 1.0);
+          }
+        }
+      if (yorder > 1)
+        {
+        ybasis[1] = norm = (y + axis->ymaxmin)*axis->yrange;
+        dybasis[1] = axis->yrange;
+        for (i = 2; (j=i) < yorder; i++)
+          {
+          ybasis[i] = ((2.0*j - 3.0) * norm * ybasis[i-1] -
+                       (j - 2.0) * ybasis[i-2]) / (j - 1.0);
+          dybasis[i] = ((2.0*j - 3.0)
+			* (axis->yrange*ybasis[i-1] + norm*dybasis[i-1])
+			- (j - 2.0) * dybasis[i-2]) / (j - 1.0);
+          }
+        }
+      break;
+
+    case TNX_POLYNOMIAL:
+      for (i = 1; i < xorder; i++)
+        {
+        xbasis[i] = x * xbasis[i-1];
+        dxbasis[i] = xbasis[i-1] + x * dxbasis[i-1];
+        }
+      for (i = 1; i < yorder; i++)
+        {
+        ybasis[i] = y * ybasis[i-1];
+        dybasis[i] = ybasis[i-1] + y * dybasis[i-1];
+        }
+      break;
+
+    default:
+      return;
+    }
+
+/* Same loop as in raw_to_tnxaxis() */
+  maxorder = xorder > yorder ? xorder : yorder;
+  xorder0 = xorder;
+  coeff = axis->coeff;
+  valx = valy = 0.0;
+  for (i = 0; i<yorder; i++)
+    {
+    accum = daccum = 0.0;
+    for (j = 0; j < xorder; j++, coeff++)
+      {
+      accum += *coeff * xbasis[j];
+      daccum += *coeff * dxbasis[j];
+      }
+    valx += daccum*ybasis[i];
+    valy += accum*dybasis[i];
+    if (xterms == TNX_XNONE)
+      xorder = 1;
+    else if (xterms == TNX_XHALF && (i + 1 + xorder0) > maxorder)
+      xorder--;
+    }
+
+  *dx = valx;
+  *dy = valy;
+
+  return;
+  }
+
+
@@ -23,7 +23,7 @@
 *	along with AstrOmatic software.
 *	If not, see <http://www.gnu.org/licenses/>.
 *
-*	Last modified:		10/10/2010
+*	Last modified:		19/10/2026
 *
 *%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
 
@@ -45,6 +45,7 @@
 #define		TNX_XHALF	2	/* half x-terms (new) */
 
 /*----------------------------- Internal constants --------------------------*/
+#define		TNX_MAXORDER	100	/* Maximum polynomial order per axis */
 
 /*------------------------------- structures --------------------------------*/
 
@@ -57,7 +58,6 @@ typedef struct tnxaxis
   double	xrange,yrange;		/* Coordinate ranges */
   double	xmaxmin,ymaxmin;	/* Well... */
   double	*coeff;			/* Polynom coefficients */
-  double	*xbasis,*ybasis;	/* Basis function values */
   }	tnxaxisstruct;
 
 /*------------------------------- functions ---------------------------------*/
@@ -67,7 +67,9 @@ tnxaxisstruct	*copy_tnxaxis(tnxaxisstruct *axis),
 
 double		raw_to_tnxaxis(tnxaxisstruct *axis, double x, double y);
 
-void		free_tnxaxis(tnxaxisstruct *axis);
+void		deriv_tnxaxis(tnxaxisstruct *axis, double x, double y,
+			double *dx, double *dy),
+		free_tnxaxis(tnxaxisstruct *axis);
 
 #endif
 
@@ -24,7 +24,7 @@
 *	You should have received a copy of the GNU General Public License
 *	along with SWarp. If not, see <http://www.gnu.org/licenses/>.
 *
-*	Last modified:		25/03/2025
+*	Last modified:		19/10/2026
 *
 *%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
 
@@ -40,6 +40,9 @@
 #include	<stdio.h>
 #include	<stdlib.h>
 #include	<string.h>
+#ifdef USE_THREADS
+#include	<pthread.h>
+#endif
 
 #include	"define.h"
 #include	"globals.h"
@@ -47,12 +50,21 @@
 #include	"field.h"
 #include	"fits/fitscat.h"
 #include	"prefs.h"
+#ifdef USE_THREADS
+#include	"threads.h"
+#endif
 #include	"weight.h"
 
 fieldstruct	*weight_reffield;
 PIXTYPE		weight_fac, weight_thresh;
 long		weight_pixcount;
 int		weight_type, weight_width, weight_y;
+#ifdef USE_THREADS
+static pthread_mutex_t	weightmutex = PTHREAD_MUTEX_INITIALIZER;
+
+static void	*pthread_weight_convert(void *arg);
+#endif
+static void	weight_convert(PIXTYPE *pix, size_t npix, int width);
 
 /******* load_weight *********************************************************
 PROTO	fieldstruct load_weight(catstruct *cat, fieldstruct *reffield,
@@ -66,7 +78,7 @@ INPUT	Cat structure pointer,
 OUTPUT	RETURN_OK if no error, or RETURN_ERROR in case of non-fatal error(s).
 NOTES   -.
 AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
-VERSION	25/03/2025
+VERSION	19/10/2026
  ***/
 fieldstruct	*load_weight(catstruct *cat, fieldstruct *reffield,
 			int frameno, int fieldno, weightenum wtype)
@@ -74,6 +86,7 @@ fieldstruct	*load_weight(catstruct *cat, fieldstruct *reffield,
   {
    fieldstruct	*wfield;
    tabstruct	*tab, *intab;
+   char		str[MAXCHAR];
    int		i, wflags;
 
   wflags = 0;	/* to avoid gcc -Wall warnings */
@@ -118,8 +131,8 @@ fieldstruct	*load_weight(catstruct *cat, fieldstruct *reffield,
     else
       wfield->rfilename++;
 
-    sprintf(gstr, "Looking for %s ...", wfield->rfilename);
-    NFPRINTF(OUTPUT, gstr);
+    sprintf(str, "Looking for %s ...", wfield->rfilename);
+    NFPRINTF(OUTPUT, str);
 
 /*-- Check the image exists and read important info (image size, etc...) */
     if (frameno >= cat->ntab)
@@ -181,10 +194,17 @@ fieldstruct	*load_weight(catstruct *cat, fieldstruct *reffield,
 
 /* Default normalization factor (will be changed if necessary later) */
   wfield->sigfac = 1.0;
+/* Conversion settings are global: serialize parallel input scans */
+#ifdef USE_THREADS
+  pthread_mutex_lock(&weightmutex);
+#endif
   set_weightconv(wfield);
   wfield->weight_thresh = prefs.weight_thresh[fieldno];
   wfield->var_thresh = wfield->weight_thresh;
   weight_to_var(&wfield->var_thresh, 1);
+#ifdef USE_THREADS
+  pthread_mutex_unlock(&weightmutex);
+#endif
 
   return wfield;
   }
@@ -223,15 +243,49 @@ PROTO	void read_weight(fieldstruct *wfield)
 PURPOSE	Read weights and store them in internal format (calibrated variance).
 INPUT	Input weight field ptr,
 OUTPUT	-.
-NOTES   -.
-AUTHOR  E. Bertin (IAP)
-VERSION 03/02/2012
+NOTES   If the raw weights have already been loaded by preload_data(), they
+	are converted in place, by chunks handed over to the worker pool.
+AUTHOR  E. Bertin (CEA/AIM/UParisSaclay)
+VERSION 19/10/2026
  ***/
 void	read_weight(fieldstruct *wfield)
   {
+#ifdef USE_THREADS
+   threads_job_t	*job;
+   weightconvstruct	*conv;
+   size_t		chunksize;
+   int			c, nchunk;
+#endif
+   size_t		npix;
+
   set_weightconv(wfield);
   if (wfield->bitpix>0)
     wfield->ipix = alloc_ibody(wfield->tab, NULL);
+  else if (wfield->pix)
+    {
+    npix = wfield->tab->tabsize/wfield->tab->bytepix;
+#ifdef USE_THREADS
+    if (threads_pool && threads_pool->nthreads>1 && npix>WEIGHT_CONVSIZE)
+      {
+/*---- Chunks are made of whole lines */
+      chunksize = (WEIGHT_CONVSIZE/wfield->width + 1)*(size_t)wfield->width;
+      nchunk = (int)((npix+chunksize-1)/chunksize);
+      QMALLOC(conv, weightconvstruct, nchunk);
+      job = threads_job_init(threads_pool);
+      for (c=0; c<nchunk; c++)
+        {
+        conv[c].pix = wfield->pix + c*chunksize;
+        conv[c].npix = c<nchunk-1? chunksize : npix - c*chunksize;
+        conv[c].width = wfield->width;
+        threads_job_add(job, &pthread_weight_convert, &conv[c]);
+        }
+      threads_job_end(job);
+      free(conv);
+      }
+    else
+#endif
+      weight_convert(wfield->pix, npix, wfield->width);
+    }
   else
     wfield->pix = alloc_body(wfield->tab, weight_to_var);
 
@@ -239,6 +293,55 @@ void	read_weight(fieldstruct *wfield)
   }
 
 
+/******* weight_convert ******************************************************
+PROTO	void weight_convert(PIXTYPE *pix, size_t npix, int width)
+PURPOSE	Convert preloaded weights to variances, line by line.
+INPUT	Pointer to the first pixel,
+	number of pixels,
+	line width.
+OUTPUT	-.
+NOTES   Conversion settings must have been set by set_weightconv(). Weights
+	derived from the background (which are never preloaded) cannot be
+	converted this way.
+AUTHOR  E. Bertin (CEA/AIM/UParisSaclay)
+VERSION 19/10/2026
+ ***/
+static void	weight_convert(PIXTYPE *pix, size_t npix, int width)
+  {
+   size_t	n;
+
+  for (; npix; npix-=n, pix+=n)
+    {
+    n = npix<(size_t)width? npix : (size_t)width;
+    weight_to_var(pix, (int)n);
+    }
+
+  return;
+  }
+
+
+#ifdef USE_THREADS
+/******* pthread_weight_convert **********************************************
+PROTO	void *pthread_weight_convert(void *arg)
+PURPOSE	Pool task converting a chunk of preloaded weights to variances.
+INPUT	Pointer to the weight chunk structure.
+OUTPUT	NULL void pointer.
+NOTES   -.
+AUTHOR  E. Bertin (CEA/AIM/UParisSaclay)
+VERSION 19/10/2026
+ ***/
+static void	*pthread_weight_convert(void *arg)
+  {
+   weightconvstruct	*conv;
+
+  conv = (weightconvstruct *)arg;
+  weight_convert(conv->pix, conv->npix, conv->width);
+
+  return (void *)NULL;
+  }
+#endif
+
+
 /******* set_weightconv ******************************************************
 PROTO	void set_weightconv(fieldstruct *wfield)
 PURPOSE	Set current weight conversion factor and flags.
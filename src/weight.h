@@ -22,7 +22,7 @@
 *	You should have received a copy of the GNU General Public License
 *	along with SWarp. If not, see <http://www.gnu.org/licenses/>.
 *
-*	Last modified:		26/10/2010
+*	Last modified:		19/10/2026
 *
 *%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
 
@@ -33,6 +33,16 @@ typedef	enum {WEIGHT_NONE, WEIGHT_FROMBACK, WEIGHT_FROMRMSMAP,
 		WEIGHT_FROMVARMAP, WEIGHT_FROMWEIGHTMAP}
 		weightenum;		/* WEIGHT_IMAGE type */
 
+#define	WEIGHT_CONVSIZE	(4*1024*1024)	/* Pixels per weight conversion task */
+
+/* Chunk of preloaded weights converted by a thread */
+typedef struct weightconv
+  {
+  PIXTYPE	*pix;			/* First pixel */
+  size_t	npix;			/* Number of pixels */
+  int		width;			/* Line width */
+  }	weightconvstruct;
+
 /*---------------------------------- protos --------------------------------*/
 
 extern fieldstruct	*init_weight(char *filename, fieldstruct *reffield),
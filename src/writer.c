@@ -0,0 +1,331 @@
+/*
+*				writer.c
+*
+* Asynchronous writing of output image bodies.
+*
+*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+*
+*	This file part of:	SWarp
+*
+*	Copyright:		(C) 2026 CEA/AIM/UParisSaclay
+*
+*	License:		GNU General Public License
+*
+*	SWarp is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*	SWarp is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU General Public License for more details.
+*	You should have received a copy of the GNU General Public License
+*	along with SWarp. If not, see <http://www.gnu.org/licenses/>.
+*
+*	Last modified:		19/10/2026
+*
+*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+
+#ifdef HAVE_CONFIG_H
+#include	"config.h"
+#endif
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "define.h"
+#include "globals.h"
+#include "fits/fitscat.h"
+#ifdef USE_THREADS
+#include "threads.h"
+#endif
+#include "writer.h"
+
+#if defined(USE_THREADS) && defined(HAVE_PWRITE)
+static void	*pthread_writer(void *arg),
+		writer_pwrite(writerstruct *writer, char *buf, size_t size);
+#endif
+
+/*
+ Output lines are copied to a bounded queue of large blocks. A dedicated
+ thread converts full blocks to the FITS format, updates the checksum and
+ writes them with pwrite() at the current file offset, so that the calling
+ threads only wait for the disk when the whole queue is full.
+*/
+
+/****** init_writer **********************************************************
+PROTO	writerstruct *init_writer(tabstruct *tab, int iflag)
+PURPOSE	Start writing the body of an output image.
+INPUT	Pointer to the output tab structure,
+	flag set if data are of FLAGTYPE instead of PIXTYPE.
+OUTPUT	Pointer to the new writer structure.
+NOTES	The tab header must have been written, and the file positioned at the
+	beginning of the data to be written. Without thread or pwrite()
+	support, or with CFITSIO outputs, writes are done synchronously
+	through write_body() and write_ibody(). The queue is shortened if
+	buffers do not fit within the MEM_MAX budget.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+writerstruct	*init_writer(tabstruct *tab, int iflag)
+  {
+   writerstruct		*writer;
+#if defined(USE_THREADS) && defined(HAVE_PWRITE)
+   catstruct		*cat;
+   size_t		esize;
+   int			b;
+#endif
+
+  QCALLOC(writer, writerstruct, 1);
+  writer->tab = tab;
+  writer->iflag = iflag;
+
+#if defined(USE_THREADS) && defined(HAVE_PWRITE)
+  cat = tab->cat;
+  writer->asyncflag = (tab->compress_type == COMPRESS_NONE);
+#ifdef HAVE_CFITSIO
+  if (cat->cfitsio_infptr)
+    writer->asyncflag = 0;
+#endif
+#endif
+  if (!writer->asyncflag)
+    return writer;
+
+#if defined(USE_THREADS) && defined(HAVE_PWRITE)
+/* Writes bypass stdio buffering from now on */
+  if (fflush(cat->file))
+    error(EXIT_FAILURE, "*Error* while writing ", cat->filename);
+  QFTELL(cat->file, writer->pos, cat->filename);
+  writer->fd = fileno(cat->file);
+
+  writer->blocknpix = WRITER_BLOCKSIZE/tab->bytepix;
+/* Shorten the queue if memory is scarce */
+  esize = iflag? sizeof(FLAGTYPE) : sizeof(PIXTYPE);
+  for (writer->nblock = WRITER_NBLOCK; ; writer->nblock--)
+    {
+    writer->ramsize = writer->nblock*writer->blocknpix*esize
+		+ WRITER_BLOCKSIZE;
+    if (reserve_ram(writer->ramsize, 0, writer->nblock==1) == RETURN_OK)
+      break;
+    }
+  QCALLOC(writer->block, writerblockstruct, writer->nblock);
+  for (b=0; b<writer->nblock; b++)
+    {
+    QMALLOC(writer->block[b].data, char, writer->blocknpix*esize);
+    writer->block[b].state = STATE_FREE;
+    }
+  if (posix_memalign((void **)&writer->encbuf, WRITER_ALIGN,
+	WRITER_BLOCKSIZE))
+    error(EXIT_FAILURE, "Could not allocate memory for ",
+	"the output write buffer");
+
+  QPTHREAD_MUTEX_INIT(&writer->mutex, NULL);
+  QPTHREAD_COND_INIT(&writer->cond, NULL);
+  QPTHREAD_CREATE(&writer->thread, NULL, &pthread_writer, writer);
+#endif
+
+  return writer;
+  }
+
+
+/****** writer_line **********************************************************
+PROTO	void writer_line(writerstruct *writer, void *ptr, size_t npix)
+PURPOSE	Queue pixel values for writing.
+INPUT	Pointer to the writer structure,
+	pointer to the pixel values (PIXTYPE or FLAGTYPE),
+	number of pixels.
+OUTPUT	-.
+NOTES	Data are copied, hence the input buffer may be reused on return.
+	Calls for a given writer must be serialized.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+void	writer_line(writerstruct *writer, void *ptr, size_t npix)
+  {
+#if defined(USE_THREADS) && defined(HAVE_PWRITE)
+   writerblockstruct	*block;
+   char			*cptr;
+   size_t		esize, n;
+#endif
+
+  if (!writer->asyncflag)
+    {
+    if (writer->iflag)
+      write_ibody(writer->tab, (FLAGTYPE *)ptr, npix);
+    else
+      write_body(writer->tab, (PIXTYPE *)ptr, npix);
+    return;
+    }
+
+#if defined(USE_THREADS) && defined(HAVE_PWRITE)
+  esize = writer->iflag? sizeof(FLAGTYPE) : sizeof(PIXTYPE);
+  cptr = (char *)ptr;
+  while (npix)
+    {
+    block = writer->block + writer->inblock;
+/*-- Wait for the block to be available (the queue is full otherwise) */
+    if (!writer->fillflag)
+      {
+      QPTHREAD_MUTEX_LOCK(&writer->mutex);
+      while (block->state != STATE_FREE)
+        QPTHREAD_COND_WAIT(&writer->cond, &writer->mutex);
+      QPTHREAD_MUTEX_UNLOCK(&writer->mutex);
+      block->npix = 0;
+      writer->fillflag = 1;
+      }
+    n = writer->blocknpix - block->npix;
+    if (n > npix)
+      n = npix;
+    memcpy(block->data + block->npix*esize, cptr, n*esize);
+    block->npix += n;
+    cptr += n*esize;
+    npix -= n;
+/*-- Hand full blocks over to the writing thread */
+    if (block->npix == writer->blocknpix)
+      {
+      QPTHREAD_MUTEX_LOCK(&writer->mutex);
+      block->state = STATE_READY;
+      QPTHREAD_COND_BROADCAST(&writer->cond);
+      QPTHREAD_MUTEX_UNLOCK(&writer->mutex);
+      writer->inblock = (writer->inblock+1)%writer->nblock;
+      writer->fillflag = 0;
+      }
+    }
+#endif
+
+  return;
+  }
+
+
+/****** end_writer ***********************************************************
+PROTO	void end_writer(writerstruct *writer)
+PURPOSE	Flush pending data and free a writer structure.
+INPUT	Pointer to the writer structure.
+OUTPUT	-.
+NOTES	On return, the output file is positioned after the last data written.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+void	end_writer(writerstruct *writer)
+  {
+#if defined(USE_THREADS) && defined(HAVE_PWRITE)
+   writerblockstruct	*block;
+   catstruct		*cat;
+   int			b;
+
+  if (writer->asyncflag)
+    {
+    QPTHREAD_MUTEX_LOCK(&writer->mutex);
+    block = writer->block + writer->inblock;
+    if (writer->fillflag && block->npix)
+      block->state = STATE_READY;
+    writer->endflag = 1;
+    QPTHREAD_COND_BROADCAST(&writer->cond);
+    QPTHREAD_MUTEX_UNLOCK(&writer->mutex);
+    QPTHREAD_JOIN(writer->thread, NULL);
+    QPTHREAD_MUTEX_DESTROY(&writer->mutex);
+    QPTHREAD_COND_DESTROY(&writer->cond);
+/*-- Resynchronize the stream with what has been written */
+    cat = writer->tab->cat;
+    QFSEEK(cat->file, writer->pos, SEEK_SET, cat->filename);
+    for (b=0; b<writer->nblock; b++)
+      free(writer->block[b].data);
+    free(writer->block);
+    free(writer->encbuf);
+    release_ram(writer->ramsize, 0);
+    }
+#endif
+
+  free(writer);
+
+  return;
+  }
+
+
+#if defined(USE_THREADS) && defined(HAVE_PWRITE)
+/****** pthread_writer *******************************************************
+PROTO	void *pthread_writer(void *arg)
+PURPOSE	Thread that converts and writes queued blocks to disk.
+INPUT	Pointer to the writer structure.
+OUTPUT	-.
+NOTES	Blocks are written in queue order.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+static void	*pthread_writer(void *arg)
+  {
+   writerstruct		*writer;
+   writerblockstruct	*block;
+   tabstruct		*tab;
+   size_t		size;
+
+  writer = (writerstruct *)arg;
+  tab = writer->tab;
+  QPTHREAD_MUTEX_LOCK(&writer->mutex);
+  for (;;)
+    {
+    block = writer->block + writer->outblock;
+    while (block->state != STATE_READY && !writer->endflag)
+      QPTHREAD_COND_WAIT(&writer->cond, &writer->mutex);
+    if (block->state != STATE_READY)
+      break;
+    block->state = STATE_BUSY;
+    QPTHREAD_MUTEX_UNLOCK(&writer->mutex);
+    if (writer->iflag)
+      encode_ibody(tab, (FLAGTYPE *)block->data, writer->encbuf, block->npix);
+    else
+      encode_body(tab, (PIXTYPE *)block->data, writer->encbuf, block->npix);
+    size = block->npix*tab->bytepix;
+    writer_pwrite(writer, writer->encbuf, size);
+    if (tab->bodysumflag)
+      {
+      tab->bodysum = compute_bufsum(writer->encbuf, size, tab->bodysumpos,
+			tab->bodysum);
+      tab->bodysumpos += size;
+      }
+    QPTHREAD_MUTEX_LOCK(&writer->mutex);
+    block->state = STATE_FREE;
+    QPTHREAD_COND_BROADCAST(&writer->cond);
+    writer->outblock = (writer->outblock+1)%writer->nblock;
+    }
+  QPTHREAD_MUTEX_UNLOCK(&writer->mutex);
+
+  return (void *)NULL;
+  }
+
+
+/****** writer_pwrite ********************************************************
+PROTO	void writer_pwrite(writerstruct *writer, char *buf, size_t size)
+PURPOSE	Write a buffer at the current writer file position.
+INPUT	Pointer to the writer structure,
+	pointer to the buffer,
+	number of bytes.
+OUTPUT	-.
+NOTES	Partial and interrupted writes are resumed.
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
+ ***/
+static void	writer_pwrite(writerstruct *writer, char *buf, size_t size)
+  {
+   ssize_t	n;
+
+  while (size)
+    {
+    if ((n = pwrite(writer->fd, buf, size, writer->pos)) < 0)
+      {
+      if (errno == EINTR)
+        continue;
+      error(EXIT_FAILURE, "*Error* while writing ",
+		writer->tab->cat->filename);
+      }
+    buf += n;
+    size -= (size_t)n;
+    writer->pos += n;
+    }
+
+  return;
+  }
+#endif
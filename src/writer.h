@@ -0,0 +1,83 @@
+/*
+*				writer.h
+*
+* Include file for writer.c.
+*
+*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+*
+*	This file part of:	SWarp
+*
+*	Copyright:		(C) 2026 CEA/AIM/UParisSaclay
+*
+*	License:		GNU General Public License
+*
+*	SWarp is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*	SWarp is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU General Public License for more details.
+*	You should have received a copy of the GNU General Public License
+*	along with SWarp. If not, see <http://www.gnu.org/licenses/>.
+*
+*	Last modified:		19/10/2026
+*
+*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+
+#ifndef _FITSCAT_H_
+#include "fits/fitscat.h"
+#endif
+
+#ifdef USE_THREADS
+#include <pthread.h>
+#endif
+
+#ifndef	_WRITER_H_
+#define	_WRITER_H_
+
+/*------------------------------- constants ---------------------------------*/
+#define	WRITER_BLOCKSIZE	(4*1024*1024)	/* Output block size (bytes) */
+#define	WRITER_NBLOCK		4	/* Max. number of queued blocks per file */
+#define	WRITER_ALIGN		4096	/* Memory alignment of output blocks */
+
+/*-------------------------- structure definitions --------------------------*/
+typedef struct writerblock
+  {
+  char		*data;			/* Pixel values in internal format */
+  size_t	npix;			/* Number of pixels in block */
+  int		state;			/* STATE_FREE, STATE_READY, STATE_BUSY */
+  }	writerblockstruct;
+
+typedef struct writer
+  {
+  tabstruct		*tab;		/* Output table */
+  int			iflag;		/* FLAGTYPE instead of PIXTYPE data? */
+  int			asyncflag;	/* Asynchronous writes? */
+  int			fd;		/* Output file descriptor */
+  OFF_T2		pos;		/* Current position in output file */
+  writerblockstruct	*block;		/* Queue of blocks */
+  int			nblock;		/* Number of blocks in queue */
+  size_t		blocknpix;	/* Max. number of pixels per block */
+  int			inblock;	/* Block currently being filled */
+  int			fillflag;	/* Set while inblock is being filled */
+  int			outblock;	/* Next block to be written */
+  char			*encbuf;	/* Buffer for data in FITS format */
+  size_t		ramsize;	/* Memory booked for buffers */
+  int			endflag;	/* Set when no more data is coming */
+#ifdef USE_THREADS
+  pthread_t		thread;		/* Writing thread */
+  pthread_mutex_t	mutex;		/* Queue mutex */
+  pthread_cond_t	cond;		/* Queue condition variable */
+#endif
+  }	writerstruct;
+
+/*------------------------------- functions ---------------------------------*/
+extern writerstruct	*init_writer(tabstruct *tab, int iflag);
+
+extern void		end_writer(writerstruct *writer),
+			writer_line(writerstruct *writer, void *ptr,
+				size_t npix);
+
+#endif
@@ -22,7 +22,7 @@
 *	You should have received a copy of the GNU General Public License
 *	along with SWarp. If not, see <http://www.gnu.org/licenses/>.
 *
-*	Last modified:		07/06/2011
+*	Last modified:		19/10/2026
 *
 *%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
 
@@ -42,6 +42,7 @@
 #include "field.h"
 #include "fitswcs.h"
 #include "key.h"
+#include "perf.h"
 #include "prefs.h"
 #include "xml.h"
 
@@ -248,8 +249,8 @@ INPUT	Pointer to the output file (or stream),
 	Pointer to an error msg (or NULL).
 OUTPUT	RETURN_OK if everything went fine, RETURN_ERROR otherwise.
 NOTES	-.
-AUTHOR	E. Bertin (IAP)
-VERSION	07/06/2011
+AUTHOR	E. Bertin (CEA/AIM/UParisSaclay)
+VERSION	19/10/2026
  ***/
 int	write_xml_meta(FILE *file, char *error)
   {
@@ -257,7 +258,8 @@ int	write_xml_meta(FILE *file, char *error)
    struct tm		*tm;
    char			sysname[16],
 			*pspath,*psuser, *pshost, *str;
-   int			d,f,n, naxis;
+   perfstatstruct	*stat;
+   int			d,f,i,n, naxis;
 
 /* Processing date and time if msg error present */
   if (error)
@@ -511,6 +513,94 @@ int	write_xml_meta(FILE *file, char *error)
   fprintf(file, "   </TABLEDATA></DATA>\n");
   fprintf(file, "  </TABLE>\n");
 
+/* Processing-stage statistics for each input and each thread */
+  if (perf_nslot())
+    {
+    fprintf(file, "  <TABLE ID=\"Input_Performance\""
+	" name=\"Input_Performance\">\n");
+    fprintf(file, "   <DESCRIPTION>Processing stage statistics for every"
+	" FITS input image</DESCRIPTION>\n");
+    fprintf(file, "   <FIELD name=\"Frame_Index\" datatype=\"int\""
+	" ucd=\"meta.record\"/>\n");
+    fprintf(file, "   <FIELD name=\"Stage\" datatype=\"char\" arraysize=\"*\""
+	" ucd=\"meta.code\"/>\n");
+    fprintf(file, "   <FIELD name=\"NCalls\" datatype=\"long\""
+	" ucd=\"meta.number\"/>\n");
+    fprintf(file, "   <FIELD name=\"Duration\" datatype=\"float\""
+	" ucd=\"time.duration\" unit=\"s\"/>\n");
+    fprintf(file, "   <FIELD name=\"NPixels\" datatype=\"double\""
+	" ucd=\"meta.number;instr.pixel\"/>\n");
+    fprintf(file, "   <FIELD name=\"NBytes\" datatype=\"double\""
+	" ucd=\"meta.number\" unit=\"byte\"/>\n");
+    fprintf(file, "   <DATA><TABLEDATA>\n");
+    for (n=0; n<perf_ninput(); n++)
+      for (stat=perf_inputstat(n), i=0; i<PERF_NSTAGE; i++, stat++)
+        if (stat->ncall)
+          fprintf(file, "    <TR><TD>%d</TD><TD>%s</TD><TD>%ld</TD>"
+		"<TD>%.4f</TD><TD>%.0f</TD><TD>%.0f</TD></TR>\n",
+		n+1, perf_stagename((perfenum)i), stat->ncall,
+		stat->time, stat->npix, stat->nbytes);
+    fprintf(file, "   </TABLEDATA></DATA>\n");
+    fprintf(file, "  </TABLE>\n");
+
+    fprintf(file, "  <TABLE ID=\"Thread_Performance\""
+	" name=\"Thread_Performance\">\n");
+    fprintf(file, "   <DESCRIPTION>Processing stage statistics for every"
+	" thread (0 is the main thread)</DESCRIPTION>\n");
+    fprintf(file, "   <FIELD name=\"Thread_Index\" datatype=\"int\""
+	" ucd=\"meta.record\"/>\n");
+    fprintf(file, "   <FIELD name=\"Stage\" datatype=\"char\" arraysize=\"*\""
+	" ucd=\"meta.code\"/>\n");
+    fprintf(file, "   <FIELD name=\"NCalls\" datatype=\"long\""
+	" ucd=\"meta.number\"/>\n");
+    fprintf(file, "   <FIELD name=\"Duration\" datatype=\"float\""
+	" ucd=\"time.duration\" unit=\"s\"/>\n");
+    fprintf(file, "   <FIELD name=\"NPixels\" datatype=\"double\""
+	" ucd=\"meta.number;instr.pixel\"/>\n");
+    fprintf(file, "   <FIELD name=\"NBytes\" datatype=\"double\""
+	" ucd=\"meta.number\" unit=\"byte\"/>\n");
+    fprintf(file, "   <DATA><TABLEDATA>\n");
+    for (n=0; n<perf_nslot(); n++)
+      for (stat=perf_threadstat(n), i=0; i<PERF_NSTAGE; i++, stat++)
+        if (stat->ncall)
+          fprintf(file, "    <TR><TD>%d</TD><TD>%s</TD><TD>%ld</TD>"
+		"<TD>%.4f</TD><TD>%.0f</TD><TD>%.0f</TD></TR>\n",
+		n, perf_stagename((perfenum)i), stat->ncall,
+		stat->time, stat->npix, stat->nbytes);
+    fprintf(file, "   </TABLEDATA></DATA>\n");
+    fprintf(file, "  </TABLE>\n");
+
+    fprintf(file, "  <TABLE ID=\"Performance_Counters\""
+	" name=\"Performance_Counters\">\n");
+    fprintf(file, "   <DESCRIPTION>Event counters</DESCRIPTION>\n");
+    fprintf(file, "   <FIELD name=\"Counter\" datatype=\"char\""
+	" arraysize=\"*\" ucd=\"meta.code\"/>\n");
+    fprintf(file, "   <FIELD name=\"Value\" datatype=\"long\""
+	" ucd=\"meta.number\"/>\n");
+    fprintf(file, "   <DATA><TABLEDATA>\n");
+    for (i=0; i<PERF_NCOUNT; i++)
+      fprintf(file, "    <TR><TD>%s</TD><TD>%ld</TD></TR>\n",
+		perf_countname((perfcountenum)i),
+		perf_counter((perfcountenum)i));
+    fprintf(file, "   </TABLEDATA></DATA>\n");
+    fprintf(file, "  </TABLE>\n");
+
+    fprintf(file, "  <TABLE ID=\"Memory_Usage\" name=\"Memory_Usage\">\n");
+    fprintf(file, "   <DESCRIPTION>Peak memory booked within the MEM_MAX"
+	" budget for every processing stage</DESCRIPTION>\n");
+    fprintf(file, "   <FIELD name=\"Stage\" datatype=\"char\" arraysize=\"*\""
+	" ucd=\"meta.code\"/>\n");
+    fprintf(file, "   <FIELD name=\"Peak_RAM\" datatype=\"double\""
+	" ucd=\"meta.number\" unit=\"byte\"/>\n");
+    fprintf(file, "   <DATA><TABLEDATA>\n");
+    for (i=0; i<PERF_NSTAGE; i++)
+      if (perf_mempeak((perfenum)i))
+        fprintf(file, "    <TR><TD>%s</TD><TD>%.0f</TD></TR>\n",
+		perf_stagename((perfenum)i), (double)perf_mempeak((perfenum)i));
+    fprintf(file, "   </TABLEDATA></DATA>\n");
+    fprintf(file, "  </TABLE>\n");
+    }
+
 /* Warnings */
   fprintf(file, "  <TABLE ID=\"Warnings\" name=\"Warnings\">\n");
   fprintf(file,
@@ -658,6 +748,11 @@ int	write_xml_meta(FILE *file, char *error)
 	"   <PARAM name=\"Resample_Suffix\" datatype=\"char\" arraysize=\"*\""
 	" ucd=\"meta.dataset;meta.file\" value=\"%s\"/>\n",
 	prefs.resamp_suffix);
+    fprintf(file,
+	"   <PARAM name=\"Resample_WeightOnly\" datatype=\"char\" arraysize=\"*\""
+	" ucd=\"meta.code\" value=\"%s\"/>\n",
+    	key[findkeys("RESAMPLE_WEIGHTONLY",keylist,
+			FIND_STRICT)].keylist[prefs.resamp_wonly]);
 
     fprintf(file,
 	"   <PARAM name=\"Resampling_Type\" datatype=\"char\" arraysize=\"*\""
@@ -731,6 +826,9 @@ int	write_xml_meta(FILE *file, char *error)
     fprintf(file, "   <PARAM name=\"Back_FiltThresh\" datatype=\"float\""
 	" ucd=\"phot.count;arith.ratio;obs.param\" value=\"%g\"/>\n",
     	prefs.back_fthresh);
+    fprintf(file, "   <PARAM name=\"Back_Sampling\" datatype=\"int\""
+	" ucd=\"obs.param\" value=\"%d\"/>\n",
+	prefs.back_sampling);
 
     fprintf(file,
 	"   <PARAM name=\"VMem_Dir\" datatype=\"char\" arraysize=\"*\""
@@ -748,6 +846,11 @@ int	write_xml_meta(FILE *file, char *error)
 	"   <PARAM name=\"Combine_BufSize\" datatype=\"int\""
 	" ucd=\"meta.number;stat.max\" value=\"%d\" unit=\"Mbyte\"/>\n",
 	prefs.coaddbuf_size);
+    fprintf(file,
+	"   <PARAM name=\"Huge_Pages\" datatype=\"char\" arraysize=\"*\""
+	" ucd=\"meta.code\" value=\"%s\"/>\n",
+    	key[findkeys("HUGE_PAGES", keylist,
+			FIND_STRICT)].keylist[prefs.hugepage_type]);
 
     fprintf(file,
 	"   <PARAM name=\"Delete_TmpFiles\" datatype=\"boolean\""
@@ -770,6 +873,16 @@ int	write_xml_meta(FILE *file, char *error)
 	" ucd=\"meta.code\" value=\"%c\"/>\n",
     	prefs.writefileinfo_flag? 'T':'F');
 
+    fprintf(file,
+	"   <PARAM name=\"Write_Checksum\" datatype=\"boolean\""
+	" ucd=\"meta.code\" value=\"%c\"/>\n",
+    	prefs.checksum_flag? 'T':'F');
+
+    fprintf(file,
+	"   <PARAM name=\"NUMA_Affinity\" datatype=\"boolean\""
+	" ucd=\"meta.code\" value=\"%c\"/>\n",
+    	prefs.numa_flag? 'T':'F');
+
     fprintf(file,
 	"   <PARAM name=\"Verbose_Type\" datatype=\"char\" arraysize=\"*\""
 	" ucd=\"meta.code\" value=\"%s\"/>\n",